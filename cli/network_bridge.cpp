@@ -0,0 +1,110 @@
+#include <signal.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "mini_ros2/communication/network_bridge.h"
+
+// 网络桥：本机唯一的网络端点，节点之间仍走共享内存；Ctrl-C 退出
+// mini_ros2_bridge [--export PATTERN]... [--import PATTERN]...
+//                  [--rate PATTERN=HZ]... [--reliable PATTERN]...
+//                  [--peer HOST:PORT]...
+//                  [--domain N] [--group ADDR] [--port N] [--iface ADDR]
+//                  [--mtu N] [--no-coalesce] [--tcp PORT]
+// PATTERN 匹配不含分区前缀的 "<topic>_<event>"；--domain 为本地分区的域 id
+// --tcp 改用 TCP 传输并监听 PORT，与每个 --peer 保持一条常驻连接
+static void usage() {
+  std::cerr << "usage: mini_ros2_bridge [--export PATTERN]... "
+               "[--import PATTERN]... [--rate PATTERN=HZ]... "
+               "[--reliable PATTERN]... "
+               "[--peer HOST:PORT]... [--domain N] [--group ADDR] [--port N] "
+               "[--iface ADDR] [--mtu N] [--no-coalesce] [--tcp PORT]"
+            << std::endl;
+}
+
+static bool parseArgs(int argc, char** argv, NetworkBridgeConfig& config) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--no-coalesce") {
+      config.transport.coalesce = false;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--export") {
+      config.export_patterns.push_back(value);
+    } else if (arg == "--import") {
+      config.import_patterns.push_back(value);
+    } else if (arg == "--rate") {
+      size_t split = value.rfind('=');
+      if (split == std::string::npos) return false;
+      config.rate_limits.push_back(
+          {value.substr(0, split), std::atof(value.c_str() + split + 1)});
+    } else if (arg == "--reliable") {
+      config.reliable_patterns.push_back(value);
+    } else if (arg == "--peer") {
+      size_t split = value.rfind(':');
+      if (split == std::string::npos) return false;
+      config.peers.push_back(
+          {value.substr(0, split),
+           static_cast<uint16_t>(std::atoi(value.c_str() + split + 1))});
+    } else if (arg == "--domain") {
+      config.local.domain_id = std::atoi(value.c_str());
+    } else if (arg == "--group") {
+      config.transport.multicast_group = value;
+    } else if (arg == "--port") {
+      config.transport.multicast_port =
+          static_cast<uint16_t>(std::atoi(value.c_str()));
+    } else if (arg == "--iface") {
+      config.transport.interface_address = value;
+    } else if (arg == "--mtu") {
+      config.transport.mtu = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--tcp") {
+      config.use_tcp = true;
+      config.tcp_transport.listen_port =
+          static_cast<uint16_t>(std::atoi(value.c_str()));
+    } else {
+      return false;
+    }
+  }
+  return !config.export_patterns.empty() || !config.import_patterns.empty();
+}
+
+int main(int argc, char** argv) {
+  NetworkBridgeConfig config;
+  if (!parseArgs(argc, argv, config)) {
+    usage();
+    return EXIT_FAILURE;
+  }
+  // 信号由 sigwait 线程处理，网关和扫描线程不会被打断
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  try {
+    NetworkBridge bridge(config);
+    bridge.start();
+    int signal = 0;
+    sigwait(&signals, &signal);
+    bridge.stop();
+    CommStats stats = bridge.getStats();
+    std::cout << "Network bridge stopped: " << stats.sent << " sent, "
+              << stats.received << " received, " << stats.throttled
+              << " throttled, " << stats.lost << " lost";
+    if (stats.latency_count > 0) {
+      std::cout << ", latency mean "
+                << stats.latency_sum_us / stats.latency_count << " us, max "
+                << stats.latency_max_us << " us";
+    }
+    std::cout << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
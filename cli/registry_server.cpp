@@ -0,0 +1,35 @@
+#include <signal.h>
+
+#include <cstdlib>
+#include <iostream>
+
+#include "mini_ros2/communication/registry.h"
+
+// 发现注册服务器：mini_ros2_registry [port]，默认 8080；Ctrl-C 退出
+int main(int argc, char** argv) {
+  uint16_t port = REGISTRY_DEFAULT_PORT;
+  if (argc > 1) {
+    port = static_cast<uint16_t>(std::atoi(argv[1]));
+  }
+  // 信号由 sigwait 线程处理，事件循环线程不会被打断
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  try {
+    RegistryServer server(port);
+    server.start();
+    int signal = 0;
+    sigwait(&signals, &signal);
+    server.stop();
+    RegistryServerStats stats = server.getStats();
+    std::cout << "Registry server stopped: " << stats.accepted
+              << " connections, " << stats.requests << " requests"
+              << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
@@ -0,0 +1,36 @@
+#include <signal.h>
+
+#include <cstdlib>
+#include <iostream>
+
+#include "mini_ros2/communication/segment_broker.h"
+
+// 本机数据段代理：mini_ros2_segd [name]，默认 miniros2_segments；Ctrl-C 退出
+// 节点设置 MINIROS2_SEGMENT_BROKER=<name> 后 topic 数据段改为匿名 memfd 经此传递
+int main(int argc, char** argv) {
+  std::string name = SEGMENT_BROKER_DEFAULT_NAME;
+  if (argc > 1) {
+    name = argv[1];
+  }
+  // 信号由 sigwait 线程处理，事件循环线程不会被打断
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  try {
+    SegmentBroker broker(name);
+    broker.start();
+    int signal = 0;
+    sigwait(&signals, &signal);
+    broker.stop();
+    SegmentBrokerStats stats = broker.getStats();
+    std::cout << "Segment broker stopped: " << stats.accepted
+              << " connections, " << stats.offers << " offers, "
+              << stats.fetches << " fetches" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
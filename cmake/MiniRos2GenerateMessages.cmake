@@ -0,0 +1,82 @@
+# mini_ros2_generate_messages(<target>
+#     FILES <a.msg> [<b.msg> ...]
+#     [SEARCH_PATHS <dir> ...])
+#
+# 根据 .msg 文件生成定长布局的 C++ 消息头文件，并创建静态库 <target>。
+# .msg 文件所在目录名即为包名：msg/std_msgs/Header.msg -> std_msgs::msg::Header，
+# 头文件路径为 std_msgs/msg/header.h。链接 <target> 即可获得包含路径。
+# SEARCH_PATHS 用于查找跨包嵌套引用的 .msg（默认包含各文件的上两级目录）。
+
+find_package(Python3 COMPONENTS Interpreter REQUIRED)
+
+set(MINI_ROS2_MSG_GENERATOR
+    ${CMAKE_CURRENT_LIST_DIR}/../tools/generate_messages.py
+    CACHE INTERNAL "miniROS2 message generator script")
+
+function(mini_ros2_generate_messages target)
+  cmake_parse_arguments(ARG "" "" "FILES;SEARCH_PATHS" ${ARGN})
+  if(NOT ARG_FILES)
+    message(FATAL_ERROR "mini_ros2_generate_messages: no FILES given")
+  endif()
+
+  set(out_dir ${CMAKE_CURRENT_BINARY_DIR}/${target}_generated)
+  set(msg_files "")
+  set(headers "")
+  set(search_args "")
+  foreach(path ${ARG_SEARCH_PATHS})
+    get_filename_component(path ${path} ABSOLUTE)
+    list(APPEND search_args --search-path ${path})
+  endforeach()
+
+  foreach(msg ${ARG_FILES})
+    get_filename_component(msg ${msg} ABSOLUTE)
+    get_filename_component(msg_dir ${msg} DIRECTORY)
+    get_filename_component(package ${msg_dir} NAME)
+    get_filename_component(root ${msg_dir} DIRECTORY)
+    get_filename_component(name ${msg} NAME_WE)
+    # 与生成器保持一致：CamelCase -> snake_case
+    string(REGEX REPLACE "([a-z0-9])([A-Z])" "\\1_\\2" header ${name})
+    string(TOLOWER ${header} header)
+    list(APPEND msg_files ${msg})
+    list(APPEND headers ${out_dir}/${package}/msg/${header}.h)
+    list(APPEND search_args --search-path ${root})
+  endforeach()
+  list(REMOVE_DUPLICATES search_args)
+
+  set(gen_command ${Python3_EXECUTABLE} ${MINI_ROS2_MSG_GENERATOR}
+      --out ${out_dir} ${search_args} ${msg_files})
+
+  # 配置阶段缺少头文件时先生成一次，保证任意目录下的目标都能直接使用
+  set(missing FALSE)
+  foreach(header ${headers})
+    if(NOT EXISTS ${header})
+      set(missing TRUE)
+    endif()
+  endforeach()
+  if(missing)
+    execute_process(COMMAND ${gen_command} RESULT_VARIABLE gen_result)
+    if(NOT gen_result EQUAL 0)
+      message(FATAL_ERROR "mini_ros2_generate_messages: failed for ${target}")
+    endif()
+  endif()
+
+  # 构建阶段：.msg 或生成器变化时重新生成
+  add_custom_command(
+    OUTPUT ${headers}
+    COMMAND ${gen_command}
+    DEPENDS ${msg_files} ${MINI_ROS2_MSG_GENERATOR}
+    COMMENT "Generating miniROS2 messages for ${target}")
+
+  # 生成的头文件作为真实目标的源文件，链接 <target> 的目标在编译前先重新生成
+  # （INTERFACE 库要到 CMake 3.19 才能 add_dependencies）；
+  # 桩文件包含全部头文件，顺带检查生成的代码能否编译
+  set(stub_content "")
+  foreach(header ${headers})
+    string(APPEND stub_content "#include \"${header}\"\n")
+  endforeach()
+  set(stub ${out_dir}/${target}_headers.cpp)
+  file(GENERATE OUTPUT ${stub} CONTENT "${stub_content}")
+
+  add_library(${target} STATIC ${stub} ${headers})
+  target_include_directories(${target} PUBLIC ${out_dir})
+endfunction()
@@ -0,0 +1,104 @@
+// 模拟 16 线旋转激光雷达：10Hz 点云 + 40Hz 二维激光扫描
+// 消息直接在共享内存中构造（publishLoanedMessage），不经过中间缓冲区
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "mini_ros2/message/sensor_msgs.h"
+#include "mini_ros2/node.h"
+#include "mini_ros2/pubsub/sensor_publisher.h"
+
+namespace {
+
+constexpr uint32_t kRings = 16;           // 扫描线数
+constexpr uint32_t kPointsPerRing = 2000;  // 每圈每线点数（0.18° 分辨率）
+constexpr float kVerticalFov = 30.0f * static_cast<float>(M_PI) / 180.0f;
+constexpr uint32_t kScanBeams = 1440;     // 2D 扫描：0.25° 分辨率
+
+using LidarCloud = PointCloudSoA<kRings * kPointsPerRing>;
+
+uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// 模拟场景：半径随方位角起伏的圆柱形房间，加上一个随时间移动的障碍物
+float sceneRange(float azimuth, double t) {
+  float range = 8.0f + 1.5f * std::sin(3.0f * azimuth);
+  float obstacle = static_cast<float>(std::fmod(t * 0.5, 2.0 * M_PI));
+  if (std::fabs(azimuth - obstacle) < 0.1f) {
+    range = 2.5f;
+  }
+  return range;
+}
+
+}  // namespace
+
+int main() {
+  Node node("lidar_node");
+  auto cloud_pub = node.createPublisher<LidarCloud>("lidar");
+  auto scan_pub = node.createPublisher<LaserScan2K>("lidar");
+  uint32_t cloud_seq = 0;
+  uint32_t scan_seq = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  node.createTimer(100, [&]() {
+    double t = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start)
+                   .count();
+    publishLoanedMessage(*cloud_pub, "points", [&](LidarCloud& cloud) {
+      cloud.header.stamp_ns = nowNs();
+      cloud.header.seq = cloud_seq++;
+      cloud.header.setFrameId("velodyne");
+      cloud.clear();
+      cloud.width = kPointsPerRing;
+      cloud.height = kRings;
+      // 逐线写入，四个分量各自连续
+      for (uint32_t ring = 0; ring < kRings; ++ring) {
+        float elevation =
+            -kVerticalFov / 2 + kVerticalFov * ring / (kRings - 1);
+        float cos_el = std::cos(elevation);
+        float sin_el = std::sin(elevation);
+        for (uint32_t i = 0; i < kPointsPerRing; ++i) {
+          float azimuth = 2.0f * static_cast<float>(M_PI) * i / kPointsPerRing;
+          float range = sceneRange(azimuth, t);
+          cloud.push(range * cos_el * std::cos(azimuth),
+                     range * cos_el * std::sin(azimuth), range * sin_el,
+                     100.0f / range);
+        }
+      }
+    });
+    if (cloud_seq % 10 == 0) {
+      std::cout << "published cloud #" << cloud_seq << " ("
+                << kRings * kPointsPerRing << " points, "
+                << sizeof(LidarCloud) / 1024 << " KiB)" << std::endl;
+    }
+  });
+
+  node.createTimer(25, [&]() {
+    double t = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start)
+                   .count();
+    publishLoanedMessage(*scan_pub, "scan", [&](LaserScan2K& scan) {
+      scan.header.stamp_ns = nowNs();
+      scan.header.seq = scan_seq++;
+      scan.header.setFrameId("laser");
+      scan.angle_min = -static_cast<float>(M_PI);
+      scan.angle_increment = 2.0f * static_cast<float>(M_PI) / kScanBeams;
+      scan.angle_max = scan.angle_min + scan.angle_increment * (kScanBeams - 1);
+      scan.scan_time = 0.025f;
+      scan.time_increment = scan.scan_time / kScanBeams;
+      scan.range_min = 0.1f;
+      scan.range_max = 30.0f;
+      scan.resize(kScanBeams);
+      for (uint32_t i = 0; i < kScanBeams; ++i) {
+        scan.ranges[i] = sceneRange(scan.angleAt(i), t);
+        scan.intensities[i] = 100.0f / scan.ranges[i];
+      }
+    });
+  });
+
+  node.spin();
+  return 0;
+}
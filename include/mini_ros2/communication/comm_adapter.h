@@ -0,0 +1,194 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mini_ros2/communication/shm_base.h"
+#include "mini_ros2/communication/shm_manager.h"
+
+// 跨主机传输抽象：共享内存只能在单机内通信，跨主机的 topic 由 CommGateway 通过
+// CommAdapter 收发；具体传输（UDP 组播 / 单播等）实现 CommAdapter 接口
+
+// 数据段不超过该大小的导出 topic 拷贝出来，与同一轮的其他 topic 合并成一批发送；
+// 更大的（如点云）在数据段锁内直接从共享内存发出，不再拷贝，发送期间发布者等待
+#define COMM_GATEWAY_COPY_LIMIT (64 * 1024)
+// 导入时按帧中的 segment_size 创建本地数据段，不超过该大小（可用
+// setMaxImportSize 调整），更长的消息截断
+#define COMM_GATEWAY_MAX_IMPORT (256u * 1024 * 1024)
+
+// 传输地址；host 为空表示发往传输的默认组（UDP 为组播组）
+struct CommEndpoint {
+  std::string host;
+  uint16_t port = 0;
+
+  bool isGroup() const { return host.empty(); }
+};
+
+// 待发送的一帧：topic 不含分区前缀，接收端换成自己分区的前缀
+// data 只需在 sendBatch 返回前有效
+struct CommFrame {
+  std::string topic;
+  std::string event;
+  uint64_t seq = 0;           // 每个 topic+event 独立递增，从 1 开始
+  uint32_t segment_size = 0;  // 发送端数据段大小，接收端按该大小创建本地数据段
+  bool reliable = false;  // 可靠传输：丢失时重发，接收端按序号交付（传输支持时）
+  uint64_t timestamp = 0;  // 数据段写入时间（system_clock 微秒），0 表示未知
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+  CommEndpoint dest;
+};
+
+// 收到的一帧，data 只在回调期间有效
+struct CommMessage {
+  uint64_t sender_id;  // 发送端 CommAdapter 的随机 id，同一 topic 的序号按发送端区分
+  uint64_t seq;
+  uint32_t segment_size;
+  // 发送端的写入时间换算到本机时钟（system_clock 微秒）；传输还没有估计出与发送端的
+  // 时钟偏移，或发送端没有提供时间戳时为 0
+  uint64_t source_time;
+  std::string topic;
+  std::string event;
+  const uint8_t* data;
+  size_t size;
+};
+
+class CommAdapter {
+ public:
+  using ReceiveCallback = std::function<void(const CommMessage&)>;
+
+  virtual ~CommAdapter() = default;
+
+  // 批量发送，返回成功发出的帧数；单帧超过传输上限时跳过该帧
+  virtual size_t sendBatch(const std::vector<CommFrame>& frames) = 0;
+  bool send(const CommFrame& frame) { return sendBatch({frame}) == 1; }
+
+  // 启动接收线程，callback 在接收线程中执行；本适配器自己发出的帧不会回调
+  virtual void start(ReceiveCallback callback) = 0;
+  virtual void stop() = 0;
+
+  // 本端 id（随帧发出）和点对点接收地址（供对端 addExport 单播）
+  virtual uint64_t senderId() const = 0;
+  virtual CommEndpoint localEndpoint() const = 0;
+};
+
+// 进程内、跨进程都不重复的发送端 id，供各 CommAdapter 实现使用
+uint64_t randomCommSenderId();
+
+struct CommStats {
+  uint64_t sent = 0;        // 发出的帧数
+  uint64_t received = 0;    // 写入本地共享内存的帧数
+  uint64_t lost = 0;        // 序号跳过的帧数（按发送端、topic 统计）
+  uint64_t duplicates = 0;  // 重复或乱序到达、被丢弃的帧数
+  uint64_t ignored = 0;     // 未登记导入（addImport / addImportPattern）的 topic
+  uint64_t throttled = 0;   // 限速期间被更新的消息取代、没有发出的消息数
+  // 端到端延迟：远端发布者写入数据段到本端导入写入，按时钟偏移换算后的微秒数；
+  // 只统计带 source_time 的消息，平均值为 latency_sum_us / latency_count
+  uint64_t latency_count = 0;
+  uint64_t latency_sum_us = 0;
+  uint64_t latency_max_us = 0;
+};
+
+// 网关：在本地分区与 CommAdapter 之间转发 topic，结构与 DomainBridge 相同
+// 导出：在本地分区中作为订阅者注册，数据段有新消息时整体发出（组播或单播到指定对端）
+// 导入：接收线程把远端消息写入本地分区的同名数据段并触发事件，本地订阅者仍走共享内存
+// 同一 topic 同时导入和导出时，导入写入的消息不会再被导出
+class CommGateway {
+ public:
+  CommGateway(const RegistryConfig& local,
+              std::unique_ptr<CommAdapter> adapter);
+  ~CommGateway();
+  CommGateway(const CommGateway&) = delete;
+  CommGateway& operator=(const CommGateway&) = delete;
+
+  // topic_name 为不含分区前缀的名字；peer 为组地址时组播，否则单播到 peer
+  // 同一 topic+event 可多次调用以发往多个对端，各对端收到相同的序号
+  void addExport(const std::string& topic_name, const std::string& event_name,
+                 const CommEndpoint& peer = CommEndpoint());
+  void addImport(const std::string& topic_name, const std::string& event_name);
+  // 导入 "<topic>_<event>"（不含分区前缀）匹配 pattern（fnmatch 通配符）的所有远端
+  // topic：收到未登记的 topic 时按需建立导入
+  void addImportPattern(const std::string& pattern);
+  // 限制导出频率：每秒最多发出 max_hz 条，间隔内的新消息只保留最新一条，到期后发出；
+  // max_hz 为 0 表示不限速。对已登记和之后登记的导出都有效
+  void setRateLimit(const std::string& topic_name,
+                    const std::string& event_name, double max_hz);
+  // 导出时使用可靠传输（CommFrame::reliable）：丢失的消息由传输重发，按序号送达
+  // 适合跨主机的命令 topic；高频的传感器 topic 保持默认的尽力而为
+  void setReliable(const std::string& topic_name,
+                   const std::string& event_name, bool reliable = true);
+  // 导入创建的本地数据段的大小上限；segment_size 来自网络，不能直接信任
+  void setMaxImportSize(size_t max_size);
+
+  // 等待本地分区的事件（最多 timeout_ms，有限速推迟的消息时不超过其到期时间），
+  // 把有新消息的导出 topic 一次批量发出，返回发出的帧数
+  int exportOnce(uint64_t timeout_ms);
+
+  // 启动接收线程和后台导出线程
+  void start();
+  void stop();
+
+  CommStats getStats();
+  CommAdapter& adapter() { return *adapter_; }
+  // 网关在本地分区注册的节点，可用于查询注册表
+  ShmManager& manager() { return *manager_; }
+
+ private:
+  struct Route {
+    std::string topic;  // 含本地分区前缀
+    std::string event;
+    std::string remote_topic;  // 不含前缀，线上使用
+    int event_id = -1;
+    bool exported = false;
+    bool imported = false;
+    bool reliable = false;
+    std::vector<CommEndpoint> peers;
+    std::shared_ptr<ShmBase> shm;
+    std::vector<uint8_t> buffer;  // 导出时拷贝出的小消息，发送完成前有效
+    uint64_t last_time = 0;  // 已导出或由导入写入的消息时间戳
+    uint64_t next_seq = 1;
+    std::unordered_map<uint64_t, uint64_t> last_seq;  // 发送端 -> 已接收序号
+    // 导出限速：min_interval 为 0 时不限速，next_send 之前的新消息推迟发送
+    std::chrono::steady_clock::duration min_interval{0};
+    std::chrono::steady_clock::time_point next_send;
+    bool pending = false;        // 有因限速推迟的消息
+    uint64_t deferred_time = 0;  // 推迟的消息的时间戳
+  };
+
+  Route& routeFor_(const std::string& topic_name,
+                   const std::string& event_name);
+  // 打开本地发布者的数据段，尚未创建时返回 false
+  bool openExport_(Route& route);
+  // 追加 route 发往各对端的帧，data 为整条消息，timestamp 为其写入时间
+  void appendFrames_(Route& route, const uint8_t* data, size_t size,
+                     uint64_t timestamp, std::vector<CommFrame>& frames);
+  // 小消息：有新消息时拷贝出来并追加到 frames，返回是否追加
+  bool collectExport_(Route& route, std::vector<CommFrame>& frames);
+  // 大消息：持数据段锁直接从共享内存发送，返回发出的帧数
+  size_t sendInPlace_(Route& route);
+  // 未到限速间隔：记下新消息，到期后再发
+  void deferExport_(Route& route);
+  // 本轮等待时间：不超过最早到期的推迟消息
+  uint64_t exportTimeout_(uint64_t timeout_ms);
+  bool matchesImportPattern_(const std::string& key) const;
+  void onMessage_(const CommMessage& msg);
+  void exportLoop_();
+
+  RegistryConfig local_;
+  std::unique_ptr<CommAdapter> adapter_;
+  std::unique_ptr<ShmManager> manager_;
+  // key 为 "<remote_topic>_<event>"；Route 地址在插入后不变
+  std::unordered_map<std::string, std::unique_ptr<Route>> routes_;
+  std::mutex routes_mutex_;
+  std::vector<std::string> import_patterns_;
+  size_t max_import_size_ = COMM_GATEWAY_MAX_IMPORT;
+  CommStats stats_;
+  std::thread export_thread_;
+  std::atomic<bool> running_ = false;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mini_ros2/communication/shm_base.h"
+#include "mini_ros2/communication/shm_manager.h"
+
+// 跨分区桥：注册表和事件通知按域（可选按命名空间）分区后，不同分区的节点互相不可见，
+// 需要跨域通信的 topic 由桥显式转发
+// 桥在源分区中作为订阅者、在目标分区中作为发布者注册，把源数据段整体拷贝到目标分区的
+// 同名 topic（前缀换成目标分区的 topicPrefix()）并触发目标分区的事件
+// 路由是单向的；双向转发同一 topic 会来回回环，需要用两个不同的 topic
+class DomainBridge {
+ public:
+  DomainBridge(const RegistryConfig& from, const RegistryConfig& to);
+  ~DomainBridge();
+  DomainBridge(const DomainBridge&) = delete;
+  DomainBridge& operator=(const DomainBridge&) = delete;
+
+  // 添加一条路由，topic_name 为不含分区前缀的名字（与 Node::createPublisher 相同）
+  void addRoute(const std::string& topic_name, const std::string& event_name);
+
+  // 等待源分区的事件（最多 timeout_ms），转发有新消息的路由，返回转发条数
+  int forwardOnce(uint64_t timeout_ms);
+
+  // 后台线程循环调用 forwardOnce
+  void start();
+  void stop();
+
+ private:
+  struct Route {
+    std::string src_topic;  // 含源分区前缀
+    std::string dst_topic;  // 含目标分区前缀
+    std::string event;
+    int src_event_id = -1;
+    std::shared_ptr<ShmBase> src_shm;
+    std::shared_ptr<ShmBase> dst_shm;
+    uint64_t last_time = 0;  // 已转发消息的写入时间戳
+  };
+
+  // 源数据段有新消息时拷贝到目标分区，返回是否转发
+  bool forwardRoute_(Route& route);
+  void ensureDstShm_(Route& route, size_t size);
+  void bridgeLoop_();
+
+  RegistryConfig from_;
+  RegistryConfig to_;
+  std::unique_ptr<ShmManager> src_manager_;
+  std::unique_ptr<ShmManager> dst_manager_;
+  std::vector<Route> routes_;
+  std::mutex routes_mutex_;
+  std::thread bridge_thread_;
+  std::atomic<bool> running_ = false;
+};
@@ -1,8 +1,10 @@
 #pragma once
 #include <atomic>
+#include <chrono>
 #include <fcntl.h>
 #include <functional>
 #include <iostream>
+#include <list>
 #include <mutex>
 #include <string>
 #include <sys/epoll.h>
@@ -14,7 +16,9 @@
 
 typedef enum {
   EVENT_TYPE_SUB, // 订阅者事件（接收消息）
-  EVENT_TYPE_PUB  // 发布者事件（如发送确认，可选）
+  EVENT_TYPE_PUB, // 发布者事件（如发送确认，可选）
+  // 普通 fd 可读（如套接字）：不读取 fd，由回调自己收取数据；fd 归调用者所有，不关闭
+  EVENT_TYPE_IO
 } EventType;
 
 typedef struct {
@@ -33,6 +37,12 @@ public:
       std::cerr << "epoll_create1 failed" << std::endl;
       return;
     }
+    // stop() 通过 wake_fd_ 立即唤醒 epoll_wait，data.ptr 为空表示唤醒
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
     thread_ = std::thread(&EventManager::run, this);
   };
   ~EventManager() {
@@ -40,9 +50,12 @@ public:
     if (epoll_fd_ != -1) {
       close(epoll_fd_);
     }
+    if (wake_fd_ != -1) {
+      close(wake_fd_);
+    }
     std::lock_guard<std::mutex> lock(epoll_mutex_);
     for (const auto &src : event_sources_) {
-      if (src.efd != -1) {
+      if (src.efd != -1 && src.type != EVENT_TYPE_IO) {
         close(src.efd);
       }
     }
@@ -60,8 +73,8 @@ public:
 
     struct epoll_event ev;
     ev.events = EPOLLIN;
-    ev.data.ptr = &event_sources_.back();
     std::lock_guard<std::mutex> lock(epoll_mutex_);
+    // std::list 插入后元素地址不变，可以放进 epoll_event.data
     event_sources_.push_back(source);
     ev.data.ptr = &event_sources_.back();
     // 注册到 epoll
@@ -82,7 +95,9 @@ public:
           return false;
         }
         // 关闭 eventfd 并从列表中删除
-        close(it->efd);
+        if (it->type != EVENT_TYPE_IO) {
+          close(it->efd);
+        }
         event_sources_.erase(it);
         return true;
       }
@@ -90,8 +105,20 @@ public:
     return false;
   };
 
+  // 周期回调：在事件线程中每 period_ms 执行一次（如检查超时），传空函数取消
+  void setTickCallback(uint64_t period_ms, std::function<void()> tick) {
+    std::lock_guard<std::mutex> lock(epoll_mutex_);
+    tick_period_ms_ = period_ms;
+    tick_ = std::move(tick);
+  };
+
   void stop() {
     running_ = false;
+    if (wake_fd_ != -1) {
+      uint64_t one = 1;
+      ssize_t n = write(wake_fd_, &one, sizeof(one));
+      (void)n;
+    }
     if (thread_.joinable()) {
       thread_.join();
     }
@@ -99,8 +126,16 @@ public:
 
 private:
   void run() {
+    auto next_tick = std::chrono::steady_clock::now();
     while (running_) {
-      int num_ready = epoll_wait(epoll_fd_, events_, MAX_EVENTS, 1000);
+      int timeout = 1000;
+      {
+        std::lock_guard<std::mutex> lock(epoll_mutex_);
+        if (tick_) {
+          timeout = static_cast<int>(std::min<uint64_t>(tick_period_ms_, 1000));
+        }
+      }
+      int num_ready = epoll_wait(epoll_fd_, events_, MAX_EVENTS, timeout);
       if (num_ready == -1) {
         if (errno == EINTR) {
           continue;
@@ -117,6 +152,10 @@ private:
         }
 
         // 检查事件类型（仅处理可读事件）
+        if ((events_[i].events & EPOLLIN) && src->type == EVENT_TYPE_IO) {
+          src->callback();
+          continue;
+        }
         if (events_[i].events & EPOLLIN) {
           // 读取 eventfd 数据（重置事件，避免持续触发）
           uint64_t notify;
@@ -132,14 +171,29 @@ private:
           }
         }
       }
+      std::function<void()> tick;
+      {
+        std::lock_guard<std::mutex> lock(epoll_mutex_);
+        if (tick_ && std::chrono::steady_clock::now() >= next_tick) {
+          tick = tick_;
+          next_tick = std::chrono::steady_clock::now() +
+                      std::chrono::milliseconds(tick_period_ms_);
+        }
+      }
+      if (tick) {
+        tick();
+      }
     }
   }
   std::atomic<bool> running_{true};
+  int wake_fd_ = -1;
+  uint64_t tick_period_ms_ = 0;
+  std::function<void()> tick_;
   std::thread thread_;
   int epoll_fd_ = -1;
   static const int MAX_EVENTS = 64; // 最大同时处理的就绪事件数
   std::mutex epoll_mutex_;          // 保护epoll_fd_的互斥锁
   epoll_event events_[MAX_EVENTS];  // 就绪事件数组
-  std::vector<EventSource> event_sources_; // 事件源容器
+  std::list<EventSource> event_sources_; // 事件源容器
   std::unordered_map<std::string, std::string> topic_eventfd_map_;
 };
\ No newline at end of file
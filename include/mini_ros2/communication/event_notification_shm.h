@@ -6,31 +6,62 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "mini_ros2/communication/shared_memory.h"
 
 #define EVENT_NOTIFICATION_SHM_NAME "/miniros2_event_notification"
 #define EVENT_NOTIFICATION_SHM_SIZE 4096  // 轻量级，只需要存储事件标志
-#define EVENT_MAX_COUNT 1024              // 位数
+#define EVENT_MAX_COUNT 1024              // 每个标志块的位数
+// 超过 EVENT_MAX_COUNT 的事件放在链式扩展块中，扩展块名为 "<基段名>.<块号>"
+#define EVENT_MAX_CHUNKS 64
 // 事件通知共享内存数据结构
 struct EventNotificationData {
   uint32_t
       initialized_;  // 初始化标志：0x4556454E = "EVEN" (Event Notification)
+  uint32_t chunk_count_;   // 标志块数（含基段中的第 0 块），只增不减
   pthread_mutex_t mutex_;  // 互斥锁（进程间共享）
-  pthread_cond_t cond_;    // 条件变量（进程间共享）
+  pthread_cond_t cond_;    // 条件变量（进程间共享），所有块共用
   // uint32_t event_flag_;    // 事件标志位（第i位表示第i个事件）
-  std::bitset<EVENT_MAX_COUNT> event_flag_;
+  std::bitset<EVENT_MAX_COUNT> event_flag_;  // 第 0 块
   uint64_t time_;  // 时间戳
-  char padding_[EVENT_NOTIFICATION_SHM_SIZE - sizeof(uint32_t) -
+  char padding_[EVENT_NOTIFICATION_SHM_SIZE - 2 * sizeof(uint32_t) -
                 sizeof(pthread_mutex_t) - sizeof(pthread_cond_t) -
                 sizeof(std::bitset<EVENT_MAX_COUNT>) -
                 sizeof(uint64_t)];  // 填充到固定大小
 };
 
+// 事件标志集合：按 EVENT_MAX_COUNT 位分块，块数随事件通知容量增长
+class EventFlags {
+ public:
+  bool any() const {
+    for (const auto& chunk : chunks_) {
+      if (chunk.any()) return true;
+    }
+    return false;
+  }
+  // 超出当前容量的 event_id 视为未触发
+  bool test(int event_id) const {
+    if (event_id < 0 ||
+        static_cast<size_t>(event_id) >= chunks_.size() * EVENT_MAX_COUNT) {
+      return false;
+    }
+    return chunks_[event_id / EVENT_MAX_COUNT][event_id % EVENT_MAX_COUNT];
+  }
+  bool operator[](int event_id) const { return test(event_id); }
+  size_t capacity() const { return chunks_.size() * EVENT_MAX_COUNT; }
+
+ private:
+  friend class EventNotificationShm;
+  std::vector<std::bitset<EVENT_MAX_COUNT>> chunks_;
+};
+
 // 独立的事件通知共享内存管理类
 class EventNotificationShm {
  public:
-  EventNotificationShm();
+  // name 为基段名，按域分区时由 RegistryConfig::eventNotificationName() 给出
+  explicit EventNotificationShm(
+      const std::string& name = EVENT_NOTIFICATION_SHM_NAME);
   ~EventNotificationShm();
 
   // 初始化共享内存（创建者调用）
@@ -45,14 +76,20 @@ class EventNotificationShm {
   // 触发事件：设置对应的位并通知条件变量
   void triggerEvent(int event_id);
 
+  // 扩容：确保 event_id < event_count 的事件都有标志块，按块链式增加
+  void ensureCapacity(int event_count);
+
+  // 当前事件容量（块数 * EVENT_MAX_COUNT）
+  int capacity() const;
+
   // 等待事件（带超时），返回当前的事件标志位
-  std::bitset<EVENT_MAX_COUNT> waitForEvent(uint64_t timeout_ms);
+  EventFlags waitForEvent(uint64_t timeout_ms);
 
   // 读取并清除事件标志位（原子操作）
-  std::bitset<EVENT_MAX_COUNT> readAndClearEvents();
+  EventFlags readAndClearEvents();
 
   // 读取事件标志位（不清除）
-  std::bitset<EVENT_MAX_COUNT> readEvents() const;
+  EventFlags readEvents() const;
 
   // 清除事件标志位
   void clearEvents();
@@ -75,10 +112,24 @@ class EventNotificationShm {
   // 缓存指针
   void cachePointers();
 
+  // 加锁；持锁进程崩溃时恢复锁并唤醒等待者
+  void lockRobust_() const;
+
+  // 以下方法要求调用者持有 mutex_ptr_
+  // 映射其他进程新增的扩展块
+  void mapChunksLocked_() const;
+  // 创建或打开第 index 个扩展块（index >= 1）
+  std::unique_ptr<SharedMemory> openChunk_(int index, bool create) const;
+  EventFlags copyFlagsLocked_() const;
+
+  std::string name_;
   std::shared_ptr<SharedMemory> shm_;
   EventNotificationData* data_ptr_ = nullptr;
   pthread_mutex_t* mutex_ptr_ = nullptr;
   pthread_cond_t* cond_ptr_ = nullptr;
   std::bitset<EVENT_MAX_COUNT>* event_flag_ptr_ = nullptr;
+  // 已映射的标志块：[0] 指向基段中的 event_flag_，其余指向扩展段
+  mutable std::vector<std::bitset<EVENT_MAX_COUNT>*> flag_chunks_;
+  mutable std::vector<std::unique_ptr<SharedMemory>> ext_chunks_;
   bool is_owner_ = false;
 };
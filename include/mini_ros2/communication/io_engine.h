@@ -0,0 +1,90 @@
+#pragma once
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mini_ros2/communication/event_manager.h"
+
+// 网络传输和录制（写文件）共用的 I/O 引擎：把每条消息一次系统调用变成一批一次
+// io_uring 实现批量提交、多发（multishot）接收、登记常驻缓冲区；内核不支持或被禁用时
+// 退回 epoll 实现（EventManager + sendmmsg / recvmmsg / pwritev）
+enum class IoBackend { Auto, IoUring, Epoll };
+
+// "io_uring" / "epoll"，未设置或其他值为 Auto
+#define IO_BACKEND_ENV "MINIROS2_IO_BACKEND"
+// epoll 实现每次 recvmmsg 最多收取的报文数
+#define IO_RECV_BATCH 32
+
+// 一次写文件请求：把 data 的 size 字节写到文件的 offset 处
+struct IoWrite {
+  const void* data;
+  size_t size;
+  uint64_t offset;
+};
+
+class IoEngine {
+ public:
+  // 报文内容和源地址（回复控制帧时使用，不依赖对端自报的地址）
+  using ReceiveHandler =
+      std::function<void(const uint8_t*, size_t, const sockaddr_in&)>;
+
+  virtual ~IoEngine() = default;
+  virtual const char* name() const = 0;
+
+  // 批量发送报文，返回成功发出的报文数；msgs[i].msg_len 为发出的字节数，失败时为 0
+  virtual size_t sendBatch(int fd, std::vector<mmsghdr>& msgs) = 0;
+
+  // 批量写文件，返回写入的总字节数；失败时抛 std::runtime_error
+  virtual size_t writeBatch(int fd, const std::vector<IoWrite>& writes) = 0;
+
+  // 登记常驻缓冲区（如共享内存数据段），之后落在其中的写请求不再逐次映射页面
+  // 再次调用替换之前的登记；不支持时返回 false，写请求照常执行
+  virtual bool registerBuffers(const std::vector<iovec>& buffers) = 0;
+
+  // start 之前添加：fd 上每收到一个不超过 max_size 的报文，在接收线程中调用一次 handler
+  virtual void addReceiver(int fd, size_t max_size, ReceiveHandler handler) = 0;
+
+  // 启动接收线程；tick 非空时在接收线程中每 tick_ms 执行一次
+  virtual void start(uint64_t tick_ms, std::function<void()> tick) = 0;
+  virtual void stop() = 0;
+};
+
+// 读取 MINIROS2_IO_BACKEND
+IoBackend ioBackendFromEnv();
+
+// Auto 优先 io_uring，探测失败时退回 epoll；指定 IoUring 但不可用时抛 std::runtime_error
+std::unique_ptr<IoEngine> createIoEngine(IoBackend backend = IoBackend::Auto);
+
+// epoll 实现：接收由 EventManager 的事件线程收取，发送和写文件直接批量系统调用
+class EpollIoEngine : public IoEngine {
+ public:
+  EpollIoEngine() = default;
+  ~EpollIoEngine() override;
+
+  const char* name() const override { return "epoll"; }
+  size_t sendBatch(int fd, std::vector<mmsghdr>& msgs) override;
+  size_t writeBatch(int fd, const std::vector<IoWrite>& writes) override;
+  bool registerBuffers(const std::vector<iovec>&) override { return false; }
+  void addReceiver(int fd, size_t max_size, ReceiveHandler handler) override;
+  void start(uint64_t tick_ms, std::function<void()> tick) override;
+  void stop() override;
+
+ private:
+  struct Receiver {
+    int fd;
+    size_t max_size;
+    ReceiveHandler handler;
+    std::vector<uint8_t> buffer;  // IO_RECV_BATCH 个报文
+  };
+  // 用 recvmmsg 收取直到没有数据
+  static void drain_(Receiver& receiver);
+
+  std::vector<std::unique_ptr<Receiver>> receivers_;
+  std::unique_ptr<EventManager> event_manager_;
+};
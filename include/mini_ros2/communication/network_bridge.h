@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "mini_ros2/communication/comm_adapter.h"
+#include "mini_ros2/communication/shm_manager.h"
+#include "mini_ros2/communication/socket_comm.h"
+#include "mini_ros2/communication/tcp_comm.h"
+
+// 单机的网络出口：节点只走共享内存，本机只有桥进程（mini_ros2_bridge）打开套接字
+// - 导出：按允许列表扫描本地分区的注册表，新出现的匹配 topic 自动经 CommGateway 导出；
+//   同一轮的小消息合并成少量报文发出，可按 topic 限速（只保留最新一条）
+// - 导入：远端 topic 匹配允许列表时写入本地分区的同名数据段，本地订阅者照常走共享内存
+// 允许列表使用 fnmatch 通配符，匹配不含分区前缀的 "<topic>_<event>"，如 "robot1_*_data"
+// 不能组播的链路（VPN、容器）改用 TCP 传输：与 peers 各保持一条常驻连接
+
+#define NETWORK_BRIDGE_SCAN_MS 100
+
+// 名字匹配 pattern 的导出 topic 每秒最多发出 max_hz 条
+struct RateRule {
+  std::string pattern;
+  double max_hz = 0;
+};
+
+struct NetworkBridgeConfig {
+  RegistryConfig local = RegistryConfig::fromEnv();
+  UdpCommConfig transport;
+  // 使用 TCP 传输（tcp_transport）代替 UDP；peers 同时作为 TCP 的常驻连接对端
+  bool use_tcp = false;
+  TcpCommConfig tcp_transport;
+  std::vector<std::string> export_patterns;
+  std::vector<std::string> import_patterns;
+  // 导出发往的对端；为空时组播到 transport 的组
+  std::vector<CommEndpoint> peers;
+  // 按顺序取第一条匹配的规则，没有匹配时不限速
+  std::vector<RateRule> rate_limits;
+  // 匹配的导出 topic 使用可靠传输（NACK 重发），如跨主机的命令 topic
+  std::vector<std::string> reliable_patterns;
+  // 注册表代数变化的检查间隔
+  uint64_t scan_interval_ms = NETWORK_BRIDGE_SCAN_MS;
+};
+
+class NetworkBridge {
+ public:
+  explicit NetworkBridge(const NetworkBridgeConfig& config);
+  ~NetworkBridge();
+  NetworkBridge(const NetworkBridge&) = delete;
+  NetworkBridge& operator=(const NetworkBridge&) = delete;
+
+  // 扫描本地注册表，为新出现的匹配 topic 建立导出，返回新增的导出数
+  // 注册表代数未变化时直接返回 0
+  size_t refresh();
+
+  // 启动网关（接收、导出线程）和注册表扫描线程
+  void start();
+  void stop();
+
+  // 已导出的 "<topic>_<event>"（不含分区前缀）
+  std::vector<std::string> exportedTopics();
+  CommGateway& gateway() { return *gateway_; }
+  CommStats getStats() { return gateway_->getStats(); }
+
+ private:
+  static bool matches_(const std::vector<std::string>& patterns,
+                       const std::string& name);
+  double rateFor_(const std::string& name) const;
+  void scanLoop_();
+
+  NetworkBridgeConfig config_;
+  std::unique_ptr<CommGateway> gateway_;
+  std::string prefix_;
+  uint64_t scanned_generation_ = 0;
+  std::unordered_set<std::string> exported_;
+  std::mutex mutex_;
+  std::thread scan_thread_;
+  std::atomic<bool> running_ = false;
+};
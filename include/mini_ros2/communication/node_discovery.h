@@ -0,0 +1,199 @@
+#pragma once
+#include <netinet/in.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mini_ros2/communication/comm_adapter.h"
+#include "mini_ros2/communication/io_engine.h"
+
+// 去中心化的跨主机发现（参考 DDS SPDP）：每个参与者（进程 / 网关）定期向组播组
+// 宣告自己的单播地址和端点（发布 / 订阅的 topic），不需要 RegistryServer
+// - 宣告带版本号（revision）。首次和被请求时发送全量状态，之后只发送增量
+//   （base_revision -> revision 之间的增删），没有变化时发送不带内容的心跳
+// - 状态稳定后宣告周期从 initial_period_ms 指数退避到 max_period_ms；
+//   本地端点变化时回到初始周期
+// - 接收端发现版本断档（丢了增量）或收到未知参与者的心跳时，组播请求该参与者的
+//   全量状态；新加入的参与者请求所有人的全量状态
+// - 参与者带租期，超过租期没有收到任何宣告视为离开；正常退出时发送 Bye
+
+#define DISCOVERY_MAGIC 0x4D525344  // "MRSD"
+#define DISCOVERY_VERSION 1
+// 全量状态按该大小拆成多个报文，避免 IP 分片
+#define DISCOVERY_MAX_DATAGRAM 1400
+// 同一参与者的全量请求 / 应答的最小间隔
+#define DISCOVERY_REQUEST_INTERVAL_MS 100
+
+enum class DiscoveryMessage : uint8_t {
+  Full = 1,     // 全量状态的一部分：part 0 带名字和地址，之后每部分带一批端点
+  Delta = 2,    // base_revision -> revision 的增删；没有内容时为心跳
+  Request = 3,  // 请求全量状态，负载为目标参与者 id（0 表示所有人）
+  Bye = 4,      // 正常退出
+};
+
+// 线上报文头，多字节字段为网络字节序；负载中的字符串为 uint16 长度 + 内容
+struct __attribute__((packed)) DiscoveryHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t type;
+  uint16_t count;  // 本报文中的端点 / 增删条目数
+  uint64_t participant_id;
+  uint32_t revision;
+  uint32_t base_revision;
+  uint32_t lease_ms;
+  uint16_t part;   // Full：第几部分
+  uint16_t parts;  // Full：共几部分
+};
+
+enum class EndpointKind : uint8_t { Publisher = 1, Subscriber = 2 };
+
+struct DiscoveredEndpoint {
+  EndpointKind kind;
+  std::string topic;
+  std::string event;
+
+  bool operator==(const DiscoveredEndpoint& other) const {
+    return kind == other.kind && topic == other.topic && event == other.event;
+  }
+};
+
+struct DiscoveredParticipant {
+  uint64_t id = 0;
+  std::string name;
+  CommEndpoint locator;  // 参与者的单播地址（如 CommAdapter::localEndpoint()）
+  uint32_t revision = 0;
+  uint32_t lease_ms = 0;
+  std::vector<DiscoveredEndpoint> endpoints;
+};
+
+enum class DiscoveryEventType {
+  ParticipantDiscovered,
+  ParticipantLost,  // 租期到期或收到 Bye
+  EndpointAdded,
+  EndpointRemoved,
+};
+
+struct DiscoveryEvent {
+  DiscoveryEventType type;
+  uint64_t participant_id;
+  std::string participant_name;
+  DiscoveredEndpoint endpoint;  // 只对 EndpointAdded / EndpointRemoved 有效
+};
+
+struct DiscoveryConfig {
+  std::string name;  // 参与者名，只用于显示
+  std::string multicast_group = "239.255.0.1";
+  uint16_t port = 7399;
+  // 组播收发使用的本机接口地址；单机测试用 127.0.0.1，跨主机时改为网卡地址
+  std::string interface_address = "0.0.0.0";
+  int multicast_ttl = 1;
+  CommEndpoint locator;  // 宣告给其他参与者的单播地址
+  uint64_t initial_period_ms = 100;
+  uint64_t max_period_ms = 2000;
+  // 应大于 max_period_ms 的数倍，丢一两个心跳不至于被判定离开
+  uint64_t lease_ms = 10000;
+  IoBackend io_backend = ioBackendFromEnv();
+};
+
+struct DiscoveryStats {
+  uint64_t full_sent = 0;      // 发出的全量报文数（含拆分的各部分）
+  uint64_t deltas_sent = 0;    // 发出的增量报文数（不含心跳）
+  uint64_t heartbeats_sent = 0;
+  uint64_t requests_sent = 0;
+  uint64_t bytes_sent = 0;
+  uint64_t received = 0;       // 收到的其他参与者的报文数
+};
+
+class NodeDiscovery {
+ public:
+  using Listener = std::function<void(const DiscoveryEvent&)>;
+
+  explicit NodeDiscovery(const DiscoveryConfig& config);
+  ~NodeDiscovery();
+  NodeDiscovery(const NodeDiscovery&) = delete;
+  NodeDiscovery& operator=(const NodeDiscovery&) = delete;
+
+  uint64_t participantId() const { return participant_id_; }
+
+  // 本地端点增删，下一个周期内以增量宣告；重复添加 / 删除不存在的端点时忽略
+  void addEndpoint(EndpointKind kind, const std::string& topic,
+                   const std::string& event);
+  void removeEndpoint(EndpointKind kind, const std::string& topic,
+                      const std::string& event);
+
+  // 在接收线程中回调，回调中不要调用 stop()
+  void setListener(Listener listener);
+
+  // 宣告自己并请求其他参与者的全量状态
+  void start();
+  // 发送 Bye 并停止；goodbye 为 false 时模拟崩溃（只用于测试租期）
+  void stop(bool goodbye = true);
+
+  std::vector<DiscoveredParticipant> participants();
+  DiscoveryStats getStats();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Change {
+    bool added;
+    DiscoveredEndpoint endpoint;
+  };
+  struct Remote {
+    DiscoveredParticipant info;
+    bool complete = false;  // 是否已收齐一次全量状态
+    Clock::time_point last_seen;
+    Clock::time_point last_request;
+    // 正在接收的全量状态
+    uint32_t full_revision = 0;
+    std::vector<bool> full_parts;
+    std::vector<DiscoveredEndpoint> full_endpoints;
+  };
+
+  void tick_();
+  void receive_(const uint8_t* data, size_t size);
+  void handleFull_(const DiscoveryHeader& header, const uint8_t* payload,
+                   size_t size);
+  void handleDelta_(const DiscoveryHeader& header, const uint8_t* payload,
+                    size_t size);
+  // 发出报文时持有 mutex_，回调在释放锁后执行
+  void sendFull_();
+  void sendDelta_();
+  void sendRequest_(uint64_t target);
+  void sendBye_();
+  void sendPackets_(std::vector<std::vector<uint8_t>>& packets);
+  std::vector<uint8_t> header_(DiscoveryMessage type, uint16_t count,
+                               uint32_t base_revision) const;
+  void requestFull_(Remote& remote, uint64_t id);
+  void emit_(DiscoveryEventType type, const Remote& remote,
+             const DiscoveredEndpoint* endpoint = nullptr);
+  void flushEvents_();
+
+  DiscoveryConfig config_;
+  uint64_t participant_id_;
+  int fd_ = -1;
+  sockaddr_in group_addr_;
+  std::unique_ptr<IoEngine> engine_;
+
+  std::mutex mutex_;
+  std::vector<DiscoveredEndpoint> endpoints_;
+  uint32_t revision_ = 1;
+  uint32_t announced_revision_ = 0;  // 0：还没有发过全量状态
+  std::vector<Change> pending_;      // announced_revision_ 之后的变化
+  uint64_t period_ms_;
+  Clock::time_point next_announce_;
+  bool full_requested_ = false;
+  Clock::time_point last_full_;
+  std::unordered_map<uint64_t, Remote> remotes_;
+  std::vector<DiscoveryEvent> events_;  // 待回调的事件
+  Listener listener_;
+  DiscoveryStats stats_;
+  std::atomic<bool> running_ = false;
+};
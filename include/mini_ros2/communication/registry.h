@@ -0,0 +1,186 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// 跨主机发现用的注册服务：节点名 -> 地址（如 CommAdapter 的单播端点）
+// 服务端是单线程 epoll 事件循环，连接常驻，一个连接上可以连续发出多个请求（流水线），
+// 回复按请求顺序返回；WATCH 之后该连接持续收到图变化通知
+// 注册归属于发起注册的连接，连接断开（节点退出或崩溃）时自动注销并通知观察者
+
+#define REGISTRY_MAGIC 0x4D525247  // "MRRG"
+#define REGISTRY_VERSION 1
+#define REGISTRY_DEFAULT_PORT 8080
+// 单帧负载上限，超过视为协议错误并断开连接
+#define REGISTRY_MAX_PAYLOAD (64 * 1024)
+// 单个连接待发送数据上限：超过后暂停读取该连接的请求；观察者超过时断开，
+// 避免不读通知的连接拖住服务端内存
+#define REGISTRY_MAX_PENDING_OUTPUT (4 * 1024 * 1024)
+
+// 请求 0x01 起，回复和通知 0x80 起
+enum class RegistryOp : uint8_t {
+  Register = 0x01,    // name, address -> Ok
+  Unregister = 0x02,  // name -> Ok / NotFound
+  Lookup = 0x03,      // name -> Entries（一项）/ NotFound
+  List = 0x04,        // -> Entries
+  Watch = 0x05,       // -> Entries（当前快照），之后推送 Notify
+  Ok = 0x80,          // version
+  NotFound = 0x81,    // version
+  Entries = 0x82,     // version, count, (name, address) * count
+  Notify = 0x83,      // version, added, name, address；request_id 为 0
+  Error = 0x84,       // message
+};
+
+// 线上帧头，多字节字段为网络字节序；负载中的字符串为 uint16 长度 + 内容
+struct __attribute__((packed)) RegistryFrameHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t op;
+  uint16_t reserved;
+  uint32_t request_id;  // 回复带回请求的 id
+  uint32_t length;      // 负载长度，不含帧头
+};
+
+struct RegistryEntry {
+  std::string name;
+  std::string address;
+};
+
+// 图变化通知；version 为变化后的图版本，每次注册 / 注销加一
+struct RegistryNotification {
+  bool added = false;  // false 为注销（含连接断开时的自动注销）
+  uint64_t version = 0;
+  RegistryEntry entry;
+};
+
+struct RegistryServerStats {
+  uint64_t accepted = 0;      // 累计接受的连接数
+  uint64_t connections = 0;   // 当前连接数
+  uint64_t requests = 0;      // 处理的请求帧数
+  uint64_t entries = 0;       // 当前注册的节点数
+  uint64_t notifications = 0; // 推送给观察者的通知帧数
+  uint64_t errors = 0;        // 因协议错误或积压断开的连接数
+};
+
+class RegistryServer {
+ public:
+  // port 为 0 时由内核分配，实际端口见 port()
+  explicit RegistryServer(uint16_t port = REGISTRY_DEFAULT_PORT,
+                          const std::string& address = "0.0.0.0");
+  ~RegistryServer();
+  RegistryServer(const RegistryServer&) = delete;
+  RegistryServer& operator=(const RegistryServer&) = delete;
+
+  uint16_t port() const { return port_; }
+
+  // 在调用线程中运行事件循环，直到 stop()
+  void run();
+  // 在后台线程中运行事件循环
+  void start();
+  // 可在任意线程调用
+  void stop();
+
+  RegistryServerStats getStats() const;
+
+ private:
+  struct Connection {
+    uint64_t id;
+    int fd;
+    std::vector<uint8_t> input;
+    size_t input_offset = 0;  // 已解析的字节数
+    std::vector<uint8_t> output;
+    size_t output_offset = 0;  // 已发出的字节数
+    bool dirty = false;           // 是否已在 dirty_ 中
+    uint32_t events = 0;          // 当前在 epoll 中关注的事件
+    std::unordered_set<std::string> owned;  // 本连接注册的节点名
+  };
+  struct Entry {
+    std::string address;
+    uint64_t owner;  // 注册连接的 id
+  };
+
+  void acceptAll_();
+  // 读到 EAGAIN 并处理所有完整的帧；返回 false 表示连接应关闭
+  bool readConnection_(Connection& conn);
+  // 处理已读入的完整帧，回复积压超过上限时暂停
+  bool processInput_(Connection& conn);
+  void handleFrame_(Connection& conn, const RegistryFrameHeader& header,
+                    const uint8_t* payload, size_t size);
+  void reply_(Connection& conn, RegistryOp op, uint32_t request_id,
+              const std::vector<uint8_t>& payload);
+  void notifyWatchers_(bool added, const std::string& name,
+                       const std::string& address);
+  void appendEntries_(std::vector<uint8_t>& payload,
+                      const std::string* only_name);
+  // 尽量发出待发送数据，发不完时等待 EPOLLOUT；返回 false 表示连接应关闭
+  bool flush_(Connection& conn);
+  void closeConnection_(uint64_t id);
+
+  int listen_fd_ = -1;
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;  // eventfd，stop() 时唤醒事件循环
+  uint16_t port_ = 0;
+  uint64_t next_connection_id_ = 1;
+  uint64_t graph_version_ = 0;
+  // 以下只在事件循环线程中访问；连接 id 不复用，旧事件不会落到新连接上
+  std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections_;
+  std::unordered_map<std::string, Entry> entries_;
+  std::unordered_set<uint64_t> watchers_;
+  std::vector<uint64_t> dirty_;  // 本轮追加了输出、待发送的连接
+  // 统计由事件循环线程更新，其他线程读取
+  std::atomic<uint64_t> stats_accepted_ = 0;
+  std::atomic<uint64_t> stats_connections_ = 0;
+  std::atomic<uint64_t> stats_requests_ = 0;
+  std::atomic<uint64_t> stats_entries_ = 0;
+  std::atomic<uint64_t> stats_notifications_ = 0;
+  std::atomic<uint64_t> stats_errors_ = 0;
+  std::thread thread_;
+};
+
+// 阻塞式客户端，一个连接；不是线程安全的
+// 同步请求等待自己的回复，期间收到的通知排队，由 waitNotification 取出
+class RegistryClient {
+ public:
+  RegistryClient(const std::string& host, uint16_t port);
+  ~RegistryClient();
+  RegistryClient(const RegistryClient&) = delete;
+  RegistryClient& operator=(const RegistryClient&) = delete;
+
+  // 返回注册后的图版本；失败时抛 std::runtime_error
+  uint64_t registerNode(const std::string& name, const std::string& address);
+  // 流水线注册：一次写出所有请求再依次读取回复，返回成功的个数
+  size_t registerNodes(const std::vector<RegistryEntry>& entries);
+  bool unregisterNode(const std::string& name);
+  bool lookup(const std::string& name, std::string& address);
+  std::vector<RegistryEntry> list(uint64_t* version = nullptr);
+  // 订阅图变化：返回当前快照，之后的变化通过 waitNotification 取出
+  std::vector<RegistryEntry> watch(uint64_t* version = nullptr);
+  bool waitNotification(RegistryNotification& notification, int timeout_ms);
+
+ private:
+  struct Frame {
+    RegistryOp op;
+    uint32_t request_id;
+    std::vector<uint8_t> payload;
+  };
+
+  uint32_t queueRequest_(RegistryOp op, const std::vector<uint8_t>& payload);
+  void flush_();
+  // 读一帧；timeout_ms < 0 时一直等待，超时返回 false
+  bool readFrame_(Frame& frame, int timeout_ms);
+  // 读到 request_id 的回复为止，其间的通知放入 notifications_
+  Frame waitReply_(uint32_t request_id);
+
+  int fd_ = -1;
+  uint32_t next_request_id_ = 1;
+  std::vector<uint8_t> output_;
+  std::vector<uint8_t> input_;
+  size_t input_offset_ = 0;
+  std::deque<RegistryNotification> notifications_;
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+// 进程间共享互斥锁 / 条件变量的公共初始化与加锁逻辑
+// 互斥锁使用 PTHREAD_MUTEX_ROBUST：持锁进程被杀死后，下一个加锁者收到 EOWNERDEAD，
+// 在这里调用 pthread_mutex_consistent 恢复锁，并通过返回值通知调用者修复受保护的数据
+
+// 初始化进程间共享的 robust 互斥锁，失败抛 std::runtime_error
+void initRobustMutex(pthread_mutex_t* mutex);
+
+// 初始化进程间共享的条件变量，失败抛 std::runtime_error
+void initSharedCond(pthread_cond_t* cond);
+
+// 加锁；返回 true 表示上一个持锁者已死亡，锁已恢复，受保护的数据可能只写了一半
+// 锁已不可恢复（ENOTRECOVERABLE）或其他错误时抛 std::runtime_error
+bool robustLock(pthread_mutex_t* mutex);
+
+// 等待条件变量，返回 true 表示等待期间持锁者已死亡，锁已恢复
+bool robustWait(pthread_cond_t* cond, pthread_mutex_t* mutex);
+
+// 带超时等待条件变量，返回 0 或 ETIMEDOUT；等待期间持锁者死亡时 *owner_died 置为 true
+// 返回时总是持有锁
+int robustTimedWait(pthread_cond_t* cond, pthread_mutex_t* mutex,
+                    const struct timespec& abstime, bool* owner_died);
+
+// 当前时间（CLOCK_REALTIME）之后 timeout_ms 毫秒的绝对时间
+struct timespec deadlineAfterMs(uint64_t timeout_ms);
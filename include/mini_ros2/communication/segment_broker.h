@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "mini_ros2/communication/shm_base.h"
+
+// 本机数据段代理：topic 数据段改为匿名 memfd，描述符经 Unix 套接字（SCM_RIGHTS）传递
+// - 数据段不在 /dev/shm 中留下名字，最后一个进程关闭描述符和映射时由内核释放，
+//   进程崩溃后不需要 clear_shm.sh 清理
+// - 代理监听抽象命名空间的 Unix 套接字（"\0<name>"），不占用文件系统路径；
+//   可以是单独的守护进程（mini_ros2_segd），也可以由发布者进程内的 SegmentBroker 承担
+// - 发布者登记（Offer）数据段，订阅者按 "<topic>_<event>" 取得（Fetch）描述符后直接映射
+// - 登记归属于发起登记的连接，所有登记者断开后代理释放自己持有的描述符；
+//   已映射的订阅者不受影响，映射一直有效到它们关闭为止
+
+#define SEGMENT_BROKER_MAGIC 0x4D525347  // "MRSG"
+#define SEGMENT_BROKER_VERSION 1
+#define SEGMENT_BROKER_DEFAULT_NAME "miniros2_segments"
+// 设置为代理名时 topic 数据段走代理（匿名段），未设置时使用 /dev/shm 命名段
+#define SEGMENT_BROKER_ENV "MINIROS2_SEGMENT_BROKER"
+#define SEGMENT_BROKER_MAX_NAME 1024
+
+enum class SegmentOp : uint8_t {
+  Offer = 0x01,     // name, size + 描述符 -> Segment（同名段已存在时为已有的段）
+  Fetch = 0x02,     // name -> Segment / NotFound
+  Withdraw = 0x03,  // name -> Ok / NotFound
+  Segment = 0x80,   // size + 描述符
+  NotFound = 0x81,
+  Ok = 0x82,
+  Error = 0x83,
+};
+
+// SOCK_SEQPACKET 报文：消息头 + name；只在本机传递，字段为主机字节序
+struct __attribute__((packed)) SegmentMessage {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t op;
+  uint16_t name_length;
+  uint64_t size;  // 数据段总大小（含 ShmHead）
+};
+
+struct SegmentBrokerStats {
+  uint64_t accepted = 0;     // 累计接受的连接数
+  uint64_t connections = 0;  // 当前连接数
+  uint64_t offers = 0;
+  uint64_t fetches = 0;
+  uint64_t segments = 0;  // 当前持有的数据段数
+  uint64_t errors = 0;    // 因协议错误断开的连接数
+};
+
+class SegmentBroker {
+ public:
+  explicit SegmentBroker(const std::string& name = SEGMENT_BROKER_DEFAULT_NAME);
+  ~SegmentBroker();
+  SegmentBroker(const SegmentBroker&) = delete;
+  SegmentBroker& operator=(const SegmentBroker&) = delete;
+
+  const std::string& name() const { return name_; }
+
+  // 在调用线程中运行事件循环，直到 stop()
+  void run();
+  // 在后台线程中运行事件循环
+  void start();
+  // 可在任意线程调用
+  void stop();
+
+  SegmentBrokerStats getStats() const;
+
+ private:
+  struct Segment {
+    int fd;
+    uint64_t size;
+    std::unordered_set<uint64_t> owners;  // 登记了该段的连接 id
+  };
+
+  void acceptAll_();
+  // 返回 false 表示连接应关闭
+  bool handleConnection_(uint64_t id, int fd);
+  void release_(const std::string& name, uint64_t owner);
+  void closeConnection_(uint64_t id);
+
+  std::string name_;
+  int listen_fd_ = -1;
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;  // eventfd，stop() 时唤醒事件循环
+  uint64_t next_connection_id_ = 1;
+  // 以下只在事件循环线程中访问
+  std::unordered_map<uint64_t, int> connections_;  // 连接 id -> fd
+  std::unordered_map<uint64_t, std::unordered_set<std::string>> owned_;
+  std::unordered_map<std::string, Segment> segments_;
+  std::atomic<uint64_t> stats_accepted_ = 0;
+  std::atomic<uint64_t> stats_connections_ = 0;
+  std::atomic<uint64_t> stats_offers_ = 0;
+  std::atomic<uint64_t> stats_fetches_ = 0;
+  std::atomic<uint64_t> stats_segments_ = 0;
+  std::atomic<uint64_t> stats_errors_ = 0;
+  std::thread thread_;
+};
+
+// 阻塞式客户端，一个连接；不是线程安全的
+// 连接保持到析构：连接断开后代理不再提供本连接登记的数据段
+class SegmentClient {
+ public:
+  explicit SegmentClient(const std::string& name = SEGMENT_BROKER_DEFAULT_NAME);
+  ~SegmentClient();
+  SegmentClient(const SegmentClient&) = delete;
+  SegmentClient& operator=(const SegmentClient&) = delete;
+
+  // 登记匿名段；同名段已被登记时返回代理中已有的段（调用者应改用它），
+  // 否则返回 segment。失败时抛 std::runtime_error
+  std::shared_ptr<ShmBase> offer(const std::string& name,
+                                 std::shared_ptr<ShmBase> segment);
+  // 取得并映射同名段，不存在时返回 nullptr
+  std::shared_ptr<ShmBase> fetch(const std::string& name);
+  // 撤销本连接的登记，返回是否登记过
+  bool withdraw(const std::string& name);
+
+ private:
+  void request_(SegmentOp op, const std::string& name, uint64_t size,
+                int send_fd);
+  // 读取回复，回复带描述符时写入 received_fd，否则为 -1
+  SegmentOp reply_(uint64_t& size, int& received_fd);
+
+  int fd_ = -1;
+};
+
+// 读取 MINIROS2_SEGMENT_BROKER，未设置时返回空串（使用命名段）
+std::string segmentBrokerFromEnv();
+
+// 以下按 MINIROS2_SEGMENT_BROKER 选择命名段或匿名段，供发布者、订阅者、桥、网关使用
+// 进程内共用一个到代理的连接（fork 后的子进程重新连接）
+
+// 创建并初始化 "<topic>_<event>" 数据段，data_size 为数据区大小；
+// 匿名段模式下同名段已被其他进程登记时返回已有的段
+std::shared_ptr<ShmBase> createTopicSegment(const std::string& shm_name,
+                                            size_t data_size);
+// 打开已初始化的数据段，不存在或尚未初始化时返回 nullptr
+std::shared_ptr<ShmBase> attachTopicSegment(const std::string& shm_name);
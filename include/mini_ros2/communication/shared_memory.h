@@ -35,12 +35,23 @@ public:
     // 2. 获取共享内存文件状态（包含大小）
     struct stat shm_stat;
     if (fstat(shm_fd, &shm_stat) == -1) {
-      throw std::invalid_argument("Can not get Stat");
       ::close(shm_fd);
+      throw std::invalid_argument("Can not get Stat");
     }
+    ::close(shm_fd);  // 只用于获取大小，Open() 时重新打开
     size_ = shm_stat.st_size; // 共享内存大小
     //初始化元信息不执行系统调用,延迟资源获取
   };
+  // 匿名段（memfd）：不在 /dev/shm 中留下名字，name 只作为调试标签
+  // fd 为 -1 时由 Create() 创建；否则接管 fd（如经 Unix 套接字收到的描述符），
+  // size 为该段的大小，Open() 直接映射
+  SharedMemory(std::string name, size_t size, int fd)
+      : name_(name), size_(size), fd_(fd), data_(nullptr), is_owner_(false),
+        anonymous_(true) {
+    if (size_ == 0) {
+      throw std::invalid_argument("Invalid size for anonymous SharedMemory");
+    }
+  }
   ~SharedMemory();
 
   bool Create();       //创建共享内存
@@ -51,6 +62,11 @@ public:
   bool Unlink(); //删除共享内存
   size_t Size() const { return size_; }
   bool IsOwner() const { return is_owner_; } //检查是否是共享内存的创建者
+  bool IsAnonymous() const { return anonymous_; }
+  // 匿名段的文件描述符，用于传给其他进程；命名段未打开时为 -1
+  int Fd() const { return fd_; }
+  // 放弃所有权：析构时不再 Unlink，生命周期交由其他对象管理（如链式扩展段）
+  void ReleaseOwnership() { is_owner_ = false; }
 
   // 引用计数相关
   bool IncrementRefCount(); // 增加引用计数
@@ -58,9 +74,12 @@ public:
   int GetRefCount();        // 获取当前引用计数
 
 private:
+  bool CreateAnonymous_();
+
   std::string name_; //共享内存名称
   size_t size_;      //共享内存大小
   int fd_;           //文件描述符
   void *data_;       //指向共享内存的指针
   bool is_owner_;    //是否是创建者
+  bool anonymous_ = false;  // memfd 段：最后一个描述符和映射关闭时由内核释放
 };
\ No newline at end of file
@@ -3,14 +3,20 @@
 
 #include <chrono>
 #include <cstring>
+#include <functional>
+#include <memory>
 #include <stdexcept>
 #include <string>
 
 #include "mysemaphore.h"
+#include "robust_mutex.h"
 #include "shared_memory.h"
 
-struct ShmHead {
+// 按缓存行对齐，使紧随其后的数据区满足 SIMD 消息类型的对齐要求
+struct alignas(64) ShmHead {
   uint32_t initialized_;  // 初始化标志：0x4D525332 = "MRS2" (MiniROS2)
+  // 写入期间为 1；写者在写入中途被杀死时保持为 1，读者据此丢弃残缺消息
+  uint32_t dirty_;
   pthread_mutex_t mutex_;
   pthread_cond_t cond_;
   uint64_t time_;
@@ -33,11 +39,23 @@ class ShmBase {
   ShmBase(const std::string& name) : name_(name), shm_(name) {
     total_size_ = shm_.Size();
     offset_ = sizeof(ShmHead);
-    data_size_ = total_size_ - offset_;
+    data_size_ = total_size_ > offset_ ? total_size_ - offset_ : 0;
   }
 
+  // 匿名数据段（memfd，见 segment_broker.h）：创建并初始化锁，data_size 为数据区大小
+  static std::shared_ptr<ShmBase> createAnonymous(const std::string& name,
+                                                  size_t data_size);
+  // 接管其他进程传来的匿名段描述符并映射，大小取自 fstat；
+  // 大小未封住或锁尚未初始化时关闭 fd 并返回 nullptr
+  static std::shared_ptr<ShmBase> adoptAnonymous(const std::string& name,
+                                                 int fd);
+
   void Create();
   bool Exists() const;  // 检查共享内存是否存在
+  bool IsAnonymous() const { return shm_.IsAnonymous(); }
+  // 匿名段的描述符，传给其他进程时使用
+  int getFd() const { return shm_.Fd(); }
+  bool IsOwner() const { return shm_.IsOwner(); }
   void Open() {
     if (!shm_.Open()) {
       throw std::runtime_error("Failed to open shared memory");
@@ -61,21 +79,46 @@ class ShmBase {
     //   throw std::runtime_error("Failed to open semaphore");
     // }
   }
+  // 订阅端使用：只映射创建者已初始化完成的共享内存，不初始化锁；未就绪时返回 false
+  bool OpenInitialized();
+
   void Write(const void* data, size_t size, size_t offset = 0);
 
   // 内部写入方法：假设调用者已经持有锁（用于避免双重锁）
   void WriteUnlocked(const void* data, size_t size, size_t offset = 0);
 
+  // 数据区残缺（上一个写者写入中途崩溃，尚未被新的写入覆盖）时抛 std::runtime_error
   void Read(void* buffer, size_t size, size_t offset = 0);
 
   void ReadUnlocked(void* buffer, size_t size, size_t offset = 0);
 
+  // 借出数据区：持锁期间由 writer 直接在共享内存中构造消息（零拷贝发布）
+  // writer 参数为数据区指针和容量，返回实际写入字节数
+  size_t Loan(const std::function<size_t(uint8_t*, size_t)>& writer);
+
+  // 借阅数据区（只读）：持锁期间由 reader 直接读取共享内存中的消息，不拷贝
+  // （如直接作为 sendmsg 的 iovec 发出），返回该消息的写入时间戳
+  // 数据区残缺时与 Read 相同抛 std::runtime_error
+  uint64_t View(const std::function<void(const uint8_t*, size_t)>& reader);
+
+  // 数据区指针，调用者需持有锁（用于就地读写，如 FlatMessage::rootOf、注册表）
+  const uint8_t* DataUnlocked() const {
+    return reinterpret_cast<const uint8_t*>(data_ptr_);
+  }
+  uint8_t* DataUnlocked() { return reinterpret_cast<uint8_t*>(data_ptr_); }
+
   void Close();
 
   size_t getSize() const { return total_size_; }
 
   size_t getDataSize() const { return data_size_; }
 
+  // 最近一次写入的时间戳（微秒），不加锁读取，用于判断数据区是否有新消息
+  uint64_t lastWriteTime() const {
+    return time_ptr_ == nullptr ? 0
+                                : __atomic_load_n(time_ptr_, __ATOMIC_ACQUIRE);
+  }
+
   std::string getShmName() {
     if (name_.empty()) {
       throw std::runtime_error("shm do not init");
@@ -84,10 +127,20 @@ class ShmBase {
   }
   void initMutexAndCond();
 
+  // 持锁进程崩溃后，下一个拿到锁的进程在持锁状态下调用 handler 修复数据区
+  // handler 内不能再对本共享内存加锁
+  void setOwnerDeadHandler(std::function<void()> handler) {
+    owner_dead_handler_ = std::move(handler);
+  }
+
   void shmBaseLock() {
-    int ret = pthread_mutex_lock(mutex_ptr_);
-    if (ret != 0) {
-      throw std::runtime_error("获取互斥锁失败：" + std::string(strerror(ret)));
+    if (robustLock(mutex_ptr_)) {
+      try {
+        handleOwnerDead_();
+      } catch (...) {
+        pthread_mutex_unlock(mutex_ptr_);
+        throw;
+      }
     }
   }
 
@@ -99,21 +152,19 @@ class ShmBase {
     }
   }
 
-  void shmBaseWait() { pthread_cond_wait(cond_ptr_, mutex_ptr_); }
+  void shmBaseWait() {
+    if (robustWait(cond_ptr_, mutex_ptr_)) {
+      handleOwnerDead_();
+    }
+  }
 
   void shmBaseWaitTimeOut(uint timeout_ms) {
-    struct timespec abstime;
-    clock_gettime(CLOCK_REALTIME, &abstime);
-    abstime.tv_sec += timeout_ms / 1000;
-    abstime.tv_nsec += (timeout_ms % 1000) * 1000000;
-    // std::cout << "shmBaseWaitTimeOut: " << timeout_ms << std::endl;
-    int ret = pthread_cond_timedwait(cond_ptr_, mutex_ptr_, &abstime);
-    // if (ret == ETIMEDOUT) {
-    //   return;
-    // } else if (ret != 0) {
-    //   throw std::runtime_error("条件变量等待失败：" +
-    //                            std::string(strerror(ret)));
-    // }
+    bool owner_died = false;
+    robustTimedWait(cond_ptr_, mutex_ptr_, deadlineAfterMs(timeout_ms),
+                    &owner_died);
+    if (owner_died) {
+      handleOwnerDead_();
+    }
   }
 
   void shmBaseSignal() { pthread_cond_signal(cond_ptr_); }
@@ -121,7 +172,16 @@ class ShmBase {
   void shmBaseBroadcast() { pthread_cond_broadcast(cond_ptr_); }
 
  private:
+  // 匿名段：fd 为 -1 时创建，否则接管，total_size 含 ShmHead
+  ShmBase(const std::string& name, size_t total_size, int fd)
+      : name_(name),
+        offset_(sizeof(ShmHead)),
+        data_size_(total_size - offset_),
+        total_size_(total_size),
+        shm_(name, total_size, fd) {}
+
   void CachePointers(ShmHead* head);
+  void handleOwnerDead_();
   // MySemaphore sem_;
   std::string name_;
   size_t offset_;
@@ -132,5 +192,25 @@ class ShmBase {
   pthread_mutex_t* mutex_ptr_ = nullptr;
   pthread_cond_t* cond_ptr_ = nullptr;
   uint64_t* time_ptr_ = nullptr;
+  uint32_t* dirty_ptr_ = nullptr;
   char* data_ptr_;
-};
\ No newline at end of file
+  std::function<void()> owner_dead_handler_;
+};
+
+// RAII 形式的共享内存锁：作用域结束或异常时自动释放
+class ShmBaseLockGuard {
+ public:
+  explicit ShmBaseLockGuard(ShmBase& shm) : shm_(shm) { shm_.shmBaseLock(); }
+  ~ShmBaseLockGuard() {
+    try {
+      shm_.shmBaseUnlock();
+    } catch (const std::exception&) {
+      // 析构函数中不抛异常
+    }
+  }
+  ShmBaseLockGuard(const ShmBaseLockGuard&) = delete;
+  ShmBaseLockGuard& operator=(const ShmBaseLockGuard&) = delete;
+
+ private:
+  ShmBase& shm_;
+};
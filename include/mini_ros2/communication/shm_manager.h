@@ -1,32 +1,60 @@
+#pragma once
 #include <pthread.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 
 #include "mini_ros2/communication/event_notification_shm.h"
 #include "mini_ros2/communication/shm_base.h"
-#include "mini_ros2/message/json.h"
 
 #define MAX_TOPICS_PER_NODE EVENT_MAX_COUNT
-#define MAX_NODE_COUNT 16
+#define MAX_NODE_COUNT 16  // 默认每个节点段的槽位数
 #define MAX_NODE_NAME_LEN 64
 #define MAX_TOPIC_NAME_LEN 64
 #define SHM_MANAGER_NAME "/miniros2_dds_shm_manager"
-#define TOPIC_INFO_SIZE sizeof(TopicsInfo)
-#define NODE_INFO_SIZE sizeof(NodesInfo)
 #define MAX_SHM_MANGER_SIZE sizeof(ShmManagerInfo)
+// 注册表布局：二进制结构体直接放在共享内存中，各进程按字段原地读写，不再经过 JSON
+#define SHM_REGISTRY_MAGIC 0x47455232    // "2REG"
+// 1 JSON 文本，2 无序号，3 定长单段，4 无哈希索引，5 秒级心跳，6 无变化日志，
+// 7 无订阅计数
+#define SHM_REGISTRY_VERSION 8
+// seqlock 读者连续失败次数上限，超过后退回持锁读取（写者可能已崩溃）
+#define REGISTRY_READ_RETRY 1024
+// 节点表和 topic 表按段链式增长，段名为 "<基段名>.nodes.<k>" / ".topics.<k>"
+#define DEFAULT_TOPICS_PER_SEGMENT 128
+#define REGISTRY_MAX_SEGMENTS 64
+// topic 哈希索引（开放寻址，线性探测），段名为 "<基段名>.index.<v>"
+// 第 v 版容量为 TOPIC_INDEX_MIN_CAPACITY << (v - 1)，负载因子保持在 1/2 以下
+#define TOPIC_INDEX_MIN_CAPACITY 256
+// 启动时配置每段容量（仅创建注册表的进程生效，其余进程沿用已有布局）
+#define REGISTRY_NODES_ENV "MINIROS2_REGISTRY_NODES"
+#define REGISTRY_TOPICS_ENV "MINIROS2_REGISTRY_TOPICS"
+// 设为 1 时同一域内不同命名空间也使用独立的注册表和事件通知段
+#define REGISTRY_NAMESPACE_PARTITION_ENV "MINIROS2_NAMESPACE_PARTITION"
+// 第 0 块最高位事件保留为"注册表已变化"通知，不分配给 topic
+#define REGISTRY_CHANGED_EVENT_ID (EVENT_MAX_COUNT - 1)
+#define MAX_TOPIC_EVENT_COUNT (EVENT_MAX_CHUNKS * EVENT_MAX_COUNT - 1)
+// 心跳超过该时间未更新的节点在注册表扫描中视为失联
+#define NODE_HEARTBEAT_TIMEOUT_MS 3000
+// 图变化日志（环形缓冲区）条目数，落后超过该条数的读者退回全量同步
+#define REGISTRY_CHANGE_LOG_SIZE 256
+// 每个节点记录的订阅条目数；超出的订阅在节点崩溃后不会从订阅计数中扣除（发布者按有订阅者处理）
+#define NODE_MAX_TRACKED_SUBSCRIPTIONS 64
 
 struct TopicInfo {
   char name_[MAX_TOPIC_NAME_LEN];
   int event_id_;
-};
-
-struct TopicsInfo {
-  int topics_count;
-  TopicInfo topics[MAX_TOPICS_PER_NODE];
+  // 创建数据段 "/<topic>_<event>" 的节点，-1 表示无；该节点死亡后由回收者删除数据段
+  int owner_node_id_;
+  // 订阅该 topic+event 的节点数，发布者据此跳过无人订阅的发布；原子读写
+  int subscriber_count_;
 };
 
 struct NodeInfo {
@@ -35,30 +63,103 @@ struct NodeInfo {
   int pub_topic_count;
   int sub_topic_count;
   bool is_alive;
-  int last_heartbeat;
+  // CLOCK_MONOTONIC 毫秒（全机共享时钟），节点自己原子写入，0 表示尚未上报
+  uint64_t last_heartbeat;
+  // 进程启动时间（/proc/<pid>/stat 第 22 列），pid 被复用时与之不符
+  uint64_t start_time;
   char node_name[MAX_NODE_NAME_LEN];
+  // 本节点订阅的 topic 表下标 + 1（0 表示空），节点注销或被回收时据此扣除订阅计数
+  int32_t sub_topics[NODE_MAX_TRACKED_SUBSCRIPTIONS];
 };
 
-struct NodesInfo {
-  int nodes_count;
-  int alive_node_count;
-  NodeInfo nodes[MAX_NODE_COUNT];
+// 图变化类型；Resync 不写入日志，表示读者落后太多、已全量同步，需要重新扫描
+enum class GraphEventType : uint32_t {
+  Resync = 0,
+  NodeAdded,
+  NodeRemoved,
+  NodeUpdated,  // 名字、存活标志等其他节点字段
+  PublisherAdded,
+  PublisherRemoved,
+  SubscriberAdded,
+  SubscriberRemoved,
+  TopicAdded,    // 只注册了 topic+event，没有发布者 / 订阅者
+  TopicUpdated,  // 数据段归属变化
+};
+
+// 图变化日志条目：每个写区间为它修改的节点槽位 / topic 条目各追加一条
+struct GraphEvent {
+  uint64_t seq;         // 日志序号，从 1 开始
+  uint64_t generation;  // 写区间结束后的注册表序号，读者据此判断是否有未记录的修改
+  GraphEventType type;
+  int32_t node_id;      // -1 表示无
+  int32_t event_id;     // -1 表示无
+  int32_t topic_index;  // topic 表下标，-1 表示无
+  char name[MAX_TOPIC_NAME_LEN];  // topic 事件为 "topic_event"，节点事件为节点名
+};
+
+// 哈希索引条目：hash 为 0 表示空槽；条目只增不删，读者无锁探测
+struct TopicIndexEntry {
+  uint64_t hash;        // topic+event 的 64 位哈希，最后写入
+  int32_t topic_index;  // topic 表中的下标
+  uint32_t reserved;
 };
 
+// 注册表容量配置：每段的节点槽位数 / topic 条目数，写满后追加新段
+// 以及注册表所属的分区：不同域（可选再按命名空间）使用各自的注册表锁和事件条件变量，
+// 互不唤醒；跨分区通信需要显式的 DomainBridge
+struct RegistryConfig {
+  int nodes_per_segment = MAX_NODE_COUNT;
+  int topics_per_segment = DEFAULT_TOPICS_PER_SEGMENT;
+  int domain_id = 0;
+  std::string name_space;
+  bool partition_by_namespace = false;  // 为 false 时同域所有命名空间共用分区
+
+  // 读取 MINIROS2_REGISTRY_NODES / MINIROS2_REGISTRY_TOPICS /
+  // MINIROS2_NAMESPACE_PARTITION，未设置时用默认值
+  static RegistryConfig fromEnv();
+
+  // 分区后缀："_d<domain>"（域 0 省略）+ "_ns_<namespace>"（开启命名空间分区时）
+  // 域 0 且不按命名空间分区时为空，段名与未分区时相同
+  std::string partitionSuffix() const;
+  std::string registryName() const;           // SHM_MANAGER_NAME + 后缀
+  std::string eventNotificationName() const;  // EVENT_NOTIFICATION_SHM_NAME + 后缀
+  // topic 数据段前缀 "/<domain>_<namespace>_"，与 Node 的 shm_prefix_ 一致
+  std::string topicPrefix() const;
+};
+
+// 基段只存放头部和计数，节点表和 topic 表位于扩展段中
 struct ShmManagerInfo {
-  TopicsInfo topic_info;
-  NodesInfo nodes_info;
+  uint32_t magic;        // SHM_REGISTRY_MAGIC，未初始化或旧格式时不匹配
+  uint32_t version;      // SHM_REGISTRY_VERSION，布局变化时递增
+  uint32_t layout_size;  // sizeof(ShmManagerInfo)，防止不同编译配置的进程混用
+  uint32_t reserved;
+  // seqlock 序号：写入期间为奇数，每次结构性修改加 2，sequence / 2 即注册表代数
+  // 心跳只做原子写入，不改变序号
+  uint64_t sequence;
+  uint32_t nodes_per_segment;   // 由创建注册表的进程决定
+  uint32_t topics_per_segment;
+  uint32_t node_segments;       // 已分配段数，只增不减，段初始化后再发布
+  uint32_t topic_segments;
+  int topics_count;
+  int nodes_count;
+  int alive_node_count;
+  uint32_t topic_index_segment;  // 当前哈希索引版本，0 表示尚未建立
+  uint64_t change_seq;  // 最新一条图变化的序号，条目写完后再发布
+  GraphEvent changes[REGISTRY_CHANGE_LOG_SIZE];  // 第 seq 条位于 (seq - 1) % SIZE
 };
 
 class ShmManager {
  public:
   // 去中心化构造函数：检查共享内存是否存在，不存在则创建
   ShmManager();
+  explicit ShmManager(const RegistryConfig& config);
 
   // 析构函数：清理共享内存
   ~ShmManager();
+  // 本节点重复订阅同一 topic 只计一次，取消没有订阅过的 topic 不改变计数
   void addSubTopic(const std::string& topic_name,
                    const std::string& event_name);
+  // 发布同理：本节点重复登记只计一次、只记录一条 PublisherAdded
   void addPubTopic(const std::string& topic_name,
                    const std::string& event_name);
   void removeSubTopic(const std::string& topic_name,
@@ -74,8 +175,33 @@ class ShmManager {
   void updateNodeInfo(const NodeInfo& node_info);  // 更新指定id节点信息非新增
   void getNodeInfo(NodeInfo& node_info);           // 获取指定id节点信息
   int getNextNodeId();                             // 获取下一个空闲节点id
+  // 分配槽位并登记本进程的存活节点（网关、分区桥等内部节点），返回节点 id；
+  // 节点表已满时抛 std::runtime_error
+  int registerProcessNode(const char* name);
+  // 回收进程已退出但仍标记为存活的节点槽位，返回回收数量
+  // 同时删除这些节点创建的 topic 数据段并清除对应的待处理事件位（event_id 保持不变）
+  int reapDeadNodes();
+  // 进程存活且心跳未超时的节点（不含尚未上报心跳的超时判断）
+  std::vector<NodeInfo> getLiveNodes(
+      uint64_t heartbeat_timeout_ms = NODE_HEARTBEAT_TIMEOUT_MS);
+  // 注册表中所有 topic+event 条目的快照，name_ 为 "<topic>_<event>"（含分区前缀）
+  std::vector<TopicInfo> getTopics();
+  // 记录当前节点创建了 topic+event 的数据段
+  void claimTopicSegment(const std::string& topic_name,
+                         const std::string& event_name);
+  // 以发布者身份打开 "/<topic>_<event>" 数据段：不存在时按 size 创建并记录归属，
+  // 已存在（例如本地发布者已创建）时按已有大小打开；两种情况都登记为发布者
+  // 供桥、网关等代替 Publisher 写入数据段的组件使用
+  std::shared_ptr<ShmBase> openPublisherSegment(const std::string& topic_name,
+                                                const std::string& event_name,
+                                                size_t size);
+  // 心跳时间戳（CLOCK_MONOTONIC 毫秒）
+  static uint64_t heartbeatNow();
   int getAliveNodeCount();
   int getNodeCount();
+  // 当前已分配的容量（随注册自动增长）
+  int getNodeCapacity();
+  int getTopicCapacity();
   void printRegistry();
 
   //   NodesInfo *getNodesInfoPtr();
@@ -85,17 +211,17 @@ class ShmManager {
 
   // 事件通知相关方法（使用独立的事件通知共享内存）
   // 等待事件（带超时），返回当前的事件标志位
-  std::bitset<EVENT_MAX_COUNT> waitForEvent(uint64_t timeout_ms) {
+  EventFlags waitForEvent(uint64_t timeout_ms) {
     return event_notification_shm_->waitForEvent(timeout_ms);
   }
 
   // 读取事件标志位（不清除）
-  std::bitset<EVENT_MAX_COUNT> getTriggerEvent() {
+  EventFlags getTriggerEvent() {
     return event_notification_shm_->readEvents();
   }
 
   // 读取并清除事件标志位
-  std::bitset<EVENT_MAX_COUNT> readAndClearEvents() {
+  EventFlags readAndClearEvents() {
     return event_notification_shm_->readAndClearEvents();
   }
 
@@ -111,6 +237,12 @@ class ShmManager {
   int getTopicEventId(const std::string& topic_name,
                       const std::string& event_name);
 
+  // 订阅 topic+event 的节点数（未注册的组合为 0），不加跨进程锁
+  int getSubscriptionCount(const std::string& topic_name,
+                           const std::string& event_name);
+  // 同上，按已缓存的 event_id 查询，发布热路径上不再计算哈希
+  int getSubscriptionCountById(int event_id);
+
   // 触发事件：设置对应的位并通知条件变量
   void triggerEvent(const std::string& topic_name,
                     const std::string& event_name);
@@ -127,6 +259,10 @@ class ShmManager {
 
   void setNodeId(int node_id) { node_id_ = node_id; };
 
+  // topic+event 的 64 位哈希（FNV-1a，等价于对 "topic_event" 求哈希）
+  static uint64_t topicEventHash(const std::string& topic_name,
+                                 const std::string& event_name);
+
   void readTopicsInfo();
 
   void readTopicsInfoUnlocked();
@@ -136,33 +272,103 @@ class ShmManager {
 
   void shmManagerUnlockRegistry() { registry_mutex_.unlock(); }
 
+  // 注册表代数未变化时直接返回，不加跨进程锁
+  // 否则按变化日志只更新改动的槽位，然后在调用线程中执行图变化回调
   void syncRegistryFromShm();
+  // 注册图变化回调，返回用于注销的 id；回调在 syncRegistryFromShm 的调用线程中执行，
+  // 不持有注册表锁，可以在回调中访问 ShmManager
+  int addGraphChangeCallback(std::function<void(const GraphEvent&)> callback);
+  void removeGraphChangeCallback(int callback_id);
+  // 所属分区的注册表段名
+  const std::string& getRegistryName() const { return registry_name_; }
+  // 当前共享内存中的注册表代数（每次结构性修改加 1）
+  uint64_t getRegistryGeneration() const;
 
  private:
-  void initializeRegistry_();
-  // 内部方法：查找或创建 topic+event 映射
-  int findOrCreateTopicEvent_(const std::string& topic_name,
-                              const std::string& event_name);
-
-  void writeRegistryToShm_();  // 写入注册表到共享内存
-  void writeNodesInfo_();
-  void writeTopicsInfo_();
-
-  void writeRegistryToShmUnlocked_();
-  void writeNodesInfoUnlocked_();
-  void writeTopicsInfoUnlocked_();
-
-  void readNodesInfo_();
-  void readTopicsInfo_();
-  int getTopicEventId_(const std::string& topic_name,
+  // 以下 *Unlocked_ 方法要求调用者持有共享内存锁（ShmBaseLockGuard）
+  void initializeRegistryUnlocked_();
+  // 共享内存锁的上一个持有者崩溃时调用：修复序号、节点计数和 topic 索引
+  void repairRegistryUnlocked_();
+  // 把写者崩溃前未插入索引的 topic 条目补入索引
+  void repairTopicIndexUnlocked_();
+  int reapDeadNodesUnlocked_();
+  // 扣除节点记录的订阅计数并清空记录（节点注销或被回收时）
+  void releaseSubscriptionsUnlocked_(NodeInfo& node, int node_id);
+  // 本节点的订阅记录中是否有 topic 表下标 index
+  bool subscribedUnlocked_(int index);
+  // 崩溃修复时按存活节点的订阅记录重新统计订阅计数
+  void recountSubscriptionsUnlocked_();
+  // 进程已退出，或 pid 已被其他进程复用
+  static bool isProcessDead_(int pid, uint64_t start_time);
+  // 心跳超时或进程已退出的节点在扫描中跳过
+  static bool isPeerLive_(const NodeInfo& node, uint64_t now,
+                          uint64_t heartbeat_timeout_ms);
+  // 内部方法：在共享内存注册表中查找或创建 topic+event 映射
+  int findOrCreateTopicEventUnlocked_(const std::string& topic_name,
+                                      const std::string& event_name);
+  // 拷贝共享内存到本地快照（只拷贝有效条目），不检查一致性
+  void copySnapshotUnlocked_();
+  // 以下方法要求调用者持有 registry_mutex_，不持有共享内存锁
+  // seqlock 读：序号前后一致才接受快照，多次失败后退回持锁读取
+  void refreshSnapshot_();
+  // 序号与缓存值相同则跳过，热路径上只有一次 64 位原子读
+  void refreshIfChanged_();
+  // 通过共享内存中的哈希索引查找，不加跨进程锁，未命中返回 -1
+  int lookupTopicEventId_(const std::string& topic_name,
+                          const std::string& event_name);
+  // 返回 topic 表下标，未命中返回 -1
+  int probeTopicIndex_(uint64_t hash, const std::string& topic_name,
                        const std::string& event_name);
+  // 映射其他进程重建后的索引
+  void mapTopicIndex_();
+  // 写区间内调用：索引容量不足 topic_capacity 的两倍时重建
+  void ensureTopicIndexUnlocked_(int topic_capacity);
+
+  // 在写区间内追加一条图变化；node_id / topic_index 为 -1 表示无
+  void logGraphEventUnlocked_(GraphEventType type, int node_id,
+                              int topic_index);
+  // 调用者持有 registry_mutex_：按变化日志增量更新快照，日志不完整时返回 false
+  bool applyGraphChanges_();
+  // 执行已应用但尚未分发的图变化回调，调用者不持有 registry_mutex_
+  void dispatchGraphEvents_();
+
+  // 段管理：调用者持有 registry_mutex_
+  // 映射其他进程新增的段
+  void mapSegments_();
+  std::unique_ptr<SharedMemory> openSegment_(const std::string& kind, int index,
+                                             size_t size, bool create);
+  // 追加一个节点段 / topic 段，调用者处于写区间内；达到上限返回 false
+  bool growNodesUnlocked_();
+  bool growTopicsUnlocked_();
+  NodeInfo& nodeSlot_(int node_id);
+  TopicInfo& topicSlot_(int index);
+  // topic 条目下标到 event_id 的映射（跳过保留的 REGISTRY_CHANGED_EVENT_ID）
+  static int topicEventId_(int index);
+  static int topicIndexOf_(int event_id);
+  void notifyRegistryChanged_();
 
   // 触发事件（通过 event_id）
   void triggerEventById_(int event_id);
   int node_id_ = -1;
-  NodesInfo nodes_;
-  TopicsInfo topics_;
-  ShmManagerInfo shm_manager_info_;
+  RegistryConfig config_;
+  std::string registry_name_;  // 基段名，扩展段名在其后追加后缀
+  // 本地快照：只在注册表变化时从共享内存刷新
+  std::vector<NodeInfo> nodes_;
+  std::vector<TopicInfo> topics_;
+  // 已映射的扩展段
+  std::vector<std::unique_ptr<SharedMemory>> node_segments_;
+  std::vector<std::unique_ptr<SharedMemory>> topic_segments_;
+  std::unique_ptr<SharedMemory> topic_index_;
+  uint32_t topic_index_segment_ = 0;  // 已映射的索引版本
+  uint64_t cached_sequence_ = 1;  // 快照对应的序号，奇数表示尚未读取
+  uint64_t applied_change_seq_ = 0;  // 快照已包含的最新图变化序号
+  // 已应用到快照、等待分发给回调的图变化
+  std::vector<GraphEvent> pending_graph_events_;
+  std::vector<std::pair<int, std::function<void(const GraphEvent&)>>>
+      graph_callbacks_;
+  int next_graph_callback_id_ = 0;
+  std::mutex graph_callback_mutex_;  // 保护 graph_callbacks_，执行回调时不持有
+  ShmManagerInfo* registry_ = nullptr;  // 指向共享内存中的注册表
   std::shared_ptr<ShmBase> shm_;
   std::shared_ptr<EventNotificationShm>
       event_notification_shm_;  // 独立的事件通知共享内存
@@ -170,7 +376,10 @@ class ShmManager {
   //   uint64_t *time_ptr_ = nullptr;
   //   char *data_ptr_;
 
-  // 进程内锁：保护 nodes_ 和 topics_ 的内存访问（非共享内存）
-  // 所有对共享内存的读写操作由 ShmBase 的锁保护
+  // 进程内锁：保护 nodes_ 和 topics_ 快照（非共享内存）
+  // 对共享内存注册表的修改由 ShmBase 的锁保护，加锁顺序：registry_mutex_ -> shm 锁
+  // 读取注册表只用 seqlock，不加共享内存锁
   std::mutex registry_mutex_;
+  // 本节点已登记发布的 topic 表下标，由 registry_mutex_ 保护
+  std::vector<int> pub_topics_;
 };
\ No newline at end of file
@@ -0,0 +1,324 @@
+#pragma once
+#include <netinet/in.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mini_ros2/communication/comm_adapter.h"
+#include "mini_ros2/communication/io_engine.h"
+
+#define UDP_COMM_MAGIC 0x4D525355  // "MRSU"
+// 1 不分片；2 一个报文只有一帧；3 没有可靠传输；4 帧头没有时间戳
+#define UDP_COMM_VERSION 5
+// 单个 UDP 报文的最大负载（IPv4）
+#define UDP_COMM_MAX_DATAGRAM 65507
+// IPv4 + UDP 头部，MTU 减去它才是报文负载上限
+#define UDP_COMM_IP_UDP_HEADER 28
+// 一个报文最多合并的帧数（每帧 3 段 iovec，不超过 IOV_MAX）
+#define UDP_COMM_MAX_RECORDS 64
+// 帧头 flags
+#define UDP_COMM_FLAG_RELIABLE 0x01   // 可靠传输的数据帧，接收端按序号交付
+#define UDP_COMM_FLAG_HEARTBEAT 0x02  // 控制帧：UdpHeartbeat
+#define UDP_COMM_FLAG_NACK 0x04       // 控制帧：UdpNack
+#define UDP_COMM_FLAG_PING 0x08       // 控制帧：UdpClockPing
+#define UDP_COMM_FLAG_PONG 0x10       // 控制帧：UdpClockPong
+// 一个 NACK 最多报告的缺失消息数（位图从 base_seq 开始）
+#define UDP_COMM_NACK_BITS 256
+// 同一 topic 两次 NACK 的最小间隔，避免乱序到达的一串消息触发一串 NACK
+#define UDP_COMM_NACK_INTERVAL_MS 5
+// 接收端接受的最大消息长度（帧头 payload_size），超过的帧丢弃
+#define UDP_COMM_MAX_MESSAGE (256u * 1024 * 1024)
+// 时钟同步：偏移取最近 UDP_CLOCK_FILTER 个样本中往返延迟最小的一个（NTP 时钟滤波），
+// 漂移对最近 UDP_CLOCK_SAMPLES 个样本中延迟不超过最小延迟 2 倍 + UDP_CLOCK_SLACK_NS
+// 的样本做线性回归
+#define UDP_CLOCK_FILTER 8
+#define UDP_CLOCK_SAMPLES 64
+#define UDP_CLOCK_SLACK_NS 100000
+
+// 线上帧头，多字节字段为网络字节序；其后依次是 topic、event（不含结束符）和本分片的数据
+// 超过一个报文的消息按 MTU 分片，每片都带完整帧头，接收端按 offset 重组
+// 发往同一地址的不分片小帧首尾相接合并进同一个报文（帧头 + 名字 + 数据依次重复），
+// 分片总是独占一个报文
+struct __attribute__((packed)) UdpFrameHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t flags;
+  uint16_t topic_len;
+  uint16_t event_len;
+  uint16_t reserved;
+  uint32_t segment_size;
+  uint32_t payload_size;    // 整条消息的长度
+  uint32_t frag_offset;     // 本分片在消息中的偏移
+  uint32_t frag_index;
+  uint32_t frag_count;      // 不分片时为 1
+  uint64_t sender_id;
+  uint64_t seq;
+  uint64_t timestamp;  // 发送端数据段的写入时间（发送端时钟，微秒），0 表示未知
+};
+
+// 可靠传输的控制帧：帧头 + topic、event + 以下结构，flags 标明类型，不分片
+// 心跳：发送端周期性地为每个可靠 topic 发出，帧头 seq 为已发出的最大序号；
+// 接收端据此发现尾部丢失的消息；NACK 发往心跳报文的源地址（发送端的单播套接字）
+// 控制帧中的 reply_addr / reply_port 是发送端自报的地址，绑定在 0.0.0.0 时为
+// 127.0.0.1，跨主机不可达，只用于诊断，回复总是发往报文的源地址
+struct __attribute__((packed)) UdpHeartbeat {
+  uint64_t first_seq;   // 历史窗口中最早的序号，更早的消息已无法重发
+  uint32_t reply_addr;  // 发送端自报的单播地址（IPv4，网络字节序）
+  uint16_t reply_port;
+  uint16_t reserved;
+};
+
+// NACK：接收端发往心跳的源地址，帧头 sender_id 为接收端自己的 id
+// 位图第 i 位表示 base_seq + i 缺失；发送端把历史窗口中有的消息单播重发到 NACK 的源地址
+struct __attribute__((packed)) UdpNack {
+  uint64_t writer_id;  // 被请求重发的发送端
+  uint64_t base_seq;
+  uint32_t reply_addr;
+  uint16_t reply_port;
+  uint16_t bit_count;
+  uint8_t bitmap[UDP_COMM_NACK_BITS / 8];
+};
+
+// 时钟同步的控制帧，topic、event 为空；时间为 system_clock 纳秒
+// 发送端周期性地向组播组和单播过的对端发出 Ping，收到的一方立即向 Ping 的源地址
+// 单播回复 Pong：
+//   offset = ((t2 - t1) + (t3 - t4)) / 2，round_trip = (t4 - t1) - (t3 - t2)
+struct __attribute__((packed)) UdpClockPing {
+  int64_t t1;  // Ping 的发送时间（发起方时钟）
+  uint32_t reply_addr;
+  uint16_t reply_port;
+  uint16_t reserved;
+};
+
+struct __attribute__((packed)) UdpClockPong {
+  uint64_t target_id;  // 发起 Ping 的一方
+  int64_t t1;
+  int64_t t2;  // 收到 Ping 的时间（应答方时钟）
+  int64_t t3;  // 发出 Pong 的时间（应答方时钟）
+};
+
+// 对一个对端时钟的估计
+struct PeerClock {
+  uint64_t peer_id;
+  int64_t offset_ns;      // 对端时钟 - 本端时钟（当前时刻）
+  int64_t round_trip_ns;  // 最近样本中最小的往返延迟，偏移误差不超过它的一半
+  double drift_ppm;       // 对端时钟相对本端每秒快多少微秒
+  size_t samples;
+};
+
+// 可靠传输的统计
+struct UdpReliableStats {
+  uint64_t heartbeats_sent = 0;
+  uint64_t nacks_sent = 0;
+  uint64_t nacks_received = 0;
+  uint64_t retransmits = 0;    // 重发的消息数
+  uint64_t unrecoverable = 0;  // 已移出发送端历史窗口、放弃的消息数
+};
+
+struct UdpCommConfig {
+  std::string multicast_group = "239.255.0.1";
+  uint16_t multicast_port = 7400;
+  // 组播收发使用的本机接口地址；单机多进程测试用 127.0.0.1，跨主机时改为网卡地址
+  std::string interface_address = "0.0.0.0";
+  uint16_t unicast_port = 0;  // 点对点接收端口，0 表示由内核分配
+  int multicast_ttl = 1;
+  bool multicast_loop = true;  // 同一主机上的其他进程也能收到组播
+  // 收发使用的 I/O 引擎，默认由 MINIROS2_IO_BACKEND 决定（未设置时优先 io_uring）
+  IoBackend io_backend = ioBackendFromEnv();
+  // 路径 MTU，报文（含 IP/UDP 头）不超过它，避免 IP 层分片；只走回环时可设为 65535
+  size_t mtu = 1500;
+  // 套接字缓冲区：一条大消息的所有分片突发到达，接收缓冲区至少要放下一条消息
+  int receive_buffer = 4 * 1024 * 1024;
+  int send_buffer = 4 * 1024 * 1024;
+  // 分片在该时间内没有收齐的消息丢弃
+  uint64_t reassembly_timeout_ms = 200;
+  // 帧头中的消息长度超过它时丢弃该帧，重组缓冲区不会超过它
+  size_t max_message_size = UDP_COMM_MAX_MESSAGE;
+  // 发送端这么久没有消息时释放它的重组缓冲区和可靠传输的接收状态
+  uint64_t peer_timeout_ms = 10000;
+  // 同一批中发往同一地址的小帧合并成一个报文，减少报文数和系统调用开销
+  bool coalesce = true;
+  // 可靠传输（CommFrame::reliable）：发送端为每个 topic 保留最近 reliable_history 条
+  // 消息，每 heartbeat_ms 发出心跳；接收端最多缓存 reliable_window 条乱序消息
+  size_t reliable_history = 128;
+  uint64_t heartbeat_ms = 50;
+  size_t reliable_window = 256;
+  // 测试用：按该比例随机丢弃收到的报文（含心跳和 NACK），在回环上模拟丢包
+  double receive_drop_rate = 0;
+  // 时钟同步的 Ping 周期，0 表示不同步（收到的时间戳不换算，source_time 为 0）
+  uint64_t clock_sync_ms = 1000;
+  // 测试用：本端时钟（发出的时间戳、时钟同步）加上偏移和漂移，单机模拟主机间的时钟差
+  int64_t clock_skew_us = 0;
+  double clock_drift_ppm = 0;
+};
+
+// UDP 传输：组播用于一对多的 topic，单播用于点对点
+// 两个套接字：组播套接字（SO_REUSEADDR，同一主机上的多个进程共享端口）只负责接收；
+// 单播套接字绑定独立端口，负责所有发送和点对点接收
+// 收发交给 IoEngine：一批帧一次提交（io_uring 或 sendmmsg），接收由引擎的线程
+// 批量收取（多发 recvmsg 或 epoll + recvmmsg）后逐个报文回调
+// 大消息按 MTU 分片，分片的 iovec 直接指向调用者的数据（如共享内存数据区），
+// 用户态不再拷贝；接收端把分片重组到按 topic 复用的缓冲区中，收齐后才回调
+// 可靠帧（CommFrame::reliable）按 topic 独立保证不丢、按序：发送端保留历史窗口并发送
+// 心跳，接收端按序号交付，发现缺口时回复 NACK 位图，发送端只重发缺失的消息；
+// 一个 topic 的缺口只阻塞该 topic，不影响其他 topic。重发以整条消息为单位，适合命令等小消息
+// 帧头带发布者的写入时间；适配器与对端做 NTP 式的 Ping / Pong 估计时钟偏移和漂移，
+// 把收到的时间戳换算成本机时钟（CommMessage::source_time），跨主机的延迟统计才有意义
+class UdpCommAdapter : public CommAdapter {
+ public:
+  explicit UdpCommAdapter(const UdpCommConfig& config = UdpCommConfig());
+  ~UdpCommAdapter() override;
+  UdpCommAdapter(const UdpCommAdapter&) = delete;
+  UdpCommAdapter& operator=(const UdpCommAdapter&) = delete;
+
+  size_t sendBatch(const std::vector<CommFrame>& frames) override;
+  void start(ReceiveCallback callback) override;
+  void stop() override;
+  uint64_t senderId() const override { return sender_id_; }
+  CommEndpoint localEndpoint() const override;
+
+  // 单个报文的 UDP 负载上限（含帧头和名字），由 mtu 决定
+  size_t maxDatagram() const { return max_datagram_; }
+  // 因分片超时或被新消息取代而丢弃的不完整消息数
+  uint64_t incompleteMessages() const { return incomplete_; }
+  // 实际使用的 I/O 引擎："io_uring" 或 "epoll"
+  const char* ioBackendName() const { return engine_->name(); }
+  // 成功发出的报文数（合并后的报文算一个）
+  uint64_t datagramsSent() const { return datagrams_sent_; }
+  UdpReliableStats reliableStats();
+  // 已估计出时钟偏移的对端（收到过 Pong）
+  std::vector<PeerClock> peerClocks();
+  bool peerClock(uint64_t peer_id, PeerClock& clock);
+
+ private:
+  // 解析主机名并缓存（只支持 IPv4）
+  const sockaddr_in& resolve_(const CommEndpoint& endpoint);
+  // 要求持有 send_mutex_；flags 与各帧的 reliable 标志合并写入帧头
+  size_t sendFrames_(const std::vector<CommFrame>& frames, uint8_t flags);
+  // 把可靠帧存入历史窗口，要求持有 send_mutex_
+  void recordHistory_(const CommFrame& frame);
+  void dispatch_(const uint8_t* data, size_t size, const sockaddr_in& from);
+  // 当前报文的源地址：对端的单播套接字，控制帧的回复发往这里
+  CommEndpoint source_() const;
+  // 解析报文中从 data 开始的一帧，返回该帧占用的字节数，格式错误时返回 0
+  size_t dispatchRecord_(const uint8_t* data, size_t size);
+  // 收齐的一条消息：可靠帧按序号排队交付，其他直接回调
+  void deliver_(const CommMessage& msg, bool reliable);
+  void onHeartbeat_(const CommMessage& msg);
+  void onNack_(const CommMessage& msg);
+  // 丢弃超时未收齐的消息，释放长时间没有消息的发送端的接收状态
+  void expireReassembly_();
+  // 接收线程的定时任务：分片超时、心跳
+  void tick_();
+  void sendHeartbeats_();
+  void sendClockPings_();
+  void onPing_(const CommMessage& msg);
+  void onPong_(const CommMessage& msg);
+  // 本端时钟（含测试用的偏移和漂移），system_clock 纳秒
+  int64_t clockNow_() const;
+  int64_t skewed_(int64_t real_ns) const;
+  // 发送端时间戳（微秒）换算成本机 system_clock 微秒，没有估计时返回 0
+  uint64_t toLocalTime_(uint64_t sender_id, uint64_t remote_us);
+
+  // 发送端：一个可靠 topic 的历史窗口，序号递增
+  struct HistorySample {
+    uint64_t seq;
+    uint32_t segment_size;
+    std::vector<uint8_t> data;
+  };
+  struct WriterStream {
+    std::string topic;
+    std::string event;
+    std::deque<HistorySample> history;
+    std::vector<CommEndpoint> dests;  // 发送过的地址，心跳发往这些地址
+  };
+
+  // 接收端：一个发送端的一个可靠 topic
+  struct PendingSample {
+    uint32_t segment_size;
+    uint64_t source_time;
+    std::vector<uint8_t> data;
+  };
+  struct ReaderStream {
+    uint64_t expected = 0;    // 下一条应交付的序号，0 表示尚未开始
+    uint64_t last_known = 0;  // 数据或心跳中见过的最大序号
+    std::map<uint64_t, PendingSample> pending;  // 乱序到达、等待交付
+    bool has_reply = false;
+    CommEndpoint reply;  // 心跳的源地址，即发送端的单播套接字
+    std::chrono::steady_clock::time_point last_nack;
+    std::chrono::steady_clock::time_point last_seen;  // 最近的数据或心跳
+  };
+  // 交付 pending 中从 expected 开始连续的消息
+  void flushPending_(ReaderStream& reader, CommMessage msg);
+  void sendNack_(ReaderStream& reader, const CommMessage& msg);
+
+  // 一个对端的时钟样本，local_ns 为收到 Pong 的本端时间
+  struct ClockSample {
+    int64_t local_ns;
+    int64_t offset_ns;
+    int64_t round_trip_ns;
+  };
+  struct ClockPeer {
+    std::deque<ClockSample> samples;
+    ClockSample best;  // 最近 UDP_CLOCK_FILTER 个样本中往返延迟最小的
+    double drift = 0;  // 偏移随本端时间的变化率
+  };
+  // 要求持有 clock_mutex_
+  static void updateClock_(ClockPeer& peer, const ClockSample& sample);
+  static int64_t offsetAt_(const ClockPeer& peer, int64_t local_ns);
+
+  // 一个发送端的一个 topic+event 正在重组的消息；缓冲区只增不减，之后的消息复用
+  struct Reassembly {
+    bool active = false;
+    uint64_t seq = 0;
+    uint32_t segment_size = 0;
+    size_t size = 0;
+    uint32_t fragment_count = 0;
+    uint32_t received = 0;
+    std::vector<uint8_t> got;  // 每个分片是否已收到
+    std::vector<uint8_t> buffer;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point last_seen;  // 最近收到分片的时间
+    bool reliable = false;
+  };
+
+  UdpCommConfig config_;
+  uint64_t sender_id_;
+  int mc_fd_ = -1;
+  int uc_fd_ = -1;
+  uint16_t unicast_port_ = 0;
+  sockaddr_in group_addr_;
+  std::unordered_map<std::string, sockaddr_in> resolved_;
+  std::mutex send_mutex_;
+  ReceiveCallback callback_;
+  size_t max_datagram_;
+  // key 为 "<sender_id>:<topic>_<event>"，只在引擎的接收线程中访问
+  std::unordered_map<std::string, Reassembly> reassembly_;
+  std::atomic<uint64_t> incomplete_ = 0;
+  std::atomic<uint64_t> datagrams_sent_ = 0;
+  // 以下由 send_mutex_ 保护
+  std::unordered_map<std::string, WriterStream> writers_;  // "<topic>_<event>"
+  std::chrono::steady_clock::time_point last_heartbeat_;
+  std::chrono::steady_clock::time_point last_ping_;
+  std::vector<CommEndpoint> clock_peers_;  // 单播过的对端，也向它们发 Ping
+  // 以下只在接收线程中访问；key 与 reassembly_ 相同
+  std::unordered_map<std::string, ReaderStream> readers_;
+  std::mt19937_64 drop_random_;
+  int64_t receive_time_ns_ = 0;  // 当前报文的接收时间（本端时钟）
+  sockaddr_in receive_from_{};   // 当前报文的源地址
+  int64_t clock_base_ns_;        // 测试用漂移的起点
+  std::mutex clock_mutex_;
+  std::unordered_map<uint64_t, ClockPeer> clocks_;
+  std::mutex stats_mutex_;
+  UdpReliableStats reliable_stats_;
+  std::unique_ptr<IoEngine> engine_;
+  std::atomic<bool> running_ = false;
+};
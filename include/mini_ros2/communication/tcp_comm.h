@@ -0,0 +1,202 @@
+#pragma once
+#include <netinet/in.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "mini_ros2/communication/comm_adapter.h"
+
+// TCP 传输：用于不能组播的链路（VPN、容器网络等）
+// 每对端一条常驻连接，所有 topic 复用这条连接，帧以长度前缀分隔
+// 一批帧按连接分组，每条连接一次 writev 发出（iovec 直接指向调用者的数据，
+// 如共享内存数据段），不在用户态拷贝；套接字总是 TCP_NODELAY，一批数据较大
+// 或需要多次 writev 时临时打开 TCP_CORK，让内核按整段发出，单条小消息立即发出
+// 发送缓冲区满时未写完的部分拷贝到连接的输出队列，由事件循环在可写时发出，
+// 发送线程（可能持有数据段锁）从不等待对端
+// 接收是单线程 epoll 事件循环（结构同 RegistryServer），断开后自动重连配置的对端
+
+#define TCP_COMM_MAGIC 0x4D525354  // "MRST"
+#define TCP_COMM_VERSION 1
+// 单帧负载（topic + event + 数据）上限，超过视为协议错误并断开连接
+#define TCP_COMM_MAX_FRAME (256u * 1024 * 1024)
+// 一批数据超过该字节数时临时打开 TCP_CORK
+#define TCP_COMM_CORK_BYTES (16 * 1024)
+// 每次 read 至少准备的缓冲区大小
+#define TCP_COMM_READ_CHUNK (64 * 1024)
+// 每条连接输出队列积压的上限，超过后断开连接
+#define TCP_COMM_MAX_PENDING_OUTPUT (64 * 1024 * 1024)
+// 帧头 flags
+#define TCP_COMM_FLAG_HELLO 0x01  // 连接建立后双方先发出的第一帧：TcpHello
+
+// 线上帧头，多字节字段为网络字节序；其后依次是 topic、event（不含结束符）和数据
+struct __attribute__((packed)) TcpFrameHeader {
+  uint32_t length;  // 帧头之后的字节数
+  uint8_t version;
+  uint8_t flags;
+  uint16_t topic_len;
+  uint16_t event_len;
+  uint16_t reserved;
+  uint32_t segment_size;
+  uint64_t seq;
+  uint64_t timestamp;  // 发送端数据段的写入时间（发送端时钟，微秒），0 表示未知
+};
+
+// 握手：对端据此得知发送端 id 和监听端口，把接受的连接登记为到该对端的连接，
+// 之后发往该对端的帧复用这条连接，不再另建连接
+struct __attribute__((packed)) TcpHello {
+  uint32_t magic;
+  uint64_t sender_id;
+  uint16_t listen_port;
+  uint16_t reserved;
+};
+
+struct TcpCommStats {
+  uint64_t connections = 0;     // 当前连接数
+  uint64_t connects = 0;        // 主动建立的连接数（含重连）
+  uint64_t accepted = 0;        // 接受的连接数
+  uint64_t frames_sent = 0;
+  uint64_t bytes_sent = 0;
+  uint64_t writev_calls = 0;    // 一批帧合并后的 writev 调用次数
+  uint64_t corked_batches = 0;  // 打开 TCP_CORK 发出的批次
+  uint64_t queued_batches = 0;  // 发送缓冲区满、剩余部分进入输出队列的批次
+  uint64_t frames_received = 0;
+  uint64_t bytes_received = 0;
+  uint64_t errors = 0;  // 因发送超时、积压、协议错误断开的连接数和失败的连接尝试
+};
+
+struct TcpCommConfig {
+  std::string listen_address = "0.0.0.0";
+  uint16_t listen_port = 0;  // 0 表示由内核分配
+  // 启动时连接的对端，断开后每 reconnect_ms 重试
+  // 发往组地址的帧发给所有已连接的对端
+  std::vector<CommEndpoint> peers;
+  uint64_t reconnect_ms = 500;
+  // 连接是非阻塞的，由事件循环完成；超过该时间还没建立的放弃，按 reconnect_ms 重试
+  uint64_t connect_timeout_ms = 1000;
+  // 输出队列超过该时间没有任何进展时断开连接（流中不能只丢一帧）
+  uint64_t send_timeout_ms = 2000;
+  // 输出队列已积压超过该字节数时，新的一批不再排队，断开连接
+  size_t max_pending_bytes = TCP_COMM_MAX_PENDING_OUTPUT;
+  size_t cork_bytes = TCP_COMM_CORK_BYTES;
+  int receive_buffer = 4 * 1024 * 1024;
+  int send_buffer = 4 * 1024 * 1024;
+};
+
+// CommAdapter 的 TCP 实现：组地址表示所有已连接的对端，单播地址按需连接，
+// 连接建立前发往该地址的帧不发出；连接在 start() 之后由事件循环完成
+// sendBatch 只计入至少写入了一条连接的帧
+// TCP 本身可靠有序，CommFrame::reliable 不需要额外处理；连接不做时钟同步，
+// 收到的消息 source_time 为 0
+// 双方同时互连时两条连接都保留，各自只用自己发起的那条发送
+class TcpCommAdapter : public CommAdapter {
+ public:
+  explicit TcpCommAdapter(const TcpCommConfig& config = TcpCommConfig());
+  ~TcpCommAdapter() override;
+  TcpCommAdapter(const TcpCommAdapter&) = delete;
+  TcpCommAdapter& operator=(const TcpCommAdapter&) = delete;
+
+  size_t sendBatch(const std::vector<CommFrame>& frames) override;
+  void start(ReceiveCallback callback) override;
+  void stop() override;
+  uint64_t senderId() const override { return sender_id_; }
+  CommEndpoint localEndpoint() const override;
+
+  uint16_t port() const { return listen_port_; }
+  // 已登记、可以发送的对端数
+  size_t peerCount();
+  TcpCommStats getStats();
+
+ private:
+  struct Connection {
+    ~Connection();
+
+    uint64_t id;
+    int fd = -1;
+    std::string key;  // 对端 "<ip>:<监听端口>"，接受的连接收到握手后才知道
+    uint64_t peer_id = 0;
+    // 以下只在接收线程中访问；input 只增不减，
+    // 有效数据为 [input_offset, input_used)
+    std::vector<uint8_t> input;
+    size_t input_used = 0;
+    size_t input_offset = 0;
+    // 发送由 send_mutex 串行化；发送失败后标记 broken，不再发送，之后关闭
+    std::mutex send_mutex;
+    std::atomic<bool> broken = false;
+    // 以下由 send_mutex 保护：发送缓冲区满时未写完的数据，有效数据为
+    // [output_offset, output.size())；非空时新的帧都排在后面，保持流中的顺序
+    std::vector<uint8_t> output;
+    size_t output_offset = 0;
+    std::chrono::steady_clock::time_point output_progress;  // 上次发出的时间
+    // 正在连接：等待可写后发出握手，之前不用于发送；由 mutex_ 保护
+    bool connecting = false;
+    std::chrono::steady_clock::time_point connect_started;
+  };
+  using ConnectionPtr = std::shared_ptr<Connection>;
+
+  // 解析为 "<ip>:<port>"，失败时抛 std::invalid_argument
+  static std::string endpointKey_(const CommEndpoint& endpoint,
+                                  sockaddr_in& addr);
+  // 发起到 endpoint 的非阻塞连接；已连接或正在连接时什么都不做
+  void connect_(const CommEndpoint& endpoint);
+  // 连接可写：检查结果，发出握手并登记为发送用的连接
+  void finishConnect_(const ConnectionPtr& conn);
+  void connectFailed_(const std::string& key);
+  // 放弃超过 connect_timeout_ms 还没建立的连接
+  void expireConnects_();
+  // 取到 dest 的已建立连接；单播地址没有连接时发起连接并返回空
+  ConnectionPtr connectionFor_(const CommEndpoint& dest);
+  // 要求持有 mutex_；登记连接，按 events 加入事件循环；key 已有连接时只用于接收
+  void addConnectionLocked_(const ConnectionPtr& conn, uint32_t events);
+  void closeConnection_(uint64_t id);
+  // 把帧一次 writev 发出（超过 IOV_MAX 时分多次），返回是否全部发出
+  bool writeFrames_(Connection& conn, const std::vector<CommFrame>& frames,
+                    const std::vector<size_t>& indices);
+  bool sendHello_(Connection& conn);
+  // 要求持有 conn.send_mutex；写出 iov 中的数据，发送缓冲区满时剩余部分
+  // 拷贝到输出队列并关注 EPOLLOUT；积压超过上限时返回 false
+  bool writeAll_(Connection& conn, std::vector<iovec>& iov);
+  // 事件循环在可写时发出输出队列，发完后不再关注 EPOLLOUT
+  bool flush_(Connection& conn);
+  // 要求持有 conn.send_mutex
+  void watchWritable_(Connection& conn, bool writable);
+  // 断开输出队列超过 send_timeout_ms 没有进展的连接
+  void expireSends_();
+  void run_();
+  void acceptAll_();
+  // 读到 EAGAIN 并处理所有完整的帧；返回 false 表示连接应关闭
+  bool readConnection_(const ConnectionPtr& conn);
+  bool processInput_(Connection& conn);
+  bool onHello_(Connection& conn, const uint8_t* data, size_t size);
+  // 重连断开的配置对端
+  void reconnect_();
+
+  TcpCommConfig config_;
+  uint64_t sender_id_;
+  int listen_fd_ = -1;
+  int epoll_fd_ = -1;
+  int wake_fd_ = -1;
+  uint16_t listen_port_ = 0;
+  ReceiveCallback callback_;
+  std::mutex mutex_;  // 保护以下连接表
+  uint64_t next_connection_id_ = 1;
+  std::unordered_map<uint64_t, ConnectionPtr> connections_;
+  std::unordered_map<std::string, ConnectionPtr> peers_;  // 发送用，按 key
+  std::unordered_map<std::string, ConnectionPtr> connecting_;  // 正在连接
+  std::unordered_map<std::string, std::string> resolved_;  // "host:port" -> key
+  // 连接失败的单播地址 -> 下次重试时间，避免每批都阻塞在连接上
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+      retry_after_;
+  std::chrono::steady_clock::time_point last_reconnect_;
+  std::mutex stats_mutex_;
+  TcpCommStats stats_;
+  std::thread thread_;
+  std::atomic<bool> running_ = false;
+};
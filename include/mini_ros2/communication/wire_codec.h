@@ -0,0 +1,80 @@
+#pragma once
+#include <arpa/inet.h>
+#include <endian.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+// 控制面报文负载的编解码（RegistryServer / NodeDiscovery 内部使用）：
+// 多字节整数为网络字节序，字符串为 u16 长度 + 内容（不含结束符）
+
+inline void putU16(std::vector<uint8_t>& out, uint16_t value) {
+  value = htons(value);
+  auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+inline void putU32(std::vector<uint8_t>& out, uint32_t value) {
+  value = htonl(value);
+  auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+inline void putU64(std::vector<uint8_t>& out, uint64_t value) {
+  value = htobe64(value);
+  auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+inline void putString(std::vector<uint8_t>& out, const std::string& value) {
+  putU16(out, static_cast<uint16_t>(value.size()));
+  out.insert(out.end(), value.begin(), value.end());
+}
+
+// 按顺序读取负载字段；越界后 ok 为 false，之后的读取都返回空值
+struct PayloadReader {
+  const uint8_t* data;
+  size_t size;
+  size_t pos = 0;
+  bool ok = true;
+
+  bool take(void* out, size_t length) {
+    if (!ok || size - pos < length) {
+      ok = false;
+      return false;
+    }
+    std::memcpy(out, data + pos, length);
+    pos += length;
+    return true;
+  }
+  uint8_t u8() {
+    uint8_t value = 0;
+    take(&value, sizeof(value));
+    return value;
+  }
+  uint16_t u16() {
+    uint16_t value = 0;
+    return take(&value, sizeof(value)) ? ntohs(value) : 0;
+  }
+  uint32_t u32() {
+    uint32_t value = 0;
+    return take(&value, sizeof(value)) ? ntohl(value) : 0;
+  }
+  uint64_t u64() {
+    uint64_t value = 0;
+    return take(&value, sizeof(value)) ? be64toh(value) : 0;
+  }
+  std::string string() {
+    uint16_t length = u16();
+    if (!ok || size - pos < length) {
+      ok = false;
+      return std::string();
+    }
+    std::string value(reinterpret_cast<const char*>(data + pos), length);
+    pos += length;
+    return value;
+  }
+};
@@ -0,0 +1,126 @@
+#pragma once
+#include <stdint.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// 定长容器：供 .msg 生成的消息结构体使用
+// 所有容器都是 trivially copyable，布局固定，可直接放入共享内存（零拷贝）
+// 布局约定（生成器按同样规则计算偏移，修改时需同步 generate_messages.py）：
+//   BoundedString<N>      : uint32_t size_; char data_[N];
+//   BoundedSequence<T, N> : uint32_t size_; (按 T 对齐填充) T data_[N];
+
+template <uint32_t N>
+class BoundedString {
+  static_assert(N > 0, "BoundedString capacity must be positive");
+
+ public:
+  static constexpr uint32_t kCapacity = N;
+
+  BoundedString() = default;
+  BoundedString(const char* str) { assign(str, std::strlen(str)); }
+  BoundedString(const std::string& str) { assign(str.data(), str.size()); }
+
+  BoundedString& operator=(const char* str) {
+    assign(str, std::strlen(str));
+    return *this;
+  }
+  BoundedString& operator=(const std::string& str) {
+    assign(str.data(), str.size());
+    return *this;
+  }
+
+  // 超出容量直接抛异常，避免静默截断导致两端数据不一致
+  void assign(const char* str, size_t len) {
+    if (len > N) {
+      throw std::length_error("BoundedString: length " + std::to_string(len) +
+                              " exceeds capacity " + std::to_string(N));
+    }
+    std::memcpy(data_, str, len);
+    size_ = static_cast<uint32_t>(len);
+  }
+
+  uint32_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  // 长度不超过容量；从对端收到的原始字节需要先校验再使用
+  bool valid() const { return size_ <= N; }
+  const char* data() const { return data_; }
+  std::string str() const { return std::string(data_, size_); }
+
+  bool operator==(const BoundedString& other) const {
+    return size_ == other.size_ && std::memcmp(data_, other.data_, size_) == 0;
+  }
+  bool operator!=(const BoundedString& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  uint32_t size_ = 0;
+  char data_[N] = {};
+};
+
+template <typename T, uint32_t N>
+class BoundedSequence {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "BoundedSequence element must be trivially copyable");
+  static_assert(N > 0, "BoundedSequence capacity must be positive");
+
+ public:
+  static constexpr uint32_t kCapacity = N;
+
+  BoundedSequence() = default;
+
+  void push_back(const T& value) {
+    if (size_ >= N) {
+      throw std::length_error("BoundedSequence: capacity " +
+                              std::to_string(N) + " exceeded");
+    }
+    data_[size_++] = value;
+  }
+
+  void resize(uint32_t size) {
+    if (size > N) {
+      throw std::length_error("BoundedSequence: capacity " +
+                              std::to_string(N) + " exceeded");
+    }
+    size_ = size;
+  }
+
+  void clear() { size_ = 0; }
+
+  uint32_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  bool valid() const { return size_ <= N; }
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+  T* begin() { return data_; }
+  T* end() { return data_ + size_; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+
+  T& operator[](uint32_t index) {
+    if (index >= size_) {
+      throw std::out_of_range("BoundedSequence: index out of range");
+    }
+    return data_[index];
+  }
+  const T& operator[](uint32_t index) const {
+    if (index >= size_) {
+      throw std::out_of_range("BoundedSequence: index out of range");
+    }
+    return data_[index];
+  }
+
+ private:
+  uint32_t size_ = 0;
+  T data_[N] = {};
+};
+
+// 消息类型特征：生成器为每个 .msg 类型特化此模板
+// is_generated 为 true 的类型走带类型哈希的序列化路径
+template <typename T>
+struct MessageTraits {
+  static constexpr bool is_generated = false;
+};
@@ -0,0 +1,375 @@
+#pragma once
+#include <stdint.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "mini_ros2/message/message_serializer.h"
+
+// 偏移表消息格式（类似 FlatBuffers）：字段通过偏移表直接从缓冲区读取，无反序列化步骤
+// 与 memcpy POD 和 JsonValue 并列的第三种序列化后端，适合大型嵌套消息
+//
+// 缓冲区布局（主机字节序，所有偏移均为相对缓冲区起点的绝对偏移）：
+//   FlatHeader                      魔数、schema 版本、根表偏移、消息总长度
+//   ... 字符串/向量/子表 ...        子对象先于父表写入
+//   vtable: uint16 field_count, uint16 table_size, FlatVTableEntry[field_count]
+//   table : uint32 vtable_pos, 按大小降序对齐排列的字段
+//
+// 每个 vtable 项记录字段类型，因此校验器无需 schema 即可做边界检查；
+// 读端按字段 id 访问：不存在或类型不符的字段返回默认值，新旧 schema 可互相读取
+
+#define FLAT_MESSAGE_MAGIC 0x4246524D  // "MRFB"
+#define FLAT_MESSAGE_MAX_DEPTH 64
+#define FLAT_MESSAGE_ALIGN 8
+
+enum class FlatFieldKind : uint8_t {
+  Absent = 0,
+  Scalar = 1,
+  String = 2,       // uint32 长度 + 字节 + '\0'
+  Vector = 3,       // uint32 个数 + 按元素大小对齐的标量数组
+  Table = 4,        // 子表
+  TableVector = 5,  // uint32 个数 + uint32 子表偏移数组
+};
+
+struct FlatHeader {
+  uint32_t magic;
+  uint16_t schema_version;
+  uint16_t reserved;
+  uint32_t root;  // 根表偏移
+  uint32_t size;  // 消息总长度（共享内存区可能更长）
+};
+
+struct FlatVTableEntry {
+  uint16_t offset;    // 字段相对表起点的偏移，0 表示不存在
+  uint8_t kind;       // FlatFieldKind
+  uint8_t elem_size;  // 标量/向量元素字节数
+};
+
+// 子对象引用，由 FlatBuilder 的 create* / endTable 返回
+struct FlatRef {
+  uint32_t pos = 0;
+  FlatFieldKind kind = FlatFieldKind::Absent;
+  uint8_t elem_size = 0;
+};
+
+class FlatBuilder {
+ public:
+  // 内部缓冲区模式：容量不足时自动扩容
+  explicit FlatBuilder(size_t initial_capacity = 1024);
+  // 外部缓冲区模式：直接写入调用方提供的内存（如 Publisher::publishLoaned 借出的共享内存）
+  // 容量不足时抛出 std::length_error；buffer 需按 FLAT_MESSAGE_ALIGN 对齐
+  FlatBuilder(uint8_t* buffer, size_t capacity);
+
+  FlatBuilder(const FlatBuilder&) = delete;
+  FlatBuilder& operator=(const FlatBuilder&) = delete;
+
+  FlatRef createString(std::string_view str);
+
+  template <typename T>
+  FlatRef createVector(const T* data, size_t count) {
+    static_assert(std::is_arithmetic<T>::value,
+                  "FlatBuilder::createVector requires scalar elements");
+    uint32_t pos = allocVector_(count, sizeof(T));
+    if (count > 0) {
+      std::memcpy(buffer_ + pos + sizeof(uint32_t), data, sizeof(T) * count);
+    }
+    return FlatRef{pos, FlatFieldKind::Vector, static_cast<uint8_t>(sizeof(T))};
+  }
+
+  template <typename T>
+  FlatRef createVector(const std::vector<T>& data) {
+    return createVector(data.data(), data.size());
+  }
+
+  FlatRef createTableVector(const std::vector<FlatRef>& tables);
+
+  // 表构造：startTable -> add* -> endTable，期间不能创建其他对象
+  void startTable();
+
+  template <typename T>
+  void addScalar(uint16_t id, T value) {
+    static_assert(std::is_arithmetic<T>::value,
+                  "FlatBuilder::addScalar requires a scalar type");
+    PendingField field;
+    field.id = id;
+    field.kind = FlatFieldKind::Scalar;
+    field.size = sizeof(T);
+    field.bits = 0;
+    std::memcpy(&field.bits, &value, sizeof(T));
+    addPending_(field);
+  }
+
+  void addRef(uint16_t id, const FlatRef& ref);
+
+  FlatRef endTable();
+
+  // 写入消息头，返回消息总长度
+  size_t finish(const FlatRef& root, uint16_t schema_version = 1);
+
+  const uint8_t* data() const { return buffer_; }
+  size_t size() const { return size_; }
+
+ private:
+  struct PendingField {
+    uint16_t id;
+    FlatFieldKind kind;
+    uint8_t size;  // 字段在表中的字节数
+    uint8_t elem_size;
+    uint64_t bits;  // 标量值或引用偏移
+  };
+
+  void checkNotInTable_() const {
+    if (in_table_) {
+      throw std::logic_error("FlatBuilder: cannot create objects inside a table");
+    }
+  }
+  void addPending_(const PendingField& field);
+  // 分配 size 字节（起点按 align 对齐，填充字节清零），返回起始偏移
+  uint32_t alloc_(size_t size, size_t align);
+  // 分配向量并写入个数前缀，数据区按元素大小对齐，返回前缀偏移
+  uint32_t allocVector_(size_t count, size_t elem_size);
+  void reserve_(size_t size);
+
+  std::vector<uint8_t> owned_;
+  uint8_t* buffer_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  bool external_ = false;
+  bool in_table_ = false;
+  std::vector<PendingField> pending_;
+};
+
+template <typename T>
+class FlatVector {
+ public:
+  FlatVector() = default;
+  FlatVector(const T* data, uint32_t size) : data_(data), size_(size) {}
+  uint32_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T* data() const { return data_; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+  const T& operator[](uint32_t index) const { return data_[index]; }
+
+ private:
+  const T* data_ = nullptr;
+  uint32_t size_ = 0;
+};
+
+// 表访问器：只保存缓冲区指针和表偏移，所有读取直接访问原始字节
+// 假定缓冲区已通过 FlatVerifier 校验（不可信数据先调用 verify）
+class FlatTable {
+ public:
+  FlatTable() = default;
+  FlatTable(const uint8_t* buffer, uint32_t pos) : buffer_(buffer), pos_(pos) {}
+
+  bool valid() const { return buffer_ != nullptr; }
+  bool has(uint16_t id) const { return entry_(id) != nullptr; }
+  uint16_t fieldCount() const {
+    return valid() ? load_<uint16_t>(vtable_()) : 0;
+  }
+
+  template <typename T>
+  T get(uint16_t id, T default_value = T()) const {
+    const FlatVTableEntry* entry = entry_(id, FlatFieldKind::Scalar);
+    if (entry == nullptr || entry->elem_size != sizeof(T)) {
+      return default_value;
+    }
+    return load_<T>(pos_ + entry->offset);
+  }
+
+  std::string_view getString(uint16_t id) const {
+    uint32_t pos = ref_(id, FlatFieldKind::String);
+    if (pos == 0) {
+      return std::string_view();
+    }
+    return std::string_view(
+        reinterpret_cast<const char*>(buffer_ + pos + sizeof(uint32_t)),
+        load_<uint32_t>(pos));
+  }
+
+  template <typename T>
+  FlatVector<T> getVector(uint16_t id) const {
+    const FlatVTableEntry* entry = entry_(id, FlatFieldKind::Vector);
+    if (entry == nullptr || entry->elem_size != sizeof(T)) {
+      return FlatVector<T>();
+    }
+    uint32_t pos = load_<uint32_t>(pos_ + entry->offset);
+    return FlatVector<T>(
+        reinterpret_cast<const T*>(buffer_ + pos + sizeof(uint32_t)),
+        load_<uint32_t>(pos));
+  }
+
+  FlatTable getTable(uint16_t id) const {
+    uint32_t pos = ref_(id, FlatFieldKind::Table);
+    return pos == 0 ? FlatTable() : FlatTable(buffer_, pos);
+  }
+
+  uint32_t getTableCount(uint16_t id) const {
+    uint32_t pos = ref_(id, FlatFieldKind::TableVector);
+    return pos == 0 ? 0 : load_<uint32_t>(pos);
+  }
+
+  FlatTable getTableAt(uint16_t id, uint32_t index) const {
+    uint32_t pos = ref_(id, FlatFieldKind::TableVector);
+    if (pos == 0 || index >= load_<uint32_t>(pos)) {
+      return FlatTable();
+    }
+    return FlatTable(buffer_, load_<uint32_t>(pos + sizeof(uint32_t) *
+                                                        (index + 1)));
+  }
+
+ private:
+  template <typename T>
+  T load_(uint32_t pos) const {
+    T value;
+    std::memcpy(&value, buffer_ + pos, sizeof(T));
+    return value;
+  }
+  uint32_t vtable_() const { return load_<uint32_t>(pos_); }
+  const FlatVTableEntry* entry_(uint16_t id) const {
+    if (!valid() || id >= fieldCount()) {
+      return nullptr;
+    }
+    const FlatVTableEntry* entry = reinterpret_cast<const FlatVTableEntry*>(
+        buffer_ + vtable_() + 2 * sizeof(uint16_t) +
+        sizeof(FlatVTableEntry) * id);
+    return entry->offset == 0 ? nullptr : entry;
+  }
+  const FlatVTableEntry* entry_(uint16_t id, FlatFieldKind kind) const {
+    const FlatVTableEntry* entry = entry_(id);
+    return entry != nullptr && entry->kind == static_cast<uint8_t>(kind)
+               ? entry
+               : nullptr;
+  }
+  uint32_t ref_(uint16_t id, FlatFieldKind kind) const {
+    const FlatVTableEntry* entry = entry_(id, kind);
+    return entry == nullptr ? 0 : load_<uint32_t>(pos_ + entry->offset);
+  }
+
+  const uint8_t* buffer_ = nullptr;
+  uint32_t pos_ = 0;
+};
+
+// 校验器：无需 schema，按 vtable 中记录的字段类型检查所有偏移是否越界
+// 每个表、vtable 项和表向量元素消耗一次预算，预算与消息大小成正比；
+// 多处引用的同一个子表只校验一次，时间复杂度 O(消息大小)，适合在接收不可信
+// 共享内存段时调用
+class FlatVerifier {
+ public:
+  static bool verify(const uint8_t* data, size_t size,
+                     std::string* error = nullptr);
+
+ private:
+  FlatVerifier(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+  bool verifyTable_(uint32_t pos, int depth);
+  bool verifyVector_(uint32_t pos, size_t elem_size);
+  bool charge_(size_t units) {
+    if (units > budget_) {
+      return fail_("message too complex");
+    }
+    budget_ -= units;
+    return true;
+  }
+  bool inBounds_(size_t pos, size_t len) const {
+    return pos <= size_ && len <= size_ - pos;
+  }
+  bool fail_(const std::string& reason) {
+    error_ = reason;
+    return false;
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t budget_ = 0;  // 剩余的访问次数
+  // 已校验的表 -> 校验时的深度；在不更深的位置再次引用时不再校验
+  std::unordered_map<uint32_t, int> verified_;
+  std::string error_;
+};
+
+// 拥有缓冲区的消息，用于 Publisher/Subscriber 传递
+// 读取时直接在原始字节上访问，不做反序列化
+class FlatMessage {
+ public:
+  FlatMessage() = default;
+  FlatMessage(const uint8_t* data, size_t size) : buffer_(data, data + size) {}
+  explicit FlatMessage(const FlatBuilder& builder)
+      : FlatMessage(builder.data(), builder.size()) {}
+
+  bool verify(std::string* error = nullptr) const {
+    return FlatVerifier::verify(buffer_.data(), buffer_.size(), error);
+  }
+  FlatTable root() const { return rootOf(buffer_.data(), buffer_.size()); }
+  uint16_t schemaVersion() const { return schemaVersionOf(buffer_.data()); }
+
+  const uint8_t* data() const { return buffer_.data(); }
+  size_t size() const { return buffer_.size(); }
+
+  // 直接在外部缓冲区（如共享内存）上访问，不拷贝
+  static FlatTable rootOf(const uint8_t* data, size_t size) {
+    if (data == nullptr || size < sizeof(FlatHeader)) {
+      return FlatTable();
+    }
+    FlatHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    return FlatTable(data, header.root);
+  }
+  static uint16_t schemaVersionOf(const uint8_t* data) {
+    FlatHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    return header.schema_version;
+  }
+  // 读取消息头中的实际长度，缓冲区不是合法消息时返回 0
+  static size_t messageSize(const uint8_t* data, size_t size) {
+    if (data == nullptr || size < sizeof(FlatHeader)) {
+      return 0;
+    }
+    FlatHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != FLAT_MESSAGE_MAGIC || header.size > size) {
+      return 0;
+    }
+    return header.size;
+  }
+
+ private:
+  std::vector<uint8_t> buffer_;
+};
+
+template <>
+inline void Serializer::serialize<FlatMessage>(const FlatMessage &data,
+                                               uint8_t *buffer,
+                                               size_t buffer_size) {
+  if (buffer_size < data.size() || buffer == nullptr) {
+    throw std::runtime_error("Buffer size is too small or buffer is null");
+  }
+  memcpy(buffer, data.data(), data.size());
+}
+
+// 只拷贝消息头声明的长度并校验，校验失败抛异常
+template <>
+inline void Serializer::deserialize<FlatMessage>(const uint8_t *buffer,
+                                                 size_t buffer_size,
+                                                 FlatMessage &data) {
+  size_t size = FlatMessage::messageSize(buffer, buffer_size);
+  if (size == 0) {
+    throw std::runtime_error("FlatMessage: invalid header");
+  }
+  FlatMessage message(buffer, size);
+  std::string error;
+  if (!message.verify(&error)) {
+    throw std::runtime_error("FlatMessage: verify failed: " + error);
+  }
+  data = std::move(message);
+}
+
+template <>
+inline size_t Serializer::getSerializedSize<FlatMessage>(
+    const FlatMessage &data) {
+  return data.size();
+}
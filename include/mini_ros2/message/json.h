@@ -7,18 +7,32 @@
 #include <sstream>
 #include <memory>
 #include <climits>
+#include <cstdint>
 
 // JSON 支持的类型枚举（标签）
 enum class JsonType {
     Null,
     Bool,
     Int,
+    Int64,   // 超出 int 范围的整数（如纳秒时间戳）
     Double,
     String,
     Array,
     Object
 };
 
+// 线上编码方式：文本 JSON 或二进制（MessagePack 兼容）
+enum class JsonEncoding {
+    Text,
+    Binary
+};
+
+// 二进制编码帧头：0xC1 在 MessagePack 中保留未用，也不可能是合法 JSON 文本的首字节
+// 订阅端据此自动识别编码
+#define JSON_BINARY_MAGIC 0xC1
+#define JSON_BINARY_VERSION 0x01
+#define JSON_BINARY_MAX_DEPTH 256
+
 // 前置声明
 class JsonValue;
 
@@ -36,6 +50,7 @@ private:
     union Data {
         bool bool_val;                // 布尔值
         int int_val;                  // 整数
+        int64_t int64_val;            // 64位整数
         double double_val;            // 浮点数
         std::string* str_val;         // 字符串（用指针避免联合中存储非POD类型）
         JsonArray* arr_val;           // 数组（指针）
@@ -108,6 +123,10 @@ public:
         data_.int_val = value;
     }
 
+    JsonValue(int64_t value) : type_(JsonType::Int64) {
+        data_.int64_val = value;
+    }
+
     JsonValue(double value) : type_(JsonType::Double) {
         data_.double_val = value;
     }
@@ -194,6 +213,13 @@ public:
         return *this;
     }
 
+    JsonValue& operator=(const int64_t other) {
+        destroyData();      // 先销毁当前数据
+        type_ = JsonType::Int64;
+        data_.int64_val = other;
+        return *this;
+    }
+
     JsonValue& operator=(const double other) {
         destroyData();      // 先销毁当前数据
         type_ = JsonType::Double;
@@ -227,6 +253,7 @@ public:
     bool isNull() const { return type_ == JsonType::Null; }
     bool isBool() const { return type_ == JsonType::Bool; }
     bool isInt() const { return type_ == JsonType::Int; }
+    bool isInt64() const { return type_ == JsonType::Int64; }
     bool isDouble() const { return type_ == JsonType::Double; }
     bool isString() const { return type_ == JsonType::String; }
     bool isArray() const { return type_ == JsonType::Array; }
@@ -241,12 +268,26 @@ public:
     }
 
     int asInt() const {
+        if (isInt64() && data_.int64_val >= INT_MIN && data_.int64_val <= INT_MAX) {
+            return static_cast<int>(data_.int64_val);
+        }
         if (!isInt()) {
             throw std::domain_error("JsonValue: not an integer");
         }
         return data_.int_val;
     }
 
+    // Int 和 Int64 均可按 64 位读取（文本解析时 int 范围内的整数仍为 Int）
+    int64_t asInt64() const {
+        if (isInt()) {
+            return data_.int_val;
+        }
+        if (!isInt64()) {
+            throw std::domain_error("JsonValue: not an integer");
+        }
+        return data_.int64_val;
+    }
+
     double asDouble() const {
         if (!isDouble()) {
             throw std::domain_error("JsonValue: not a double");
@@ -356,9 +397,30 @@ public:
 
     static JsonValue deserialize(const std::string& json);
 
+    // 二进制编码（MessagePack 兼容，带 2 字节帧头）
+    // 字符串/容器带长度前缀，数值按原始宽度存储，浮点数往返无精度损失
+    std::string serializeBinary() const;
+    static JsonValue deserializeBinary(const uint8_t* data, size_t size);
+
+    // 按指定编码序列化
+    std::string encode(JsonEncoding encoding) const {
+        return encoding == JsonEncoding::Binary ? serializeBinary() : serialize();
+    }
+    // 自动识别编码并反序列化；文本编码遇到 '\0' 视为结束
+    static JsonValue decode(const uint8_t* data, size_t size);
+    static bool isBinaryEncoded(const uint8_t* data, size_t size) {
+        return size >= 2 && data[0] == JSON_BINARY_MAGIC;
+    }
+
+    // 仅解析二进制对象中的一个成员，其余子树按长度跳过而不构造 JsonValue
+    static bool findBinaryMember(const uint8_t* data, size_t size,
+                                 const std::string& key, JsonValue& out);
+
 private:
     // 辅助函数：转义字符串中的特殊字符
     std::string escapeString(const std::string& str) const;
+    // 文本序列化辅助函数：追加到同一个缓冲区，避免逐层创建字符串
+    void serializeTo(std::string& out) const;
 
     static void skipWhitespace(const std::string& json, size_t& index);
     // 辅助函数：解析双引号包裹的字符串（处理转义），返回解析后的字符串，更新索引
@@ -371,6 +433,11 @@ private:
     static JsonValue parseArray(const std::string& json, size_t& index);
     // 辅助函数：解析数字（int或double），返回对应的JsonValue，更新索引
     static JsonValue parseNumber(const std::string& json, size_t& index);
+
+    // 二进制编码辅助函数
+    void encodeBinary(std::string& out) const;
+    static JsonValue parseBinary(const uint8_t* data, size_t size, size_t& index, int depth);
+    static void skipBinary(const uint8_t* data, size_t size, size_t& index, int depth);
 };
 
 
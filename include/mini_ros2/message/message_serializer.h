@@ -1,10 +1,19 @@
 #pragma once
 
+#include "mini_ros2/message/bounded.h"
 #include "mini_ros2/message/json.h"
 #include <cstring>
 #include <stdexcept>
 #include <type_traits>
 
+// 生成消息的线上格式：固定头 + 结构体原始字节
+// 订阅端通过 type_hash 校验两端的 .msg 定义是否一致，无需 JSON
+struct MessageWireHeader {
+  uint64_t type_hash;
+  uint32_t payload_size;
+  uint32_t reserved;
+};
+
 class Serializer {
 public:
   Serializer() {}
@@ -26,28 +35,70 @@ public:
   template <typename T> static size_t getSerializedSize(const T &data) {
     return sizeof(T);
   }
+
+  // 生成消息的序列化实现，由生成头文件中的特化调用
+  template <typename T>
+  static void serializeGenerated(const T &data, uint8_t *buffer,
+                                 size_t buffer_size) {
+    static_assert(MessageTraits<T>::is_generated,
+                  "serializeGenerated requires a generated message type");
+    if (buffer_size < sizeof(MessageWireHeader) + sizeof(T) ||
+        buffer == nullptr) {
+      throw std::runtime_error("Buffer size is too small or buffer is null");
+    }
+    MessageWireHeader header;
+    header.type_hash = MessageTraits<T>::type_hash;
+    header.payload_size = static_cast<uint32_t>(sizeof(T));
+    header.reserved = 0;
+    memcpy(buffer, &header, sizeof(header));
+    memcpy(buffer + sizeof(header), &data, sizeof(T));
+  }
+
+  template <typename T>
+  static void deserializeGenerated(const uint8_t *buffer, size_t buffer_size,
+                                   T &data) {
+    static_assert(MessageTraits<T>::is_generated,
+                  "deserializeGenerated requires a generated message type");
+    if (buffer_size < sizeof(MessageWireHeader) + sizeof(T) ||
+        buffer == nullptr) {
+      throw std::runtime_error("Buffer size is too small or buffer is null");
+    }
+    MessageWireHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    if (header.type_hash != MessageTraits<T>::type_hash ||
+        header.payload_size != sizeof(T)) {
+      throw std::runtime_error(std::string("Message type mismatch for ") +
+                               MessageTraits<T>::name);
+    }
+    memcpy(&data, buffer + sizeof(header), sizeof(T));
+    // 有界字段的长度来自对端，超过容量时访问会越界
+    if (!data.validate()) {
+      throw std::runtime_error(std::string("Bounded field overflow in ") +
+                               MessageTraits<T>::name);
+    }
+  }
 };
 
 template <>
 inline void Serializer::serialize<JsonValue>(const JsonValue &data,
                                              uint8_t *buffer,
                                              size_t buffer_size) {
-  if (buffer_size < data.serialize().size() || buffer == nullptr) {
+  std::string text = data.serialize();
+  if (buffer_size < text.size() || buffer == nullptr) {
     throw std::runtime_error("Buffer size is too small or buffer is null");
   }
-  memcpy(buffer, data.serialize().c_str(), buffer_size);
+  memcpy(buffer, text.c_str(), text.size());
 }
 
+// 自动识别文本/二进制编码（见 JsonValue::decode）
 template <>
 inline void Serializer::deserialize<JsonValue>(const uint8_t *buffer,
                                                size_t buffer_size,
                                                JsonValue &data) {
-  if (buffer_size < data.serialize().size() || buffer == nullptr) {
+  if (buffer == nullptr) {
     throw std::runtime_error("Buffer size is too small or buffer is null");
   }
-  data =
-      JsonValue::deserialize(std::string(reinterpret_cast<const char *>(buffer),
-                                         buffer_size)); // 包含终止符
+  data = JsonValue::decode(buffer, buffer_size);
 }
 
 template <>
@@ -0,0 +1,217 @@
+#pragma once
+#include <stdint.h>
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// 传感器消息库：结构体数组（SoA）布局 + 定长容量
+// - 每个分量独立连续存放并按 SENSOR_MSG_ALIGN 对齐，可直接用 SIMD 批量处理
+// - 所有类型 trivially copyable，可通过 Publisher::publishLoaned 直接在共享内存中构造
+// - 容量为模板参数，实际元素个数记录在 size/count 字段，只有前 size 个元素有效
+
+#define SENSOR_MSG_ALIGN 64            // 缓存行 / AVX-512 寄存器宽度
+#define SENSOR_MSG_LANES 16            // 一个对齐块内的 float 个数
+#define SENSOR_FRAME_ID_MAX 32
+
+struct SensorHeader {
+  uint64_t stamp_ns;
+  uint32_t seq;
+  uint32_t frame_id_size;
+  char frame_id[SENSOR_FRAME_ID_MAX];
+
+  void setFrameId(const std::string& id) {
+    if (id.size() > SENSOR_FRAME_ID_MAX) {
+      throw std::length_error("SensorHeader: frame_id too long: " + id);
+    }
+    std::memcpy(frame_id, id.data(), id.size());
+    frame_id_size = static_cast<uint32_t>(id.size());
+  }
+  std::string frameId() const { return std::string(frame_id, frame_id_size); }
+};
+
+// 点云：x/y/z/intensity 四个独立数组
+template <uint32_t MaxPoints>
+struct alignas(SENSOR_MSG_ALIGN) PointCloudSoA {
+  static_assert(MaxPoints > 0 && MaxPoints % SENSOR_MSG_LANES == 0,
+                "PointCloudSoA capacity must be a multiple of 16");
+  static constexpr uint32_t kCapacity = MaxPoints;
+
+  SensorHeader header;
+  uint32_t size;    // 有效点数
+  uint32_t width;   // 有序点云：每条扫描线的点数；无序点云为 size
+  uint32_t height;  // 有序点云：扫描线数；无序点云为 1
+  uint32_t reserved;
+
+  alignas(SENSOR_MSG_ALIGN) float x[MaxPoints];
+  alignas(SENSOR_MSG_ALIGN) float y[MaxPoints];
+  alignas(SENSOR_MSG_ALIGN) float z[MaxPoints];
+  alignas(SENSOR_MSG_ALIGN) float intensity[MaxPoints];
+
+  void clear() {
+    size = 0;
+    width = 0;
+    height = 1;
+    reserved = 0;
+  }
+  bool full() const { return size >= MaxPoints; }
+  void push(float px, float py, float pz, float pi) {
+    if (size >= MaxPoints) {
+      throw std::length_error("PointCloudSoA: capacity " +
+                              std::to_string(MaxPoints) + " exceeded");
+    }
+    x[size] = px;
+    y[size] = py;
+    z[size] = pz;
+    intensity[size] = pi;
+    ++size;
+  }
+  // 按 SIMD 宽度向上取整的有效长度，尾部填充值由调用方保证（如 clear 后补零）
+  uint32_t paddedSize() const {
+    return (size + SENSOR_MSG_LANES - 1) / SENSOR_MSG_LANES * SENSOR_MSG_LANES;
+  }
+};
+
+// 激光扫描：ranges/intensities 两个数组，角度由 angle_min + i * angle_increment 计算
+template <uint32_t MaxBeams>
+struct alignas(SENSOR_MSG_ALIGN) LaserScanSoA {
+  static_assert(MaxBeams > 0 && MaxBeams % SENSOR_MSG_LANES == 0,
+                "LaserScanSoA capacity must be a multiple of 16");
+  static constexpr uint32_t kCapacity = MaxBeams;
+
+  SensorHeader header;
+  float angle_min;
+  float angle_max;
+  float angle_increment;
+  float time_increment;  // 相邻光束间隔（秒）
+  float scan_time;       // 一圈扫描耗时（秒）
+  float range_min;
+  float range_max;
+  uint32_t count;  // 有效光束数
+
+  alignas(SENSOR_MSG_ALIGN) float ranges[MaxBeams];
+  alignas(SENSOR_MSG_ALIGN) float intensities[MaxBeams];
+
+  void resize(uint32_t beams) {
+    if (beams > MaxBeams) {
+      throw std::length_error("LaserScanSoA: capacity " +
+                              std::to_string(MaxBeams) + " exceeded");
+    }
+    count = beams;
+  }
+  float angleAt(uint32_t index) const {
+    return angle_min + angle_increment * static_cast<float>(index);
+  }
+};
+
+enum class PixelFormat : uint32_t {
+  Mono8 = 0,       // 1 个平面
+  Rgb8Planar = 1,  // R/G/B 三个平面
+  Yuv444Planar = 2,
+};
+
+// 图像：按通道分平面存放，每行按 SENSOR_MSG_ALIGN 对齐（step >= width）
+template <uint32_t MaxWidth, uint32_t MaxHeight, uint32_t Planes>
+struct alignas(SENSOR_MSG_ALIGN) ImagePlanar {
+  static_assert(MaxWidth > 0 && MaxHeight > 0 && Planes > 0,
+                "ImagePlanar dimensions must be positive");
+  static constexpr uint32_t kMaxWidth = MaxWidth;
+  static constexpr uint32_t kMaxHeight = MaxHeight;
+  static constexpr uint32_t kPlanes = Planes;
+  static constexpr uint32_t kStep =
+      (MaxWidth + SENSOR_MSG_ALIGN - 1) / SENSOR_MSG_ALIGN * SENSOR_MSG_ALIGN;
+  static constexpr uint32_t kPlaneSize = kStep * MaxHeight;
+
+  SensorHeader header;
+  uint32_t width;
+  uint32_t height;
+  uint32_t step;  // 行跨度（字节），固定为 kStep
+  PixelFormat format;
+
+  alignas(SENSOR_MSG_ALIGN) uint8_t data[Planes][kPlaneSize];
+
+  void setSize(uint32_t w, uint32_t h, PixelFormat fmt) {
+    if (w > MaxWidth || h > MaxHeight) {
+      throw std::length_error("ImagePlanar: " + std::to_string(w) + "x" +
+                              std::to_string(h) + " exceeds capacity");
+    }
+    width = w;
+    height = h;
+    step = kStep;
+    format = fmt;
+  }
+  uint8_t* row(uint32_t plane, uint32_t y) { return data[plane] + y * kStep; }
+  const uint8_t* row(uint32_t plane, uint32_t y) const {
+    return data[plane] + y * kStep;
+  }
+};
+
+// IMU 批量采样：高频采样攒成一批发布，降低每条消息的通知开销
+template <uint32_t MaxSamples>
+struct alignas(SENSOR_MSG_ALIGN) ImuBatch {
+  static_assert(MaxSamples > 0 && MaxSamples % SENSOR_MSG_LANES == 0,
+                "ImuBatch capacity must be a multiple of 16");
+  static constexpr uint32_t kCapacity = MaxSamples;
+
+  SensorHeader header;
+  uint32_t count;          // 本批有效采样数
+  float sample_rate_hz;
+
+  alignas(SENSOR_MSG_ALIGN) uint64_t stamp_ns[MaxSamples];
+  alignas(SENSOR_MSG_ALIGN) float accel_x[MaxSamples];  // m/s^2
+  alignas(SENSOR_MSG_ALIGN) float accel_y[MaxSamples];
+  alignas(SENSOR_MSG_ALIGN) float accel_z[MaxSamples];
+  alignas(SENSOR_MSG_ALIGN) float gyro_x[MaxSamples];  // rad/s
+  alignas(SENSOR_MSG_ALIGN) float gyro_y[MaxSamples];
+  alignas(SENSOR_MSG_ALIGN) float gyro_z[MaxSamples];
+
+  void clear() { count = 0; }
+  bool full() const { return count >= MaxSamples; }
+  void push(uint64_t stamp, float ax, float ay, float az, float gx, float gy,
+            float gz) {
+    if (count >= MaxSamples) {
+      throw std::length_error("ImuBatch: capacity " +
+                              std::to_string(MaxSamples) + " exceeded");
+    }
+    stamp_ns[count] = stamp;
+    accel_x[count] = ax;
+    accel_y[count] = ay;
+    accel_z[count] = az;
+    gyro_x[count] = gx;
+    gyro_y[count] = gy;
+    gyro_z[count] = gz;
+    ++count;
+  }
+};
+
+// 在借出的缓冲区上就地构造消息（不清零数组，只初始化调用方写入的部分）
+template <typename T>
+T* loanMessage(uint8_t* buffer, size_t capacity) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "loanMessage requires a trivially copyable message");
+  if (buffer == nullptr || capacity < sizeof(T)) {
+    throw std::length_error("loanMessage: buffer smaller than message");
+  }
+  if (reinterpret_cast<uintptr_t>(buffer) % alignof(T) != 0) {
+    throw std::invalid_argument("loanMessage: buffer misaligned");
+  }
+  return new (buffer) T;
+}
+
+// 常用容量
+using PointCloud32K = PointCloudSoA<32768>;
+using LaserScan2K = LaserScanSoA<2048>;
+using ImageVga = ImagePlanar<640, 480, 3>;
+using ImuBatch64 = ImuBatch<64>;
+
+static_assert(std::is_trivially_copyable<PointCloud32K>::value &&
+                  std::is_standard_layout<PointCloud32K>::value,
+              "sensor messages must be shm-loanable");
+static_assert(std::is_trivially_copyable<ImageVga>::value &&
+                  std::is_standard_layout<ImageVga>::value,
+              "sensor messages must be shm-loanable");
+static_assert(offsetof(PointCloud32K, x) % SENSOR_MSG_ALIGN == 0,
+              "SoA arrays must be aligned");
@@ -52,6 +52,16 @@ class Node {
     return pub;
   }
 
+  // 创建 Publisher 并按最大消息大小预先创建 event 的数据段，订阅者可以先于第一条消息启动
+  template <typename MsgT>
+  std::shared_ptr<Publisher<MsgT>> createPublisher(
+      const std::string& topic_name, const std::string& event_name,
+      size_t max_message_size, size_t qos_depth = 10) {
+    auto pub = createPublisher<MsgT>(topic_name, qos_depth);
+    pub->advertise(event_name, max_message_size);
+    return pub;
+  }
+
   // -------------------------- Subscriber 相关 --------------------------
   /**
    * @brief 创建 Subscriber（唯一入口）
@@ -68,6 +78,7 @@ class Node {
     std::string full_topic = shm_prefix_ + topic_name;
 
     // 创建具体Subscriber实例（调用私有构造函数，依赖友元关系）
+    // 发布者尚未出现时不会失败，收到第一个事件时再映射数据段
     auto sub = std::make_shared<Subscriber<MsgT>>(full_topic);
     // sub->SetCallback(callback); // 设置回调
     sub->subscribe(event_name, callback);
@@ -105,9 +116,19 @@ class Node {
 
   void printRegistry();
 
+  // 图变化回调（节点 / 发布者 / 订阅者增删），在 spin 线程中收到注册表变化通知后执行
+  // 例如订阅者出现时再开始发布：type == SubscriberAdded 且 name 为 "<topic>_<event>"
+  int addGraphChangeCallback(std::function<void(const GraphEvent&)> callback) {
+    return shm_manager_->addGraphChangeCallback(std::move(callback));
+  }
+  void removeGraphChangeCallback(int callback_id) {
+    shm_manager_->removeGraphChangeCallback(callback_id);
+  }
+
  private:
   void registerNode();
   void unregisterNode();
+  void startHeartbeat();
   void heartbeatLoop();
   void spinLoop();
   static void signalHandler(int signum);
@@ -123,8 +144,11 @@ class Node {
 
   std::thread heartbeat_thread_;
   std::atomic<bool> heartbeat_running_ = false;  // 心跳机制，定时更新节点状态
-  const int HEARTBEAT_INTERVAL = 1;              // 秒
-  const int HEARTBEAT_TIMEOUT = 3;               // 秒
+  std::mutex heartbeat_mutex_;
+  std::condition_variable heartbeat_cv_;  // 析构时唤醒心跳线程
+  const int HEARTBEAT_INTERVAL = 1;       // 秒
+  // 秒，与 NODE_HEARTBEAT_TIMEOUT_MS 一致，也是回收死亡节点的周期
+  const int HEARTBEAT_TIMEOUT = NODE_HEARTBEAT_TIMEOUT_MS / 1000;
 
   EventManager event_manager_;  // 事件管理器
   std::thread spin_thread_;
@@ -1,10 +1,17 @@
 #pragma once
 #include <sys/eventfd.h>
 
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
+#include "mini_ros2/communication/segment_broker.h"
 #include "mini_ros2/communication/shm_base.h"
 #include "mini_ros2/message/message_serializer.h"
 #include "mini_ros2/message/qos_buffer.h"
@@ -34,36 +41,80 @@ class Publisher : public PublisherBase {
   // Publisher &operator=(Publisher &&) = delete;
 
   ~Publisher() = default;
+  // 没有订阅者时直接返回（首次发布除外：需要创建数据段供订阅者打开）
   int publish(const std::string& event, const MsgT& data, int depth = 10) {
-    size_t msg_serialize_size;
-    msg_serialize_size = Serializer::getSerializedSize<MsgT>(data);
-    // std::cout << "msg_serialize_size: " << msg_serialize_size << std::endl;
-    uint8_t* buffer = new uint8_t[msg_serialize_size];
-    Serializer::serialize<MsgT>(data, buffer, msg_serialize_size);
-    std::string topic_str = topic_ + "_" + event;
-    if (shm_ == nullptr) {
-      shm_ = std::make_shared<ShmBase>(topic_str, msg_serialize_size);
-      shm_->Create();
-      shm_->Open();
+    if (!shouldPublish_(event)) {
+      return 0;
     }
-    // std::cout << data_str << std::endl;
-    // shm_->Open();
-    if(!shm_manager_->isTopicExist(topic_, event)) {
-      std::cout << "addPubTopic: " << topic_ << " " << event << std::endl;
-      shm_manager_->addPubTopic(topic_, event);
-    }
-    shm_->Write(buffer, msg_serialize_size);
-    // 触发事件：通知 ShmManager 更新 event_flag_ 并唤醒等待的订阅者
-    if (shm_manager_ && !topic_name_for_event_.empty()) {
-      std::cout << "triggerEvent: " << topic_name_for_event_ << " " << event
-      << " message: " << data.serialize() << std::endl;
-      shm_manager_->triggerEvent(topic_name_for_event_, event);
+    if constexpr (std::is_same<MsgT, JsonValue>::value) {
+      // JsonValue 按发布者选择的编码只序列化一次
+      std::string payload = data.encode(json_encoding_);
+      return publishSerialized_(
+          event, reinterpret_cast<const uint8_t*>(payload.data()),
+          payload.size());
+    } else {
+      size_t msg_serialize_size = Serializer::getSerializedSize<MsgT>(data);
+      std::vector<uint8_t> buffer(msg_serialize_size);
+      Serializer::serialize<MsgT>(data, buffer.data(), msg_serialize_size);
+      return publishSerialized_(event, buffer.data(), msg_serialize_size);
     }
+  }
 
-    delete[] buffer;
+  // 零拷贝发布：借出共享内存数据区，由 writer 直接在其中构造消息
+  // （如 FlatBuilder(buf, cap)），返回实际写入字节数；首次调用按 capacity 创建共享内存
+  int publishLoaned(const std::string& event, size_t capacity,
+                    const std::function<size_t(uint8_t*, size_t)>& writer) {
+    if (!shouldPublish_(event)) {
+      return 0;
+    }
+    ensureShm_(event, capacity);
+    shm_->Loan(writer);
+    notify_(event);
     return 0;
   }
 
+  // 按 QoS 给出的最大消息大小预先创建数据段并登记为发布者，
+  // 订阅者不必等第一条消息即可映射；之后的消息不能超过该大小
+  void advertise(const std::string& event, size_t max_message_size) {
+    ensureShm_(event, max_message_size);
+  }
+
+  // 定长消息的 publishLoanedMessage / advertiseMessage 见 sensor_publisher.h
+
+  // 消息构造代价高时使用：没有订阅者时连 make 也不调用
+  int publishIfSubscribed(const std::string& event,
+                          const std::function<MsgT()>& make) {
+    if (!shouldPublish_(event)) {
+      return 0;
+    }
+    return publish(event, make());
+  }
+
+  // 注册表维护的订阅者数量；未设置 ShmManager 时返回 -1（未知）
+  int getSubscriptionCount(const std::string& event) {
+    if (shm_manager_ == nullptr) {
+      return -1;
+    }
+    // topic 条目只增不删，event_id 查到后缓存，之后只有一次原子读
+    auto it = event_ids_.find(event);
+    if (it == event_ids_.end()) {
+      int event_id = shm_manager_->getTopicEventId(topic_, event);
+      if (event_id < 0) {
+        return 0;  // 还没有任何节点注册过这个 topic+event
+      }
+      it = event_ids_.emplace(event, event_id).first;
+    }
+    return shm_manager_->getSubscriptionCountById(it->second);
+  }
+
+  bool hasSubscribers(const std::string& event) {
+    return getSubscriptionCount(event) != 0;
+  }
+
+  // 选择 JsonValue 消息的线上编码（订阅端自动识别），其他消息类型忽略
+  void setJsonEncoding(JsonEncoding encoding) { json_encoding_ = encoding; }
+  JsonEncoding getJsonEncoding() const { return json_encoding_; }
+
   // 设置 ShmManager 引用（由 Node 调用）
   void setShmManager(ShmManager* shm_manager) { shm_manager_ = shm_manager; }
 
@@ -97,6 +148,51 @@ class Publisher : public PublisherBase {
   std::string getTopicName() const { return topic_; }
 
  private:
+  void ensureShm_(const std::string& event, size_t size) {
+    bool created = false;
+    if (shm_ == nullptr) {
+      shm_ = createTopicSegment(topic_ + "_" + event, size);
+      created = true;
+    }
+    if (created) {
+      // 订阅者可能已先登记了这个 topic：无论 topic 是否存在都登记为发布者
+      shm_manager_->addPubTopic(topic_, event);
+      // 本进程被杀死时由其他节点的回收者删除这个数据段
+      shm_manager_->claimTopicSegment(topic_, event);
+    }
+  }
+
+  // 数据段已创建且没有订阅者时跳过发布
+  bool shouldPublish_(const std::string& event) {
+    return shm_ == nullptr || hasSubscribers(event);
+  }
+
+  // 触发事件：通知 ShmManager 更新 event_flag_ 并唤醒等待的订阅者
+  void notify_(const std::string& event) {
+    if (shm_manager_ && !topic_name_for_event_.empty()) {
+      shm_manager_->triggerEvent(topic_name_for_event_, event);
+    }
+  }
+
+  int publishSerialized_(const std::string& event, const uint8_t* buffer,
+                         size_t size) {
+    ensureShm_(event, size);
+    if (size > shm_->getDataSize()) {
+      throw std::out_of_range("Publisher: message exceeds shared memory size");
+    }
+    // 消息比共享内存区短时写入结束符，避免订阅端读到上一条消息的残留；
+    // 数据和结束符在同一次持锁内写入，读端不会看到新数据接着旧消息的尾部
+    shm_->Loan([buffer, size](uint8_t* data, size_t capacity) {
+      std::memcpy(data, buffer, size);
+      if (size < capacity) {
+        data[size] = 0;
+      }
+      return size;
+    });
+    notify_(event);
+    return 0;
+  }
+
   // int count;
   int32_t host_id_;
 
@@ -106,6 +202,9 @@ class Publisher : public PublisherBase {
 
   ShmManager* shm_manager_;           // ShmManager 引用，用于触发事件
   std::string topic_name_for_event_;  // 用于事件触发的 topic 名称（去除前缀）
+  std::unordered_map<std::string, int> event_ids_;  // event -> event_id 缓存
 
   long long time_stamp_ = 0;
+
+  JsonEncoding json_encoding_ = JsonEncoding::Text;
 };
\ No newline at end of file
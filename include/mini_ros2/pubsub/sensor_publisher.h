@@ -0,0 +1,35 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "mini_ros2/message/sensor_msgs.h"
+#include "mini_ros2/pubsub/publisher.h"
+
+// 定长消息（如 sensor_msgs.h 中的 SoA 类型）的发布辅助，建立在通用的
+// Publisher::publishLoaned / advertise 之上，发布/订阅核心不依赖消息包
+
+// 零拷贝发布：fill(MsgT&) 直接填写共享内存中的消息
+template <typename MsgT, typename Fill>
+int publishLoanedMessage(Publisher<MsgT>& pub, const std::string& event,
+                         Fill&& fill) {
+  static_assert(std::is_trivially_copyable<MsgT>::value,
+                "publishLoanedMessage requires a trivially copyable message");
+  return pub.publishLoaned(event, sizeof(MsgT),
+                           [&fill](uint8_t* buffer, size_t capacity) {
+                             std::forward<Fill>(fill)(
+                                 *loanMessage<MsgT>(buffer, capacity));
+                             return sizeof(MsgT);
+                           });
+}
+
+// 按 sizeof(MsgT) 预先创建数据段并登记为发布者
+template <typename MsgT>
+void advertiseMessage(Publisher<MsgT>& pub, const std::string& event) {
+  static_assert(std::is_trivially_copyable<MsgT>::value,
+                "advertiseMessage requires a trivially copyable message");
+  pub.advertise(event, sizeof(MsgT));
+}
@@ -7,7 +7,9 @@
 #include <iostream>
 #include <mutex>
 #include <string>
+#include <vector>
 
+#include "mini_ros2/communication/segment_broker.h"
 #include "mini_ros2/communication/shm_base.h"
 #include "mini_ros2/message/message_serializer.h"
 #include "mini_ros2/message/qos_buffer.h"
@@ -47,19 +49,20 @@ class Subscriber : public SubscriberBase {
       // std::cout << Serializer::serialize(data) << std::endl;
     });
   }
+  // 发布者的数据段可以尚不存在：订阅意图由 Node 登记到注册表，
+  // 数据段在发布者出现后（收到第一个事件时）再映射，启动顺序无关
   void subscribe(const std::string& event,
                  std::function<void(const MsgT& data)> callback) {
     setCallback(callback);
-    if (shm_ == nullptr) {
-      // 订阅时创建共享内存
-      std::string shm_name = topic_ + "_" + event;
-      shm_ = std::make_shared<ShmBase>(shm_name);
-      // link("/proc/self/fd/" + std::to_string(efd), eventfd_path_.c_str());
-    }
-    // if (eventfd_path_.empty() || event_fd_ == -1) {
-    //   initEventFd();
-    // }
-    shm_->Open();
+    std::lock_guard<std::mutex> lock(mutex_);
+    shm_name_ = topic_ + "_" + event;
+    tryAttach_();
+  }
+
+  // 是否已映射发布者的数据段
+  bool isAttached() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shm_ != nullptr || tryAttach_();
   }
 
   void setCallback(std::function<void(const MsgT& data)> callback) {
@@ -121,28 +124,56 @@ class Subscriber : public SubscriberBase {
     std::cout << "test" << std::endl;
   }
 
+  // 数据段尚未出现或消息残缺（读取、反序列化失败）时返回空任务
   std::function<void()> createTaskFromSubEvent() {
     std::lock_guard<std::mutex> lock(mutex_);
-    getMessage();
+    if (!getMessage()) {
+      return []() {};
+    }
     std::shared_ptr<MsgT> msg_ptr = std::make_shared<MsgT>(msg_);
     return [this, msg_ptr]() { this->execute(msg_ptr); };
   }
 
  private:
-  void getMessage() {
+  // 调用者持有 mutex_；数据段不存在时返回 false，下次收到事件时重试
+  bool tryAttach_() {
+    if (shm_ != nullptr) {
+      return true;
+    }
+    if (shm_name_.empty()) {
+      return false;
+    }
+    try {
+      // 发布者尚未创建或正在创建数据段时为 nullptr
+      shm_ = attachTopicSegment(shm_name_);
+    } catch (const std::exception&) {
+      return false;  // 数据段代理不可用
+    }
+    return shm_ != nullptr;
+  }
+
+  bool getMessage() {
+    if (!tryAttach_()) {
+      std::cerr << "Subscription " << shm_name_ << " not attached yet"
+                << std::endl;
+      return false;
+    }
     try {
       size_t msg_serialize_size = shm_->getDataSize();
-      std::cout << "msg_serialize_size: " << msg_serialize_size << std::endl;
-      uint8_t* data = new uint8_t[msg_serialize_size];
-      shm_->ReadUnlocked(data, msg_serialize_size);
-      Serializer::deserialize<MsgT>(data, msg_serialize_size, msg_);
-      delete[] data;
+      std::vector<uint8_t> data(msg_serialize_size);
+      // 持锁读取：发布者写到一半被杀死时 Read 抛异常，丢弃这条残缺消息
+      shm_->Read(data.data(), msg_serialize_size);
+      Serializer::deserialize<MsgT>(data.data(), msg_serialize_size, msg_);
     } catch (const std::exception& e) {
+      // msg_ 仍是上一条消息，不能当作新消息再交付一次
       std::cerr << "Subscription listen error: " << e.what() << "\n";
+      return false;
     }
+    return true;
   }
   std::mutex mutex_;
   std::string topic_;
+  std::string shm_name_;  // "<topic>_<event>"，subscribe 后有效
   std::shared_ptr<ShmBase> shm_;
   std::function<void(const MsgT& data)> callback_;
   int depth_;
@@ -0,0 +1,353 @@
+#include "mini_ros2/communication/comm_adapter.h"
+
+#include <fnmatch.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include "mini_ros2/communication/segment_broker.h"
+
+uint64_t randomCommSenderId() {
+  std::random_device device;
+  uint64_t id = (static_cast<uint64_t>(device()) << 32) ^ device();
+  id ^= static_cast<uint64_t>(getpid()) << 16;
+  id ^= static_cast<uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+  return id == 0 ? 1 : id;
+}
+
+CommGateway::CommGateway(const RegistryConfig& local,
+                         std::unique_ptr<CommAdapter> adapter)
+    : local_(local), adapter_(std::move(adapter)) {
+  if (adapter_ == nullptr) {
+    throw std::invalid_argument("CommGateway: adapter is null");
+  }
+  manager_ = std::make_unique<ShmManager>(local_);
+  manager_->registerProcessNode("comm_gateway");
+  std::cout << "CommGateway: " << local_.registryName() << " sender "
+            << std::hex << adapter_->senderId() << std::dec << std::endl;
+}
+
+CommGateway::~CommGateway() {
+  stop();
+  // 先释放数据段，再注销节点
+  routes_.clear();
+  manager_->removeNode();
+}
+
+CommGateway::Route& CommGateway::routeFor_(const std::string& topic_name,
+                                           const std::string& event_name) {
+  std::string key = topic_name + "_" + event_name;
+  auto it = routes_.find(key);
+  if (it == routes_.end()) {
+    auto route = std::make_unique<Route>();
+    route->topic = local_.topicPrefix() + topic_name;
+    route->event = event_name;
+    route->remote_topic = topic_name;
+    it = routes_.emplace(key, std::move(route)).first;
+  }
+  return *it->second;
+}
+
+void CommGateway::addExport(const std::string& topic_name,
+                            const std::string& event_name,
+                            const CommEndpoint& peer) {
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  Route& route = routeFor_(topic_name, event_name);
+  if (!route.exported) {
+    // 作为订阅者注册：本地发布者不会因为没有订阅者而跳过发布
+    manager_->addSubTopic(route.topic, event_name);
+    route.event_id = manager_->registerTopicEvent(route.topic, event_name);
+    if (route.event_id < 0) {
+      throw std::runtime_error("CommGateway: failed to register " +
+                               route.topic + " " + event_name);
+    }
+    route.exported = true;
+  }
+  route.peers.push_back(peer);
+}
+
+void CommGateway::addImport(const std::string& topic_name,
+                            const std::string& event_name) {
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  routeFor_(topic_name, event_name).imported = true;
+}
+
+void CommGateway::addImportPattern(const std::string& pattern) {
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  import_patterns_.push_back(pattern);
+}
+
+void CommGateway::setRateLimit(const std::string& topic_name,
+                               const std::string& event_name, double max_hz) {
+  if (max_hz < 0 || !std::isfinite(max_hz)) {
+    throw std::invalid_argument("CommGateway: invalid rate limit for " +
+                                topic_name);
+  }
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  Route& route = routeFor_(topic_name, event_name);
+  route.min_interval =
+      max_hz == 0 ? std::chrono::steady_clock::duration::zero()
+                  : std::chrono::duration_cast<
+                        std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(1.0 / max_hz));
+}
+
+void CommGateway::setReliable(const std::string& topic_name,
+                              const std::string& event_name, bool reliable) {
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  routeFor_(topic_name, event_name).reliable = reliable;
+}
+
+void CommGateway::setMaxImportSize(size_t max_size) {
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  max_import_size_ = max_size;
+}
+
+bool CommGateway::matchesImportPattern_(const std::string& key) const {
+  for (const auto& pattern : import_patterns_) {
+    if (fnmatch(pattern.c_str(), key.c_str(), 0) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int CommGateway::exportOnce(uint64_t timeout_ms) {
+  EventFlags flags = manager_->waitForEvent(exportTimeout_(timeout_ms));
+  manager_->updateNodeHeartbeat();
+  std::vector<CommFrame> frames;
+  size_t sent = 0;
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  auto now = std::chrono::steady_clock::now();
+  for (auto& entry : routes_) {
+    Route& route = *entry.second;
+    // 不清除事件位，本地订阅者照常处理；按写入时间戳去重
+    // 推迟的消息不依赖事件位：事件位可能已被本地订阅者清除
+    if (!route.exported || (!flags.test(route.event_id) && !route.pending)) {
+      continue;
+    }
+    try {
+      if (!openExport_(route)) {
+        continue;
+      }
+      if (now < route.next_send) {
+        deferExport_(route);
+        continue;
+      }
+      route.pending = false;
+      uint64_t last_time = route.last_time;
+      if (route.shm->getDataSize() > COMM_GATEWAY_COPY_LIMIT) {
+        sent += sendInPlace_(route);
+      } else {
+        collectExport_(route, frames);
+      }
+      if (route.last_time != last_time) {
+        route.next_send = now + route.min_interval;
+      }
+    } catch (const std::exception& e) {
+      std::cerr << "CommGateway: export " << route.topic << " failed: "
+                << e.what() << std::endl;
+    }
+  }
+  // 同一轮的所有小消息和对端一次系统调用发出
+  if (!frames.empty()) {
+    sent += adapter_->sendBatch(frames);
+  }
+  stats_.sent += sent;
+  return static_cast<int>(sent);
+}
+
+void CommGateway::deferExport_(Route& route) {
+  uint64_t write_time = route.shm->lastWriteTime();
+  if (write_time == 0 || write_time == route.last_time ||
+      write_time == route.deferred_time) {
+    return;
+  }
+  if (route.pending) {
+    stats_.throttled++;  // 上一条推迟的消息被覆盖，不会再发出
+  }
+  route.pending = true;
+  route.deferred_time = write_time;
+}
+
+uint64_t CommGateway::exportTimeout_(uint64_t timeout_ms) {
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& entry : routes_) {
+    const Route& route = *entry.second;
+    if (!route.pending) {
+      continue;
+    }
+    if (route.next_send <= now) {
+      return 0;
+    }
+    // 向上取整，避免醒来时还差不到 1 毫秒而再等一轮
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+        route.next_send - now);
+    timeout_ms = std::min<uint64_t>(timeout_ms, remaining.count());
+  }
+  return timeout_ms;
+}
+
+bool CommGateway::openExport_(Route& route) {
+  if (route.shm == nullptr) {
+    // 发布者尚未创建数据段时为 nullptr
+    route.shm = attachTopicSegment(route.topic + "_" + route.event);
+  }
+  return route.shm != nullptr;
+}
+
+void CommGateway::appendFrames_(Route& route, const uint8_t* data,
+                                size_t size, uint64_t timestamp,
+                                std::vector<CommFrame>& frames) {
+  uint64_t seq = route.next_seq++;
+  for (const auto& peer : route.peers) {
+    CommFrame frame;
+    frame.topic = route.remote_topic;
+    frame.event = route.event;
+    frame.seq = seq;
+    frame.segment_size = static_cast<uint32_t>(size);
+    frame.reliable = route.reliable;
+    frame.timestamp = timestamp;
+    frame.data = data;
+    frame.size = size;
+    frame.dest = peer;
+    frames.push_back(std::move(frame));
+  }
+}
+
+bool CommGateway::collectExport_(Route& route,
+                                 std::vector<CommFrame>& frames) {
+  // 先取时间戳再读数据，与 DomainBridge 相同：并发写入最多导致重复发送，不会漏发
+  uint64_t write_time = route.shm->lastWriteTime();
+  if (write_time == 0 || write_time == route.last_time) {
+    return false;
+  }
+  route.buffer.resize(route.shm->getDataSize());
+  route.shm->Read(route.buffer.data(), route.buffer.size());
+  route.last_time = write_time;
+  appendFrames_(route, route.buffer.data(), route.buffer.size(), write_time,
+                frames);
+  return true;
+}
+
+size_t CommGateway::sendInPlace_(Route& route) {
+  uint64_t write_time = route.shm->lastWriteTime();
+  if (write_time == 0 || write_time == route.last_time) {
+    return 0;
+  }
+  size_t sent = 0;
+  // 持锁期间时间戳不会变化，View 返回的就是发出的这条消息的时间戳
+  route.last_time = route.shm->View([&](const uint8_t* data, size_t size) {
+    std::vector<CommFrame> frames;
+    appendFrames_(route, data, size, route.shm->lastWriteTime(), frames);
+    sent = adapter_->sendBatch(frames);
+  });
+  return sent;
+}
+
+void CommGateway::onMessage_(const CommMessage& msg) {
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  std::string key = msg.topic + "_" + msg.event;
+  auto it = routes_.find(key);
+  Route* found = it == routes_.end() ? nullptr : it->second.get();
+  if ((found == nullptr || !found->imported) && matchesImportPattern_(key)) {
+    found = &routeFor_(msg.topic, msg.event);
+    found->imported = true;
+  }
+  if (found == nullptr || !found->imported) {
+    stats_.ignored++;
+    return;
+  }
+  Route& route = *found;
+  // 每个发送端的第一帧作为起点，之后按序号统计丢失，丢弃重复和迟到的帧
+  auto seq_it = route.last_seq.find(msg.sender_id);
+  if (seq_it != route.last_seq.end()) {
+    if (msg.seq <= seq_it->second) {
+      stats_.duplicates++;
+      return;
+    }
+    stats_.lost += msg.seq - seq_it->second - 1;
+  }
+  route.last_seq[msg.sender_id] = msg.seq;
+
+  if (route.shm == nullptr) {
+    // 至少放得下这条消息和结束符，至多 max_import_size_
+    size_t segment_size = std::max<size_t>(msg.segment_size, msg.size + 1);
+    route.shm = manager_->openPublisherSegment(
+        route.topic, route.event, std::min(segment_size, max_import_size_));
+  }
+  const uint8_t* data = msg.data;
+  size_t size = msg.size;
+  // 与 Publisher 相同：消息比数据区短时写入结束符，与数据在同一次持锁内写入
+  route.shm->Loan([data, size](uint8_t* buffer, size_t capacity) {
+    size_t written = std::min(size, capacity);
+    std::memcpy(buffer, data, written);
+    if (written < capacity) {
+      buffer[written] = 0;
+    }
+    return written;
+  });
+  // 记录这次写入，导出时跳过，避免把收到的消息再发回网络
+  route.last_time = route.shm->lastWriteTime();
+  stats_.received++;
+  if (msg.source_time != 0) {
+    uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+    // 偏移估计有误差，极短的延迟可能算成负数，按 0 计
+    uint64_t latency = now > msg.source_time ? now - msg.source_time : 0;
+    stats_.latency_count++;
+    stats_.latency_sum_us += latency;
+    stats_.latency_max_us = std::max(stats_.latency_max_us, latency);
+  }
+  manager_->triggerEvent(route.topic, route.event);
+}
+
+CommStats CommGateway::getStats() {
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  return stats_;
+}
+
+void CommGateway::start() {
+  if (running_) return;
+  running_ = true;
+  adapter_->start([this](const CommMessage& msg) {
+    try {
+      onMessage_(msg);
+    } catch (const std::exception& e) {
+      std::cerr << "CommGateway: import " << msg.topic << " failed: "
+                << e.what() << std::endl;
+    }
+  });
+  export_thread_ = std::thread(&CommGateway::exportLoop_, this);
+}
+
+void CommGateway::stop() {
+  running_ = false;
+  if (manager_) {
+    manager_->notifyAllWaiters();
+  }
+  if (export_thread_.joinable()) {
+    export_thread_.join();
+  }
+  if (adapter_) {
+    adapter_->stop();
+  }
+}
+
+void CommGateway::exportLoop_() {
+  pthread_setname_np(pthread_self(), "comm_export");
+  while (running_) {
+    try {
+      exportOnce(100);
+    } catch (const std::exception& e) {
+      std::cerr << "CommGateway: " << e.what() << std::endl;
+    }
+  }
+}
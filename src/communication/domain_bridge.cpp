@@ -0,0 +1,129 @@
+#include "mini_ros2/communication/domain_bridge.h"
+
+#include <chrono>
+#include <iostream>
+
+#include "mini_ros2/communication/segment_broker.h"
+
+DomainBridge::DomainBridge(const RegistryConfig& from, const RegistryConfig& to)
+    : from_(from), to_(to) {
+  if (from_.registryName() == to_.registryName()) {
+    throw std::invalid_argument(
+        "DomainBridge: source and destination are the same partition " +
+        from_.registryName());
+  }
+  src_manager_ = std::make_unique<ShmManager>(from_);
+  dst_manager_ = std::make_unique<ShmManager>(to_);
+  src_manager_->registerProcessNode("domain_bridge");
+  dst_manager_->registerProcessNode("domain_bridge");
+  std::cout << "DomainBridge: " << from_.registryName() << " -> "
+            << to_.registryName() << std::endl;
+}
+
+DomainBridge::~DomainBridge() {
+  stop();
+  // 先释放目标数据段，再注销节点
+  routes_.clear();
+  src_manager_->removeNode();
+  dst_manager_->removeNode();
+}
+
+void DomainBridge::addRoute(const std::string& topic_name,
+                            const std::string& event_name) {
+  Route route;
+  route.src_topic = from_.topicPrefix() + topic_name;
+  route.dst_topic = to_.topicPrefix() + topic_name;
+  route.event = event_name;
+  // 在源分区中作为订阅者注册，发布者出现前也能拿到 event_id
+  src_manager_->addSubTopic(route.src_topic, event_name);
+  route.src_event_id =
+      src_manager_->registerTopicEvent(route.src_topic, event_name);
+  if (route.src_event_id < 0) {
+    throw std::runtime_error("DomainBridge: failed to register " +
+                             route.src_topic + " " + event_name);
+  }
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  routes_.push_back(std::move(route));
+}
+
+int DomainBridge::forwardOnce(uint64_t timeout_ms) {
+  EventFlags flags = src_manager_->waitForEvent(timeout_ms);
+  src_manager_->updateNodeHeartbeat();
+  dst_manager_->updateNodeHeartbeat();
+  int forwarded = 0;
+  std::lock_guard<std::mutex> lock(routes_mutex_);
+  for (auto& route : routes_) {
+    // 不清除源分区的事件位，源分区内的订阅者照常处理；按写入时间戳去重
+    if (!flags.test(route.src_event_id)) {
+      continue;
+    }
+    try {
+      if (forwardRoute_(route)) {
+        forwarded++;
+      }
+    } catch (const std::exception& e) {
+      std::cerr << "DomainBridge: forward " << route.src_topic << " failed: "
+                << e.what() << std::endl;
+    }
+  }
+  return forwarded;
+}
+
+bool DomainBridge::forwardRoute_(Route& route) {
+  if (route.src_shm == nullptr) {
+    route.src_shm = attachTopicSegment(route.src_topic + "_" + route.event);
+    if (route.src_shm == nullptr) {
+      return false;  // 发布者尚未创建数据段
+    }
+  }
+  // 先取时间戳再读数据：读到的消息不早于该时间戳，并发写入最多导致重复转发，不会漏发
+  uint64_t write_time = route.src_shm->lastWriteTime();
+  if (write_time == 0 || write_time == route.last_time) {
+    return false;
+  }
+  size_t size = route.src_shm->getDataSize();
+  std::vector<uint8_t> data(size);
+  route.src_shm->Read(data.data(), size);
+  route.last_time = write_time;
+
+  ensureDstShm_(route, size);
+  size_t copy_size = std::min(size, route.dst_shm->getDataSize());
+  route.dst_shm->Write(data.data(), copy_size);
+  dst_manager_->triggerEvent(route.dst_topic, route.event);
+  return true;
+}
+
+void DomainBridge::ensureDstShm_(Route& route, size_t size) {
+  if (route.dst_shm == nullptr) {
+    // 目标分区中已有同名数据段（例如本地发布者）时按已有大小写入
+    route.dst_shm =
+        dst_manager_->openPublisherSegment(route.dst_topic, route.event, size);
+  }
+}
+
+void DomainBridge::start() {
+  if (running_) return;
+  running_ = true;
+  bridge_thread_ = std::thread(&DomainBridge::bridgeLoop_, this);
+}
+
+void DomainBridge::stop() {
+  running_ = false;
+  if (src_manager_) {
+    src_manager_->notifyAllWaiters();
+  }
+  if (bridge_thread_.joinable()) {
+    bridge_thread_.join();
+  }
+}
+
+void DomainBridge::bridgeLoop_() {
+  pthread_setname_np(pthread_self(), "domain_bridge");
+  while (running_) {
+    try {
+      forwardOnce(100);
+    } catch (const std::exception& e) {
+      std::cerr << "DomainBridge: " << e.what() << std::endl;
+    }
+  }
+}
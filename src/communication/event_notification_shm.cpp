@@ -1,22 +1,35 @@
 #include "mini_ros2/communication/event_notification_shm.h"
 
+#include <errno.h>
 #include <sys/mman.h>
 
 #include <chrono>
 #include <cstring>
 #include <ctime>
 
-EventNotificationShm::EventNotificationShm() {
-  shm_ = std::make_shared<SharedMemory>(EVENT_NOTIFICATION_SHM_NAME,
-                                        EVENT_NOTIFICATION_SHM_SIZE);
+#include "mini_ros2/communication/robust_mutex.h"
+
+EventNotificationShm::EventNotificationShm(const std::string& name)
+    : name_(name) {
+  shm_ = std::make_shared<SharedMemory>(name_, EVENT_NOTIFICATION_SHM_SIZE);
 }
 
 EventNotificationShm::~EventNotificationShm() {
+  // 扩展块的生命周期跟随基段：基段创建者退出时一并删除
+  if (shm_ && data_ptr_ != nullptr && is_owner_ && shm_->IsOwner()) {
+    uint32_t chunk_count =
+        __atomic_load_n(&data_ptr_->chunk_count_, __ATOMIC_ACQUIRE);
+    ext_chunks_.clear();
+    for (uint32_t i = 1; i < chunk_count; ++i) {
+      shm_unlink((name_ + "." + std::to_string(i)).c_str());
+    }
+  }
+  ext_chunks_.clear();
   // 清理共享内存
   if (shm_) {
     if (is_owner_ && shm_->IsOwner()) {
       std::cout << "EventNotificationShm destructor: cleaning up shared memory "
-                << EVENT_NOTIFICATION_SHM_NAME << std::endl;
+                << name_ << std::endl;
       // SharedMemory 的析构函数会自动调用 Unlink() 如果 is_owner_ 为 true
       // 但我们需要先关闭，然后让 SharedMemory 的析构函数处理 Unlink
       shm_->Close();
@@ -70,54 +83,13 @@ void EventNotificationShm::initMutexAndCond() {
         "Failed to get event notification shared memory pointer");
   }
 
-  // 初始化互斥锁
-  pthread_mutexattr_t mutex_attr;
-  int ret = pthread_mutexattr_init(&mutex_attr);
-  if (ret != 0) {
-    throw std::runtime_error("Failed to init mutex attr: " +
-                             std::string(strerror(ret)));
-  }
-
-  ret = pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
-  if (ret != 0) {
-    pthread_mutexattr_destroy(&mutex_attr);
-    throw std::runtime_error("Failed to set mutex shared: " +
-                             std::string(strerror(ret)));
-  }
-
-  ret = pthread_mutex_init(&head->mutex_, &mutex_attr);
-  if (ret != 0) {
-    pthread_mutexattr_destroy(&mutex_attr);
-    throw std::runtime_error("Failed to init mutex: " +
-                             std::string(strerror(ret)));
-  }
-  pthread_mutexattr_destroy(&mutex_attr);
-
-  // 初始化条件变量
-  pthread_condattr_t cond_attr;
-  ret = pthread_condattr_init(&cond_attr);
-  if (ret != 0) {
-    throw std::runtime_error("Failed to init cond attr: " +
-                             std::string(strerror(ret)));
-  }
-
-  ret = pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
-  if (ret != 0) {
-    pthread_condattr_destroy(&cond_attr);
-    throw std::runtime_error("Failed to set cond shared: " +
-                             std::string(strerror(ret)));
-  }
-
-  ret = pthread_cond_init(&head->cond_, &cond_attr);
-  if (ret != 0) {
-    pthread_condattr_destroy(&cond_attr);
-    throw std::runtime_error("Failed to init cond: " +
-                             std::string(strerror(ret)));
-  }
-  pthread_condattr_destroy(&cond_attr);
+  // 初始化互斥锁（robust）和条件变量
+  initRobustMutex(&head->mutex_);
+  initSharedCond(&head->cond_);
 
   // 设置初始化标志
   head->initialized_ = 0x4556454E;  // "EVEN"
+  head->chunk_count_ = 1;
   head->event_flag_.reset();
   head->time_ = 0;
 
@@ -136,10 +108,85 @@ void EventNotificationShm::cachePointers() {
   mutex_ptr_ = &head->mutex_;
   cond_ptr_ = &head->cond_;
   event_flag_ptr_ = &head->event_flag_;
+  flag_chunks_.assign(1, event_flag_ptr_);
+  ext_chunks_.clear();
+}
+
+std::unique_ptr<SharedMemory> EventNotificationShm::openChunk_(
+    int index, bool create) const {
+  auto chunk = std::make_unique<SharedMemory>(
+      name_ + "." + std::to_string(index),
+      sizeof(std::bitset<EVENT_MAX_COUNT>));
+  if (create) {
+    // 上次运行残留的同名块直接复用
+    if (!chunk->Create() && !chunk->Open()) {
+      throw std::runtime_error("Failed to create event flag chunk " +
+                               std::to_string(index));
+    }
+    static_cast<std::bitset<EVENT_MAX_COUNT>*>(chunk->Data())->reset();
+    chunk->ReleaseOwnership();
+  } else if (!chunk->Open()) {
+    throw std::runtime_error("Failed to open event flag chunk " +
+                             std::to_string(index));
+  }
+  return chunk;
+}
+
+void EventNotificationShm::mapChunksLocked_() const {
+  uint32_t chunk_count = data_ptr_->chunk_count_;
+  while (flag_chunks_.size() < chunk_count) {
+    ext_chunks_.push_back(openChunk_(flag_chunks_.size(), false));
+    flag_chunks_.push_back(static_cast<std::bitset<EVENT_MAX_COUNT>*>(
+        ext_chunks_.back()->Data()));
+  }
+}
+
+EventFlags EventNotificationShm::copyFlagsLocked_() const {
+  mapChunksLocked_();
+  EventFlags flags;
+  flags.chunks_.reserve(flag_chunks_.size());
+  for (const auto* chunk : flag_chunks_) {
+    flags.chunks_.push_back(*chunk);
+  }
+  return flags;
+}
+
+void EventNotificationShm::ensureCapacity(int event_count) {
+  if (event_count > EVENT_MAX_CHUNKS * EVENT_MAX_COUNT) {
+    throw std::length_error("EventNotificationShm: event capacity " +
+                            std::to_string(event_count) + " exceeds limit");
+  }
+  lock();
+  try {
+    mapChunksLocked_();
+    while (static_cast<int>(flag_chunks_.size()) * EVENT_MAX_COUNT <
+           event_count) {
+      ext_chunks_.push_back(openChunk_(flag_chunks_.size(), true));
+      flag_chunks_.push_back(static_cast<std::bitset<EVENT_MAX_COUNT>*>(
+          ext_chunks_.back()->Data()));
+      // 块初始化完成后再发布块数
+      __atomic_store_n(&data_ptr_->chunk_count_,
+                       static_cast<uint32_t>(flag_chunks_.size()),
+                       __ATOMIC_RELEASE);
+    }
+  } catch (...) {
+    unlock();
+    throw;
+  }
+  unlock();
+}
+
+int EventNotificationShm::capacity() const {
+  if (data_ptr_ == nullptr) {
+    return 0;
+  }
+  return static_cast<int>(
+             __atomic_load_n(&data_ptr_->chunk_count_, __ATOMIC_ACQUIRE)) *
+         EVENT_MAX_COUNT;
 }
 
 void EventNotificationShm::triggerEvent(int event_id) {
-  if (event_id < 0 || event_id >= EVENT_MAX_COUNT) {
+  if (event_id < 0 || event_id >= EVENT_MAX_CHUNKS * EVENT_MAX_COUNT) {
     return;  // 无效的 event_id
   }
 
@@ -149,15 +196,15 @@ void EventNotificationShm::triggerEvent(int event_id) {
   }
 
   // 获取锁
-  int ret = pthread_mutex_lock(mutex_ptr_);
-  if (ret != 0) {
-    throw std::runtime_error("Failed to lock mutex: " +
-                             std::string(strerror(ret)));
-  }
+  lockRobust_();
 
   try {
-    // 设置对应的位
-    event_flag_ptr_->set(event_id);
+    // 设置对应的位（超出已分配块的事件忽略）
+    mapChunksLocked_();
+    size_t chunk = event_id / EVENT_MAX_COUNT;
+    if (chunk < flag_chunks_.size()) {
+      flag_chunks_[chunk]->set(event_id % EVENT_MAX_COUNT);
+    }
     // 更新时间戳
     data_ptr_->time_ = std::chrono::duration_cast<std::chrono::microseconds>(
                            std::chrono::system_clock::now().time_since_epoch())
@@ -170,50 +217,33 @@ void EventNotificationShm::triggerEvent(int event_id) {
   }
 
   // 释放锁
-  ret = pthread_mutex_unlock(mutex_ptr_);
+  int ret = pthread_mutex_unlock(mutex_ptr_);
   if (ret != 0) {
     throw std::runtime_error("Failed to unlock mutex: " +
                              std::string(strerror(ret)));
   }
 }
 
-std::bitset<EVENT_MAX_COUNT> EventNotificationShm::waitForEvent(
-    uint64_t timeout_ms) {
+EventFlags EventNotificationShm::waitForEvent(uint64_t timeout_ms) {
   if (mutex_ptr_ == nullptr) {
     throw std::runtime_error(
         "Event notification shared memory not initialized");
   }
 
   // 获取锁
-  int ret = pthread_mutex_lock(mutex_ptr_);
-  if (ret != 0) {
-    throw std::runtime_error("Failed to lock mutex: " +
-                             std::string(strerror(ret)));
-  }
+  lockRobust_();
 
-  std::bitset<EVENT_MAX_COUNT> event_flag;
+  EventFlags event_flag;
   try {
-    // 等待条件变量（带超时）
-    struct timespec abstime;
-    clock_gettime(CLOCK_REALTIME, &abstime);
-    abstime.tv_sec += timeout_ms / 1000;
-    abstime.tv_nsec += (timeout_ms % 1000) * 1000000;
-    if (abstime.tv_nsec >= 1000000000) {
-      abstime.tv_sec += 1;
-      abstime.tv_nsec -= 1000000000;
-    }
-
-    ret = pthread_cond_timedwait(cond_ptr_, mutex_ptr_, &abstime);
+    // 等待条件变量（带超时），等待期间持锁进程崩溃时锁已在 robustTimedWait 中恢复
+    struct timespec abstime = deadlineAfterMs(timeout_ms);
+    int ret = robustTimedWait(cond_ptr_, mutex_ptr_, abstime, nullptr);
     if (ret == ETIMEDOUT) {
       // 超时，返回当前的事件标志位（可能为0）
-      event_flag = *event_flag_ptr_;
-    } else if (ret != 0) {
-      pthread_mutex_unlock(mutex_ptr_);
-      throw std::runtime_error("Failed to wait cond: " +
-                               std::string(strerror(ret)));
+      event_flag = copyFlagsLocked_();
     } else {
       // 被唤醒，读取事件标志位
-      event_flag = *event_flag_ptr_;
+      event_flag = copyFlagsLocked_();
     }
   } catch (...) {
     pthread_mutex_unlock(mutex_ptr_);
@@ -221,7 +251,7 @@ std::bitset<EVENT_MAX_COUNT> EventNotificationShm::waitForEvent(
   }
 
   // 释放锁
-  ret = pthread_mutex_unlock(mutex_ptr_);
+  int ret = pthread_mutex_unlock(mutex_ptr_);
   if (ret != 0) {
     throw std::runtime_error("Failed to unlock mutex: " +
                              std::string(strerror(ret)));
@@ -230,31 +260,29 @@ std::bitset<EVENT_MAX_COUNT> EventNotificationShm::waitForEvent(
   return event_flag;
 }
 
-std::bitset<EVENT_MAX_COUNT> EventNotificationShm::readAndClearEvents() {
+EventFlags EventNotificationShm::readAndClearEvents() {
   if (mutex_ptr_ == nullptr) {
     throw std::runtime_error(
         "Event notification shared memory not initialized");
   }
 
   // 获取锁
-  int ret = pthread_mutex_lock(mutex_ptr_);
-  if (ret != 0) {
-    throw std::runtime_error("Failed to lock mutex: " +
-                             std::string(strerror(ret)));
-  }
+  lockRobust_();
 
-  std::bitset<EVENT_MAX_COUNT> event_flag;
+  EventFlags event_flag;
   try {
     // 读取并清除事件标志位
-    event_flag = *event_flag_ptr_;
-    event_flag_ptr_->reset();
+    event_flag = copyFlagsLocked_();
+    for (auto* chunk : flag_chunks_) {
+      chunk->reset();
+    }
   } catch (...) {
     pthread_mutex_unlock(mutex_ptr_);
     throw;
   }
 
   // 释放锁
-  ret = pthread_mutex_unlock(mutex_ptr_);
+  int ret = pthread_mutex_unlock(mutex_ptr_);
   if (ret != 0) {
     throw std::runtime_error("Failed to unlock mutex: " +
                              std::string(strerror(ret)));
@@ -263,23 +291,25 @@ std::bitset<EVENT_MAX_COUNT> EventNotificationShm::readAndClearEvents() {
   return event_flag;
 }
 
-std::bitset<EVENT_MAX_COUNT> EventNotificationShm::readEvents() const {
+EventFlags EventNotificationShm::readEvents() const {
   if (mutex_ptr_ == nullptr) {
     throw std::runtime_error(
         "Event notification shared memory not initialized");
   }
 
   // 获取锁
-  int ret = pthread_mutex_lock(mutex_ptr_);
-  if (ret != 0) {
-    throw std::runtime_error("Failed to lock mutex: " +
-                             std::string(strerror(ret)));
-  }
+  lockRobust_();
 
-  std::bitset<EVENT_MAX_COUNT> event_flag = *event_flag_ptr_;
+  EventFlags event_flag;
+  try {
+    event_flag = copyFlagsLocked_();
+  } catch (...) {
+    pthread_mutex_unlock(mutex_ptr_);
+    throw;
+  }
 
   // 释放锁
-  ret = pthread_mutex_unlock(mutex_ptr_);
+  int ret = pthread_mutex_unlock(mutex_ptr_);
   if (ret != 0) {
     throw std::runtime_error("Failed to unlock mutex: " +
                              std::string(strerror(ret)));
@@ -293,8 +323,9 @@ void EventNotificationShm::notifyAll() {
     return;  // 未初始化
   }
   // 获取锁
-  int ret = pthread_mutex_lock(mutex_ptr_);
-  if (ret != 0) {
+  try {
+    lockRobust_();
+  } catch (const std::exception&) {
     return;  // 获取锁失败，忽略错误
   }
   // 通知所有等待的线程
@@ -311,21 +342,27 @@ void EventNotificationShm::clearEvents(int event_id) {
   }
 
   // 获取锁
-  int ret = pthread_mutex_lock(mutex_ptr_);
-  if (ret != 0) {
-    throw std::runtime_error("Failed to lock mutex: " +
-                             std::string(strerror(ret)));
-  }
+  lockRobust_();
 
-  event_flag_ptr_->reset(event_id);
+  try {
+    mapChunksLocked_();
+    size_t chunk = static_cast<size_t>(event_id) / EVENT_MAX_COUNT;
+    if (event_id >= 0 && chunk < flag_chunks_.size()) {
+      flag_chunks_[chunk]->reset(event_id % EVENT_MAX_COUNT);
+    }
+  } catch (...) {
+    pthread_mutex_unlock(mutex_ptr_);
+    throw;
+  }
 
   // 释放锁
-  ret = pthread_mutex_unlock(mutex_ptr_);
+  int ret = pthread_mutex_unlock(mutex_ptr_);
   if (ret != 0) {
     throw std::runtime_error("Failed to unlock mutex: " +
                              std::string(strerror(ret)));
   }
 }
+
 void EventNotificationShm::clearEvents() {
   if (mutex_ptr_ == nullptr) {
     throw std::runtime_error(
@@ -333,16 +370,21 @@ void EventNotificationShm::clearEvents() {
   }
 
   // 获取锁
-  int ret = pthread_mutex_lock(mutex_ptr_);
-  if (ret != 0) {
-    throw std::runtime_error("Failed to lock mutex: " +
-                             std::string(strerror(ret)));
-  }
+  lockRobust_();
 
-  event_flag_ptr_->reset();
+  try {
+    // 其他进程可能已追加标志块，先映射才能清除全部事件位
+    mapChunksLocked_();
+    for (auto* chunk : flag_chunks_) {
+      chunk->reset();
+    }
+  } catch (...) {
+    pthread_mutex_unlock(mutex_ptr_);
+    throw;
+  }
 
   // 释放锁
-  ret = pthread_mutex_unlock(mutex_ptr_);
+  int ret = pthread_mutex_unlock(mutex_ptr_);
   if (ret != 0) {
     throw std::runtime_error("Failed to unlock mutex: " +
                              std::string(strerror(ret)));
@@ -354,11 +396,7 @@ void EventNotificationShm::lock() {
     throw std::runtime_error(
         "Event notification shared memory not initialized");
   }
-  int ret = pthread_mutex_lock(mutex_ptr_);
-  if (ret != 0) {
-    throw std::runtime_error("Failed to lock mutex: " +
-                             std::string(strerror(ret)));
-  }
+  lockRobust_();
 }
 
 void EventNotificationShm::unlock() {
@@ -372,3 +410,13 @@ void EventNotificationShm::unlock() {
                              std::string(strerror(ret)));
   }
 }
+
+void EventNotificationShm::lockRobust_() const {
+  if (robustLock(mutex_ptr_)) {
+    // 持锁进程在修改标志位时被杀死：单个位的置位 / 清除不会半途而废，
+    // 但它可能没来得及广播，唤醒所有等待者重新读取标志位
+    std::cerr << "EventNotificationShm: lock owner died, waking waiters"
+              << std::endl;
+    pthread_cond_broadcast(cond_ptr_);
+  }
+}
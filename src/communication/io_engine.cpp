@@ -0,0 +1,187 @@
+#include "mini_ros2/communication/io_engine.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "mini_ros2/communication/io_uring_engine.h"
+
+IoBackend ioBackendFromEnv() {
+  const char* value = std::getenv(IO_BACKEND_ENV);
+  if (value == nullptr) {
+    return IoBackend::Auto;
+  }
+  if (std::strcmp(value, "io_uring") == 0) {
+    return IoBackend::IoUring;
+  }
+  if (std::strcmp(value, "epoll") == 0) {
+    return IoBackend::Epoll;
+  }
+  return IoBackend::Auto;
+}
+
+std::unique_ptr<IoEngine> createIoEngine(IoBackend backend) {
+  if (backend == IoBackend::Epoll) {
+    return std::make_unique<EpollIoEngine>();
+  }
+  if (UringIoEngine::isSupported()) {
+    return std::make_unique<UringIoEngine>();
+  }
+  if (backend == IoBackend::IoUring) {
+    throw std::runtime_error("io_uring is not supported by this kernel");
+  }
+  return std::make_unique<EpollIoEngine>();
+}
+
+EpollIoEngine::~EpollIoEngine() { stop(); }
+
+size_t EpollIoEngine::sendBatch(int fd, std::vector<mmsghdr>& msgs) {
+  size_t sent = 0;
+  size_t ok = 0;
+  while (sent < msgs.size()) {
+    int ret = sendmmsg(fd, msgs.data() + sent,
+                       static_cast<unsigned int>(msgs.size() - sent), 0);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        // 接收线程把套接字设成了非阻塞，发送缓冲区满时等它腾出空间
+        pollfd pfd = {fd, POLLOUT, 0};
+        poll(&pfd, 1, 100);
+        continue;
+      }
+      // 一个报文失败（例如对端不可达）时跳过它，继续发送后面的报文
+      std::cerr << "EpollIoEngine: sendmmsg failed: " << strerror(errno)
+                << std::endl;
+      msgs[sent].msg_len = 0;
+      sent++;
+      continue;
+    }
+    ok += ret;
+    sent += ret;
+  }
+  return ok;
+}
+
+size_t EpollIoEngine::writeBatch(int fd, const std::vector<IoWrite>& writes) {
+  // 首尾相接的请求（如按顺序追加的录制文件）合并成一次 pwritev
+  size_t total = 0;
+  size_t i = 0;
+  std::vector<iovec> iovecs;
+  while (i < writes.size()) {
+    uint64_t offset = writes[i].offset;
+    uint64_t end = offset;
+    iovecs.clear();
+    while (i < writes.size() && writes[i].offset == end &&
+           iovecs.size() < IOV_MAX) {
+      iovecs.push_back({const_cast<void*>(writes[i].data), writes[i].size});
+      end += writes[i].size;
+      i++;
+    }
+    size_t done = 0;
+    size_t length = end - offset;
+    size_t first = 0;
+    while (done < length) {
+      ssize_t ret = pwritev(fd, iovecs.data() + first,
+                            static_cast<int>(iovecs.size() - first),
+                            static_cast<off_t>(offset + done));
+      if (ret < 0) {
+        if (errno == EINTR) continue;
+        throw std::runtime_error("EpollIoEngine: pwritev failed: " +
+                                 std::string(strerror(errno)));
+      }
+      done += ret;
+      // 短写：跳过已写完的 iovec，调整部分写入的那一个
+      size_t skip = ret;
+      while (first < iovecs.size() && skip >= iovecs[first].iov_len) {
+        skip -= iovecs[first].iov_len;
+        first++;
+      }
+      if (first < iovecs.size()) {
+        iovecs[first].iov_base = static_cast<char*>(iovecs[first].iov_base) +
+                                 skip;
+        iovecs[first].iov_len -= skip;
+      }
+    }
+    total += length;
+  }
+  return total;
+}
+
+void EpollIoEngine::addReceiver(int fd, size_t max_size,
+                                ReceiveHandler handler) {
+  auto receiver = std::make_unique<Receiver>();
+  receiver->fd = fd;
+  receiver->max_size = max_size;
+  receiver->handler = std::move(handler);
+  receiver->buffer.resize(IO_RECV_BATCH * max_size);
+  receivers_.push_back(std::move(receiver));
+}
+
+void EpollIoEngine::start(uint64_t tick_ms, std::function<void()> tick) {
+  if (event_manager_) return;
+  event_manager_ = std::make_unique<EventManager>();
+  for (auto& receiver : receivers_) {
+    Receiver* r = receiver.get();
+    EventSource source;
+    source.efd_name = "io_receiver";
+    source.efd = r->fd;
+    source.type = EVENT_TYPE_IO;
+    source.data = r;
+    source.callback = [r]() { drain_(*r); };
+    if (!event_manager_->addEventSource(source)) {
+      throw std::runtime_error("EpollIoEngine: failed to watch fd " +
+                               std::to_string(r->fd));
+    }
+  }
+  if (tick) {
+    event_manager_->setTickCallback(tick_ms, std::move(tick));
+  }
+}
+
+void EpollIoEngine::stop() {
+  // EventManager 析构时停止并等待事件线程
+  event_manager_.reset();
+}
+
+void EpollIoEngine::drain_(Receiver& receiver) {
+  iovec iovecs[IO_RECV_BATCH];
+  mmsghdr msgs[IO_RECV_BATCH];
+  sockaddr_in sources[IO_RECV_BATCH];
+  while (true) {
+    for (size_t i = 0; i < IO_RECV_BATCH; i++) {
+      iovecs[i].iov_base = receiver.buffer.data() + i * receiver.max_size;
+      iovecs[i].iov_len = receiver.max_size;
+      std::memset(&msgs[i], 0, sizeof(mmsghdr));
+      std::memset(&sources[i], 0, sizeof(sockaddr_in));
+      msgs[i].msg_hdr.msg_name = &sources[i];
+      msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+      msgs[i].msg_hdr.msg_iov = &iovecs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int ret = recvmmsg(receiver.fd, msgs, IO_RECV_BATCH, MSG_DONTWAIT,
+                       nullptr);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        std::cerr << "EpollIoEngine: recvmmsg failed: " << strerror(errno)
+                  << std::endl;
+      }
+      return;
+    }
+    for (int i = 0; i < ret; i++) {
+      if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+        continue;
+      }
+      receiver.handler(static_cast<const uint8_t*>(iovecs[i].iov_base),
+                       msgs[i].msg_len, sources[i]);
+    }
+    if (ret < IO_RECV_BATCH) {
+      return;
+    }
+  }
+}
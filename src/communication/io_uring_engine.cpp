@@ -0,0 +1,639 @@
+#include "mini_ros2/communication/io_uring_engine.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned to_submit, unsigned min_complete,
+                 unsigned flags, const void* arg, size_t arg_size) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                  min_complete, flags, arg, arg_size));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void* arg,
+                    unsigned nr_args) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// 缓冲区环的第 i 项。不用 io_uring_buf_ring::bufs：C++ 下 __DECLARE_FLEX_ARRAY
+// 展开成带空结构体的包装，bufs 偏移为 8 而不是 0，与内核的布局不一致
+io_uring_buf* ringBuffer(io_uring_buf_ring* ring, unsigned index) {
+  return reinterpret_cast<io_uring_buf*>(ring) + index;
+}
+
+// 接收线程环上的 user_data：0 为唤醒 eventfd 的读请求，i + 1 为第 i 个接收者
+#define WAKE_USER_DATA 0
+#define RECV_BUFFER_GROUP 0
+
+}  // namespace
+
+// 一个 io_uring 实例：映射提交队列 / 完成队列，只由一个线程（或持锁的线程）使用
+class IoUringRing {
+ public:
+  // cq_entries 为 0 时完成队列是提交队列的两倍；多发请求一次提交产生大量完成事件，
+  // 需要单独放大，否则完成队列溢出会终止多发请求
+  explicit IoUringRing(unsigned entries, unsigned cq_entries = 0) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    if (cq_entries > 0) {
+      params.flags |= IORING_SETUP_CQSIZE;
+      params.cq_entries = cq_entries;
+    }
+    fd_ = ioUringSetup(entries, &params);
+    if (fd_ < 0) {
+      throw std::runtime_error("io_uring_setup failed: " +
+                               std::string(strerror(errno)));
+    }
+    features_ = params.features;
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (features_ & IORING_FEAT_SINGLE_MMAP) {
+      sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+      close(fd_);
+      throw std::runtime_error("io_uring mmap sq failed");
+    }
+    if (features_ & IORING_FEAT_SINGLE_MMAP) {
+      cq_ptr_ = sq_ptr_;
+    } else {
+      cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+      if (cq_ptr_ == MAP_FAILED) {
+        munmap(sq_ptr_, sq_size_);
+        close(fd_);
+        throw std::runtime_error("io_uring mmap cq failed");
+      }
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(
+        mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) {
+      if (cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_size_);
+      munmap(sq_ptr_, sq_size_);
+      close(fd_);
+      throw std::runtime_error("io_uring mmap sqes failed");
+    }
+    char* sq = static_cast<char*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    char* cq = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  }
+
+  ~IoUringRing() {
+    munmap(sqes_, sqes_size_);
+    if (cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_size_);
+    munmap(sq_ptr_, sq_size_);
+    close(fd_);
+  }
+
+  int fd() const { return fd_; }
+  unsigned features() const { return features_; }
+  unsigned capacity() const { return sq_entries_; }
+
+  // 取一个清零的 SQE，队列满时返回 nullptr（调用者先 submit）
+  io_uring_sqe* getSqe() {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (local_tail_ - head >= sq_entries_) {
+      return nullptr;
+    }
+    unsigned index = local_tail_ & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    local_tail_++;
+    return sqe;
+  }
+
+  // 提交已填写的 SQE 并等待至少 wait_nr 个完成；timeout_ms 非 0 时最多等待这么久
+  // 返回内核接受的 SQE 数，超时或被信号打断时返回 0
+  int submit(unsigned wait_nr, uint64_t timeout_ms = 0) {
+    unsigned to_submit = local_tail_ - *sq_tail_;
+    __atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE);
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    __kernel_timespec ts;
+    io_uring_getevents_arg arg;
+    const void* arg_ptr = nullptr;
+    size_t arg_size = 0;
+    if (wait_nr > 0 && timeout_ms > 0) {
+      ts.tv_sec = static_cast<long long>(timeout_ms / 1000);
+      ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+      std::memset(&arg, 0, sizeof(arg));
+      arg.sigmask_sz = _NSIG / 8;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+      flags |= IORING_ENTER_EXT_ARG;
+      arg_ptr = &arg;
+      arg_size = sizeof(arg);
+    }
+    while (true) {
+      int ret = ioUringEnter(fd_, to_submit, wait_nr, flags, arg_ptr,
+                             arg_size);
+      if (ret >= 0) {
+        return ret;
+      }
+      if (errno == ETIME || errno == EINTR) {
+        return 0;
+      }
+      if (errno == EAGAIN || errno == EBUSY) {
+        // 完成队列满：先让调用者收割完成事件
+        return 0;
+      }
+      throw std::runtime_error("io_uring_enter failed: " +
+                               std::string(strerror(errno)));
+    }
+  }
+
+  // 依次处理已到达的完成事件，返回处理数
+  template <typename F>
+  unsigned reap(F&& handle) {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    unsigned count = 0;
+    while (head != tail) {
+      handle(cqes_[head & cq_mask_]);
+      head++;
+      count++;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return count;
+  }
+
+ private:
+  int fd_ = -1;
+  unsigned features_ = 0;
+  void* sq_ptr_ = nullptr;
+  void* cq_ptr_ = nullptr;
+  size_t sq_size_ = 0;
+  size_t cq_size_ = 0;
+  size_t sqes_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned local_tail_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+};
+
+namespace {
+
+// 在回环 UDP 套接字上实际跑一次多发 recvmsg + 缓冲区环，确认内核支持（>= 6.0）
+// 并且没有被 seccomp / io_uring_disabled 禁用
+bool probeIoUring() {
+  try {
+    IoUringRing ring(4);
+    if (!(ring.features() & IORING_FEAT_EXT_ARG)) {
+      return false;
+    }
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    void* mem = mmap(nullptr, page, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+      return false;
+    }
+    auto* buf_ring = static_cast<io_uring_buf_ring*>(mem);
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring);
+    reg.ring_entries = 1;
+    reg.bgid = RECV_BUFFER_GROUP;
+    bool ok = false;
+    int fd = -1;
+    if (ioUringRegister(ring.fd(), IORING_REGISTER_PBUF_RING, &reg, 1) == 0) {
+      static char buffer[256];
+      io_uring_buf* buf = ringBuffer(buf_ring, 0);
+      buf->addr = reinterpret_cast<uint64_t>(buffer);
+      buf->len = sizeof(buffer);
+      buf->bid = 0;
+      __atomic_store_n(&buf_ring->tail, 1, __ATOMIC_RELEASE);
+
+      fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+      sockaddr_in addr;
+      std::memset(&addr, 0, sizeof(addr));
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      socklen_t len = sizeof(addr);
+      if (fd >= 0 &&
+          bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+          getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        io_uring_sqe* sqe = ring.getSqe();
+        sqe->opcode = IORING_OP_RECVMSG;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&msg);
+        sqe->len = 1;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = RECV_BUFFER_GROUP;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        ring.submit(0);
+        sendto(fd, "probe", 5, 0, reinterpret_cast<sockaddr*>(&addr),
+               sizeof(addr));
+        ring.submit(1, 200);
+        ring.reap([&ok](const io_uring_cqe& cqe) {
+          ok = ok || (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER));
+        });
+      }
+    }
+    if (fd >= 0) close(fd);
+    munmap(mem, page);
+    return ok;
+  } catch (const std::exception&) {
+    return false;
+  }
+}
+
+}  // namespace
+
+bool UringIoEngine::isSupported() {
+  static const bool supported = probeIoUring();
+  return supported;
+}
+
+UringIoEngine::UringIoEngine() {
+  send_ring_ = std::make_unique<IoUringRing>(IO_URING_SEND_ENTRIES);
+}
+
+UringIoEngine::~UringIoEngine() {
+  stop();
+  if (buffers_ != nullptr) {
+    munmap(buffers_, buffer_size_ * IO_URING_RECV_BUFFERS);
+  }
+  if (buf_ring_ != nullptr) {
+    munmap(buf_ring_, IO_URING_RECV_BUFFERS * sizeof(io_uring_buf));
+  }
+}
+
+size_t UringIoEngine::sendBatch(int fd, std::vector<mmsghdr>& msgs) {
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  size_t ok = 0;
+  size_t next = 0;
+  while (next < msgs.size()) {
+    // 一批最多填满提交队列，一次 io_uring_enter 提交并等待全部完成
+    unsigned queued = 0;
+    io_uring_sqe* sqe;
+    while (next < msgs.size() && (sqe = send_ring_->getSqe()) != nullptr) {
+      sqe->opcode = IORING_OP_SENDMSG;
+      sqe->fd = fd;
+      sqe->addr = reinterpret_cast<uint64_t>(&msgs[next].msg_hdr);
+      sqe->len = 1;
+      sqe->user_data = next;
+      next++;
+      queued++;
+    }
+    unsigned done = 0;
+    while (done < queued) {
+      send_ring_->submit(queued - done);
+      done += send_ring_->reap([&](const io_uring_cqe& cqe) {
+        mmsghdr& msg = msgs[cqe.user_data];
+        if (cqe.res >= 0) {
+          msg.msg_len = static_cast<unsigned>(cqe.res);
+          ok++;
+        } else {
+          msg.msg_len = 0;
+          std::cerr << "UringIoEngine: sendmsg failed: " << strerror(-cqe.res)
+                    << std::endl;
+        }
+      });
+    }
+  }
+  return ok;
+}
+
+int UringIoEngine::fixedBufferIndex_(const void* data, size_t size) const {
+  auto begin = reinterpret_cast<uintptr_t>(data);
+  for (size_t i = 0; i < registered_.size(); i++) {
+    auto base = reinterpret_cast<uintptr_t>(registered_[i].iov_base);
+    if (begin >= base && begin + size <= base + registered_[i].iov_len) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+size_t UringIoEngine::writeBatch(int fd, const std::vector<IoWrite>& writes) {
+  // 与 epoll 实现相同，首尾相接的请求合并成一次写：文件的缓冲写通常由内核工作线程
+  // 逐个执行，请求数比系统调用数更关键；内存上也相连的部分再合并成一个 iovec
+  struct Run {
+    uint64_t offset;
+    size_t length;
+    size_t first;  // iovecs 中的下标
+    size_t count;
+  };
+  std::vector<iovec> iovecs;
+  std::vector<Run> runs;
+  iovecs.reserve(writes.size());
+  for (const auto& write : writes) {
+    void* data = const_cast<void*>(write.data);
+    if (!runs.empty() && write.offset == runs.back().offset +
+                                             runs.back().length) {
+      Run& run = runs.back();
+      iovec& last = iovecs.back();
+      if (static_cast<char*>(last.iov_base) + last.iov_len == data) {
+        last.iov_len += write.size;
+        run.length += write.size;
+        continue;
+      }
+      if (run.count < IOV_MAX) {
+        iovecs.push_back({data, write.size});
+        run.length += write.size;
+        run.count++;
+        continue;
+      }
+    }
+    runs.push_back({write.offset, write.size, iovecs.size(), 1});
+    iovecs.push_back({data, write.size});
+  }
+
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  std::vector<ssize_t> results(runs.size(), 0);
+  size_t next = 0;
+  while (next < runs.size()) {
+    unsigned queued = 0;
+    io_uring_sqe* sqe;
+    while (next < runs.size() && (sqe = send_ring_->getSqe()) != nullptr) {
+      const Run& run = runs[next];
+      const iovec& iov = iovecs[run.first];
+      int index = run.count == 1 ? fixedBufferIndex_(iov.iov_base, iov.iov_len)
+                                 : -1;
+      sqe->fd = fd;
+      sqe->off = run.offset;
+      sqe->user_data = next;
+      if (run.count > 1) {
+        sqe->opcode = IORING_OP_WRITEV;
+        sqe->addr = reinterpret_cast<uint64_t>(&iov);
+        sqe->len = static_cast<uint32_t>(run.count);
+      } else {
+        sqe->opcode = index >= 0 ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe->addr = reinterpret_cast<uint64_t>(iov.iov_base);
+        sqe->len = static_cast<uint32_t>(iov.iov_len);
+        sqe->buf_index = static_cast<uint16_t>(index >= 0 ? index : 0);
+      }
+      next++;
+      queued++;
+    }
+    unsigned done = 0;
+    while (done < queued) {
+      send_ring_->submit(queued - done);
+      done += send_ring_->reap([&results](const io_uring_cqe& cqe) {
+        results[cqe.user_data] = cqe.res;
+      });
+    }
+  }
+
+  size_t total = 0;
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (results[i] < 0) {
+      throw std::runtime_error("UringIoEngine: write failed: " +
+                               std::string(strerror(-results[i])));
+    }
+    // 短写（如磁盘将满）时同步补齐剩余部分
+    const Run& run = runs[i];
+    size_t written = static_cast<size_t>(results[i]);
+    size_t skip = written;
+    size_t first = run.first;
+    size_t end = run.first + run.count;
+    while (written < run.length) {
+      // 跳过已写完的 iovec，调整部分写入的那一个
+      while (skip >= iovecs[first].iov_len) {
+        skip -= iovecs[first].iov_len;
+        first++;
+      }
+      iovecs[first].iov_base = static_cast<char*>(iovecs[first].iov_base) +
+                               skip;
+      iovecs[first].iov_len -= skip;
+      ssize_t ret = pwritev(fd, &iovecs[first], static_cast<int>(end - first),
+                            static_cast<off_t>(run.offset + written));
+      if (ret < 0) {
+        if (errno == EINTR) continue;
+        throw std::runtime_error("UringIoEngine: pwritev failed: " +
+                                 std::string(strerror(errno)));
+      }
+      written += ret;
+      skip = ret;
+    }
+    total += written;
+  }
+  return total;
+}
+
+bool UringIoEngine::registerBuffers(const std::vector<iovec>& buffers) {
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  if (!registered_.empty()) {
+    ioUringRegister(send_ring_->fd(), IORING_UNREGISTER_BUFFERS, nullptr, 0);
+    registered_.clear();
+  }
+  if (buffers.empty()) {
+    return true;
+  }
+  // 内核固定这些页面（计入 RLIMIT_MEMLOCK / memcg），失败时写请求退回普通 WRITE
+  if (ioUringRegister(send_ring_->fd(), IORING_REGISTER_BUFFERS,
+                      buffers.data(),
+                      static_cast<unsigned>(buffers.size())) < 0) {
+    std::cerr << "UringIoEngine: register buffers failed: " << strerror(errno)
+              << std::endl;
+    return false;
+  }
+  registered_ = buffers;
+  return true;
+}
+
+void UringIoEngine::addReceiver(int fd, size_t max_size,
+                                ReceiveHandler handler) {
+  Receiver receiver;
+  receiver.fd = fd;
+  receiver.handler = std::move(handler);
+  std::memset(&receiver.msg, 0, sizeof(receiver.msg));
+  receiver.msg.msg_namelen = sizeof(sockaddr_in);
+  receivers_.push_back(std::move(receiver));
+  // 缓冲区依次放 io_uring_recvmsg_out、源地址和报文（不要控制信息）
+  buffer_size_ = std::max(buffer_size_, sizeof(io_uring_recvmsg_out) +
+                                            sizeof(sockaddr_in) + max_size);
+}
+
+void UringIoEngine::recycleBuffer_(uint16_t bid) {
+  io_uring_buf* buf =
+      ringBuffer(buf_ring_, buf_tail_ & (IO_URING_RECV_BUFFERS - 1));
+  buf->addr = reinterpret_cast<uint64_t>(buffers_ + bid * buffer_size_);
+  buf->len = static_cast<uint32_t>(buffer_size_);
+  buf->bid = bid;
+  buf_tail_++;
+  // 立即交还内核：大消息的分片连续到达时，多发接收不会因缓冲区用完而中断
+  __atomic_store_n(&buf_ring_->tail, buf_tail_, __ATOMIC_RELEASE);
+}
+
+void UringIoEngine::armReceiver_(size_t index) {
+  io_uring_sqe* sqe = recv_ring_->getSqe();
+  if (sqe == nullptr) {
+    recv_ring_->submit(0);
+    sqe = recv_ring_->getSqe();
+  }
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = receivers_[index].fd;
+  sqe->addr = reinterpret_cast<uint64_t>(&receivers_[index].msg);
+  sqe->len = 1;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = RECV_BUFFER_GROUP;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->user_data = index + 1;
+}
+
+void UringIoEngine::start(uint64_t tick_ms, std::function<void()> tick) {
+  if (running_) return;
+  recv_ring_ = std::make_unique<IoUringRing>(
+      static_cast<unsigned>(receivers_.size() + 2), IO_URING_RECV_BUFFERS);
+  // 缓冲区和缓冲区环用匿名映射：按需分配物理页，小报文只占用每个缓冲区的前几页
+  // stop 之后再次 start 时复用缓冲区，在新的环上重新登记
+  if (buffers_ == nullptr) {
+    buffer_size_ = (buffer_size_ + 63) & ~static_cast<size_t>(63);
+    void* mem = mmap(nullptr, buffer_size_ * IO_URING_RECV_BUFFERS,
+                     PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                     0);
+    if (mem == MAP_FAILED) {
+      throw std::runtime_error("UringIoEngine: mmap receive buffers failed");
+    }
+    buffers_ = static_cast<uint8_t*>(mem);
+    void* ring = mmap(nullptr, IO_URING_RECV_BUFFERS * sizeof(io_uring_buf),
+                      PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                      0);
+    if (ring == MAP_FAILED) {
+      throw std::runtime_error("UringIoEngine: mmap buffer ring failed");
+    }
+    buf_ring_ = static_cast<io_uring_buf_ring*>(ring);
+  }
+  std::memset(buf_ring_, 0, IO_URING_RECV_BUFFERS * sizeof(io_uring_buf));
+  buf_tail_ = 0;
+  io_uring_buf_reg reg;
+  std::memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+  reg.ring_entries = IO_URING_RECV_BUFFERS;
+  reg.bgid = RECV_BUFFER_GROUP;
+  if (ioUringRegister(recv_ring_->fd(), IORING_REGISTER_PBUF_RING, &reg, 1) <
+      0) {
+    throw std::runtime_error("UringIoEngine: register buffer ring failed: " +
+                             std::string(strerror(errno)));
+  }
+  for (uint16_t bid = 0; bid < IO_URING_RECV_BUFFERS; bid++) {
+    recycleBuffer_(bid);
+  }
+
+  wake_fd_ = eventfd(0, EFD_CLOEXEC);
+  io_uring_sqe* sqe = recv_ring_->getSqe();
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = wake_fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(&wake_value_);
+  sqe->len = sizeof(wake_value_);
+  sqe->user_data = WAKE_USER_DATA;
+  for (size_t i = 0; i < receivers_.size(); i++) {
+    armReceiver_(i);
+  }
+  recv_ring_->submit(0);
+
+  running_ = true;
+  recv_thread_ =
+      std::thread(&UringIoEngine::receiveLoop_, this, tick_ms, std::move(tick));
+}
+
+void UringIoEngine::stop() {
+  if (!running_) return;
+  running_ = false;
+  uint64_t one = 1;
+  ssize_t ret = write(wake_fd_, &one, sizeof(one));
+  (void)ret;
+  if (recv_thread_.joinable()) {
+    recv_thread_.join();
+  }
+  // 关闭环即取消仍在等待的多发接收
+  recv_ring_.reset();
+  close(wake_fd_);
+  wake_fd_ = -1;
+}
+
+void UringIoEngine::receiveLoop_(uint64_t tick_ms,
+                                 std::function<void()> tick) {
+  pthread_setname_np(pthread_self(), "uring_recv");
+  auto next_tick = std::chrono::steady_clock::now();
+  uint64_t wait_ms = tick ? std::max<uint64_t>(1, tick_ms) : 1000;
+  std::vector<size_t> rearm;
+  bool woken = false;
+  while (running_ && !woken) {
+    recv_ring_->submit(1, wait_ms);
+    recv_ring_->reap([&](const io_uring_cqe& cqe) {
+      if (cqe.user_data == WAKE_USER_DATA) {
+        woken = true;
+        return;
+      }
+      size_t index = cqe.user_data - 1;
+      if (cqe.flags & IORING_CQE_F_BUFFER) {
+        auto bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        if (cqe.res > 0) {
+          const uint8_t* buffer = buffers_ + bid * buffer_size_;
+          auto* out = reinterpret_cast<const io_uring_recvmsg_out*>(buffer);
+          // 源地址区和控制信息区按模板的长度预留，out 中是实际长度
+          const msghdr& msg = receivers_[index].msg;
+          const uint8_t* name = buffer + sizeof(io_uring_recvmsg_out);
+          const uint8_t* payload = name + msg.msg_namelen + msg.msg_controllen;
+          sockaddr_in source;
+          std::memset(&source, 0, sizeof(source));
+          std::memcpy(&source, name,
+                      std::min<size_t>(out->namelen, sizeof(source)));
+          if (!(out->flags & MSG_TRUNC)) {
+            receivers_[index].handler(payload, out->payloadlen, source);
+          }
+        }
+        recycleBuffer_(bid);
+      }
+      // 没有 F_MORE 表示这个多发请求已结束（如缓冲区暂时用完），重新挂上
+      if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        if (cqe.res < 0 && cqe.res != -ENOBUFS) {
+          std::cerr << "UringIoEngine: recvmsg failed: " << strerror(-cqe.res)
+                    << std::endl;
+        }
+        rearm.push_back(index);
+      }
+    });
+    for (size_t index : rearm) {
+      armReceiver_(index);
+    }
+    rearm.clear();
+    if (tick && std::chrono::steady_clock::now() >= next_tick) {
+      tick();
+      next_tick = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(tick_ms);
+    }
+  }
+}
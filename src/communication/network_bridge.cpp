@@ -0,0 +1,136 @@
+#include "mini_ros2/communication/network_bridge.h"
+
+#include <fnmatch.h>
+
+#include <chrono>
+#include <iostream>
+
+NetworkBridge::NetworkBridge(const NetworkBridgeConfig& config)
+    : config_(config), prefix_(config.local.topicPrefix()) {
+  std::unique_ptr<CommAdapter> adapter;
+  if (config_.use_tcp) {
+    TcpCommConfig tcp = config_.tcp_transport;
+    tcp.peers.insert(tcp.peers.end(), config_.peers.begin(),
+                     config_.peers.end());
+    adapter = std::make_unique<TcpCommAdapter>(tcp);
+  } else {
+    adapter = std::make_unique<UdpCommAdapter>(config_.transport);
+  }
+  gateway_ = std::make_unique<CommGateway>(config_.local, std::move(adapter));
+  for (const auto& pattern : config_.import_patterns) {
+    gateway_->addImportPattern(pattern);
+  }
+  std::cout << "NetworkBridge: " << config_.export_patterns.size()
+            << " export patterns, " << config_.import_patterns.size()
+            << " import patterns" << std::endl;
+}
+
+NetworkBridge::~NetworkBridge() { stop(); }
+
+bool NetworkBridge::matches_(const std::vector<std::string>& patterns,
+                             const std::string& name) {
+  for (const auto& pattern : patterns) {
+    if (fnmatch(pattern.c_str(), name.c_str(), 0) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+double NetworkBridge::rateFor_(const std::string& name) const {
+  for (const auto& rule : config_.rate_limits) {
+    if (fnmatch(rule.pattern.c_str(), name.c_str(), 0) == 0) {
+      return rule.max_hz;
+    }
+  }
+  return 0;
+}
+
+size_t NetworkBridge::refresh() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ShmManager& manager = gateway_->manager();
+  uint64_t generation = manager.getRegistryGeneration();
+  if (generation == scanned_generation_) {
+    return 0;
+  }
+  scanned_generation_ = generation;
+  size_t added = 0;
+  for (const TopicInfo& topic : manager.getTopics()) {
+    std::string name(topic.name_);
+    if (name.compare(0, prefix_.size(), prefix_) != 0) {
+      continue;
+    }
+    name.erase(0, prefix_.size());
+    if (exported_.count(name) != 0 ||
+        !matches_(config_.export_patterns, name)) {
+      continue;
+    }
+    // 注册表只记录合并后的 "<topic>_<event>"；按最后一个 '_' 拆开即可：
+    // 两端都重新拼成同一个名字，数据段名和事件哈希不受拆分位置影响
+    size_t split = name.rfind('_');
+    if (split == std::string::npos || split == 0) {
+      continue;
+    }
+    std::string topic_name = name.substr(0, split);
+    std::string event_name = name.substr(split + 1);
+    double max_hz = rateFor_(name);
+    if (max_hz > 0) {
+      gateway_->setRateLimit(topic_name, event_name, max_hz);
+    }
+    bool reliable = matches_(config_.reliable_patterns, name);
+    if (reliable) {
+      gateway_->setReliable(topic_name, event_name);
+    }
+    if (config_.peers.empty()) {
+      gateway_->addExport(topic_name, event_name);
+    }
+    for (const auto& peer : config_.peers) {
+      gateway_->addExport(topic_name, event_name, peer);
+    }
+    exported_.insert(name);
+    added++;
+    std::cout << "NetworkBridge: export " << name;
+    if (max_hz > 0) {
+      std::cout << " (max " << max_hz << " Hz)";
+    }
+    if (reliable) {
+      std::cout << " (reliable)";
+    }
+    std::cout << std::endl;
+  }
+  return added;
+}
+
+std::vector<std::string> NetworkBridge::exportedTopics() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::vector<std::string>(exported_.begin(), exported_.end());
+}
+
+void NetworkBridge::start() {
+  if (running_) return;
+  refresh();
+  gateway_->start();
+  running_ = true;
+  scan_thread_ = std::thread(&NetworkBridge::scanLoop_, this);
+}
+
+void NetworkBridge::stop() {
+  running_ = false;
+  if (scan_thread_.joinable()) {
+    scan_thread_.join();
+  }
+  gateway_->stop();
+}
+
+void NetworkBridge::scanLoop_() {
+  pthread_setname_np(pthread_self(), "bridge_scan");
+  while (running_) {
+    try {
+      refresh();
+    } catch (const std::exception& e) {
+      std::cerr << "NetworkBridge: " << e.what() << std::endl;
+    }
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(config_.scan_interval_ms));
+  }
+}
@@ -0,0 +1,583 @@
+#include "mini_ros2/communication/node_discovery.h"
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "mini_ros2/communication/wire_codec.h"
+
+namespace {
+
+std::runtime_error socketError(const std::string& what) {
+  return std::runtime_error("NodeDiscovery: " + what + ": " +
+                            std::string(strerror(errno)));
+}
+
+in_addr parseAddress(const std::string& address) {
+  in_addr addr;
+  if (inet_pton(AF_INET, address.c_str(), &addr) != 1) {
+    throw std::invalid_argument("NodeDiscovery: invalid IPv4 address " +
+                                address);
+  }
+  return addr;
+}
+
+void putEndpoint(std::vector<uint8_t>& out,
+                 const DiscoveredEndpoint& endpoint) {
+  out.push_back(static_cast<uint8_t>(endpoint.kind));
+  putString(out, endpoint.topic);
+  putString(out, endpoint.event);
+}
+
+size_t endpointSize(const DiscoveredEndpoint& endpoint) {
+  return 1 + 2 + endpoint.topic.size() + 2 + endpoint.event.size();
+}
+
+// 读取 putEndpoint 写入的端点；类型非法时 reader.ok 为 false
+DiscoveredEndpoint readEndpoint(PayloadReader& reader) {
+  DiscoveredEndpoint endpoint;
+  uint8_t kind = reader.u8();
+  if (kind != static_cast<uint8_t>(EndpointKind::Publisher) &&
+      kind != static_cast<uint8_t>(EndpointKind::Subscriber)) {
+    reader.ok = false;
+  }
+  endpoint.kind = static_cast<EndpointKind>(kind);
+  endpoint.topic = reader.string();
+  endpoint.event = reader.string();
+  return endpoint;
+}
+
+bool containsEndpoint(const std::vector<DiscoveredEndpoint>& endpoints,
+                      const DiscoveredEndpoint& endpoint) {
+  return std::find(endpoints.begin(), endpoints.end(), endpoint) !=
+         endpoints.end();
+}
+
+}  // namespace
+
+NodeDiscovery::NodeDiscovery(const DiscoveryConfig& config)
+    : config_(config),
+      participant_id_(randomCommSenderId()),
+      period_ms_(config.initial_period_ms) {
+  if (config_.initial_period_ms == 0 ||
+      config_.max_period_ms < config_.initial_period_ms ||
+      config_.lease_ms <= config_.max_period_ms) {
+    throw std::invalid_argument(
+        "NodeDiscovery: need 0 < initial_period_ms <= max_period_ms < "
+        "lease_ms");
+  }
+  in_addr iface = parseAddress(config_.interface_address);
+  std::memset(&group_addr_, 0, sizeof(group_addr_));
+  group_addr_.sin_family = AF_INET;
+  group_addr_.sin_port = htons(config_.port);
+  group_addr_.sin_addr = parseAddress(config_.multicast_group);
+
+  try {
+    // 收发共用一个套接字：绑定组播端口，同一主机上的多个参与者共享；
+    // 自己发出的宣告经组播回环收回，按参与者 id 丢弃
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) throw socketError("socket");
+    int on = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in bind_addr;
+    std::memset(&bind_addr, 0, sizeof(bind_addr));
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_port = htons(config_.port);
+    bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&bind_addr), sizeof(bind_addr)) <
+        0) {
+      throw socketError("bind discovery port");
+    }
+    ip_mreq mreq;
+    mreq.imr_multiaddr = group_addr_.sin_addr;
+    mreq.imr_interface = iface;
+    if (setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) <
+        0) {
+      throw socketError("join " + config_.multicast_group);
+    }
+    int off = 0;
+    setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_ALL, &off, sizeof(off));
+    if (setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) <
+        0) {
+      throw socketError("set multicast interface");
+    }
+    unsigned char ttl = static_cast<unsigned char>(config_.multicast_ttl);
+    setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    // 同一主机上的其他参与者靠回环收到宣告
+    unsigned char loop = 1;
+    setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    engine_ = createIoEngine(config_.io_backend);
+    engine_->addReceiver(fd_, DISCOVERY_MAX_DATAGRAM,
+                         [this](const uint8_t* data, size_t size,
+                                const sockaddr_in&) { receive_(data, size); });
+  } catch (...) {
+    if (fd_ >= 0) close(fd_);
+    throw;
+  }
+  std::cout << "NodeDiscovery: " << config_.name << " participant "
+            << std::hex << participant_id_ << std::dec << " group "
+            << config_.multicast_group << ":" << config_.port << " io "
+            << engine_->name() << std::endl;
+}
+
+NodeDiscovery::~NodeDiscovery() {
+  stop();
+  engine_.reset();
+  close(fd_);
+}
+
+void NodeDiscovery::addEndpoint(EndpointKind kind, const std::string& topic,
+                                const std::string& event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  DiscoveredEndpoint endpoint{kind, topic, event};
+  if (containsEndpoint(endpoints_, endpoint)) {
+    return;
+  }
+  endpoints_.push_back(endpoint);
+  pending_.push_back({true, endpoint});
+  revision_++;
+  // 有变化时立即宣告，并回到初始周期
+  period_ms_ = config_.initial_period_ms;
+  next_announce_ = Clock::now();
+}
+
+void NodeDiscovery::removeEndpoint(EndpointKind kind, const std::string& topic,
+                                   const std::string& event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  DiscoveredEndpoint endpoint{kind, topic, event};
+  auto it = std::find(endpoints_.begin(), endpoints_.end(), endpoint);
+  if (it == endpoints_.end()) {
+    return;
+  }
+  endpoints_.erase(it);
+  pending_.push_back({false, endpoint});
+  revision_++;
+  period_ms_ = config_.initial_period_ms;
+  next_announce_ = Clock::now();
+}
+
+void NodeDiscovery::setListener(Listener listener) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  listener_ = std::move(listener);
+}
+
+void NodeDiscovery::start() {
+  if (running_) return;
+  running_ = true;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    announced_revision_ = 0;
+    sendFull_();
+    sendRequest_(0);
+    period_ms_ = config_.initial_period_ms;
+    next_announce_ = Clock::now() + std::chrono::milliseconds(period_ms_);
+  }
+  // tick 要比初始周期和请求间隔都细，变化和全量请求不会等太久
+  uint64_t tick_ms =
+      std::max<uint64_t>(1, std::min<uint64_t>(config_.initial_period_ms,
+                                               DISCOVERY_REQUEST_INTERVAL_MS) /
+                                2);
+  engine_->start(tick_ms, [this]() { tick_(); });
+}
+
+void NodeDiscovery::stop(bool goodbye) {
+  if (!running_) return;
+  running_ = false;
+  engine_->stop();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (goodbye) {
+    sendBye_();
+  }
+  // 重新 start 时重新发现，不再回调旧参与者的离开
+  remotes_.clear();
+  events_.clear();
+}
+
+std::vector<DiscoveredParticipant> NodeDiscovery::participants() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<DiscoveredParticipant> result;
+  for (const auto& [id, remote] : remotes_) {
+    if (remote.complete) {
+      result.push_back(remote.info);
+    }
+  }
+  return result;
+}
+
+DiscoveryStats NodeDiscovery::getStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void NodeDiscovery::tick_() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    if (full_requested_ &&
+        now - last_full_ >=
+            std::chrono::milliseconds(DISCOVERY_REQUEST_INTERVAL_MS)) {
+      sendFull_();
+    }
+    if (now >= next_announce_) {
+      bool stable = pending_.empty();
+      sendDelta_();
+      // 没有变化时每次宣告后周期加倍，直到 max_period_ms
+      if (stable) {
+        period_ms_ = std::min(period_ms_ * 2, config_.max_period_ms);
+      }
+      next_announce_ = now + std::chrono::milliseconds(period_ms_);
+    }
+    for (auto it = remotes_.begin(); it != remotes_.end();) {
+      Remote& remote = it->second;
+      if (now - remote.last_seen >
+          std::chrono::milliseconds(remote.info.lease_ms)) {
+        if (remote.complete) {
+          emit_(DiscoveryEventType::ParticipantLost, remote);
+        }
+        it = remotes_.erase(it);
+        continue;
+      }
+      // 全量状态的请求或应答丢失时重新请求
+      if (!remote.complete) {
+        requestFull_(remote, it->first);
+      }
+      ++it;
+    }
+  }
+  flushEvents_();
+}
+
+void NodeDiscovery::receive_(const uint8_t* data, size_t size) {
+  if (size < sizeof(DiscoveryHeader)) {
+    return;
+  }
+  DiscoveryHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (ntohl(header.magic) != DISCOVERY_MAGIC ||
+      header.version != DISCOVERY_VERSION) {
+    return;
+  }
+  header.count = ntohs(header.count);
+  header.participant_id = be64toh(header.participant_id);
+  header.revision = ntohl(header.revision);
+  header.base_revision = ntohl(header.base_revision);
+  header.lease_ms = ntohl(header.lease_ms);
+  header.part = ntohs(header.part);
+  header.parts = ntohs(header.parts);
+  if (header.participant_id == participant_id_) {
+    return;  // 组播回环收到的自己发出的宣告
+  }
+  const uint8_t* payload = data + sizeof(header);
+  size_t payload_size = size - sizeof(header);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.received++;
+    switch (static_cast<DiscoveryMessage>(header.type)) {
+      case DiscoveryMessage::Full:
+        handleFull_(header, payload, payload_size);
+        break;
+      case DiscoveryMessage::Delta:
+        handleDelta_(header, payload, payload_size);
+        break;
+      case DiscoveryMessage::Request: {
+        PayloadReader reader{payload, payload_size};
+        uint64_t target = reader.u64();
+        if (reader.ok && (target == 0 || target == participant_id_)) {
+          full_requested_ = true;
+        }
+        break;
+      }
+      case DiscoveryMessage::Bye: {
+        auto it = remotes_.find(header.participant_id);
+        if (it != remotes_.end()) {
+          if (it->second.complete) {
+            emit_(DiscoveryEventType::ParticipantLost, it->second);
+          }
+          remotes_.erase(it);
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  flushEvents_();
+}
+
+void NodeDiscovery::handleFull_(const DiscoveryHeader& header,
+                                const uint8_t* payload, size_t size) {
+  if (header.parts == 0 || header.part >= header.parts) {
+    return;
+  }
+  Remote& remote = remotes_[header.participant_id];
+  remote.last_seen = Clock::now();
+  remote.info.id = header.participant_id;
+  remote.info.lease_ms = header.lease_ms;
+  if (remote.complete && remote.info.revision == header.revision) {
+    return;  // 应答别人的请求时重发的全量状态，已经是最新的
+  }
+  PayloadReader reader{payload, size};
+  std::string name;
+  CommEndpoint locator;
+  if (header.part == 0) {
+    name = reader.string();
+    locator.host = reader.string();
+    locator.port = reader.u16();
+  }
+  std::vector<DiscoveredEndpoint> endpoints;
+  for (uint16_t i = 0; i < header.count && reader.ok; i++) {
+    endpoints.push_back(readEndpoint(reader));
+  }
+  if (!reader.ok) {
+    return;
+  }
+  if (remote.full_revision != header.revision ||
+      remote.full_parts.size() != header.parts) {
+    remote.full_revision = header.revision;
+    remote.full_parts.assign(header.parts, false);
+    remote.full_endpoints.clear();
+  }
+  if (remote.full_parts[header.part]) {
+    return;
+  }
+  remote.full_parts[header.part] = true;
+  if (header.part == 0) {
+    remote.info.name = name;
+    remote.info.locator = locator;
+  }
+  remote.full_endpoints.insert(remote.full_endpoints.end(), endpoints.begin(),
+                               endpoints.end());
+  if (std::find(remote.full_parts.begin(), remote.full_parts.end(), false) !=
+      remote.full_parts.end()) {
+    return;
+  }
+
+  // 收齐后与已知状态比较，只回调差异
+  if (!remote.complete) {
+    remote.info.endpoints.clear();
+    emit_(DiscoveryEventType::ParticipantDiscovered, remote);
+  }
+  for (const auto& endpoint : remote.info.endpoints) {
+    if (!containsEndpoint(remote.full_endpoints, endpoint)) {
+      emit_(DiscoveryEventType::EndpointRemoved, remote, &endpoint);
+    }
+  }
+  for (const auto& endpoint : remote.full_endpoints) {
+    if (!containsEndpoint(remote.info.endpoints, endpoint)) {
+      emit_(DiscoveryEventType::EndpointAdded, remote, &endpoint);
+    }
+  }
+  remote.info.endpoints = std::move(remote.full_endpoints);
+  remote.info.revision = header.revision;
+  remote.complete = true;
+  remote.full_endpoints.clear();
+  remote.full_parts.clear();
+}
+
+void NodeDiscovery::handleDelta_(const DiscoveryHeader& header,
+                                 const uint8_t* payload, size_t size) {
+  auto it = remotes_.find(header.participant_id);
+  if (it == remotes_.end()) {
+    // 错过了全量状态（如在对方之后加入，或请求丢失）
+    Remote& remote = remotes_[header.participant_id];
+    remote.info.id = header.participant_id;
+    remote.info.lease_ms = header.lease_ms;
+    remote.last_seen = Clock::now();
+    requestFull_(remote, header.participant_id);
+    return;
+  }
+  Remote& remote = it->second;
+  remote.last_seen = Clock::now();
+  remote.info.lease_ms = header.lease_ms;
+  if (!remote.complete) {
+    requestFull_(remote, header.participant_id);
+    return;
+  }
+  if (header.revision == remote.info.revision) {
+    return;  // 心跳
+  }
+  if (header.base_revision != remote.info.revision) {
+    // 中间的增量丢了，改为请求全量状态
+    requestFull_(remote, header.participant_id);
+    return;
+  }
+  PayloadReader reader{payload, size};
+  std::vector<Change> changes;
+  for (uint16_t i = 0; i < header.count && reader.ok; i++) {
+    bool added = reader.u8() != 0;
+    changes.push_back({added, readEndpoint(reader)});
+  }
+  if (!reader.ok) {
+    return;
+  }
+  std::vector<DiscoveredEndpoint>& endpoints = remote.info.endpoints;
+  for (const auto& change : changes) {
+    auto found = std::find(endpoints.begin(), endpoints.end(), change.endpoint);
+    if (change.added && found == endpoints.end()) {
+      endpoints.push_back(change.endpoint);
+      emit_(DiscoveryEventType::EndpointAdded, remote, &change.endpoint);
+    } else if (!change.added && found != endpoints.end()) {
+      endpoints.erase(found);
+      emit_(DiscoveryEventType::EndpointRemoved, remote, &change.endpoint);
+    }
+  }
+  remote.info.revision = header.revision;
+}
+
+std::vector<uint8_t> NodeDiscovery::header_(DiscoveryMessage type,
+                                            uint16_t count,
+                                            uint32_t base_revision) const {
+  DiscoveryHeader header;
+  header.magic = htonl(DISCOVERY_MAGIC);
+  header.version = DISCOVERY_VERSION;
+  header.type = static_cast<uint8_t>(type);
+  header.count = htons(count);
+  header.participant_id = htobe64(participant_id_);
+  header.revision = htonl(revision_);
+  header.base_revision = htonl(base_revision);
+  header.lease_ms = htonl(static_cast<uint32_t>(config_.lease_ms));
+  header.part = 0;
+  header.parts = htons(1);
+  auto* bytes = reinterpret_cast<const uint8_t*>(&header);
+  return std::vector<uint8_t>(bytes, bytes + sizeof(header));
+}
+
+void NodeDiscovery::sendFull_() {
+  // 按 DISCOVERY_MAX_DATAGRAM 拆成多部分，每部分至少一个端点
+  std::vector<std::vector<uint8_t>> packets;
+  std::vector<uint16_t> counts;
+  packets.push_back(header_(DiscoveryMessage::Full, 0, revision_));
+  counts.push_back(0);
+  putString(packets.back(), config_.name);
+  putString(packets.back(), config_.locator.host);
+  putU16(packets.back(), config_.locator.port);
+  for (const auto& endpoint : endpoints_) {
+    if (counts.back() > 0 &&
+        packets.back().size() + endpointSize(endpoint) >
+            DISCOVERY_MAX_DATAGRAM) {
+      packets.push_back(header_(DiscoveryMessage::Full, 0, revision_));
+      counts.push_back(0);
+    }
+    putEndpoint(packets.back(), endpoint);
+    counts.back()++;
+  }
+  for (size_t i = 0; i < packets.size(); i++) {
+    DiscoveryHeader* header =
+        reinterpret_cast<DiscoveryHeader*>(packets[i].data());
+    header->count = htons(counts[i]);
+    header->part = htons(static_cast<uint16_t>(i));
+    header->parts = htons(static_cast<uint16_t>(packets.size()));
+  }
+  sendPackets_(packets);
+  stats_.full_sent += packets.size();
+  announced_revision_ = revision_;
+  pending_.clear();
+  full_requested_ = false;
+  last_full_ = Clock::now();
+}
+
+void NodeDiscovery::sendDelta_() {
+  if (announced_revision_ == 0) {
+    sendFull_();
+    return;
+  }
+  std::vector<std::vector<uint8_t>> packets;
+  packets.push_back(header_(DiscoveryMessage::Delta,
+                            static_cast<uint16_t>(pending_.size()),
+                            announced_revision_));
+  for (const auto& change : pending_) {
+    packets.back().push_back(change.added ? 1 : 0);
+    putEndpoint(packets.back(), change.endpoint);
+  }
+  // 一个报文放不下的增量改为全量状态
+  if (packets.back().size() > DISCOVERY_MAX_DATAGRAM ||
+      pending_.size() > UINT16_MAX) {
+    sendFull_();
+    return;
+  }
+  sendPackets_(packets);
+  if (pending_.empty()) {
+    stats_.heartbeats_sent++;
+  } else {
+    stats_.deltas_sent++;
+  }
+  announced_revision_ = revision_;
+  pending_.clear();
+}
+
+void NodeDiscovery::sendRequest_(uint64_t target) {
+  std::vector<std::vector<uint8_t>> packets;
+  packets.push_back(header_(DiscoveryMessage::Request, 0, revision_));
+  putU64(packets.back(), target);
+  sendPackets_(packets);
+  stats_.requests_sent++;
+}
+
+void NodeDiscovery::sendBye_() {
+  std::vector<std::vector<uint8_t>> packets;
+  packets.push_back(header_(DiscoveryMessage::Bye, 0, revision_));
+  sendPackets_(packets);
+}
+
+void NodeDiscovery::sendPackets_(std::vector<std::vector<uint8_t>>& packets) {
+  std::vector<iovec> iovs(packets.size());
+  std::vector<mmsghdr> msgs(packets.size());
+  for (size_t i = 0; i < packets.size(); i++) {
+    iovs[i].iov_base = packets[i].data();
+    iovs[i].iov_len = packets[i].size();
+    std::memset(&msgs[i], 0, sizeof(mmsghdr));
+    msgs[i].msg_hdr.msg_name = &group_addr_;
+    msgs[i].msg_hdr.msg_namelen = sizeof(group_addr_);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  engine_->sendBatch(fd_, msgs);
+  for (const auto& msg : msgs) {
+    stats_.bytes_sent += msg.msg_len;
+  }
+}
+
+void NodeDiscovery::requestFull_(Remote& remote, uint64_t id) {
+  Clock::time_point now = Clock::now();
+  if (now - remote.last_request <
+      std::chrono::milliseconds(DISCOVERY_REQUEST_INTERVAL_MS)) {
+    return;
+  }
+  remote.last_request = now;
+  sendRequest_(id);
+}
+
+void NodeDiscovery::emit_(DiscoveryEventType type, const Remote& remote,
+                          const DiscoveredEndpoint* endpoint) {
+  DiscoveryEvent event;
+  event.type = type;
+  event.participant_id = remote.info.id;
+  event.participant_name = remote.info.name;
+  if (endpoint != nullptr) {
+    event.endpoint = *endpoint;
+  }
+  events_.push_back(std::move(event));
+}
+
+void NodeDiscovery::flushEvents_() {
+  std::vector<DiscoveryEvent> events;
+  Listener listener;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events.swap(events_);
+    listener = listener_;
+  }
+  if (!listener) {
+    return;
+  }
+  for (const auto& event : events) {
+    listener(event);
+  }
+}
@@ -1,53 +1,752 @@
-#include <iostream>
-#include <mutex>
+#include "mini_ros2/communication/registry.h"
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <errno.h>
+#include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
-#include <thread>
 #include <unistd.h>
-#include <unordered_map>
-
-std::unordered_map<std::string, std::string> node_registry; //节点->端口
-std::mutex registry_mutex; // 用于保护 node_registry 的互斥锁
-
-void handle_client(int client_socket) {
-  char buffer[1024] = {0};
-  read(client_socket, buffer, 1024);
-  std::string msg(buffer);
-  if (msg.substr(0, 8) == "REGISTER") {
-    std::string node_name = msg.substr(9, msg.find(',') - 9);
-    std::string node_addr = msg.substr(msg.find(',') + 1);
-    {
-      std::lock_guard<std::mutex> lock(registry_mutex);
-      node_registry[node_name] = node_addr;
-    }
-    std::cout << "Registered: " << node_name << " at " << node_addr
-              << std::endl;
-    send(client_socket, "OK", 2, 0);
-  }
-  close(client_socket);
-}
-int main() {
-  // 创建socket：AF_INET（IPv4），SOCK_DGRAM（TCP协议），0（默认协议）
-  int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-  // 定义服务器地址结构
-  sockaddr_in address;
-  address.sin_family = AF_INET;         // IPV4
-  address.sin_addr.s_addr = INADDR_ANY; //监听所有地址
-  address.sin_port = htons(8080);       // 端口号
-  if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
-    perror("bind failed");
-    close(server_fd);
-    return EXIT_FAILURE;
-  } // 绑定socket和地址
-  if (listen(server_fd, 5) < 0) {
-    perror("listen failed");
-    close(server_fd);
-    return EXIT_FAILURE;
-  } // 监听连接（最多允许5个排队连接）
-  std::cout << "Registry server started on port 8080" << std::endl;
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "mini_ros2/communication/wire_codec.h"
+
+namespace {
+
+// epoll_event.data.u64：连接 id 从 1 开始，0 和最大值留给监听套接字和唤醒 eventfd
+#define LISTEN_TAG 0
+#define WAKE_TAG UINT64_MAX
+// 每次 read 至少预留的空间
+#define READ_CHUNK (64 * 1024)
+// 客户端流水线一批的请求数：写完一批再读回复，服务端积压的回复不超过上限
+#define CLIENT_PIPELINE_DEPTH 1024
+
+void appendFrame(std::vector<uint8_t>& out, RegistryOp op, uint32_t request_id,
+                 const std::vector<uint8_t>& payload) {
+  RegistryFrameHeader header;
+  header.magic = htonl(REGISTRY_MAGIC);
+  header.version = REGISTRY_VERSION;
+  header.op = static_cast<uint8_t>(op);
+  header.reserved = 0;
+  header.request_id = htonl(request_id);
+  header.length = htonl(static_cast<uint32_t>(payload.size()));
+  auto* bytes = reinterpret_cast<const uint8_t*>(&header);
+  out.insert(out.end(), bytes, bytes + sizeof(header));
+  out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// 解析 input 中 offset 处的帧头；数据不足一个帧头时返回 0，帧头非法时返回 -1
+int parseHeader(const std::vector<uint8_t>& input, size_t offset,
+                size_t max_length, RegistryFrameHeader& header) {
+  if (input.size() - offset < sizeof(RegistryFrameHeader)) {
+    return 0;
+  }
+  std::memcpy(&header, input.data() + offset, sizeof(header));
+  header.magic = ntohl(header.magic);
+  header.request_id = ntohl(header.request_id);
+  header.length = ntohl(header.length);
+  if (header.magic != REGISTRY_MAGIC || header.version != REGISTRY_VERSION ||
+      header.length > max_length) {
+    return -1;
+  }
+  return 1;
+}
+
+// 丢弃已处理的输入；剩余不多时整体前移，避免缓冲区无限增长
+void compact(std::vector<uint8_t>& buffer, size_t& offset) {
+  if (offset == buffer.size()) {
+    buffer.clear();
+    offset = 0;
+  } else if (offset >= READ_CHUNK) {
+    buffer.erase(buffer.begin(), buffer.begin() + offset);
+    offset = 0;
+  }
+}
+
+std::vector<RegistryEntry> parseEntries(const std::vector<uint8_t>& payload,
+                                        uint64_t* version) {
+  PayloadReader reader{payload.data(), payload.size()};
+  uint64_t graph_version = reader.u64();
+  if (version != nullptr) {
+    *version = graph_version;
+  }
+  uint32_t count = reader.u32();
+  std::vector<RegistryEntry> entries;
+  for (uint32_t i = 0; i < count && reader.ok; i++) {
+    RegistryEntry entry;
+    entry.name = reader.string();
+    entry.address = reader.string();
+    entries.push_back(std::move(entry));
+  }
+  if (!reader.ok) {
+    throw std::runtime_error("RegistryClient: malformed entries");
+  }
+  return entries;
+}
+
+std::runtime_error replyError(const std::vector<uint8_t>& payload) {
+  PayloadReader reader{payload.data(), payload.size()};
+  return std::runtime_error("RegistryClient: server error: " +
+                            reader.string());
+}
+
+RegistryNotification parseNotification(const std::vector<uint8_t>& payload) {
+  PayloadReader reader{payload.data(), payload.size()};
+  RegistryNotification notification;
+  notification.version = reader.u64();
+  notification.added = reader.u8() != 0;
+  notification.entry.name = reader.string();
+  notification.entry.address = reader.string();
+  return notification;
+}
+
+}  // namespace
+
+RegistryServer::RegistryServer(uint16_t port, const std::string& address) {
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+    throw std::invalid_argument("RegistryServer: invalid IPv4 address " +
+                                address);
+  }
+  try {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+      throw std::runtime_error("RegistryServer: socket: " +
+                               std::string(strerror(errno)));
+    }
+    int on = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) <
+        0) {
+      throw std::runtime_error("RegistryServer: bind port " +
+                               std::to_string(port) + ": " +
+                               std::string(strerror(errno)));
+    }
+    // 重连风暴时大量连接同时到达，积压队列用系统上限
+    if (listen(listen_fd_, SOMAXCONN) < 0) {
+      throw std::runtime_error("RegistryServer: listen: " +
+                               std::string(strerror(errno)));
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+      throw std::runtime_error("RegistryServer: epoll: " +
+                               std::string(strerror(errno)));
+    }
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_TAG;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev);
+    ev.data.u64 = WAKE_TAG;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+  } catch (...) {
+    if (listen_fd_ >= 0) close(listen_fd_);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+    throw;
+  }
+  std::cout << "RegistryServer: listening on " << address << ":" << port_
+            << std::endl;
+}
+
+RegistryServer::~RegistryServer() {
+  stop();
+  for (auto& entry : connections_) {
+    close(entry.second->fd);
+  }
+  close(listen_fd_);
+  close(epoll_fd_);
+  close(wake_fd_);
+}
+
+void RegistryServer::start() {
+  if (thread_.joinable()) return;
+  thread_ = std::thread([this]() {
+    pthread_setname_np(pthread_self(), "registry");
+    run();
+  });
+}
+
+void RegistryServer::stop() {
+  uint64_t one = 1;
+  ssize_t ret = write(wake_fd_, &one, sizeof(one));
+  (void)ret;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void RegistryServer::run() {
+  epoll_event events[64];
+  while (true) {
+    int ready = epoll_wait(epoll_fd_, events, 64, -1);
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      std::cerr << "RegistryServer: epoll_wait failed: " << strerror(errno)
+                << std::endl;
+      return;
+    }
+    for (int i = 0; i < ready; i++) {
+      uint64_t tag = events[i].data.u64;
+      if (tag == WAKE_TAG) {
+        uint64_t value;
+        ssize_t ret = read(wake_fd_, &value, sizeof(value));
+        (void)ret;
+        return;
+      }
+      if (tag == LISTEN_TAG) {
+        acceptAll_();
+        continue;
+      }
+      // 同一批事件中前面的处理可能已经关闭了这个连接
+      auto it = connections_.find(tag);
+      if (it == connections_.end()) {
+        continue;
+      }
+      Connection& conn = *it->second;
+      bool keep = !(events[i].events & EPOLLERR);
+      if (keep && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) {
+        keep = readConnection_(conn);
+      }
+      if (keep && (events[i].events & EPOLLOUT)) {
+        keep = flush_(conn);
+      }
+      if (!keep) {
+        closeConnection_(tag);
+      }
+    }
+    // 本轮所有请求处理完后再统一发送：流水线请求的回复和同一轮的多条通知合并成一次写
+    for (size_t i = 0; i < dirty_.size(); i++) {
+      auto it = connections_.find(dirty_[i]);
+      if (it == connections_.end()) {
+        continue;
+      }
+      it->second->dirty = false;
+      if (!flush_(*it->second)) {
+        closeConnection_(dirty_[i]);
+      }
+    }
+    dirty_.clear();
+  }
+}
+
+void RegistryServer::acceptAll_() {
+  while (true) {
+    int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        std::cerr << "RegistryServer: accept failed: " << strerror(errno)
+                  << std::endl;
+      }
+      return;
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    auto conn = std::make_unique<Connection>();
+    conn->id = next_connection_id_++;
+    conn->fd = fd;
+    conn->events = EPOLLIN | EPOLLRDHUP;
+    epoll_event ev;
+    ev.events = conn->events;
+    ev.data.u64 = conn->id;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      close(fd);
+      continue;
+    }
+    connections_.emplace(conn->id, std::move(conn));
+    stats_accepted_++;
+    stats_connections_++;
+  }
+}
+
+bool RegistryServer::readConnection_(Connection& conn) {
+  bool open = true;
+  while (true) {
+    size_t used = conn.input.size();
+    conn.input.resize(used + READ_CHUNK);
+    ssize_t ret = read(conn.fd, conn.input.data() + used, READ_CHUNK);
+    conn.input.resize(used + (ret > 0 ? ret : 0));
+    if (ret > 0) {
+      if (static_cast<size_t>(ret) < READ_CHUNK) break;
+      continue;
+    }
+    if (ret < 0 && errno == EINTR) continue;
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    open = false;  // 对端关闭或出错：先处理已收到的请求
+    break;
+  }
+  return processInput_(conn) && open;
+}
+
+bool RegistryServer::processInput_(Connection& conn) {
+  // 一次读到的可能是多个流水线请求，逐个处理；回复积压过多时先停下，发出去再继续
+  while (conn.output.size() - conn.output_offset <=
+         REGISTRY_MAX_PENDING_OUTPUT) {
+    RegistryFrameHeader header;
+    int parsed = parseHeader(conn.input, conn.input_offset,
+                             REGISTRY_MAX_PAYLOAD, header);
+    if (parsed < 0) {
+      std::cerr << "RegistryServer: bad frame from connection " << conn.id
+                << ", closing" << std::endl;
+      stats_errors_++;
+      return false;
+    }
+    if (parsed == 0 || conn.input.size() - conn.input_offset <
+                           sizeof(header) + header.length) {
+      break;
+    }
+    const uint8_t* payload =
+        conn.input.data() + conn.input_offset + sizeof(header);
+    conn.input_offset += sizeof(header) + header.length;
+    handleFrame_(conn, header, payload, header.length);
+  }
+  compact(conn.input, conn.input_offset);
+  return true;
+}
+
+void RegistryServer::handleFrame_(Connection& conn,
+                                  const RegistryFrameHeader& header,
+                                  const uint8_t* payload, size_t size) {
+  stats_requests_++;
+  PayloadReader reader{payload, size};
+  std::vector<uint8_t> out;
+  switch (static_cast<RegistryOp>(header.op)) {
+    case RegistryOp::Register: {
+      std::string name = reader.string();
+      std::string address = reader.string();
+      if (!reader.ok || name.empty()) {
+        break;
+      }
+      auto it = entries_.find(name);
+      if (it == entries_.end() || it->second.address != address ||
+          it->second.owner != conn.id) {
+        // 节点重连后重新注册：归属转到新连接，旧连接断开时不再注销它
+        if (it != entries_.end() && it->second.owner != conn.id) {
+          auto owner = connections_.find(it->second.owner);
+          if (owner != connections_.end()) {
+            owner->second->owned.erase(name);
+          }
+        }
+        entries_[name] = Entry{address, conn.id};
+        conn.owned.insert(name);
+        graph_version_++;
+        notifyWatchers_(true, name, address);
+      }
+      putU64(out, graph_version_);
+      reply_(conn, RegistryOp::Ok, header.request_id, out);
+      stats_entries_ = entries_.size();
+      return;
+    }
+    case RegistryOp::Unregister: {
+      std::string name = reader.string();
+      if (!reader.ok) {
+        break;
+      }
+      auto it = entries_.find(name);
+      if (it == entries_.end()) {
+        putU64(out, graph_version_);
+        reply_(conn, RegistryOp::NotFound, header.request_id, out);
+        return;
+      }
+      auto owner = connections_.find(it->second.owner);
+      if (owner != connections_.end()) {
+        owner->second->owned.erase(name);
+      }
+      std::string address = it->second.address;
+      entries_.erase(it);
+      graph_version_++;
+      notifyWatchers_(false, name, address);
+      putU64(out, graph_version_);
+      reply_(conn, RegistryOp::Ok, header.request_id, out);
+      stats_entries_ = entries_.size();
+      return;
+    }
+    case RegistryOp::Lookup: {
+      std::string name = reader.string();
+      if (!reader.ok) {
+        break;
+      }
+      putU64(out, graph_version_);
+      if (entries_.count(name) == 0) {
+        reply_(conn, RegistryOp::NotFound, header.request_id, out);
+      } else {
+        appendEntries_(out, &name);
+        reply_(conn, RegistryOp::Entries, header.request_id, out);
+      }
+      return;
+    }
+    case RegistryOp::List:
+    case RegistryOp::Watch:
+      // 快照和之后的通知在同一个事件循环中依次追加，观察者不会漏掉变化
+      if (static_cast<RegistryOp>(header.op) == RegistryOp::Watch) {
+        watchers_.insert(conn.id);
+      }
+      putU64(out, graph_version_);
+      appendEntries_(out, nullptr);
+      reply_(conn, RegistryOp::Entries, header.request_id, out);
+      return;
+    default:
+      putString(out, "unknown op " + std::to_string(header.op));
+      reply_(conn, RegistryOp::Error, header.request_id, out);
+      return;
+  }
+  putString(out, "malformed request");
+  reply_(conn, RegistryOp::Error, header.request_id, out);
+}
+
+void RegistryServer::appendEntries_(std::vector<uint8_t>& payload,
+                                    const std::string* only_name) {
+  if (only_name != nullptr) {
+    putU32(payload, 1);
+    putString(payload, *only_name);
+    putString(payload, entries_.at(*only_name).address);
+    return;
+  }
+  putU32(payload, static_cast<uint32_t>(entries_.size()));
+  for (const auto& entry : entries_) {
+    putString(payload, entry.first);
+    putString(payload, entry.second.address);
+  }
+}
+
+void RegistryServer::reply_(Connection& conn, RegistryOp op,
+                            uint32_t request_id,
+                            const std::vector<uint8_t>& payload) {
+  appendFrame(conn.output, op, request_id, payload);
+  if (!conn.dirty) {
+    conn.dirty = true;
+    dirty_.push_back(conn.id);
+  }
+}
+
+void RegistryServer::notifyWatchers_(bool added, const std::string& name,
+                                     const std::string& address) {
+  if (watchers_.empty()) {
+    return;
+  }
+  std::vector<uint8_t> payload;
+  putU64(payload, graph_version_);
+  payload.push_back(added ? 1 : 0);
+  putString(payload, name);
+  putString(payload, address);
+  for (uint64_t id : watchers_) {
+    auto it = connections_.find(id);
+    if (it != connections_.end()) {
+      reply_(*it->second, RegistryOp::Notify, 0, payload);
+      stats_notifications_++;
+    }
+  }
+}
+
+bool RegistryServer::flush_(Connection& conn) {
+  while (conn.output_offset < conn.output.size()) {
+    ssize_t ret = send(conn.fd, conn.output.data() + conn.output_offset,
+                       conn.output.size() - conn.output_offset, MSG_NOSIGNAL);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      return false;
+    }
+    conn.output_offset += ret;
+  }
+  size_t pending = conn.output.size() - conn.output_offset;
+  bool backlogged = pending > REGISTRY_MAX_PENDING_OUTPUT;
+  if (backlogged && watchers_.count(conn.id) > 0) {
+    // 通知不能丢也不能无限积压：不读通知的观察者断开，重连后用快照重新同步
+    std::cerr << "RegistryServer: watcher " << conn.id << " has " << pending
+              << " bytes pending, closing" << std::endl;
+    stats_errors_++;
+    return false;
+  }
+  // 只在有积压时关注 EPOLLOUT，否则每轮都会被可写事件唤醒；
+  // 回复积压过多时暂停读取，对端的请求留在内核缓冲区里（TCP 流控）
+  uint32_t events =
+      (backlogged ? 0u : static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP)) |
+      (pending > 0 ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+  if (events != conn.events) {
+    epoll_event ev;
+    ev.events = events;
+    ev.data.u64 = conn.id;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+    conn.events = events;
+  }
+  compact(conn.output, conn.output_offset);
+  // 积压发出后继续处理暂停时已读入的请求
+  if (!backlogged && conn.input_offset < conn.input.size()) {
+    return processInput_(conn);
+  }
+  return true;
+}
+
+void RegistryServer::closeConnection_(uint64_t id) {
+  auto it = connections_.find(id);
+  if (it == connections_.end()) {
+    return;
+  }
+  std::unique_ptr<Connection> conn = std::move(it->second);
+  connections_.erase(it);
+  watchers_.erase(id);
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->fd, nullptr);
+  close(conn->fd);
+  stats_connections_--;
+  // 连接上注册的节点随连接注销
+  for (const auto& name : conn->owned) {
+    auto entry = entries_.find(name);
+    if (entry == entries_.end() || entry->second.owner != id) {
+      continue;
+    }
+    std::string address = entry->second.address;
+    entries_.erase(entry);
+    graph_version_++;
+    notifyWatchers_(false, name, address);
+  }
+  stats_entries_ = entries_.size();
+}
+
+RegistryServerStats RegistryServer::getStats() const {
+  RegistryServerStats stats;
+  stats.accepted = stats_accepted_;
+  stats.connections = stats_connections_;
+  stats.requests = stats_requests_;
+  stats.entries = stats_entries_;
+  stats.notifications = stats_notifications_;
+  stats.errors = stats_errors_;
+  return stats;
+}
+
+RegistryClient::RegistryClient(const std::string& host, uint16_t port) {
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+  int ret = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints,
+                        &result);
+  if (ret != 0 || result == nullptr) {
+    throw std::runtime_error("RegistryClient: cannot resolve " + host + ": " +
+                             gai_strerror(ret));
+  }
+  fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ < 0 || connect(fd_, result->ai_addr, result->ai_addrlen) < 0) {
+    int error = errno;
+    freeaddrinfo(result);
+    if (fd_ >= 0) close(fd_);
+    throw std::runtime_error("RegistryClient: connect " + host + ":" +
+                             std::to_string(port) + ": " + strerror(error));
+  }
+  freeaddrinfo(result);
+  int on = 1;
+  setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+RegistryClient::~RegistryClient() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+uint32_t RegistryClient::queueRequest_(RegistryOp op,
+                                       const std::vector<uint8_t>& payload) {
+  uint32_t request_id = next_request_id_++;
+  if (next_request_id_ == 0) {
+    next_request_id_ = 1;  // 0 留给通知
+  }
+  appendFrame(output_, op, request_id, payload);
+  return request_id;
+}
+
+void RegistryClient::flush_() {
+  size_t sent = 0;
+  while (sent < output_.size()) {
+    ssize_t ret = send(fd_, output_.data() + sent, output_.size() - sent,
+                       MSG_NOSIGNAL);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error("RegistryClient: send: " +
+                               std::string(strerror(errno)));
+    }
+    sent += ret;
+  }
+  output_.clear();
+}
+
+bool RegistryClient::readFrame_(Frame& frame, int timeout_ms) {
+  while (true) {
+    RegistryFrameHeader header;
+    // 回复（如 List）可以超过请求的负载上限
+    int parsed = parseHeader(input_, input_offset_, UINT32_MAX, header);
+    if (parsed < 0) {
+      throw std::runtime_error("RegistryClient: bad frame from server");
+    }
+    if (parsed > 0 &&
+        input_.size() - input_offset_ >= sizeof(header) + header.length) {
+      const uint8_t* payload = input_.data() + input_offset_ + sizeof(header);
+      frame.op = static_cast<RegistryOp>(header.op);
+      frame.request_id = header.request_id;
+      frame.payload.assign(payload, payload + header.length);
+      input_offset_ += sizeof(header) + header.length;
+      compact(input_, input_offset_);
+      return true;
+    }
+    if (timeout_ms >= 0) {
+      pollfd pfd = {fd_, POLLIN, 0};
+      int ready = poll(&pfd, 1, timeout_ms);
+      if (ready == 0) {
+        return false;
+      }
+      if (ready < 0 && errno != EINTR) {
+        throw std::runtime_error("RegistryClient: poll: " +
+                                 std::string(strerror(errno)));
+      }
+    }
+    size_t used = input_.size();
+    input_.resize(used + READ_CHUNK);
+    ssize_t ret = recv(fd_, input_.data() + used, READ_CHUNK, 0);
+    input_.resize(used + (ret > 0 ? ret : 0));
+    if (ret == 0) {
+      throw std::runtime_error("RegistryClient: connection closed");
+    }
+    if (ret < 0 && errno != EINTR) {
+      throw std::runtime_error("RegistryClient: recv: " +
+                               std::string(strerror(errno)));
+    }
+  }
+}
+
+RegistryClient::Frame RegistryClient::waitReply_(uint32_t request_id) {
+  Frame frame;
   while (true) {
-    int client_socket = accept(server_fd, nullptr, nullptr);
-    std::thread(handle_client, client_socket).detach();
+    readFrame_(frame, -1);
+    if (frame.op == RegistryOp::Notify) {
+      notifications_.push_back(parseNotification(frame.payload));
+      continue;
+    }
+    if (frame.request_id == request_id) {
+      return frame;
+    }
+  }
+}
+
+uint64_t RegistryClient::registerNode(const std::string& name,
+                                      const std::string& address) {
+  std::vector<uint8_t> payload;
+  putString(payload, name);
+  putString(payload, address);
+  uint32_t request_id = queueRequest_(RegistryOp::Register, payload);
+  flush_();
+  Frame reply = waitReply_(request_id);
+  if (reply.op != RegistryOp::Ok) {
+    throw replyError(reply.payload);
+  }
+  PayloadReader reader{reply.payload.data(), reply.payload.size()};
+  return reader.u64();
+}
+
+size_t RegistryClient::registerNodes(const std::vector<RegistryEntry>& entries) {
+  size_t ok = 0;
+  std::vector<uint8_t> payload;
+  std::vector<uint32_t> request_ids;
+  for (size_t begin = 0; begin < entries.size();
+       begin += CLIENT_PIPELINE_DEPTH) {
+    size_t end = std::min(entries.size(), begin + CLIENT_PIPELINE_DEPTH);
+    request_ids.clear();
+    for (size_t i = begin; i < end; i++) {
+      payload.clear();
+      putString(payload, entries[i].name);
+      putString(payload, entries[i].address);
+      request_ids.push_back(queueRequest_(RegistryOp::Register, payload));
+    }
+    flush_();
+    for (uint32_t request_id : request_ids) {
+      if (waitReply_(request_id).op == RegistryOp::Ok) {
+        ok++;
+      }
+    }
+  }
+  return ok;
+}
+
+bool RegistryClient::unregisterNode(const std::string& name) {
+  std::vector<uint8_t> payload;
+  putString(payload, name);
+  uint32_t request_id = queueRequest_(RegistryOp::Unregister, payload);
+  flush_();
+  Frame reply = waitReply_(request_id);
+  if (reply.op == RegistryOp::Error) {
+    throw replyError(reply.payload);
+  }
+  return reply.op == RegistryOp::Ok;
+}
+
+bool RegistryClient::lookup(const std::string& name, std::string& address) {
+  std::vector<uint8_t> payload;
+  putString(payload, name);
+  uint32_t request_id = queueRequest_(RegistryOp::Lookup, payload);
+  flush_();
+  Frame reply = waitReply_(request_id);
+  if (reply.op == RegistryOp::Error) {
+    throw replyError(reply.payload);
+  }
+  if (reply.op != RegistryOp::Entries) {
+    return false;
+  }
+  std::vector<RegistryEntry> entries = parseEntries(reply.payload, nullptr);
+  if (entries.empty()) {
+    return false;
+  }
+  address = entries[0].address;
+  return true;
+}
+
+std::vector<RegistryEntry> RegistryClient::list(uint64_t* version) {
+  uint32_t request_id = queueRequest_(RegistryOp::List, {});
+  flush_();
+  Frame reply = waitReply_(request_id);
+  if (reply.op != RegistryOp::Entries) {
+    throw replyError(reply.payload);
   }
-  return 0;
-}
\ No newline at end of file
+  return parseEntries(reply.payload, version);
+}
+
+std::vector<RegistryEntry> RegistryClient::watch(uint64_t* version) {
+  uint32_t request_id = queueRequest_(RegistryOp::Watch, {});
+  flush_();
+  Frame reply = waitReply_(request_id);
+  if (reply.op != RegistryOp::Entries) {
+    throw replyError(reply.payload);
+  }
+  return parseEntries(reply.payload, version);
+}
+
+bool RegistryClient::waitNotification(RegistryNotification& notification,
+                                      int timeout_ms) {
+  while (notifications_.empty()) {
+    Frame frame;
+    if (!readFrame_(frame, timeout_ms)) {
+      return false;
+    }
+    // 同步请求都已读到自己的回复，这里只会收到通知
+    if (frame.op == RegistryOp::Notify) {
+      notifications_.push_back(parseNotification(frame.payload));
+    }
+  }
+  notification = std::move(notifications_.front());
+  notifications_.pop_front();
+  return true;
+}
@@ -0,0 +1,114 @@
+#include "mini_ros2/communication/robust_mutex.h"
+
+#include <errno.h>
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+void initRobustMutex(pthread_mutex_t* mutex) {
+  pthread_mutexattr_t mutex_attr;
+  int ret = pthread_mutexattr_init(&mutex_attr);
+  if (ret != 0) {
+    throw std::runtime_error("Failed to init mutex attr: " +
+                             std::string(strerror(ret)));
+  }
+  ret = pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+  if (ret == 0) {
+    ret = pthread_mutexattr_setrobust(&mutex_attr, PTHREAD_MUTEX_ROBUST);
+  }
+  if (ret != 0) {
+    pthread_mutexattr_destroy(&mutex_attr);
+    throw std::runtime_error("Failed to set mutex attr: " +
+                             std::string(strerror(ret)));
+  }
+  ret = pthread_mutex_init(mutex, &mutex_attr);
+  pthread_mutexattr_destroy(&mutex_attr);
+  if (ret != 0) {
+    throw std::runtime_error("Failed to init mutex: " +
+                             std::string(strerror(ret)));
+  }
+}
+
+void initSharedCond(pthread_cond_t* cond) {
+  pthread_condattr_t cond_attr;
+  int ret = pthread_condattr_init(&cond_attr);
+  if (ret != 0) {
+    throw std::runtime_error("Failed to init cond attr: " +
+                             std::string(strerror(ret)));
+  }
+  ret = pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+  if (ret != 0) {
+    pthread_condattr_destroy(&cond_attr);
+    throw std::runtime_error("Failed to set cond shared: " +
+                             std::string(strerror(ret)));
+  }
+  ret = pthread_cond_init(cond, &cond_attr);
+  pthread_condattr_destroy(&cond_attr);
+  if (ret != 0) {
+    throw std::runtime_error("Failed to init cond: " +
+                             std::string(strerror(ret)));
+  }
+}
+
+namespace {
+
+// EOWNERDEAD：锁已被当前线程持有，标记为一致后即可继续使用
+bool recoverOwnerDead(pthread_mutex_t* mutex, int ret) {
+  if (ret == 0) {
+    return false;
+  }
+  if (ret == EOWNERDEAD) {
+    std::cerr << "robust mutex: previous owner died, recovering lock"
+              << std::endl;
+    ret = pthread_mutex_consistent(mutex);
+    if (ret != 0) {
+      pthread_mutex_unlock(mutex);
+      throw std::runtime_error("Failed to make mutex consistent: " +
+                               std::string(strerror(ret)));
+    }
+    return true;
+  }
+  if (ret == ENOTRECOVERABLE) {
+    throw std::runtime_error(
+        "Shared mutex not recoverable, run clear_shm.sh");
+  }
+  throw std::runtime_error("Failed to lock mutex: " +
+                           std::string(strerror(ret)));
+}
+
+}  // namespace
+
+bool robustLock(pthread_mutex_t* mutex) {
+  return recoverOwnerDead(mutex, pthread_mutex_lock(mutex));
+}
+
+bool robustWait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+  return recoverOwnerDead(mutex, pthread_cond_wait(cond, mutex));
+}
+
+int robustTimedWait(pthread_cond_t* cond, pthread_mutex_t* mutex,
+                    const struct timespec& abstime, bool* owner_died) {
+  int ret = pthread_cond_timedwait(cond, mutex, &abstime);
+  if (ret == ETIMEDOUT) {
+    return ret;
+  }
+  bool died = recoverOwnerDead(mutex, ret);
+  if (owner_died != nullptr && died) {
+    *owner_died = true;
+  }
+  return 0;
+}
+
+struct timespec deadlineAfterMs(uint64_t timeout_ms) {
+  struct timespec abstime;
+  clock_gettime(CLOCK_REALTIME, &abstime);
+  abstime.tv_sec += timeout_ms / 1000;
+  abstime.tv_nsec += (timeout_ms % 1000) * 1000000;
+  if (abstime.tv_nsec >= 1000000000) {
+    abstime.tv_sec += 1;
+    abstime.tv_nsec -= 1000000000;
+  }
+  return abstime;
+}
@@ -0,0 +1,561 @@
+#include "mini_ros2/communication/segment_broker.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// epoll_event.data.u64：连接 id 从 1 开始，0 和最大值留给监听套接字和唤醒 eventfd
+#define LISTEN_TAG 0
+#define WAKE_TAG UINT64_MAX
+
+// 抽象命名空间地址：sun_path[0] 为 '\0'，名字不以 '\0' 结尾
+socklen_t brokerAddress(const std::string& name, sockaddr_un& addr) {
+  if (name.empty() || name.size() >= sizeof(addr.sun_path)) {
+    throw std::invalid_argument("SegmentBroker: invalid broker name " + name);
+  }
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path + 1, name.data(), name.size());
+  return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 +
+                                name.size());
+}
+
+// 发送一条报文，send_fd >= 0 时随报文传递该描述符
+bool sendMessage(int fd, SegmentOp op, const std::string& name, uint64_t size,
+                 int send_fd, int flags) {
+  SegmentMessage header;
+  header.magic = SEGMENT_BROKER_MAGIC;
+  header.version = SEGMENT_BROKER_VERSION;
+  header.op = static_cast<uint8_t>(op);
+  header.name_length = static_cast<uint16_t>(name.size());
+  header.size = size;
+  iovec iov[2];
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof(header);
+  iov[1].iov_base = const_cast<char*>(name.data());
+  iov[1].iov_len = name.size();
+  msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = 2;
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  if (send_fd >= 0) {
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &send_fd, sizeof(int));
+  }
+  while (true) {
+    ssize_t ret = sendmsg(fd, &msg, flags | MSG_NOSIGNAL);
+    if (ret >= 0) return true;
+    if (errno != EINTR) return false;
+  }
+}
+
+// 接收一条报文：返回读到的字节数（0 为对端关闭，-1 为出错，errno 有效）
+// 报文带描述符时写入 received_fd，否则为 -1
+ssize_t receiveMessage(int fd, std::vector<uint8_t>& buffer, int& received_fd,
+                       int flags) {
+  received_fd = -1;
+  buffer.resize(sizeof(SegmentMessage) + SEGMENT_BROKER_MAX_NAME);
+  iovec iov;
+  iov.iov_base = buffer.data();
+  iov.iov_len = buffer.size();
+  msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  ssize_t ret;
+  do {
+    ret = recvmsg(fd, &msg, flags | MSG_CMSG_CLOEXEC);
+  } while (ret < 0 && errno == EINTR);
+  if (ret < 0) {
+    return ret;
+  }
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(sizeof(int))) {
+      std::memcpy(&received_fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+  }
+  // 报文被截断或控制信息被截断都视为协议错误
+  if ((msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0) {
+    if (received_fd >= 0) close(received_fd);
+    received_fd = -1;
+    errno = EMSGSIZE;
+    return -1;
+  }
+  return ret;
+}
+
+// 校验报文头并取出 name；非法时返回 false
+bool parseMessage(const std::vector<uint8_t>& buffer, size_t length,
+                  SegmentMessage& header, std::string& name) {
+  if (length < sizeof(SegmentMessage)) {
+    return false;
+  }
+  std::memcpy(&header, buffer.data(), sizeof(header));
+  if (header.magic != SEGMENT_BROKER_MAGIC ||
+      header.version != SEGMENT_BROKER_VERSION ||
+      length != sizeof(header) + header.name_length) {
+    return false;
+  }
+  name.assign(reinterpret_cast<const char*>(buffer.data()) + sizeof(header),
+              header.name_length);
+  return true;
+}
+
+}  // namespace
+
+SegmentBroker::SegmentBroker(const std::string& name) : name_(name) {
+  sockaddr_un addr;
+  socklen_t addr_len = brokerAddress(name_, addr);
+  try {
+    // SEQPACKET 保留报文边界，一次 recvmsg 正好一个请求，不需要分帧
+    listen_fd_ =
+        socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+      throw std::runtime_error("SegmentBroker: socket: " +
+                               std::string(strerror(errno)));
+    }
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), addr_len) < 0) {
+      throw std::runtime_error("SegmentBroker: bind " + name_ + ": " +
+                               std::string(strerror(errno)));
+    }
+    if (listen(listen_fd_, SOMAXCONN) < 0) {
+      throw std::runtime_error("SegmentBroker: listen: " +
+                               std::string(strerror(errno)));
+    }
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+      throw std::runtime_error("SegmentBroker: epoll: " +
+                               std::string(strerror(errno)));
+    }
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_TAG;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev);
+    ev.data.u64 = WAKE_TAG;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+  } catch (...) {
+    if (listen_fd_ >= 0) close(listen_fd_);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+    throw;
+  }
+  std::cout << "SegmentBroker: listening on @" << name_ << std::endl;
+}
+
+SegmentBroker::~SegmentBroker() {
+  stop();
+  for (auto& entry : connections_) {
+    close(entry.second);
+  }
+  for (auto& entry : segments_) {
+    close(entry.second.fd);
+  }
+  close(listen_fd_);
+  close(epoll_fd_);
+  close(wake_fd_);
+}
+
+void SegmentBroker::start() {
+  if (thread_.joinable()) return;
+  thread_ = std::thread([this]() {
+    pthread_setname_np(pthread_self(), "segment_broker");
+    run();
+  });
+}
+
+void SegmentBroker::stop() {
+  uint64_t one = 1;
+  ssize_t ret = write(wake_fd_, &one, sizeof(one));
+  (void)ret;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+SegmentBrokerStats SegmentBroker::getStats() const {
+  SegmentBrokerStats stats;
+  stats.accepted = stats_accepted_.load();
+  stats.connections = stats_connections_.load();
+  stats.offers = stats_offers_.load();
+  stats.fetches = stats_fetches_.load();
+  stats.segments = stats_segments_.load();
+  stats.errors = stats_errors_.load();
+  return stats;
+}
+
+void SegmentBroker::run() {
+  epoll_event events[64];
+  while (true) {
+    int ready = epoll_wait(epoll_fd_, events, 64, -1);
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      std::cerr << "SegmentBroker: epoll_wait failed: " << strerror(errno)
+                << std::endl;
+      return;
+    }
+    for (int i = 0; i < ready; i++) {
+      uint64_t tag = events[i].data.u64;
+      if (tag == WAKE_TAG) {
+        uint64_t value;
+        ssize_t ret = read(wake_fd_, &value, sizeof(value));
+        (void)ret;
+        return;
+      }
+      if (tag == LISTEN_TAG) {
+        acceptAll_();
+        continue;
+      }
+      auto it = connections_.find(tag);
+      if (it == connections_.end()) {
+        continue;
+      }
+      if (!handleConnection_(tag, it->second)) {
+        closeConnection_(tag);
+      }
+    }
+  }
+}
+
+void SegmentBroker::acceptAll_() {
+  while (true) {
+    int fd =
+        accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        std::cerr << "SegmentBroker: accept failed: " << strerror(errno)
+                  << std::endl;
+      }
+      return;
+    }
+    uint64_t id = next_connection_id_++;
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.u64 = id;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      close(fd);
+      continue;
+    }
+    connections_.emplace(id, fd);
+    stats_accepted_++;
+    stats_connections_++;
+  }
+}
+
+bool SegmentBroker::handleConnection_(uint64_t id, int fd) {
+  std::vector<uint8_t> buffer;
+  while (true) {
+    int received_fd = -1;
+    ssize_t length = receiveMessage(fd, buffer, received_fd, MSG_DONTWAIT);
+    if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return true;
+    }
+    if (length <= 0) {
+      if (length < 0) stats_errors_++;
+      return false;  // 对端关闭或报文非法
+    }
+    SegmentMessage header;
+    std::string name;
+    bool valid = parseMessage(buffer, static_cast<size_t>(length), header,
+                              name);
+    SegmentOp op = static_cast<SegmentOp>(header.op);
+    // 只有 Offer 带描述符；Offer 的描述符必须是封住大小、与声明一致的段
+    if (valid && op == SegmentOp::Offer) {
+      struct stat st;
+      int seals = received_fd >= 0 ? fcntl(received_fd, F_GET_SEALS) : -1;
+      valid = seals != -1 && (seals & F_SEAL_SHRINK) &&
+              fstat(received_fd, &st) == 0 &&
+              static_cast<uint64_t>(st.st_size) == header.size;
+    } else if (received_fd >= 0) {
+      valid = false;
+    }
+    if (!valid) {
+      if (received_fd >= 0) close(received_fd);
+      stats_errors_++;
+      sendMessage(fd, SegmentOp::Error, std::string(), 0, -1, MSG_DONTWAIT);
+      return false;
+    }
+
+    bool sent = true;
+    switch (op) {
+      case SegmentOp::Offer: {
+        stats_offers_++;
+        owned_[id].insert(name);
+        auto it = segments_.find(name);
+        if (it == segments_.end()) {
+          segments_.emplace(name, Segment{received_fd, header.size, {id}});
+          stats_segments_++;
+          sent = sendMessage(fd, SegmentOp::Ok, name, header.size, -1,
+                             MSG_DONTWAIT);
+        } else {
+          // 同名段已被登记（并发创建）：登记者也成为它的归属者，改用已有的段
+          close(received_fd);
+          it->second.owners.insert(id);
+          sent = sendMessage(fd, SegmentOp::Segment, name, it->second.size,
+                             it->second.fd, MSG_DONTWAIT);
+        }
+        break;
+      }
+      case SegmentOp::Fetch: {
+        stats_fetches_++;
+        auto it = segments_.find(name);
+        sent = it == segments_.end()
+                   ? sendMessage(fd, SegmentOp::NotFound, name, 0, -1,
+                                 MSG_DONTWAIT)
+                   : sendMessage(fd, SegmentOp::Segment, name,
+                                 it->second.size, it->second.fd,
+                                 MSG_DONTWAIT);
+        break;
+      }
+      case SegmentOp::Withdraw: {
+        auto owned = owned_.find(id);
+        bool found = owned != owned_.end() && owned->second.erase(name) > 0;
+        if (found) {
+          release_(name, id);
+        }
+        sent = sendMessage(fd, found ? SegmentOp::Ok : SegmentOp::NotFound,
+                           name, 0, -1, MSG_DONTWAIT);
+        break;
+      }
+      default:
+        stats_errors_++;
+        return false;
+    }
+    // 客户端同步等待回复，发送缓冲区满说明对端不读，断开
+    if (!sent) {
+      return false;
+    }
+  }
+}
+
+void SegmentBroker::release_(const std::string& name, uint64_t owner) {
+  auto it = segments_.find(name);
+  if (it == segments_.end()) {
+    return;
+  }
+  it->second.owners.erase(owner);
+  if (it->second.owners.empty()) {
+    // 代理不再持有；已映射的进程不受影响，全部关闭后由内核释放
+    close(it->second.fd);
+    segments_.erase(it);
+    stats_segments_--;
+  }
+}
+
+void SegmentBroker::closeConnection_(uint64_t id) {
+  auto it = connections_.find(id);
+  if (it == connections_.end()) {
+    return;
+  }
+  auto owned = owned_.find(id);
+  if (owned != owned_.end()) {
+    for (const auto& name : owned->second) {
+      release_(name, id);
+    }
+    owned_.erase(owned);
+  }
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second, nullptr);
+  close(it->second);
+  connections_.erase(it);
+  stats_connections_--;
+}
+
+SegmentClient::SegmentClient(const std::string& name) {
+  sockaddr_un addr;
+  socklen_t addr_len = brokerAddress(name, addr);
+  fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) {
+    throw std::runtime_error("SegmentClient: socket: " +
+                             std::string(strerror(errno)));
+  }
+  if (connect(fd_, reinterpret_cast<sockaddr*>(&addr), addr_len) < 0) {
+    int error = errno;
+    close(fd_);
+    throw std::runtime_error("SegmentClient: connect @" + name + ": " +
+                             std::string(strerror(error)));
+  }
+}
+
+SegmentClient::~SegmentClient() { close(fd_); }
+
+std::shared_ptr<ShmBase> SegmentClient::offer(
+    const std::string& name, std::shared_ptr<ShmBase> segment) {
+  if (segment == nullptr || !segment->IsAnonymous()) {
+    throw std::invalid_argument("SegmentClient: only anonymous segments can "
+                                "be offered");
+  }
+  request_(SegmentOp::Offer, name, segment->getSize(), segment->getFd());
+  uint64_t size = 0;
+  int fd = -1;
+  SegmentOp op = reply_(size, fd);
+  if (op == SegmentOp::Ok) {
+    return segment;
+  }
+  if (op == SegmentOp::Segment) {
+    std::shared_ptr<ShmBase> existing = ShmBase::adoptAnonymous(name, fd);
+    if (existing != nullptr) {
+      return existing;
+    }
+  }
+  throw std::runtime_error("SegmentClient: offer " + name + " rejected");
+}
+
+std::shared_ptr<ShmBase> SegmentClient::fetch(const std::string& name) {
+  request_(SegmentOp::Fetch, name, 0, -1);
+  uint64_t size = 0;
+  int fd = -1;
+  SegmentOp op = reply_(size, fd);
+  if (op == SegmentOp::Segment) {
+    return ShmBase::adoptAnonymous(name, fd);
+  }
+  if (op == SegmentOp::NotFound) {
+    return nullptr;
+  }
+  throw std::runtime_error("SegmentClient: fetch " + name + " failed");
+}
+
+bool SegmentClient::withdraw(const std::string& name) {
+  request_(SegmentOp::Withdraw, name, 0, -1);
+  uint64_t size = 0;
+  int fd = -1;
+  return reply_(size, fd) == SegmentOp::Ok;
+}
+
+void SegmentClient::request_(SegmentOp op, const std::string& name,
+                             uint64_t size, int send_fd) {
+  if (name.size() > SEGMENT_BROKER_MAX_NAME) {
+    throw std::invalid_argument("SegmentClient: segment name too long: " +
+                                name);
+  }
+  if (!sendMessage(fd_, op, name, size, send_fd, 0)) {
+    throw std::runtime_error("SegmentClient: send: " +
+                             std::string(strerror(errno)));
+  }
+}
+
+SegmentOp SegmentClient::reply_(uint64_t& size, int& received_fd) {
+  std::vector<uint8_t> buffer;
+  ssize_t length = receiveMessage(fd_, buffer, received_fd, 0);
+  if (length <= 0) {
+    throw std::runtime_error(
+        "SegmentClient: broker closed the connection" +
+        (length < 0 ? ": " + std::string(strerror(errno)) : std::string()));
+  }
+  SegmentMessage header;
+  std::string name;
+  if (!parseMessage(buffer, static_cast<size_t>(length), header, name)) {
+    if (received_fd >= 0) close(received_fd);
+    throw std::runtime_error("SegmentClient: malformed reply");
+  }
+  SegmentOp op = static_cast<SegmentOp>(header.op);
+  if (op != SegmentOp::Segment && received_fd >= 0) {
+    close(received_fd);
+    received_fd = -1;
+  }
+  if (op == SegmentOp::Segment && received_fd < 0) {
+    throw std::runtime_error("SegmentClient: reply without descriptor");
+  }
+  size = header.size;
+  return op;
+}
+
+std::string segmentBrokerFromEnv() {
+  const char* value = std::getenv(SEGMENT_BROKER_ENV);
+  return value == nullptr ? std::string() : std::string(value);
+}
+
+namespace {
+
+std::mutex g_client_mutex;
+std::unique_ptr<SegmentClient> g_client;
+std::string g_client_broker;
+pid_t g_client_pid = 0;
+
+// 进程内共用的代理连接，调用者持有 g_client_mutex
+// fork 出的子进程继承的是父进程的连接，重新连接以免和父进程的请求交错
+SegmentClient& processClient(const std::string& broker) {
+  if (g_client != nullptr &&
+      (g_client_pid != getpid() || g_client_broker != broker)) {
+    g_client.reset();
+  }
+  if (g_client == nullptr) {
+    g_client = std::make_unique<SegmentClient>(broker);
+    g_client_broker = broker;
+    g_client_pid = getpid();
+  }
+  return *g_client;
+}
+
+// 代理重启等导致请求失败时丢弃连接，下次调用重新连接；之前的登记随旧连接失效
+template <typename Fn>
+std::shared_ptr<ShmBase> withProcessClient(const std::string& broker, Fn fn) {
+  std::lock_guard<std::mutex> lock(g_client_mutex);
+  try {
+    return fn(processClient(broker));
+  } catch (const std::runtime_error&) {
+    g_client.reset();
+    throw;
+  }
+}
+
+}  // namespace
+
+std::shared_ptr<ShmBase> createTopicSegment(const std::string& shm_name,
+                                            size_t data_size) {
+  std::string broker = segmentBrokerFromEnv();
+  if (broker.empty()) {
+    auto shm = std::make_shared<ShmBase>(shm_name, data_size);
+    shm->Create();
+    shm->Open();
+    return shm;
+  }
+  std::shared_ptr<ShmBase> shm = ShmBase::createAnonymous(shm_name, data_size);
+  return withProcessClient(broker, [&](SegmentClient& client) {
+    return client.offer(shm_name, shm);
+  });
+}
+
+std::shared_ptr<ShmBase> attachTopicSegment(const std::string& shm_name) {
+  std::string broker = segmentBrokerFromEnv();
+  if (broker.empty()) {
+    try {
+      auto shm = std::make_shared<ShmBase>(shm_name);
+      if (!shm->OpenInitialized()) {
+        return nullptr;  // 发布者正在创建数据段
+      }
+      return shm;
+    } catch (const std::invalid_argument&) {
+      return nullptr;  // 发布者尚未创建数据段
+    }
+  }
+  return withProcessClient(broker, [&](SegmentClient& client) {
+    return client.fetch(shm_name);
+  });
+}
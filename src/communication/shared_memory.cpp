@@ -1,5 +1,9 @@
 #include "mini_ros2/communication/shared_memory.h"
 
+#include <sys/mman.h>
+
+#include <cstring>
+
 SharedMemory::~SharedMemory() {
   if (data_ != MAP_FAILED && data_ != nullptr) {
     Close();
@@ -14,6 +18,9 @@ bool SharedMemory::Create() {
   if (is_owner_) {
     return true;  // 已经是创建者，直接返回
   }
+  if (anonymous_) {
+    return CreateAnonymous_();
+  }
   // std::cout << name_ << std::endl;
   fd_ = shm_open(
       name_.c_str(), O_CREAT | O_EXCL | O_RDWR,
@@ -41,7 +48,38 @@ bool SharedMemory::Create() {
   return true;
 }
 
+bool SharedMemory::CreateAnonymous_() {
+  // memfd 名字只出现在 /proc/<pid>/fd 中，去掉开头的 '/'，长度上限 249
+  std::string label = name_.empty() || name_[0] != '/' ? name_ : name_.substr(1);
+  label = label.substr(0, 249);
+  fd_ = memfd_create(label.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd_ == -1) {
+    std::cout << "memfd_create failed: " << strerror(errno) << std::endl;
+    return false;
+  }
+  // 封住大小：接收描述符的进程可以信任 fstat 得到的大小，
+  // 不会因为对方缩小文件而在访问映射时收到 SIGBUS
+  if (ftruncate(fd_, size_) == -1 ||
+      fcntl(fd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) ==
+          -1) {
+    std::cout << "memfd setup failed: " << strerror(errno) << std::endl;
+    Close();
+    return false;
+  }
+  data_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data_ == MAP_FAILED) {
+    Close();
+    std::cout << "mmap failed" << std::endl;
+    return false;
+  }
+  is_owner_ = true;
+  return true;
+}
+
 bool SharedMemory::Exists() const {
+  if (anonymous_) {
+    return fd_ != -1;
+  }
   int fd = shm_open(name_.c_str(), O_RDONLY, 0666);
   if (fd == -1) {
     return false;  // 不存在
@@ -54,6 +92,22 @@ bool SharedMemory::Open() {
   if (is_owner_) {
     return true;  // 已经是创建者，直接返回
   }
+  if (anonymous_) {
+    if (data_ != nullptr && data_ != MAP_FAILED) {
+      return true;
+    }
+    if (fd_ == -1) {
+      return false;
+    }
+    data_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (data_ == MAP_FAILED) {
+      data_ = nullptr;
+      Close();  // 接管的描述符不再使用
+      std::cout << "mmap failed" << std::endl;
+      return false;
+    }
+    return true;
+  }
   std::cout << name_ << std::endl;
   fd_ = shm_open(name_.c_str(), O_RDWR, 0666);
   if (fd_ == -1) {
@@ -86,6 +140,9 @@ bool SharedMemory::Unlink() {
   if (!is_owner_) {
     return false;  // 不是创建者，不能删除
   }
+  if (anonymous_) {
+    return true;  // 没有名字，最后一个引用关闭时由内核释放
+  }
   if (shm_unlink(name_.c_str()) == -1) {
     return false;  // 删除失败
   }
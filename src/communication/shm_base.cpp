@@ -1,5 +1,37 @@
 #include "mini_ros2/communication/shm_base.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iostream>
+
+std::shared_ptr<ShmBase> ShmBase::createAnonymous(const std::string& name,
+                                                  size_t data_size) {
+  std::shared_ptr<ShmBase> shm(
+      new ShmBase(name, sizeof(ShmHead) + data_size, -1));
+  shm->Create();
+  shm->Open();
+  return shm;
+}
+
+std::shared_ptr<ShmBase> ShmBase::adoptAnonymous(const std::string& name,
+                                                 int fd) {
+  struct stat st;
+  int seals = fcntl(fd, F_GET_SEALS);
+  if (fstat(fd, &st) == -1 || seals == -1 || !(seals & F_SEAL_SHRINK) ||
+      static_cast<size_t>(st.st_size) <= sizeof(ShmHead)) {
+    close(fd);
+    return nullptr;
+  }
+  std::shared_ptr<ShmBase> shm(
+      new ShmBase(name, static_cast<size_t>(st.st_size), fd));
+  if (!shm->OpenInitialized()) {
+    return nullptr;  // 析构时关闭 fd
+  }
+  return shm;
+}
+
 void ShmBase::Create() {
   if (!shm_.Create()) {
     throw std::runtime_error("Failed to create shared memory");
@@ -15,63 +47,41 @@ void ShmBase::initMutexAndCond() {
     throw std::runtime_error("获取共享内存头部指针失败");
   }
 
-  // 3. 初始化互斥锁（进程间共享）
-  pthread_mutexattr_t mutex_attr;
-  int ret = pthread_mutexattr_init(&mutex_attr);
-  if (ret != 0) {
-    throw std::runtime_error("初始化互斥锁属性失败：" +
-                             std::string(strerror(ret)));
-  }
-  // 设置互斥锁可跨进程共享
-  ret = pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
-  if (ret != 0) {
-    pthread_mutexattr_destroy(&mutex_attr);
-    throw std::runtime_error("设置互斥锁进程共享属性失败：" +
-                             std::string(strerror(ret)));
-  }
-  // 初始化互斥锁
+  // 3. 初始化互斥锁（进程间共享，robust：持锁进程崩溃后可恢复）
   // 注意：如果互斥锁已经初始化，pthread_mutex_init 会返回 EBUSY 或 EINVAL
   // 这种情况理论上不应该发生，因为我们已经检查了 initialized_ 标志
-  ret = pthread_mutex_init(&head->mutex_, &mutex_attr);
-  if (ret != 0) {
-    pthread_mutexattr_destroy(&mutex_attr);
-    throw std::runtime_error("初始化互斥锁失败：" + std::string(strerror(ret)));
-  }
-  pthread_mutexattr_destroy(&mutex_attr);
+  initRobustMutex(&head->mutex_);
 
   // 4. 初始化条件变量（进程间共享）
-  pthread_condattr_t cond_attr;
-  ret = pthread_condattr_init(&cond_attr);
-  if (ret != 0) {
-    throw std::runtime_error("初始化条件变量属性失败：" +
-                             std::string(strerror(ret)));
-  }
-  ret = pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
-  if (ret != 0) {
-    pthread_condattr_destroy(&cond_attr);
-    throw std::runtime_error("设置条件变量进程共享属性失败：" +
-                             std::string(strerror(ret)));
-  }
-  // 初始化条件变量（如果已初始化，上面的 mutex_destroy 中已经销毁了）
-  ret = pthread_cond_init(&head->cond_, &cond_attr);
-  if (ret != 0) {
-    pthread_condattr_destroy(&cond_attr);
-    throw std::runtime_error("初始化条件变量失败：" +
-                             std::string(strerror(ret)));
-  }
-  pthread_condattr_destroy(&cond_attr);
+  initSharedCond(&head->cond_);
 
-  // 设置初始化标志
-  head->initialized_ = 0x4D525332;  // "MRS2"
+  head->dirty_ = 0;
   head->time_ = 0;
+  // 初始化标志最后写入，OpenInitialized 看到标志即说明锁已初始化完成
+  __atomic_store_n(&head->initialized_, 0x4D525332, __ATOMIC_RELEASE);  // "MRS2"
 
   CachePointers(head);
 }
 
+bool ShmBase::OpenInitialized() {
+  // 创建者 ftruncate 之前大小为 0，只有头部说明尚未设置大小
+  if (total_size_ <= sizeof(ShmHead) || !shm_.Open()) {
+    return false;
+  }
+  ShmHead* head = static_cast<ShmHead*>(shm_.Data());
+  if (__atomic_load_n(&head->initialized_, __ATOMIC_ACQUIRE) != 0x4D525332) {
+    shm_.Close();
+    return false;
+  }
+  CachePointers(head);
+  return true;
+}
+
 void ShmBase::CachePointers(ShmHead* head) {
   mutex_ptr_ = &head->mutex_;
   cond_ptr_ = &head->cond_;
   time_ptr_ = &head->time_;
+  dirty_ptr_ = &head->dirty_;
 
   // 数据区紧跟在ShmHead之后
   // 使用 sizeof(ShmHead) 计算偏移，确保指向数据区开始
@@ -106,13 +116,13 @@ void ShmBase::Write(const void* data, size_t size, size_t offset) {
   }
   char* write_ptr = data_ptr_ + offset;  // 写入起始地址
   // sem_.Wait(); // 获取信号量
-  int ret = pthread_mutex_lock(mutex_ptr_);
-  if (ret != 0) {
-    throw std::runtime_error("获取互斥锁失败：" + std::string(strerror(ret)));
-  }
+  shmBaseLock();
   try {
+    // 写入期间标记为残缺，写完再清除
+    *dirty_ptr_ = 1;
     // 修复：使用 write_ptr 而不是 data_ptr_，以支持偏移写入
     std::memcpy(write_ptr, data, size);
+    *dirty_ptr_ = 0;
     *time_ptr_ = std::chrono::duration_cast<std::chrono::microseconds>(
                      std::chrono::system_clock::now().time_since_epoch())
                      .count();
@@ -122,7 +132,7 @@ void ShmBase::Write(const void* data, size_t size, size_t offset) {
     throw;
   }
   // 解锁
-  ret = pthread_mutex_unlock(mutex_ptr_);
+  int ret = pthread_mutex_unlock(mutex_ptr_);
   if (ret != 0) {
     throw std::runtime_error("释放互斥锁失败WRITE: " +
                              std::string(strerror(ret)));
@@ -150,6 +160,44 @@ void ShmBase::WriteUnlocked(const void* data, size_t size, size_t offset) {
   }
 }
 
+size_t ShmBase::Loan(
+    const std::function<size_t(uint8_t*, size_t)>& writer) {
+  if (shm_.Data() == nullptr || mutex_ptr_ == nullptr) {
+    throw std::runtime_error("Shared memory not initialized");
+  }
+  shmBaseLock();
+  size_t written = 0;
+  try {
+    *dirty_ptr_ = 1;
+    written = writer(reinterpret_cast<uint8_t*>(data_ptr_), data_size_);
+    if (written > data_size_) {
+      throw std::out_of_range("Loan writer exceeds shared memory size");
+    }
+    *dirty_ptr_ = 0;
+    *time_ptr_ = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+  } catch (...) {
+    pthread_mutex_unlock(mutex_ptr_);
+    throw;
+  }
+  shmBaseUnlock();
+  return written;
+}
+
+uint64_t ShmBase::View(
+    const std::function<void(const uint8_t*, size_t)>& reader) {
+  if (shm_.Data() == nullptr || mutex_ptr_ == nullptr) {
+    throw std::runtime_error("Shared memory not initialized");
+  }
+  ShmBaseLockGuard lock(*this);
+  if (*dirty_ptr_ != 0) {
+    throw std::runtime_error("Read torn message from dead writer: " + name_);
+  }
+  reader(reinterpret_cast<const uint8_t*>(data_ptr_), data_size_);
+  return *time_ptr_;
+}
+
 void ShmBase::ReadUnlocked(void* buffer, size_t size, size_t offset) {
   if (offset + size > shm_.Size()) {
     throw std::out_of_range("read exceeds shared memory size");
@@ -185,11 +233,12 @@ void ShmBase::Read(void* buffer, size_t size, size_t offset) {
   const char* read_ptr = data_ptr_ + offset;  // 读取起始地址
 
   // 加锁（互斥访问）
-  int ret = pthread_mutex_lock(mutex_ptr_);
-  if (ret != 0) {
-    throw std::runtime_error("获取互斥锁失败：" + std::string(strerror(ret)));
-  }
+  shmBaseLock();
   try {
+    // 写者在写入中途崩溃，数据区只写了一半
+    if (*dirty_ptr_ != 0) {
+      throw std::runtime_error("Read torn message from dead writer: " + name_);
+    }
     // 读取数据
     // 修复：使用 read_ptr 而不是 data_ptr_，以支持偏移读取
     std::memcpy(buffer, read_ptr, size);
@@ -198,7 +247,7 @@ void ShmBase::Read(void* buffer, size_t size, size_t offset) {
     throw;
   }
   // 解锁
-  ret = pthread_mutex_unlock(mutex_ptr_);
+  int ret = pthread_mutex_unlock(mutex_ptr_);
   if (ret != 0) {
     throw std::runtime_error("释放互斥锁失败READ: " +
                              std::string(strerror(ret)));
@@ -206,6 +255,14 @@ void ShmBase::Read(void* buffer, size_t size, size_t offset) {
   // sem_.Post(); // 释放信号量
 }
 
+void ShmBase::handleOwnerDead_() {
+  std::cerr << "ShmBase: lock owner of " << name_ << " died"
+            << (*dirty_ptr_ != 0 ? " while writing" : "") << std::endl;
+  if (owner_dead_handler_) {
+    owner_dead_handler_();
+  }
+}
+
 void ShmBase::Close() {
   if (!shm_.Close()) {
     throw std::runtime_error("Failed to close shared memory");
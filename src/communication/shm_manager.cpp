@@ -1,10 +1,231 @@
 #include "mini_ros2/communication/shm_manager.h"
-ShmManager::ShmManager() {
+
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#include "mini_ros2/communication/segment_broker.h"
+
+namespace {
+
+// 单字段原子读写：心跳等高频字段无需加锁即可更新
+template <typename T>
+void atomicStore(T& field, T value) {
+  __atomic_store_n(&field, value, __ATOMIC_RELEASE);
+}
+
+template <typename T>
+T atomicLoad(const T& field) {
+  return __atomic_load_n(&field, __ATOMIC_ACQUIRE);
+}
+
+// 注册表写区间：持有共享内存锁，期间 seqlock 序号为奇数，读者据此丢弃不一致的快照
+class RegistryWriteGuard {
+ public:
+  RegistryWriteGuard(ShmBase& shm, uint64_t& sequence)
+      : lock_(shm), sequence_(sequence) {
+    uint64_t seq = __atomic_load_n(&sequence_, __ATOMIC_RELAXED);
+    // 上一个写者在写区间内崩溃时序号停在奇数，先补齐为偶数
+    if (seq & 1) {
+      ++seq;
+    }
+    __atomic_store_n(&sequence_, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+  }
+  ~RegistryWriteGuard() {
+    __atomic_store_n(&sequence_,
+                     __atomic_load_n(&sequence_, __ATOMIC_RELAXED) + 1,
+                     __ATOMIC_RELEASE);
+  }
+  RegistryWriteGuard(const RegistryWriteGuard&) = delete;
+  RegistryWriteGuard& operator=(const RegistryWriteGuard&) = delete;
+
+ private:
+  ShmBaseLockGuard lock_;
+  uint64_t& sequence_;
+};
+
+int readEnvCapacity(const char* name, int default_value) {
+  const char* value = std::getenv(name);
+  if (value == nullptr || *value == '\0') {
+    return default_value;
+  }
+  char* end = nullptr;
+  long parsed = std::strtol(value, &end, 10);
+  if (*end != '\0' || parsed <= 0) {
+    throw std::invalid_argument(std::string(name) + " must be a positive integer");
+  }
+  return static_cast<int>(std::min<long>(parsed, 1 << 20));
+}
+
+// FNV-1a 64 位
+uint64_t fnv1a(uint64_t hash, const char* data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// 0 用作空槽标记
+uint64_t nonZeroHash(uint64_t hash) { return hash == 0 ? 1 : hash; }
+
+// 比较存储的 "topic_event" 名字，避免拼接临时字符串
+bool matchesTopicEvent(const char* name, const std::string& topic_name,
+                       const std::string& event_name) {
+  if (topic_name.size() + 1 + event_name.size() >= MAX_TOPIC_NAME_LEN) {
+    return false;
+  }
+  return std::memcmp(name, topic_name.data(), topic_name.size()) == 0 &&
+         name[topic_name.size()] == '_' &&
+         std::strcmp(name + topic_name.size() + 1, event_name.c_str()) == 0;
+}
+
+uint64_t topicIndexCapacity(uint32_t version) {
+  return version == 0 ? 0
+                      : static_cast<uint64_t>(TOPIC_INDEX_MIN_CAPACITY)
+                            << (version - 1);
+}
+
+void insertTopicIndex(TopicIndexEntry* entries, uint64_t capacity,
+                      uint64_t hash, int topic_index) {
+  // 负载因子不超过 1/2，必然能找到空槽
+  for (uint64_t i = 0;; ++i) {
+    TopicIndexEntry& entry = entries[(hash + i) & (capacity - 1)];
+    if (entry.hash == 0) {
+      entry.topic_index = topic_index;
+      // hash 最后写入，读者看到 hash 即可读到 topic_index 和 topic 条目
+      __atomic_store_n(&entry.hash, hash, __ATOMIC_RELEASE);
+      return;
+    }
+  }
+}
+
+// 读取 /proc/<pid>/stat 的第 3 列（进程状态）和第 22 列（开机后的启动时钟滴答数）
+bool readProcessStat(int pid, char* state, uint64_t* start_time) {
+  std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+  std::string line;
+  if (!std::getline(stat, line)) {
+    return false;
+  }
+  // 第 2 列是带括号的进程名，可能含空格，从最后一个 ')' 之后开始数
+  size_t pos = line.rfind(')');
+  if (pos == std::string::npos) {
+    return false;
+  }
+  std::istringstream fields(line.substr(pos + 1));
+  std::string field;
+  for (int i = 3; i <= 22 && fields >> field; ++i) {
+    if (i == 3) {
+      *state = field[0];
+    } else if (i == 22) {
+      *start_time = std::strtoull(field.c_str(), nullptr, 10);
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t processStartTime(int pid) {
+  char state = 0;
+  uint64_t start_time = 0;
+  return readProcessStat(pid, &state, &start_time) ? start_time : 0;
+}
+
+// 按 pid 缓存，fork 出的子进程重新读取
+uint64_t selfStartTime() {
+  static int cached_pid = 0;
+  static uint64_t start_time = 0;
+  if (cached_pid != getpid()) {
+    start_time = processStartTime(getpid());
+    cached_pid = getpid();
+  }
+  return start_time;
+}
+
+std::string segmentName(const std::string& base, const std::string& kind,
+                        int index) {
+  return base + "." + kind + "." + std::to_string(index);
+}
+
+// 读者落后太多时代替具体变化分发给回调
+GraphEvent resyncEvent() {
+  GraphEvent event;
+  std::memset(&event, 0, sizeof(event));
+  event.type = GraphEventType::Resync;
+  event.node_id = event.event_id = event.topic_index = -1;
+  return event;
+}
+
+// 段名中只能有开头的 '/'，命名空间中的 '/' 替换为 '_'
+std::string sanitizeShmName(const std::string& name) {
+  std::string result = name;
+  std::replace(result.begin(), result.end(), '/', '_');
+  return result;
+}
+
+}  // namespace
+
+RegistryConfig RegistryConfig::fromEnv() {
+  RegistryConfig config;
+  config.nodes_per_segment =
+      readEnvCapacity(REGISTRY_NODES_ENV, config.nodes_per_segment);
+  config.topics_per_segment =
+      readEnvCapacity(REGISTRY_TOPICS_ENV, config.topics_per_segment);
+  const char* partition = std::getenv(REGISTRY_NAMESPACE_PARTITION_ENV);
+  config.partition_by_namespace =
+      partition != nullptr && std::strcmp(partition, "1") == 0;
+  return config;
+}
+
+std::string RegistryConfig::partitionSuffix() const {
+  std::string suffix;
+  if (domain_id != 0) {
+    suffix += "_d" + std::to_string(domain_id);
+  }
+  if (partition_by_namespace && !name_space.empty()) {
+    suffix += "_ns_" + sanitizeShmName(name_space);
+  }
+  return suffix;
+}
+
+std::string RegistryConfig::registryName() const {
+  return std::string(SHM_MANAGER_NAME) + partitionSuffix();
+}
+
+std::string RegistryConfig::eventNotificationName() const {
+  return std::string(EVENT_NOTIFICATION_SHM_NAME) + partitionSuffix();
+}
+
+std::string RegistryConfig::topicPrefix() const {
+  std::string name = name_space.empty() ? name_space : name_space + "_";
+  return "/" + std::to_string(domain_id) + "_" + name;
+}
+
+ShmManager::ShmManager() : ShmManager(RegistryConfig::fromEnv()) {}
+
+ShmManager::ShmManager(const RegistryConfig& config) : config_(config) {
+  // 单段大小受 SharedMemory 的 10MB 限制
+  if (config_.nodes_per_segment <= 0 ||
+      static_cast<size_t>(config_.nodes_per_segment) * sizeof(NodeInfo) >
+          10 * 1024 * 1024 ||
+      config_.topics_per_segment <= 0 ||
+      static_cast<size_t>(config_.topics_per_segment) * sizeof(TopicInfo) >
+          10 * 1024 * 1024) {
+    throw std::invalid_argument("ShmManager: invalid registry segment size");
+  }
   std::cout << "shm_manager" << std::endl;
-  shm_ = std::make_shared<ShmBase>(SHM_MANAGER_NAME, MAX_SHM_MANGER_SIZE);
+  registry_name_ = config_.registryName();
+  shm_ = std::make_shared<ShmBase>(registry_name_, MAX_SHM_MANGER_SIZE);
 
-  // 初始化事件通知共享内存
-  event_notification_shm_ = std::make_shared<EventNotificationShm>();
+  // 初始化事件通知共享内存（与注册表同属一个分区）
+  event_notification_shm_ =
+      std::make_shared<EventNotificationShm>(config_.eventNotificationName());
   if (event_notification_shm_->Exists()) {
     event_notification_shm_->Open();
     std::cout << "event_notification_shm open" << std::endl;
@@ -18,13 +239,27 @@ ShmManager::ShmManager() {
     // 已存在，直接打开
     shm_->Open();
     std::cout << "shm_manager open" << std::endl;
-    initializeRegistry_();  // 只有事先已存在共享内存信息才尝试拷贝注册表信息
   } else {
     // 不存在，创建新的
     std::cout << "shm_manager create" << std::endl;
     shm_->Create();
     shm_->Open();
   }
+  if (shm_->getDataSize() < sizeof(ShmManagerInfo)) {
+    throw std::runtime_error(
+        "ShmManager: registry segment too small, stale layout in " +
+        registry_name_);
+  }
+  registry_ = reinterpret_cast<ShmManagerInfo*>(shm_->DataUnlocked());
+  // 持锁进程崩溃后，下一个加锁者（总是持有 registry_mutex_）在持锁状态下修复注册表
+  shm_->setOwnerDeadHandler([this]() { repairRegistryUnlocked_(); });
+
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  {
+    ShmBaseLockGuard shm_lock(*shm_);
+    initializeRegistryUnlocked_();
+  }
+  refreshSnapshot_();
 };
 
 ShmManager::~ShmManager() {
@@ -36,521 +271,1189 @@ ShmManager::~ShmManager() {
     event_notification_shm_.reset();
   }
 
+  // 扩展段的生命周期跟随基段：基段创建者退出时一并删除
+  node_segments_.clear();
+  topic_segments_.clear();
+  topic_index_.reset();
+  if (shm_ && registry_ != nullptr && shm_->IsOwner()) {
+    uint32_t node_segments = atomicLoad(registry_->node_segments);
+    uint32_t topic_segments = atomicLoad(registry_->topic_segments);
+    for (uint32_t i = 0; i < node_segments; ++i) {
+      shm_unlink(segmentName(registry_name_, "nodes", i).c_str());
+    }
+    for (uint32_t i = 0; i < topic_segments; ++i) {
+      shm_unlink(segmentName(registry_name_, "topics", i).c_str());
+    }
+    uint32_t index_segment = atomicLoad(registry_->topic_index_segment);
+    if (index_segment != 0) {
+      shm_unlink(segmentName(registry_name_, "index", index_segment).c_str());
+    }
+  }
+
   // 清理注册表共享内存
   if (shm_) {
     // ShmBase 内部使用 SharedMemory，其析构函数会自动清理
+    registry_ = nullptr;
     shm_.reset();
   }
 }
 
-void ShmManager::readNodesInfo_() {
-  char node_data[NODE_INFO_SIZE];
-  memset(node_data, 0,
-         NODE_INFO_SIZE);  // 初始化为0
-  try {
-    std::cout << "read node info_" << std::endl;
-    shm_->Read(node_data, NODE_INFO_SIZE, TOPIC_INFO_SIZE);
-    // NodesInfo *nodes = static_cast<NodesInfo *>(node_data);
-    std::string jsonStr(node_data);
-    std::cout << jsonStr << std::endl;
-    // 检查是否为空或无效JSON
-    if (jsonStr.empty() ||
-        jsonStr.find_first_not_of(" \t\n\r") == std::string::npos) {
-      // 空数据，初始化默认值
-      nodes_.nodes_count = 0;
-      nodes_.alive_node_count = 0;
-      return;
+// 新建的共享内存全为 0；旧的 JSON 注册表首字节为 '{'，两者 magic 都不匹配，直接重建
+// 段容量由创建注册表的进程决定，后加入的进程沿用已有值
+void ShmManager::initializeRegistryUnlocked_() {
+  if (registry_->magic == SHM_REGISTRY_MAGIC) {
+    if (registry_->version != SHM_REGISTRY_VERSION ||
+        registry_->layout_size != sizeof(ShmManagerInfo)) {
+      throw std::runtime_error(
+          "ShmManager: registry layout version mismatch (found v" +
+          std::to_string(registry_->version) + "), run clear_shm.sh");
     }
-    JsonValue json = JsonValue::deserialize(jsonStr);
-    nodes_.nodes_count = json["node_count"].asInt();
-    nodes_.alive_node_count = json["alive_node_count"].asInt();
-
-    for (int i = 0; i < nodes_.nodes_count; i++) {
-      nodes_.nodes[i].node_id = json["nodes"][i]["node_id"].asInt();
-      nodes_.nodes[i].pid = json["nodes"][i]["pid"].asInt();
-      nodes_.nodes[i].pub_topic_count =
-          json["nodes"][i]["pub_topic_count"].asInt();
-      nodes_.nodes[i].sub_topic_count =
-          json["nodes"][i]["sub_topic_count"].asInt();
-      std::strcpy(nodes_.nodes[i].node_name,
-                  json["nodes"][i]["node_name"].asString().c_str());
-      nodes_.nodes[i].is_alive = json["nodes"][i]["is_alive"].asBool();
-      nodes_.nodes[i].last_heartbeat =
-          json["nodes"][i]["last_heartbeat"].asInt();
-    }
-  } catch (const std::exception& e) {
-    // JSON解析失败，初始化默认值
-    std::cout << "Failed to parse JSON from shared memory: " << e.what()
-              << std::endl;
-    nodes_.nodes_count = 0;
-    nodes_.alive_node_count = 0;
+    if (static_cast<int>(registry_->nodes_per_segment) !=
+            config_.nodes_per_segment ||
+        static_cast<int>(registry_->topics_per_segment) !=
+            config_.topics_per_segment) {
+      std::cout << "registry segment size taken from existing registry: "
+                << registry_->nodes_per_segment << " nodes, "
+                << registry_->topics_per_segment << " topics" << std::endl;
+    }
+    config_.nodes_per_segment = registry_->nodes_per_segment;
+    config_.topics_per_segment = registry_->topics_per_segment;
+    return;
   }
+  std::cout << "initializeRegistry" << std::endl;
+  std::memset(registry_, 0, sizeof(ShmManagerInfo));
+  registry_->version = SHM_REGISTRY_VERSION;
+  registry_->layout_size = sizeof(ShmManagerInfo);
+  registry_->nodes_per_segment = config_.nodes_per_segment;
+  registry_->topics_per_segment = config_.topics_per_segment;
+  // magic 最后写入，其他进程看到 magic 即说明布局已初始化完成
+  atomicStore(registry_->magic, static_cast<uint32_t>(SHM_REGISTRY_MAGIC));
 }
 
-void ShmManager::readTopicsInfo() {
+// 写者在写区间内被杀死时可能留下：奇数序号、未计入的节点、未进入索引的 topic 条目
+// 段和 topic 条目都是先初始化后发布，发布前崩溃只会留下未发布的内容，下次写入时覆盖
+void ShmManager::repairRegistryUnlocked_() {
+  initializeRegistryUnlocked_();
+  uint64_t seq = __atomic_load_n(&registry_->sequence, __ATOMIC_RELAXED);
+  if (seq & 1) {
+    ++seq;
+  }
+  // 修复本身也是一次写区间，读者在修复期间丢弃快照
+  __atomic_store_n(&registry_->sequence, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  mapSegments_();
+  int alive = 0;
+  int node_capacity =
+      static_cast<int>(node_segments_.size()) * config_.nodes_per_segment;
+  for (int i = 0; i < node_capacity; ++i) {
+    if (nodeSlot_(i).is_alive) {
+      ++alive;
+    }
+  }
+  registry_->nodes_count = alive;
+  registry_->alive_node_count = alive;
+
+  int topic_capacity =
+      static_cast<int>(topic_segments_.size()) * config_.topics_per_segment;
+  registry_->topics_count =
+      std::max(0, std::min(registry_->topics_count, topic_capacity));
+  repairTopicIndexUnlocked_();
+  recountSubscriptionsUnlocked_();
+
+  __atomic_store_n(&registry_->sequence, seq + 2, __ATOMIC_RELEASE);
+  std::cerr << "ShmManager: registry repaired after writer died, " << alive
+            << " nodes, " << registry_->topics_count << " topics" << std::endl;
+}
+
+void ShmManager::repairTopicIndexUnlocked_() {
+  int count = registry_->topics_count;
+  if (count == 0) {
+    return;
+  }
+  ensureTopicIndexUnlocked_(static_cast<int>(topic_segments_.size()) *
+                            config_.topics_per_segment);
+  uint64_t capacity = topicIndexCapacity(topic_index_segment_);
+  auto* entries = static_cast<TopicIndexEntry*>(topic_index_->Data());
+  for (int i = 0; i < count; ++i) {
+    const char* name = topicSlot_(i).name_;
+    uint64_t hash =
+        nonZeroHash(fnv1a(0xcbf29ce484222325ULL, name, std::strlen(name)));
+    // 沿探测链找到本条目即已入索引；先遇到空槽说明写者在插入前崩溃
+    for (uint64_t j = 0; j < capacity; ++j) {
+      const TopicIndexEntry& entry = entries[(hash + j) & (capacity - 1)];
+      if (entry.hash == 0) {
+        insertTopicIndex(entries, capacity, hash, i);
+        break;
+      }
+      if (entry.hash == hash && entry.topic_index == i) {
+        break;
+      }
+    }
+  }
+}
+
+void ShmManager::releaseSubscriptionsUnlocked_(NodeInfo& node, int node_id) {
+  int topics_count = registry_->topics_count;
+  for (int32_t& entry : node.sub_topics) {
+    int index = entry - 1;
+    entry = 0;
+    if (index < 0 || index >= topics_count) {
+      continue;
+    }
+    int& count = topicSlot_(index).subscriber_count_;
+    atomicStore(count, std::max(0, count - 1));
+    logGraphEventUnlocked_(GraphEventType::SubscriberRemoved, node_id, index);
+  }
+}
+
+bool ShmManager::subscribedUnlocked_(int index) {
+  for (int32_t entry : nodeSlot_(node_id_).sub_topics) {
+    if (entry == index + 1) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ShmManager::recountSubscriptionsUnlocked_() {
+  int topics_count = registry_->topics_count;
+  std::vector<int> counts(topics_count, 0);
+  int node_capacity =
+      static_cast<int>(node_segments_.size()) * config_.nodes_per_segment;
+  for (int i = 0; i < node_capacity; ++i) {
+    const NodeInfo& node = nodeSlot_(i);
+    if (!node.is_alive) {
+      continue;
+    }
+    for (int32_t entry : node.sub_topics) {
+      if (entry > 0 && entry <= topics_count) {
+        counts[entry - 1]++;
+      }
+    }
+  }
+  for (int t = 0; t < topics_count; ++t) {
+    atomicStore(topicSlot_(t).subscriber_count_, counts[t]);
+  }
+}
+
+bool ShmManager::isProcessDead_(int pid, uint64_t start_time) {
+  if (pid <= 0 || pid == getpid()) {
+    return false;
+  }
+  if (kill(pid, 0) != 0 && errno == ESRCH) {
+    return true;
+  }
+  char state = 0;
+  uint64_t current = 0;
+  if (!readProcessStat(pid, &state, &current)) {
+    return false;  // 无法确认（如 /proc 不可用），按存活处理
+  }
+  // 僵尸进程（父进程未回收）kill 仍会成功；启动时间不同说明 pid 已被新进程复用
+  return state == 'Z' || state == 'X' ||
+         (start_time != 0 && current != start_time);
+}
+
+bool ShmManager::isPeerLive_(const NodeInfo& node, uint64_t now,
+                             uint64_t heartbeat_timeout_ms) {
+  if (!node.is_alive || isProcessDead_(node.pid, node.start_time)) {
+    return false;
+  }
+  // 尚未上报心跳的节点（刚注册或不运行心跳线程）只按进程判断
+  uint64_t heartbeat = node.last_heartbeat;
+  return heartbeat == 0 || now < heartbeat ||
+         now - heartbeat <= heartbeat_timeout_ms;
+}
+
+uint64_t ShmManager::heartbeatNow() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 回收死亡节点：清空槽位，删除其创建的 topic 数据段（否则重启的发布者 O_EXCL 创建失败）
+// topic 条目和 event_id 保留，其他进程缓存的 id 不会指向别的 topic；只清除残留的事件位
+int ShmManager::reapDeadNodesUnlocked_() {
+  mapSegments_();
+  int reaped = 0;
+  int capacity =
+      static_cast<int>(node_segments_.size()) * config_.nodes_per_segment;
+  for (int i = 0; i < capacity; ++i) {
+    NodeInfo& node = nodeSlot_(i);
+    if (!node.is_alive || !isProcessDead_(node.pid, node.start_time)) {
+      continue;
+    }
+    std::cout << "reap dead node " << i << " name: " << node.node_name
+              << " pid: " << node.pid << std::endl;
+    releaseSubscriptionsUnlocked_(node, i);
+    logGraphEventUnlocked_(GraphEventType::NodeRemoved, i, -1);
+    std::memset(&node, 0, sizeof(NodeInfo));
+    registry_->nodes_count = std::max(0, registry_->nodes_count - 1);
+    registry_->alive_node_count = std::max(0, registry_->alive_node_count - 1);
+    int topics_count = registry_->topics_count;
+    for (int t = 0; t < topics_count; ++t) {
+      TopicInfo& topic = topicSlot_(t);
+      if (topic.owner_node_id_ != i) {
+        continue;
+      }
+      topic.owner_node_id_ = -1;
+      logGraphEventUnlocked_(GraphEventType::TopicUpdated, -1, t);
+      if (topic.name_[0] == '/') {
+        shm_unlink(topic.name_);
+      }
+      event_notification_shm_->clearEvents(topic.event_id_);
+    }
+    ++reaped;
+  }
+  return reaped;
+}
+
+int ShmManager::reapDeadNodes() {
+  int reaped = 0;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    // 先无锁检查，没有死亡节点时不进入写区间，避免推进代数
+    mapSegments_();
+    int capacity =
+        static_cast<int>(node_segments_.size()) * config_.nodes_per_segment;
+    bool found = false;
+    for (int i = 0; i < capacity && !found; ++i) {
+      const NodeInfo& node = nodeSlot_(i);
+      found = atomicLoad(node.is_alive) &&
+              isProcessDead_(atomicLoad(node.pid), atomicLoad(node.start_time));
+    }
+    if (!found) {
+      return 0;
+    }
+    {
+      RegistryWriteGuard write(*shm_, registry_->sequence);
+      reaped = reapDeadNodesUnlocked_();
+    }
+    refreshSnapshot_();
+  }
+  if (reaped > 0) {
+    notifyRegistryChanged_();
+  }
+  return reaped;
+}
+
+std::vector<NodeInfo> ShmManager::getLiveNodes(uint64_t heartbeat_timeout_ms) {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  readTopicsInfo_();
+  refreshIfChanged_();
+  uint64_t now = heartbeatNow();
+  std::vector<NodeInfo> live;
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    NodeInfo node = nodes_[i];
+    // 心跳不推进代数，快照中的值可能过期，从共享内存读取最新值
+    node.last_heartbeat = atomicLoad(nodeSlot_(i).last_heartbeat);
+    if (isPeerLive_(node, now, heartbeat_timeout_ms)) {
+      live.push_back(node);
+    }
+  }
+  return live;
 }
-void ShmManager::readTopicsInfoUnlocked() {
-  char topic_data[TOPIC_INFO_SIZE];
-  memset(topic_data, 0,
-         TOPIC_INFO_SIZE);  // 初始化为0
-  // std::cout << "readTopicsInfo" << std::endl;
-  try {
-    // std::cout << "shm_->Read" << std::endl;
-    shm_->ReadUnlocked(topic_data, TOPIC_INFO_SIZE);
-    // std::cout << "shm_->Read done" << std::endl;
-    // TopicsInfo *topics = static_cast<TopicsInfo *>(topic_data);
-    std::string jsonStr(topic_data);
-    // std::cout << "jsonStr: " << jsonStr << std::endl;
-    // 检查是否为空或无效JSON
-    if (jsonStr.empty() ||
-        jsonStr.find_first_not_of(" \t\n\r") == std::string::npos) {
-      // 空数据，初始化默认值
-      // std::cout << "empty" << std::endl;
-      topics_.topics_count = 0;
+
+std::vector<TopicInfo> ShmManager::getTopics() {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  refreshIfChanged_();
+  return topics_;
+}
+
+void ShmManager::claimTopicSegment(const std::string& topic_name,
+                                   const std::string& event_name) {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  int index = probeTopicIndex_(topicEventHash(topic_name, event_name),
+                               topic_name, event_name);
+  if (index < 0 || node_id_ < 0) {
+    return;
+  }
+  {
+    RegistryWriteGuard write(*shm_, registry_->sequence);
+    topicSlot_(index).owner_node_id_ = node_id_;
+    logGraphEventUnlocked_(GraphEventType::TopicUpdated, node_id_, index);
+  }
+  refreshSnapshot_();
+}
+
+std::shared_ptr<ShmBase> ShmManager::openPublisherSegment(
+    const std::string& topic_name, const std::string& event_name,
+    size_t size) {
+  std::string shm_name = topic_name + "_" + event_name;
+  std::shared_ptr<ShmBase> shm = attachTopicSegment(shm_name);
+  bool created = shm == nullptr;
+  if (created) {
+    shm = createTopicSegment(shm_name, size);
+  }
+  // 订阅者可能已先登记了这个 topic：总是登记为发布者（重复登记不计数）
+  addPubTopic(topic_name, event_name);
+  if (created) {
+    claimTopicSegment(topic_name, event_name);
+  }
+  return shm;
+}
+
+std::unique_ptr<SharedMemory> ShmManager::openSegment_(const std::string& kind,
+                                                       int index, size_t size,
+                                                       bool create) {
+  auto segment = std::make_unique<SharedMemory>(
+      segmentName(registry_name_, kind, index), size);
+  if (create) {
+    // 上次运行残留的同名段大小可能不同，先删除再创建
+    if (!segment->Create()) {
+      shm_unlink(segmentName(registry_name_, kind, index).c_str());
+      if (!segment->Create()) {
+        throw std::runtime_error("ShmManager: failed to create segment " +
+                                 segmentName(registry_name_, kind, index));
+      }
+    }
+    std::memset(segment->Data(), 0, size);
+    // 段由基段创建者统一删除，创建扩展段的进程退出时不删除
+    segment->ReleaseOwnership();
+  } else if (!segment->Open()) {
+    throw std::runtime_error("ShmManager: failed to open segment " +
+                             segmentName(registry_name_, kind, index));
+  }
+  return segment;
+}
+
+void ShmManager::mapSegments_() {
+  uint32_t node_segments = atomicLoad(registry_->node_segments);
+  while (node_segments_.size() < node_segments) {
+    node_segments_.push_back(
+        openSegment_("nodes", node_segments_.size(),
+                     sizeof(NodeInfo) * config_.nodes_per_segment, false));
+  }
+  uint32_t topic_segments = atomicLoad(registry_->topic_segments);
+  while (topic_segments_.size() < topic_segments) {
+    topic_segments_.push_back(
+        openSegment_("topics", topic_segments_.size(),
+                     sizeof(TopicInfo) * config_.topics_per_segment, false));
+  }
+}
+
+bool ShmManager::growNodesUnlocked_() {
+  mapSegments_();
+  if (node_segments_.size() >= REGISTRY_MAX_SEGMENTS) {
+    return false;
+  }
+  node_segments_.push_back(
+      openSegment_("nodes", node_segments_.size(),
+                   sizeof(NodeInfo) * config_.nodes_per_segment, true));
+  atomicStore(registry_->node_segments,
+              static_cast<uint32_t>(node_segments_.size()));
+  std::cout << "registry node capacity: "
+            << node_segments_.size() * config_.nodes_per_segment << std::endl;
+  return true;
+}
+
+bool ShmManager::growTopicsUnlocked_() {
+  mapSegments_();
+  if (topic_segments_.size() >= REGISTRY_MAX_SEGMENTS) {
+    return false;
+  }
+  topic_segments_.push_back(
+      openSegment_("topics", topic_segments_.size(),
+                   sizeof(TopicInfo) * config_.topics_per_segment, true));
+  atomicStore(registry_->topic_segments,
+              static_cast<uint32_t>(topic_segments_.size()));
+  return true;
+}
+
+NodeInfo& ShmManager::nodeSlot_(int node_id) {
+  size_t segment = node_id / config_.nodes_per_segment;
+  if (segment >= node_segments_.size()) {
+    mapSegments_();
+  }
+  if (node_id < 0 || segment >= node_segments_.size()) {
+    throw std::out_of_range("ShmManager: invalid node id " +
+                            std::to_string(node_id));
+  }
+  return static_cast<NodeInfo*>(
+      node_segments_[segment]->Data())[node_id % config_.nodes_per_segment];
+}
+
+TopicInfo& ShmManager::topicSlot_(int index) {
+  size_t segment = index / config_.topics_per_segment;
+  if (segment >= topic_segments_.size()) {
+    mapSegments_();
+  }
+  if (index < 0 || segment >= topic_segments_.size()) {
+    throw std::out_of_range("ShmManager: invalid topic index " +
+                            std::to_string(index));
+  }
+  return static_cast<TopicInfo*>(
+      topic_segments_[segment]->Data())[index % config_.topics_per_segment];
+}
+
+int ShmManager::topicEventId_(int index) {
+  return index < REGISTRY_CHANGED_EVENT_ID ? index : index + 1;
+}
+
+int ShmManager::topicIndexOf_(int event_id) {
+  if (event_id < 0) {
+    return -1;
+  }
+  return event_id < REGISTRY_CHANGED_EVENT_ID ? event_id : event_id - 1;
+}
+
+uint64_t ShmManager::topicEventHash(const std::string& topic_name,
+                                    const std::string& event_name) {
+  uint64_t hash = fnv1a(0xcbf29ce484222325ULL, topic_name.data(),
+                        topic_name.size());
+  hash = fnv1a(hash, "_", 1);
+  return nonZeroHash(fnv1a(hash, event_name.data(), event_name.size()));
+}
+
+void ShmManager::mapTopicIndex_() {
+  uint32_t version = atomicLoad(registry_->topic_index_segment);
+  while (version != topic_index_segment_) {
+    auto index = std::make_unique<SharedMemory>(
+        segmentName(registry_name_, "index", version),
+        topicIndexCapacity(version) * sizeof(TopicIndexEntry));
+    if (index->Open()) {
+      topic_index_ = std::move(index);
+      topic_index_segment_ = version;
       return;
     }
-    // std::cout << "not empty" << std::endl;
-    JsonValue json = JsonValue::deserialize(jsonStr);
-    // std::cout << "json: " << json.serialize() << std::endl;
-    topics_.topics_count = json["topic_count"].asInt();
-    // event_flag_ 已移除，不再从注册表读取（从 EventNotificationShm 读取）
-    for (int i = 0; i < topics_.topics_count; i++) {
-      topics_.topics[i].event_id_ = json["topics"][i]["topic_id"].asInt();
-      std::strcpy(topics_.topics[i].name_,
-                  json["topics"][i]["name"].asString().c_str());
-    }
-  } catch (const std::exception& e) {
-    // JSON解析失败，初始化默认值
-    std::cout << "Failed to parse JSON from shared memory: " << e.what()
-              << std::endl;
-    topics_.topics_count = 0;
-  }
-}
-void ShmManager::readTopicsInfo_() {
-  char topic_data[TOPIC_INFO_SIZE];
-  memset(topic_data, 0,
-         TOPIC_INFO_SIZE);  // 初始化为0
-  // std::cout << "readTopicsInfo" << std::endl;
-  try {
-    // std::cout << "shm_->Read" << std::endl;
-    shm_->Read(topic_data, TOPIC_INFO_SIZE);
-    // std::cout << "shm_->Read done" << std::endl;
-    // TopicsInfo *topics = static_cast<TopicsInfo *>(topic_data);
-    std::string jsonStr(topic_data);
-    // std::cout << "jsonStr: " << jsonStr << std::endl;
-    // 检查是否为空或无效JSON
-    if (jsonStr.empty() ||
-        jsonStr.find_first_not_of(" \t\n\r") == std::string::npos) {
-      // 空数据，初始化默认值
-      // std::cout << "empty" << std::endl;
-      topics_.topics_count = 0;
+    // 打开前索引已被重建，旧版本已删除，重新读取版本号
+    uint32_t latest = atomicLoad(registry_->topic_index_segment);
+    if (latest == version) {
+      throw std::runtime_error("ShmManager: failed to open topic index " +
+                               segmentName(registry_name_, "index", version));
+    }
+    version = latest;
+  }
+}
+
+void ShmManager::ensureTopicIndexUnlocked_(int topic_capacity) {
+  mapTopicIndex_();
+  uint64_t needed =
+      2 * static_cast<uint64_t>(std::min(topic_capacity, MAX_TOPIC_EVENT_COUNT));
+  uint32_t old_version = topic_index_segment_;
+  if (topicIndexCapacity(old_version) >= needed) {
+    return;
+  }
+  uint32_t version = old_version + 1;
+  while (topicIndexCapacity(version) < needed) {
+    ++version;
+  }
+  uint64_t capacity = topicIndexCapacity(version);
+  auto index = openSegment_("index", version,
+                            capacity * sizeof(TopicIndexEntry), true);
+  auto* entries = static_cast<TopicIndexEntry*>(index->Data());
+  int count = registry_->topics_count;
+  for (int i = 0; i < count; ++i) {
+    const char* name = topicSlot_(i).name_;
+    insertTopicIndex(
+        entries, capacity,
+        nonZeroHash(fnv1a(0xcbf29ce484222325ULL, name, std::strlen(name))), i);
+  }
+  // 新索引建好后再发布，读者在下次查找时切换
+  atomicStore(registry_->topic_index_segment, version);
+  topic_index_ = std::move(index);
+  topic_index_segment_ = version;
+  if (old_version != 0) {
+    // 已映射旧索引的进程不受影响，切换后自然释放
+    shm_unlink(segmentName(registry_name_, "index", old_version).c_str());
+  }
+}
+
+int ShmManager::probeTopicIndex_(uint64_t hash, const std::string& topic_name,
+                                 const std::string& event_name) {
+  mapTopicIndex_();
+  if (!topic_index_) {
+    return -1;
+  }
+  uint64_t capacity = topicIndexCapacity(topic_index_segment_);
+  const auto* entries =
+      static_cast<const TopicIndexEntry*>(topic_index_->Data());
+  for (uint64_t i = 0; i < capacity; ++i) {
+    const TopicIndexEntry& entry = entries[(hash + i) & (capacity - 1)];
+    uint64_t entry_hash = __atomic_load_n(&entry.hash, __ATOMIC_ACQUIRE);
+    if (entry_hash == 0) {
+      return -1;
+    }
+    // 哈希相同仍需比较名字，排除碰撞
+    if (entry_hash == hash &&
+        matchesTopicEvent(topicSlot_(entry.topic_index).name_, topic_name,
+                          event_name)) {
+      return entry.topic_index;
+    }
+  }
+  return -1;
+}
+
+void ShmManager::copySnapshotUnlocked_() {
+  mapSegments_();
+  applied_change_seq_ = atomicLoad(registry_->change_seq);
+  // 与写者并发时计数可能是中间值，先钳位，一致性由序号校验保证
+  size_t node_capacity = node_segments_.size() * config_.nodes_per_segment;
+  nodes_.resize(node_capacity);
+  for (size_t i = 0; i < node_segments_.size(); ++i) {
+    std::memcpy(&nodes_[i * config_.nodes_per_segment],
+                node_segments_[i]->Data(),
+                sizeof(NodeInfo) * config_.nodes_per_segment);
+  }
+  int topic_capacity =
+      static_cast<int>(topic_segments_.size()) * config_.topics_per_segment;
+  int count = __atomic_load_n(&registry_->topics_count, __ATOMIC_RELAXED);
+  count = std::max(0, std::min(count, topic_capacity));
+  topics_.resize(count);
+  for (int copied = 0; copied < count;) {
+    int segment = copied / config_.topics_per_segment;
+    int n = std::min(count - copied, config_.topics_per_segment);
+    std::memcpy(&topics_[copied], topic_segments_[segment]->Data(),
+                sizeof(TopicInfo) * n);
+    copied += n;
+  }
+}
+
+void ShmManager::refreshSnapshot_() {
+  // 已有快照时先按变化日志增量更新，日志被覆盖或有未记录的修改时全量拷贝
+  bool had_snapshot = !(cached_sequence_ & 1);
+  if (had_snapshot && applyGraphChanges_()) {
+    return;
+  }
+  if (had_snapshot) {
+    pending_graph_events_.push_back(resyncEvent());
+  }
+  uint64_t& sequence = registry_->sequence;
+  for (int attempt = 0; attempt < REGISTRY_READ_RETRY; ++attempt) {
+    uint64_t before = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE);
+    if (before & 1) {
+      sched_yield();  // 写者正在修改
+      continue;
+    }
+    copySnapshotUnlocked_();
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&sequence, __ATOMIC_RELAXED) == before) {
+      cached_sequence_ = before;
       return;
     }
-    // std::cout << "not empty" << std::endl;
-    JsonValue json = JsonValue::deserialize(jsonStr);
-    // std::cout << "json: " << json.serialize() << std::endl;
-    topics_.topics_count = json["topic_count"].asInt();
-    // event_flag_ 已移除，不再从注册表读取（从 EventNotificationShm 读取）
-    for (int i = 0; i < topics_.topics_count; i++) {
-      topics_.topics[i].event_id_ = json["topics"][i]["topic_id"].asInt();
-      std::strcpy(topics_.topics[i].name_,
-                  json["topics"][i]["name"].asString().c_str());
-    }
-  } catch (const std::exception& e) {
-    // JSON解析失败，初始化默认值
-    std::cout << "Failed to parse JSON from shared memory: " << e.what()
+  }
+
+  // 持续读不到一致快照：持锁读取，序号仍为奇数说明写者已在写区间内退出
+  ShmBaseLockGuard shm_lock(*shm_);
+  uint64_t seq = __atomic_load_n(&sequence, __ATOMIC_RELAXED);
+  if (seq & 1) {
+    std::cerr << "ShmManager: repairing registry sequence left by dead writer"
               << std::endl;
-    topics_.topics_count = 0;
+    __atomic_store_n(&sequence, ++seq, __ATOMIC_RELEASE);
   }
+  copySnapshotUnlocked_();
+  cached_sequence_ = seq;
 }
-void ShmManager::initializeRegistry_() {
-  // 初始化注册表直接从共享内存读取数据
-  std::cout << "initializeRegistry" << std::endl;
-  readTopicsInfo_();
-  readNodesInfo_();
+
+void ShmManager::refreshIfChanged_() {
+  if (__atomic_load_n(&registry_->sequence, __ATOMIC_ACQUIRE) !=
+      cached_sequence_) {
+    refreshSnapshot_();
+  }
 }
 
-void ShmManager::syncRegistryFromShm() {
+uint64_t ShmManager::getRegistryGeneration() const {
+  return __atomic_load_n(&registry_->sequence, __ATOMIC_ACQUIRE) / 2;
+}
+
+void ShmManager::readTopicsInfo() {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  refreshIfChanged_();
+}
+
+void ShmManager::readTopicsInfoUnlocked() {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  std::cout << "syncRegistry " << std::endl;
-  readTopicsInfo_();
-  std::cout << "read node info" << std::endl;
-  readNodesInfo_();
+  refreshIfChanged_();
+}
+
+void ShmManager::syncRegistryFromShm() {
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    refreshIfChanged_();
+  }
+  dispatchGraphEvents_();
+}
+
+void ShmManager::logGraphEventUnlocked_(GraphEventType type, int node_id,
+                                        int topic_index) {
+  uint64_t seq = registry_->change_seq + 1;
+  GraphEvent& event = registry_->changes[(seq - 1) % REGISTRY_CHANGE_LOG_SIZE];
+  std::memset(&event, 0, sizeof(event));
+  event.seq = seq;
+  // 写区间内序号为奇数，结束时再加 1
+  event.generation = registry_->sequence + 1;
+  event.type = type;
+  event.node_id = node_id;
+  event.topic_index = topic_index;
+  event.event_id = topic_index < 0 ? -1 : topicEventId_(topic_index);
+  if (topic_index >= 0) {
+    std::strcpy(event.name, topicSlot_(topic_index).name_);
+  } else if (node_id >= 0) {
+    std::strncpy(event.name, nodeSlot_(node_id).node_name,
+                 sizeof(event.name) - 1);
+  }
+  atomicStore(registry_->change_seq, seq);
+}
+
+// 与 refreshSnapshot_ 相同的 seqlock 读：只重新拷贝日志中提到的槽位
+bool ShmManager::applyGraphChanges_() {
+  uint64_t& sequence = registry_->sequence;
+  std::vector<GraphEvent> events;
+  for (int attempt = 0; attempt < REGISTRY_READ_RETRY; ++attempt) {
+    uint64_t before = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE);
+    if (before & 1) {
+      sched_yield();  // 写者正在修改
+      continue;
+    }
+    if (before == cached_sequence_) {
+      return true;
+    }
+    uint64_t head = atomicLoad(registry_->change_seq);
+    if (head <= applied_change_seq_ ||
+        head - applied_change_seq_ > REGISTRY_CHANGE_LOG_SIZE) {
+      return false;  // 修改没有记录日志（如崩溃修复），或日志已被覆盖
+    }
+    events.clear();
+    for (uint64_t seq = applied_change_seq_ + 1; seq <= head; ++seq) {
+      events.push_back(
+          registry_->changes[(seq - 1) % REGISTRY_CHANGE_LOG_SIZE]);
+    }
+    if (events.back().generation != before) {
+      return false;  // 最后一个写区间之后还有未记录日志的修改
+    }
+    mapSegments_();
+    size_t node_capacity = node_segments_.size() * config_.nodes_per_segment;
+    nodes_.resize(node_capacity);
+    int topic_capacity =
+        static_cast<int>(topic_segments_.size()) * config_.topics_per_segment;
+    int count = __atomic_load_n(&registry_->topics_count, __ATOMIC_RELAXED);
+    count = std::max(0, std::min(count, topic_capacity));
+    size_t known = topics_.size();
+    topics_.resize(count);
+    for (int i = static_cast<int>(known); i < count; ++i) {
+      topics_[i] = topicSlot_(i);
+    }
+    for (const GraphEvent& event : events) {
+      if (event.node_id >= 0 &&
+          static_cast<size_t>(event.node_id) < node_capacity) {
+        nodes_[event.node_id] = nodeSlot_(event.node_id);
+      }
+      if (event.topic_index >= 0 && event.topic_index < count) {
+        topics_[event.topic_index] = topicSlot_(event.topic_index);
+      }
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&sequence, __ATOMIC_RELAXED) != before) {
+      continue;  // 读取期间有新的写入，重新读取
+    }
+    for (const GraphEvent& event : events) {
+      if (event.seq != applied_change_seq_ + 1) {
+        return false;  // 条目在读取前已被覆盖
+      }
+      applied_change_seq_ = event.seq;
+    }
+    cached_sequence_ = before;
+    // 回调长期未分发时丢弃积压，改为一条 Resync
+    if (pending_graph_events_.size() + events.size() >
+        REGISTRY_CHANGE_LOG_SIZE) {
+      pending_graph_events_.assign(1, resyncEvent());
+    } else {
+      pending_graph_events_.insert(pending_graph_events_.end(), events.begin(),
+                                   events.end());
+    }
+    return true;
+  }
+  return false;
+}
+
+void ShmManager::dispatchGraphEvents_() {
+  std::vector<GraphEvent> events;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    events.swap(pending_graph_events_);
+  }
+  if (events.empty()) {
+    return;
+  }
+  std::vector<std::function<void(const GraphEvent&)>> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(graph_callback_mutex_);
+    for (const auto& entry : graph_callbacks_) {
+      callbacks.push_back(entry.second);
+    }
+  }
+  for (const GraphEvent& event : events) {
+    for (const auto& callback : callbacks) {
+      try {
+        callback(event);
+      } catch (const std::exception& e) {
+        std::cerr << "graph change callback error: " << e.what() << std::endl;
+      }
+    }
+  }
 }
+
+int ShmManager::addGraphChangeCallback(
+    std::function<void(const GraphEvent&)> callback) {
+  std::lock_guard<std::mutex> lock(graph_callback_mutex_);
+  int id = next_graph_callback_id_++;
+  graph_callbacks_.emplace_back(id, std::move(callback));
+  return id;
+}
+
+void ShmManager::removeGraphChangeCallback(int callback_id) {
+  std::lock_guard<std::mutex> lock(graph_callback_mutex_);
+  graph_callbacks_.erase(
+      std::remove_if(graph_callbacks_.begin(), graph_callbacks_.end(),
+                     [callback_id](const auto& entry) {
+                       return entry.first == callback_id;
+                     }),
+      graph_callbacks_.end());
+}
+
 void ShmManager::updateNodeHeartbeat() {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  nodes_.nodes[node_id_].last_heartbeat = time(nullptr);
-  // writeRegistryToShm_();
-  writeNodesInfo_();
-  // TBD心跳更新会频繁写入共享内存，后面优化为修改而非覆写
+  // 心跳只改一个字段，原子写入即可，不占用共享内存锁，也不推进代数
+  atomicStore(nodeSlot_(node_id_).last_heartbeat, heartbeatNow());
 };
 
 bool ShmManager::isNodeAlive() {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  bool is_alive = nodes_.nodes[node_id_].is_alive;
-  return is_alive;
+  return atomicLoad(nodeSlot_(node_id_).is_alive);
 };
 
 void ShmManager::addNode(const NodeInfo& node_info) {
-  std::lock_guard<std::mutex> lock(registry_mutex_);
-  nodes_.nodes[node_id_] = node_info;
-  nodes_.nodes_count++;
-  nodes_.alive_node_count++;
-  // writeRegistryToShm_();
-  writeNodesInfo_();
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    {
+      RegistryWriteGuard write(*shm_, registry_->sequence);
+      NodeInfo& node = nodeSlot_(node_id_);
+      // getNextNodeId 占用槽位时已计数
+      if (!node.is_alive) {
+        registry_->nodes_count++;
+        registry_->alive_node_count++;
+      }
+      node = node_info;
+      node.start_time =
+          node.pid == getpid() ? selfStartTime() : processStartTime(node.pid);
+      logGraphEventUnlocked_(GraphEventType::NodeAdded, node_id_, -1);
+    }
+    refreshSnapshot_();
+  }
+  notifyRegistryChanged_();
 }
 
 void ShmManager::updateNodeInfo(const NodeInfo& node_info) {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  nodes_.nodes[node_id_] = node_info;
-  // writeRegistryToShm_();
-  writeNodesInfo_();
+  {
+    RegistryWriteGuard write(*shm_, registry_->sequence);
+    NodeInfo& node = nodeSlot_(node_id_);
+    // 订阅记录由 addSubTopic / removeSubTopic 维护，不随节点信息覆盖
+    int32_t sub_topics[NODE_MAX_TRACKED_SUBSCRIPTIONS];
+    std::memcpy(sub_topics, node.sub_topics, sizeof(sub_topics));
+    node = node_info;
+    std::memcpy(node.sub_topics, sub_topics, sizeof(sub_topics));
+    logGraphEventUnlocked_(GraphEventType::NodeUpdated, node_id_, -1);
+  }
+  refreshSnapshot_();
 };
+
 void ShmManager::removeNode() {
-  std::lock_guard<std::mutex> lock(registry_mutex_);
-  //   nodes.erase(nodes.begin() + node_id);
-  nodes_.nodes[node_id_].is_alive = false;
-  nodes_.alive_node_count--;
-  nodes_.nodes_count--;
-  writeNodesInfo_();
-  triggerEventById_(MAX_TOPICS_PER_NODE - 1);
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    {
+      RegistryWriteGuard write(*shm_, registry_->sequence);
+      NodeInfo& node = nodeSlot_(node_id_);
+      if (node.is_alive) {
+        node.is_alive = false;
+        registry_->alive_node_count--;
+        registry_->nodes_count--;
+      }
+      releaseSubscriptionsUnlocked_(node, node_id_);
+      pub_topics_.clear();
+      logGraphEventUnlocked_(GraphEventType::NodeRemoved, node_id_, -1);
+    }
+    refreshSnapshot_();
+  }
+  notifyRegistryChanged_();
 }
 
 void ShmManager::getNodeInfo(NodeInfo& node_info) {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  node_info = nodes_.nodes[node_id_];
+  refreshIfChanged_();
+  node_info = nodeSlot_(node_id_);
 }
-// TBD 这里的MAX_NODE_COUNT需要从配置文件中读取
+
+// 查找并占用下一个空闲节点槽位（持共享内存锁，避免两个进程同时启动时拿到同一 id）
+// 先回收进程已退出但未注销的节点槽位；现有段全部占满时追加一个节点段
 int ShmManager::getNextNodeId() {
-  std::lock_guard<std::mutex> lock(registry_mutex_);
-  for (int i = 0; i < MAX_NODE_COUNT; i++) {
-    if (!nodes_.nodes[i].is_alive) {
-      return i;
+  int node_id = -1;
+  int reaped = 0;
+  std::unique_lock<std::mutex> lock(registry_mutex_);
+  {
+    RegistryWriteGuard write(*shm_, registry_->sequence);
+    reaped = reapDeadNodesUnlocked_();
+    int capacity =
+        static_cast<int>(node_segments_.size()) * config_.nodes_per_segment;
+    for (int i = 0; i < capacity; i++) {
+      if (!nodeSlot_(i).is_alive) {
+        node_id = i;
+        break;
+      }
+    }
+    if (node_id < 0 && growNodesUnlocked_()) {
+      node_id = capacity;
+    }
+    if (node_id >= 0) {
+      NodeInfo& node = nodeSlot_(node_id);
+      std::memset(&node, 0, sizeof(NodeInfo));
+      node.node_id = node_id;
+      node.is_alive = true;
+      node.pid = getpid();
+      node.start_time = selfStartTime();
+      registry_->nodes_count++;
+      registry_->alive_node_count++;
+      // 槽位已占用但节点信息尚未填写，addNode 时再记录 NodeAdded
+      logGraphEventUnlocked_(GraphEventType::NodeUpdated, node_id, -1);
+    } else if (reaped == 0) {
+      // 写区间内没有任何修改也要记录，保证日志覆盖每个写区间
+      logGraphEventUnlocked_(GraphEventType::NodeUpdated, -1, -1);
     }
   }
-  return -1;
+  refreshSnapshot_();
+  lock.unlock();
+  if (reaped > 0) {
+    notifyRegistryChanged_();
+  }
+  return node_id;
+}
+
+int ShmManager::registerProcessNode(const char* name) {
+  int node_id = getNextNodeId();
+  if (node_id < 0) {
+    throw std::runtime_error(std::string("ShmManager: maximum node count "
+                                         "reached, cannot register ") +
+                             name);
+  }
+  setNodeId(node_id);
+  NodeInfo info;
+  std::memset(&info, 0, sizeof(info));
+  info.node_id = node_id;
+  std::strncpy(info.node_name, name, MAX_NODE_NAME_LEN - 1);
+  info.pid = getpid();
+  info.last_heartbeat = heartbeatNow();
+  info.is_alive = true;
+  addNode(info);
+  return node_id;
 }
 
 int ShmManager::getAliveNodeCount() {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  int count = nodes_.alive_node_count;
-  return count;
+  return atomicLoad(registry_->alive_node_count);
 }
 int ShmManager::getNodeCount() {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  int count = nodes_.nodes_count;
-  return count;
-}
-
-// void ShmManager::writeShmHead() {}
-// 写入方法：使用进程内锁保护数据访问，使用 ShmBase 锁保护共享内存写入
-void ShmManager::writeNodesInfo_() {
-  // 1. 加进程内锁保护 nodes_ 的内存访问
-  // std::lock_guard<std::mutex> lock(registry_mutex_);
-  JsonValue json;
-  json["node_count"] = nodes_.nodes_count;
-  json["alive_node_count"] = nodes_.alive_node_count;
-  json["nodes"] = JsonArray(nodes_.nodes_count);
-  for (int i = 0; i < nodes_.nodes_count; i++) {
-    json["nodes"][i]["node_id"] = nodes_.nodes[i].node_id;
-    json["nodes"][i]["pid"] = nodes_.nodes[i].pid;
-    json["nodes"][i]["pub_topic_count"] = nodes_.nodes[i].pub_topic_count;
-    json["nodes"][i]["sub_topic_count"] = nodes_.nodes[i].sub_topic_count;
-    json["nodes"][i]["node_name"] = std::string(nodes_.nodes[i].node_name);
-    json["nodes"][i]["is_alive"] = nodes_.nodes[i].is_alive;
-    json["nodes"][i]["last_heartbeat"] = nodes_.nodes[i].last_heartbeat;
-  }
-  std::string json_str = json.serialize();
-  // 2. 锁在 lock_guard 析构时自动释放
-  // 3. 调用 Write() 写入共享内存（Write() 内部会用自己的锁保护）
-  std::cout << json_str.c_str();
-  shm_->Write(json_str.c_str(), json_str.size(), TOPIC_INFO_SIZE);
-}
-
-// void shmManager::updateEventFlag_(int event_id) {
-//   std::lock_guard<std::mutex> lock(registry_mutex_);
-//   topics_.event_flag_ |= (1 << event_id);
-//   writeTopicsInfo_();
-// }
-// 写入方法：使用进程内锁保护数据访问，使用 ShmBase 锁保护共享内存写入
-// 注意：event_flag_ 已移至独立的 EventNotificationShm，不再写入注册表
-void ShmManager::writeTopicsInfo_() {
-  // 1. 加进程内锁保护 topics_ 的内存访问
-  // std::lock_guard<std::mutex> lock(registry_mutex_);
-  JsonValue json;
-  json["topic_count"] = topics_.topics_count;
-  // event_flag_ 已移除，不再序列化
-  json["topics"] = JsonArray(topics_.topics_count);
-  for (int i = 0; i < topics_.topics_count; i++) {
-    json["topics"][i]["topic_id"] = topics_.topics[i].event_id_;
-    json["topics"][i]["name"] = std::string(topics_.topics[i].name_);
-  }
-  std::string json_str = json.serialize();
-  // std::cout << "writeTopicsInfo: " << json_str << std::endl;
-  // 2. 锁在 lock_guard 析构时自动释放
-  // 3. 调用 Write() 写入共享内存（Write() 内部会用自己的锁保护）
-  shm_->Write(json_str.c_str(), json_str.size());
-}
-
-void ShmManager::writeTopicsInfoUnlocked_() {
-  // 1. 加进程内锁保护 topics_ 的内存访问
-  // std::lock_guard<std::mutex> lock(registry_mutex_);
-  JsonValue json;
-  json["topic_count"] = topics_.topics_count;
-  // event_flag_ 已移除，不再序列化
-  json["topics"] = JsonArray(topics_.topics_count);
-  for (int i = 0; i < topics_.topics_count; i++) {
-    json["topics"][i]["topic_id"] = topics_.topics[i].event_id_;
-    json["topics"][i]["name"] = std::string(topics_.topics[i].name_);
-  }
-  std::string json_str = json.serialize();
-  // std::cout << "writeTopicsInfo: " << json_str << std::endl;
-  // 2. 锁在 lock_guard 析构时自动释放
-  // 3. 调用 Write() 写入共享内存（Write() 内部会用自己的锁保护）
-  shm_->WriteUnlocked(json_str.c_str(), json_str.size());
-}
-
-void ShmManager::writeNodesInfoUnlocked_() {
-  JsonValue json;
-  json["node_count"] = nodes_.nodes_count;
-  json["alive_node_count"] = nodes_.alive_node_count;
-  json["nodes"] = JsonArray(nodes_.nodes_count);
-  for (int i = 0; i < nodes_.nodes_count; i++) {
-    json["nodes"][i]["node_id"] = nodes_.nodes[i].node_id;
-    json["nodes"][i]["pid"] = nodes_.nodes[i].pid;
-    json["nodes"][i]["pub_topic_count"] = nodes_.nodes[i].pub_topic_count;
-    json["nodes"][i]["sub_topic_count"] = nodes_.nodes[i].sub_topic_count;
-    json["nodes"][i]["node_name"] = std::string(nodes_.nodes[i].node_name);
-    json["nodes"][i]["is_alive"] = nodes_.nodes[i].is_alive;
-    // json["nodes"][i]["pub_topics"] =
-    // JsonArray(nodes_.nodes[i].pub_topic_count);
-    // json["nodes"][i]["sub_topics"] =
-    // JsonArray(nodes_.nodes[i].sub_topic_count); for (int j = 0; j <
-    // nodes_.nodes[i].pub_topic_count; j++) {
-    //   json["nodes"][i]["pub_topics"][j] =
-    //       std::string(nodes_.nodes[i].pub_topics[j]);
-    // }
-    // for (int j = 0; j < nodes_.nodes[i].sub_topic_count; j++) {
-    //   json["nodes"][i]["sub_topics"][j] =
-    //       std::string(nodes_.nodes[i].sub_topics[j]);
-    // }
-    json["nodes"][i]["last_heartbeat"] = nodes_.nodes[i].last_heartbeat;
-  }
-  std::string json_str = json.serialize();
-  std::cout << "writeNodesInfo: " << json_str << std::endl;
-  shm_->WriteUnlocked(json_str.c_str(), json_str.size());
-}
-
-void ShmManager::writeRegistryToShm_() {
-  // writeShmHead();
-  // writeTopicsInfo() 和 writeNodesInfo() 内部已经有锁保护
-  writeTopicsInfo_();
-  writeNodesInfo_();
-}
-
-void ShmManager::writeRegistryToShmUnlocked_() {
-  writeTopicsInfoUnlocked_();
-  writeNodesInfoUnlocked_();
+  return atomicLoad(registry_->nodes_count);
+}
+
+int ShmManager::getNodeCapacity() {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  return static_cast<int>(atomicLoad(registry_->node_segments)) *
+         config_.nodes_per_segment;
+}
+
+int ShmManager::getTopicCapacity() {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  return static_cast<int>(atomicLoad(registry_->topic_segments)) *
+         config_.topics_per_segment;
 }
 
 void ShmManager::addSubTopic(const std::string& topic_name,
                              const std::string& event_name) {
-  // 使用进程内锁保护 nodes_ 和 topics_ 的访问
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  if (nodes_.nodes[node_id_].sub_topic_count < MAX_TOPICS_PER_NODE) {
-    // std::strcpy(nodes_.nodes[node_id_]
-    //                 .sub_topics[nodes_.nodes[node_id_].sub_topic_count],
-    //             topic_name.c_str());
-    nodes_.nodes[node_id_].sub_topic_count++;
-  }
-  // 查找或创建 topic event，findOrCreateTopicEvent_ 内部会处理 topics_ 的更新
-  int event_id = findOrCreateTopicEvent_(topic_name, event_name);
+  // 订阅计数与 sub_topics 一致（回收和重新统计都按 sub_topics 计）：
+  // 本节点已订阅时什么都不改，不进入写区间（没有日志的写区间会让读者全量同步）
+  int known = probeTopicIndex_(topicEventHash(topic_name, event_name),
+                               topic_name, event_name);
+  if (known >= 0 && subscribedUnlocked_(known)) {
+    return;
+  }
+  int event_id;
+  {
+    RegistryWriteGuard write(*shm_, registry_->sequence);
+    NodeInfo& node = nodeSlot_(node_id_);
+    event_id = findOrCreateTopicEventUnlocked_(topic_name, event_name);
+    int index = topicIndexOf_(event_id);
+    int32_t* slot = nullptr;
+    for (int32_t& entry : node.sub_topics) {
+      if (entry == 0) {
+        slot = &entry;
+        break;
+      }
+    }
+    if (index >= 0 && slot != nullptr) {
+      *slot = index + 1;
+      node.sub_topic_count++;
+      int& count = topicSlot_(index).subscriber_count_;
+      atomicStore(count, count + 1);
+      logGraphEventUnlocked_(GraphEventType::SubscriberAdded, node_id_, index);
+    } else if (index >= 0 && known < 0) {
+      // 订阅表已满时不计数，只记下新注册的 topic
+      logGraphEventUnlocked_(GraphEventType::TopicAdded, -1, index);
+    }
+  }
+  refreshSnapshot_();
+  notifyRegistryChanged_();
   if (event_id < 0) {
     std::cerr << "Failed to create topic event" << std::endl;
   }
-  // writeRegistryToShm_();
-  writeNodesInfo_();
-  // 锁释放后，调用 writeTopicsInfo() 和 writeNodesInfo() 写入共享内存
-  // 它们内部会重新加锁读取数据并写入
 }
 
 void ShmManager::addPubTopic(const std::string& topic_name,
                              const std::string& event_name) {
-  // 使用进程内锁保护 nodes_ 和 topics_ 的访问
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  std::string full_name = topic_name + "_" + event_name;
-  if (nodes_.nodes[node_id_].pub_topic_count < MAX_TOPICS_PER_NODE) {
-    // std::strcpy(nodes_.nodes[node_id_]
-    //                 .pub_topics[nodes_.nodes[node_id_].pub_topic_count],
-    //             full_name.c_str());
-    nodes_.nodes[node_id_].pub_topic_count++;
-  }
-  // 查找或创建 topic event，findOrCreateTopicEvent_ 内部会处理 topics_ 的更新
-  int event_id = findOrCreateTopicEvent_(topic_name, event_name);
+  // 同一节点重复登记同一 topic 只计一次，不进入写区间
+  int known = probeTopicIndex_(topicEventHash(topic_name, event_name),
+                               topic_name, event_name);
+  if (known >= 0 && std::find(pub_topics_.begin(), pub_topics_.end(),
+                              known) != pub_topics_.end()) {
+    return;
+  }
+  int event_id;
+  {
+    RegistryWriteGuard write(*shm_, registry_->sequence);
+    NodeInfo& node = nodeSlot_(node_id_);
+    event_id = findOrCreateTopicEventUnlocked_(topic_name, event_name);
+    int index = topicIndexOf_(event_id);
+    if (index >= 0) {
+      pub_topics_.push_back(index);
+      if (node.pub_topic_count < MAX_TOPICS_PER_NODE) {
+        node.pub_topic_count++;
+      }
+      logGraphEventUnlocked_(GraphEventType::PublisherAdded, node_id_, index);
+    }
+  }
+  refreshSnapshot_();
+  notifyRegistryChanged_();
   if (event_id < 0) {
     std::cerr << "Failed to create topic event" << std::endl;
   }
-  TopicInfo topic_info;
-  topic_info.event_id_ = event_id;
-  // std::string full_name = topic_name + "_" + event_name;
-  std::strcpy(topic_info.name_, full_name.c_str());
-  topics_.topics[topics_.topics_count] = topic_info;
-  topics_.topics_count++;
   std::cout << "event_id: " << event_id << std::endl;
-  writeRegistryToShm_();
-  // 锁释放后，调用 writeTopicsInfo() 和 writeNodesInfo() 写入共享内存
-  // 它们内部会重新加锁读取数据并写入
 }
 
 void ShmManager::removeSubTopic(const std::string& topic_name,
                                 const std::string& event_name) {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  // for (int i = 0; i < nodes_.nodes[node_id_].sub_topic_count; i++) {
-  //   if (nodes_.nodes[node_id_].sub_topics[i] == topic_name) {
-  //     // 移除topic，将后面的元素前移
-  //     // for (int j = i; j < nodes_.nodes[node_id_].sub_topic_count - 1; j++)
-  //     {
-  //     //   std::strcpy(nodes_.nodes[node_id_].sub_topics[j],
-  //     //               nodes_.nodes[node_id_].sub_topics[j + 1]);
-  //     // }
-  //     nodes_.nodes[node_id_].sub_topic_count--;
-  //     writeRegistryToShm_();
-  //     break;
-  //   }
-  // }
+  // 只有本节点确实订阅过时才扣除计数
+  int index = probeTopicIndex_(topicEventHash(topic_name, event_name),
+                               topic_name, event_name);
+  if (index < 0 || !subscribedUnlocked_(index)) {
+    return;
+  }
+  {
+    RegistryWriteGuard write(*shm_, registry_->sequence);
+    NodeInfo& node = nodeSlot_(node_id_);
+    for (int32_t& entry : node.sub_topics) {
+      if (entry == index + 1) {
+        entry = 0;
+        if (node.sub_topic_count > 0) {
+          node.sub_topic_count--;
+        }
+        int& count = topicSlot_(index).subscriber_count_;
+        atomicStore(count, std::max(0, count - 1));
+        logGraphEventUnlocked_(GraphEventType::SubscriberRemoved, node_id_,
+                               index);
+        break;
+      }
+    }
+  }
+  refreshSnapshot_();
+  notifyRegistryChanged_();
 }
 
 void ShmManager::removePubTopic(const std::string& topic_name,
                                 const std::string& event_name) {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  // for (int i = 0; i < nodes_.nodes[node_id_].pub_topic_count; i++) {
-  //   if (nodes_.nodes[node_id_].pub_topics[i] == topic_name) {
-  //     // 移除topic，将后面的元素前移
-  //     // for (int j = i; j < nodes_.nodes[node_id_].pub_topic_count - 1; j++)
-  //     {
-  //     //   std::strcpy(nodes_.nodes[node_id_].pub_topics[j],
-  //     //               nodes_.nodes[node_id_].pub_topics[j + 1]);
-  //     // }
-  //     nodes_.nodes[node_id_].pub_topic_count--;
-  //     writeRegistryToShm_();
-  //     break;
-  //   }
-  // }
+  int index = probeTopicIndex_(topicEventHash(topic_name, event_name),
+                               topic_name, event_name);
+  auto it = std::find(pub_topics_.begin(), pub_topics_.end(), index);
+  if (index < 0 || it == pub_topics_.end()) {
+    return;
+  }
+  pub_topics_.erase(it);
+  {
+    RegistryWriteGuard write(*shm_, registry_->sequence);
+    NodeInfo& node = nodeSlot_(node_id_);
+    if (node.pub_topic_count > 0) {
+      node.pub_topic_count--;
+    }
+    logGraphEventUnlocked_(GraphEventType::PublisherRemoved, node_id_, index);
+  }
+  refreshSnapshot_();
+  notifyRegistryChanged_();
 }
 
 void ShmManager::updateNodeAlive() {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  nodes_.nodes[node_id_].is_alive = true;
-  // writeRegistryToShm_();
-  writeNodesInfo_();
+  {
+    RegistryWriteGuard write(*shm_, registry_->sequence);
+    nodeSlot_(node_id_).is_alive = true;
+    logGraphEventUnlocked_(GraphEventType::NodeUpdated, node_id_, -1);
+  }
+  refreshSnapshot_();
 }
+
 void ShmManager::updateNodeName(const std::string& node_name) {
+  if (node_name.size() >= MAX_NODE_NAME_LEN) {
+    throw std::invalid_argument("ShmManager: node name too long: " + node_name);
+  }
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  std::strcpy(nodes_.nodes[node_id_].node_name, node_name.c_str());
-  // writeRegistryToShm_();
-  writeNodesInfo_();
+  {
+    RegistryWriteGuard write(*shm_, registry_->sequence);
+    std::strcpy(nodeSlot_(node_id_).node_name, node_name.c_str());
+    logGraphEventUnlocked_(GraphEventType::NodeUpdated, node_id_, -1);
+  }
+  refreshSnapshot_();
 }
 
 void ShmManager::printRegistry() {
-  // char data[MAX_SHM_MANGER_SIZE];
-  // memset(data, 0, MAX_SHM_MANGER_SIZE); // 初始化为0
-  // shm_->Read(data, MAX_SHM_MANGER_SIZE);
-  // std::string jsonStr(data);
-  // std::cout << jsonStr << std::endl;
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  // char topic_data[TOPIC_INFO_SIZE];
-  // memset(topic_data, 0, TOPIC_INFO_SIZE);
-  // shm_->Read(topic_data, TOPIC_INFO_SIZE);
-  // std::string jsonStr(topic_data);
-  // std::cout << "jsonStr: " << jsonStr << std::endl;
-  // JsonValue json = JsonValue::deserialize(jsonStr);
-  // std::cout << "topics_count: " << json["topic_count"].asInt() << std::endl;
-  // std::cout << "event_flag_: " << json["event_flag_"].asInt() << std::endl;
-  for (int i = 0; i < topics_.topics_count; i++) {
-    std::cout << "name: " << topics_.topics->name_
-              << " event_id: " << topics_.topics->event_id_ << std::endl;
-  }
-  for (int i = 0; i < nodes_.nodes_count; i++) {
-    std::cout << "id: " << nodes_.nodes[i].node_id
-              << " name: " << nodes_.nodes[i].node_name
-              << " pid: " << nodes_.nodes[i].pid
-              << " pub_count: " << nodes_.nodes[i].pub_topic_count
-              << " sub_count: " << nodes_.nodes[i].sub_topic_count << std::endl;
-  }
-  // std::cout << "printRegistry" << std::endl;
-}
-
-// 查找或创建 topic+event 映射，返回 event_id（位索引）
-int ShmManager::findOrCreateTopicEvent_(const std::string& topic_name,
-                                        const std::string& event_name) {
-  std::string full_name = topic_name + "_" + event_name;
-
-  // 查找是否已存在
-  for (int i = 0; i < topics_.topics_count; i++) {
-    if (std::string(topics_.topics[i].name_) == full_name) {
-      return topics_.topics[i].event_id_;
-    }
-  }
-
-  // 不存在，创建新的映射
-  if (topics_.topics_count >= MAX_TOPICS_PER_NODE) {
-    std::cerr << "Maximum topic count reached" << std::endl;
-    return -1;
+  refreshIfChanged_();
+  std::cout << "registry generation: " << cached_sequence_ / 2
+            << " node capacity: " << nodes_.size()
+            << " topic capacity: "
+            << topic_segments_.size() * config_.topics_per_segment
+            << std::endl;
+  for (const TopicInfo& topic : topics_) {
+    std::cout << "name: " << topic.name_ << " event_id: " << topic.event_id_
+              << std::endl;
+  }
+  uint64_t now = heartbeatNow();
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    NodeInfo node = nodes_[i];
+    node.last_heartbeat = atomicLoad(nodeSlot_(i).last_heartbeat);
+    if (!isPeerLive_(node, now, NODE_HEARTBEAT_TIMEOUT_MS)) {
+      continue;
+    }
+    std::cout << "id: " << node.node_id << " name: " << node.node_name
+              << " pid: " << node.pid
+              << " pub_count: " << node.pub_topic_count
+              << " sub_count: " << node.sub_topic_count << std::endl;
   }
+}
 
-  // 分配新的 event_id（位索引）
-  int new_event_id = topics_.topics_count + 1;
-  topics_.topics[new_event_id].event_id_ = new_event_id;
-  std::strcpy(topics_.topics[new_event_id].name_, full_name.c_str());
-  topics_.topics_count++;
+// 查找或创建 topic+event 映射，返回 event_id（位索引），调用者处于写区间内
+// 条目只增不删，已分配的 id 在整个运行期间保持不变；写满时追加 topic 段
+int ShmManager::findOrCreateTopicEventUnlocked_(const std::string& topic_name,
+                                                const std::string& event_name) {
+  if (topic_name.size() + 1 + event_name.size() >= MAX_TOPIC_NAME_LEN) {
+    std::cerr << "Topic name too long: " << topic_name << "_" << event_name
+              << std::endl;
+    return -1;
+  }
+  uint64_t hash = topicEventHash(topic_name, event_name);
+  int existing = probeTopicIndex_(hash, topic_name, event_name);
+  if (existing >= 0) {
+    return topicEventId_(existing);
+  }
 
+  // 不存在，创建新的映射（保留位不分配给 topic）
+  mapSegments_();
+  int count = registry_->topics_count;
+  int capacity =
+      static_cast<int>(topic_segments_.size()) * config_.topics_per_segment;
+  if (count >= MAX_TOPIC_EVENT_COUNT ||
+      (count >= capacity && !growTopicsUnlocked_())) {
+    std::cerr << "Maximum topic count reached" << std::endl;
+    return -1;
+  }
+  ensureTopicIndexUnlocked_(static_cast<int>(topic_segments_.size()) *
+                            config_.topics_per_segment);
+  int new_event_id = topicEventId_(count);
+  event_notification_shm_->ensureCapacity(new_event_id + 1);
+  TopicInfo& topic = topicSlot_(count);
+  std::memset(topic.name_, 0, sizeof(topic.name_));
+  std::strcpy(topic.name_, (topic_name + "_" + event_name).c_str());
+  topic.event_id_ = new_event_id;
+  topic.owner_node_id_ = -1;
+  topic.subscriber_count_ = 0;
+  registry_->topics_count = count + 1;
+  insertTopicIndex(static_cast<TopicIndexEntry*>(topic_index_->Data()),
+                   topicIndexCapacity(topic_index_segment_), hash, count);
   return new_event_id;
 }
 
 // 注册 topic+event 组合，返回分配的 event_id（位索引）
+// 已注册的组合直接从快照返回，不进入写区间，避免无意义地推进代数
 int ShmManager::registerTopicEvent(const std::string& topic_name,
                                    const std::string& event_name) {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  int event_id = findOrCreateTopicEvent_(topic_name, event_name);
+  int event_id = lookupTopicEventId_(topic_name, event_name);
   if (event_id >= 0) {
-    writeTopicsInfo_();  // 更新到共享内存
+    return event_id;
   }
+  {
+    RegistryWriteGuard write(*shm_, registry_->sequence);
+    event_id = findOrCreateTopicEventUnlocked_(topic_name, event_name);
+    logGraphEventUnlocked_(GraphEventType::TopicAdded, -1,
+                           topicIndexOf_(event_id));
+  }
+  refreshSnapshot_();
   return event_id;
 }
 
+// 调用者持有 registry_mutex_（只保护本进程的段映射）；探测共享内存索引不加锁
+int ShmManager::lookupTopicEventId_(const std::string& topic_name,
+                                    const std::string& event_name) {
+  int index = probeTopicIndex_(topicEventHash(topic_name, event_name),
+                               topic_name, event_name);
+  return index < 0 ? -1 : topicEventId_(index);
+}
+
 // 查找 topic+event 对应的 event_id，如果不存在返回 -1
-int ShmManager::getTopicEventId_(const std::string& topic_name,
-                                 const std::string& event_name) {
-  // std::lock_guard<std::mutex> lock(registry_mutex_);
-  std::string full_name = topic_name + "_" + event_name;
-  for (int i = 0; i < topics_.topics_count; i++) {
-    if (std::string(topics_.topics[i].name_) == full_name) {
-      int event_id = topics_.topics[i].event_id_;
-      return event_id;
-    }
+int ShmManager::getTopicEventId(const std::string& topic_name,
+                                const std::string& event_name) {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  return lookupTopicEventId_(topic_name, event_name);
+}
+
+int ShmManager::getSubscriptionCount(const std::string& topic_name,
+                                     const std::string& event_name) {
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  int index = probeTopicIndex_(topicEventHash(topic_name, event_name),
+                               topic_name, event_name);
+  return index < 0 ? 0 : atomicLoad(topicSlot_(index).subscriber_count_);
+}
+
+int ShmManager::getSubscriptionCountById(int event_id) {
+  int index = topicIndexOf_(event_id);
+  std::lock_guard<std::mutex> lock(registry_mutex_);
+  if (index < 0 || index >= atomicLoad(registry_->topics_count)) {
+    return 0;
   }
-  return -1;
+  return atomicLoad(topicSlot_(index).subscriber_count_);
 }
 
 // 触发事件：设置对应的位并通知条件变量
 void ShmManager::triggerEvent(const std::string& topic_name,
                               const std::string& event_name) {
-  std::lock_guard<std::mutex> lock(registry_mutex_);
-  // std::cout << "triggerEvent: " << topic_name << " " << event_name <<
-  // std::endl;
-  int event_id = getTopicEventId_(topic_name, event_name);
+  int event_id;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    event_id = lookupTopicEventId_(topic_name, event_name);
+  }
   if (event_id >= 0) {
-    // std::cout << "triggerEventById: " << event_id << std::endl;
     triggerEventById_(event_id);
   }
 }
 
+void ShmManager::notifyRegistryChanged_() {
+  triggerEventById_(REGISTRY_CHANGED_EVENT_ID);
+}
+
 // 触发事件（通过 event_id）
 // 使用独立的事件通知共享内存，不再更新注册表
 void ShmManager::triggerEventById_(int event_id) {
-  if (event_id < 0 || event_id >= MAX_TOPICS_PER_NODE) {
+  if (event_id < 0 || event_id > MAX_TOPIC_EVENT_COUNT) {
     return;
   }
 
@@ -560,8 +1463,7 @@ void ShmManager::triggerEventById_(int event_id) {
 
 // 清除事件标志位
 void ShmManager::clearTriggerEvent(int event_id) {
-  // std::lock_guard<std::mutex> lock(registry_mutex_);
-  if (event_id < 0 || event_id >= MAX_TOPICS_PER_NODE) {
+  if (event_id < 0 || event_id > MAX_TOPIC_EVENT_COUNT) {
     return;
   }
   event_notification_shm_->clearEvents(event_id);
@@ -569,9 +1471,7 @@ void ShmManager::clearTriggerEvent(int event_id) {
 
 // 清除所有事件标志位
 void ShmManager::clearAllTriggerEvents() {
-  // std::lock_guard<std::mutex> lock(registry_mutex_);
   event_notification_shm_->clearEvents();
-  // writeTopicsInfo_();
 }
 
 // 批量读取并清除事件标志位（原子操作）
@@ -581,11 +1481,5 @@ void ShmManager::clearAllTriggerEvents() {
 bool ShmManager::isTopicExist(const std::string& topic_name,
                               const std::string& event_name) {
   std::lock_guard<std::mutex> lock(registry_mutex_);
-  std::string full_name = topic_name + "_" + event_name;
-  for (int i = 0; i < topics_.topics_count; i++) {
-    if (std::string(topics_.topics[i].name_) == full_name) {
-      return true;
-    }
-  }
-  return false;
-}
\ No newline at end of file
+  return lookupTopicEventId_(topic_name, event_name) >= 0;
+}
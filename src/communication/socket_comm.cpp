@@ -0,0 +1,990 @@
+#include "mini_ros2/communication/socket_comm.h"
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+std::runtime_error socketError(const std::string& what) {
+  return std::runtime_error("UdpCommAdapter: " + what + ": " +
+                            std::string(strerror(errno)));
+}
+
+in_addr parseAddress(const std::string& address) {
+  in_addr addr;
+  if (inet_pton(AF_INET, address.c_str(), &addr) != 1) {
+    throw std::invalid_argument("UdpCommAdapter: invalid IPv4 address " +
+                                address);
+  }
+  return addr;
+}
+
+}  // namespace
+
+UdpCommAdapter::UdpCommAdapter(const UdpCommConfig& config)
+    : config_(config),
+      sender_id_(randomCommSenderId()),
+      drop_random_(sender_id_),
+      clock_base_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count()) {
+  if (config_.mtu <= UDP_COMM_IP_UDP_HEADER + sizeof(UdpFrameHeader)) {
+    throw std::invalid_argument("UdpCommAdapter: mtu " +
+                                std::to_string(config_.mtu) + " too small");
+  }
+  max_datagram_ = std::min<size_t>(config_.mtu - UDP_COMM_IP_UDP_HEADER,
+                                   UDP_COMM_MAX_DATAGRAM);
+  in_addr iface = parseAddress(config_.interface_address);
+  std::memset(&group_addr_, 0, sizeof(group_addr_));
+  group_addr_.sin_family = AF_INET;
+  group_addr_.sin_port = htons(config_.multicast_port);
+  group_addr_.sin_addr = parseAddress(config_.multicast_group);
+
+  try {
+    // 组播接收套接字：绑定组播端口，同一主机上的多个进程共享
+    mc_fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (mc_fd_ < 0) throw socketError("socket");
+    int on = 1;
+    setsockopt(mc_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in bind_addr;
+    std::memset(&bind_addr, 0, sizeof(bind_addr));
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_port = htons(config_.multicast_port);
+    bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(mc_fd_, reinterpret_cast<sockaddr*>(&bind_addr),
+             sizeof(bind_addr)) < 0) {
+      throw socketError("bind multicast port");
+    }
+    ip_mreq mreq;
+    mreq.imr_multiaddr = group_addr_.sin_addr;
+    mreq.imr_interface = iface;
+    if (setsockopt(mc_fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq,
+                   sizeof(mreq)) < 0) {
+      throw socketError("join " + config_.multicast_group);
+    }
+    // 只接收本套接字加入的组，不接收绑定同一端口的其他组
+    int off = 0;
+    setsockopt(mc_fd_, IPPROTO_IP, IP_MULTICAST_ALL, &off, sizeof(off));
+
+    // 单播套接字：所有发送都从这里发出，对端可以按源地址单播回来
+    uc_fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (uc_fd_ < 0) throw socketError("socket");
+    bind_addr.sin_port = htons(config_.unicast_port);
+    if (bind(uc_fd_, reinterpret_cast<sockaddr*>(&bind_addr),
+             sizeof(bind_addr)) < 0) {
+      throw socketError("bind unicast port");
+    }
+    socklen_t len = sizeof(bind_addr);
+    getsockname(uc_fd_, reinterpret_cast<sockaddr*>(&bind_addr), &len);
+    unicast_port_ = ntohs(bind_addr.sin_port);
+    if (setsockopt(uc_fd_, IPPROTO_IP, IP_MULTICAST_IF, &iface,
+                   sizeof(iface)) < 0) {
+      throw socketError("set multicast interface");
+    }
+    unsigned char ttl = static_cast<unsigned char>(config_.multicast_ttl);
+    setsockopt(uc_fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    unsigned char loop = config_.multicast_loop ? 1 : 0;
+    setsockopt(uc_fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    // 非特权进程的缓冲区大小受 net.core.rmem_max / wmem_max 限制，先尝试 FORCE
+    for (int fd : {mc_fd_, uc_fd_}) {
+      if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &config_.receive_buffer,
+                     sizeof(config_.receive_buffer)) < 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &config_.receive_buffer,
+                   sizeof(config_.receive_buffer));
+      }
+    }
+    if (setsockopt(uc_fd_, SOL_SOCKET, SO_SNDBUFFORCE, &config_.send_buffer,
+                   sizeof(config_.send_buffer)) < 0) {
+      setsockopt(uc_fd_, SOL_SOCKET, SO_SNDBUF, &config_.send_buffer,
+                 sizeof(config_.send_buffer));
+    }
+
+    engine_ = createIoEngine(config_.io_backend);
+    for (int fd : {mc_fd_, uc_fd_}) {
+      engine_->addReceiver(fd, UDP_COMM_MAX_DATAGRAM,
+                           [this](const uint8_t* data, size_t size,
+                                  const sockaddr_in& from) {
+                             dispatch_(data, size, from);
+                           });
+    }
+  } catch (...) {
+    if (mc_fd_ >= 0) close(mc_fd_);
+    if (uc_fd_ >= 0) close(uc_fd_);
+    throw;
+  }
+  std::cout << "UdpCommAdapter: group " << config_.multicast_group << ":"
+            << config_.multicast_port << " unicast port " << unicast_port_
+            << " mtu " << config_.mtu << " io " << engine_->name()
+            << std::endl;
+}
+
+UdpCommAdapter::~UdpCommAdapter() {
+  stop();
+  engine_.reset();
+  close(mc_fd_);
+  close(uc_fd_);
+}
+
+CommEndpoint UdpCommAdapter::localEndpoint() const {
+  CommEndpoint endpoint;
+  // 绑定在所有接口上，回环地址总是可达；跨主机时对端使用本机网卡地址
+  endpoint.host = config_.interface_address == "0.0.0.0"
+                      ? "127.0.0.1"
+                      : config_.interface_address;
+  endpoint.port = unicast_port_;
+  return endpoint;
+}
+
+const sockaddr_in& UdpCommAdapter::resolve_(const CommEndpoint& endpoint) {
+  if (endpoint.isGroup()) {
+    return group_addr_;
+  }
+  std::string key = endpoint.host + ":" + std::to_string(endpoint.port);
+  auto it = resolved_.find(key);
+  if (it != resolved_.end()) {
+    return it->second;
+  }
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo* result = nullptr;
+  int ret = getaddrinfo(endpoint.host.c_str(), nullptr, &hints, &result);
+  if (ret != 0 || result == nullptr) {
+    throw std::invalid_argument("UdpCommAdapter: cannot resolve " +
+                                endpoint.host + ": " + gai_strerror(ret));
+  }
+  sockaddr_in addr = *reinterpret_cast<sockaddr_in*>(result->ai_addr);
+  freeaddrinfo(result);
+  addr.sin_port = htons(endpoint.port);
+  return resolved_.emplace(key, addr).first->second;
+}
+
+size_t UdpCommAdapter::sendBatch(const std::vector<CommFrame>& frames) {
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  for (const auto& frame : frames) {
+    if (frame.reliable) {
+      recordHistory_(frame);
+    }
+    // 单播过的对端也参与时钟同步（组播组总是参与）
+    auto same = [&frame](const CommEndpoint& peer) {
+      return peer.host == frame.dest.host && peer.port == frame.dest.port;
+    };
+    if (!frame.dest.isGroup() &&
+        std::none_of(clock_peers_.begin(), clock_peers_.end(), same)) {
+      clock_peers_.push_back(frame.dest);
+    }
+  }
+  return sendFrames_(frames, 0);
+}
+
+void UdpCommAdapter::recordHistory_(const CommFrame& frame) {
+  WriterStream& writer = writers_[frame.topic + "_" + frame.event];
+  if (writer.history.empty()) {
+    writer.topic = frame.topic;
+    writer.event = frame.event;
+  }
+  // 同一条消息发往多个对端时只保存一份
+  if (writer.history.empty() || writer.history.back().seq != frame.seq) {
+    writer.history.push_back(
+        {frame.seq, frame.segment_size,
+         std::vector<uint8_t>(frame.data, frame.data + frame.size)});
+    while (writer.history.size() > config_.reliable_history) {
+      writer.history.pop_front();
+    }
+  }
+  auto same = [&frame](const CommEndpoint& dest) {
+    return dest.host == frame.dest.host && dest.port == frame.dest.port;
+  };
+  if (std::none_of(writer.dests.begin(), writer.dests.end(), same)) {
+    writer.dests.push_back(frame.dest);
+  }
+}
+
+size_t UdpCommAdapter::sendFrames_(const std::vector<CommFrame>& frames,
+                                   uint8_t flags) {
+  // 先算出每帧的分片数，预留好容器，保证 iovec 指向的帧头和名字地址不变
+  std::vector<size_t> chunks(frames.size(), 0);
+  std::vector<uint32_t> counts(frames.size(), 0);
+  size_t total_fragments = 0;
+  for (size_t i = 0; i < frames.size(); i++) {
+    const CommFrame& frame = frames[i];
+    size_t overhead =
+        sizeof(UdpFrameHeader) + frame.topic.size() + frame.event.size();
+    if (overhead >= max_datagram_ || frame.size > UINT32_MAX) {
+      std::cerr << "UdpCommAdapter: frame " << frame.topic
+                << " cannot be sent, dropped" << std::endl;
+      continue;
+    }
+    chunks[i] = max_datagram_ - overhead;
+    counts[i] = static_cast<uint32_t>(
+        std::max<size_t>(1, (frame.size + chunks[i] - 1) / chunks[i]));
+    total_fragments += counts[i];
+  }
+  std::vector<UdpFrameHeader> headers;
+  std::vector<std::string> names;
+  std::vector<iovec> iovecs;
+  std::vector<mmsghdr> msgs;
+  std::vector<size_t> record_frame;  // 按报文顺序排列的每条记录所属的帧
+  std::vector<size_t> msg_first;     // 报文的第一条记录在 record_frame 中的下标
+  headers.reserve(total_fragments);
+  names.reserve(frames.size());
+  iovecs.reserve(total_fragments * 3);
+  msgs.reserve(total_fragments);
+  record_frame.reserve(total_fragments);
+  msg_first.reserve(total_fragments);
+
+  // 每条记录三段 iovec：帧头、topic+event、数据；数据直接指向调用者的缓冲区
+  auto appendRecord = [&](size_t i, uint32_t k, size_t offset,
+                          size_t length) {
+    const CommFrame& frame = frames[i];
+    UdpFrameHeader header;
+    header.magic = htonl(UDP_COMM_MAGIC);
+    header.version = UDP_COMM_VERSION;
+    header.flags = flags | (frame.reliable ? UDP_COMM_FLAG_RELIABLE : 0);
+    header.topic_len = htons(static_cast<uint16_t>(frame.topic.size()));
+    header.event_len = htons(static_cast<uint16_t>(frame.event.size()));
+    header.reserved = 0;
+    header.segment_size = htonl(frame.segment_size);
+    header.payload_size = htonl(static_cast<uint32_t>(frame.size));
+    header.frag_offset = htonl(static_cast<uint32_t>(offset));
+    header.frag_index = htonl(k);
+    header.frag_count = htonl(counts[i]);
+    header.sender_id = htobe64(sender_id_);
+    header.seq = htobe64(frame.seq);
+    header.timestamp =
+        frame.timestamp == 0
+            ? 0
+            : htobe64(skewed_(static_cast<int64_t>(frame.timestamp) * 1000) /
+                      1000);
+    headers.push_back(header);
+    if (k == 0) {
+      names.push_back(frame.topic + frame.event);
+    }
+    const std::string& name = names.back();
+    iovecs.push_back({&headers.back(), sizeof(UdpFrameHeader)});
+    iovecs.push_back({const_cast<char*>(name.data()), name.size()});
+    iovecs.push_back({const_cast<uint8_t*>(frame.data) + offset, length});
+    record_frame.push_back(i);
+  };
+  // 报文的 iovec 是 iovecs 中从 first_iov 开始的连续一段
+  auto closeMessage = [&](const sockaddr_in& addr, size_t first_iov,
+                          size_t first_record) {
+    mmsghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_hdr.msg_name = const_cast<sockaddr_in*>(&addr);
+    msg.msg_hdr.msg_namelen = sizeof(addr);
+    msg.msg_hdr.msg_iov = &iovecs[first_iov];
+    msg.msg_hdr.msg_iovlen = iovecs.size() - first_iov;
+    msgs.push_back(msg);
+    msg_first.push_back(first_record);
+  };
+
+  // 分片（以及关闭合并时的所有帧）每片一个报文；可合并的小帧按目的地址分组
+  std::vector<std::pair<const sockaddr_in*, std::vector<size_t>>> groups;
+  for (size_t i = 0; i < frames.size(); i++) {
+    if (chunks[i] == 0) {
+      continue;
+    }
+    const CommFrame& frame = frames[i];
+    const sockaddr_in& addr = resolve_(frame.dest);
+    if (config_.coalesce && counts[i] == 1) {
+      auto group = std::find_if(groups.begin(), groups.end(),
+                                [&addr](const auto& entry) {
+                                  return entry.first == &addr;
+                                });
+      if (group == groups.end()) {
+        groups.push_back({&addr, {}});
+        group = groups.end() - 1;
+      }
+      group->second.push_back(i);
+      continue;
+    }
+    for (uint32_t k = 0; k < counts[i]; k++) {
+      size_t offset = static_cast<size_t>(k) * chunks[i];
+      size_t first_iov = iovecs.size();
+      size_t first_record = record_frame.size();
+      appendRecord(i, k, offset, std::min(chunks[i], frame.size - offset));
+      closeMessage(addr, first_iov, first_record);
+    }
+  }
+  // 同一地址的小帧依次装入报文，装不下或达到记录上限时开始下一个报文
+  for (const auto& group : groups) {
+    size_t first_iov = iovecs.size();
+    size_t first_record = record_frame.size();
+    size_t used = 0;
+    for (size_t i : group.second) {
+      size_t length = max_datagram_ - chunks[i] + frames[i].size;
+      if (record_frame.size() > first_record &&
+          (used + length > max_datagram_ ||
+           record_frame.size() - first_record >= UDP_COMM_MAX_RECORDS)) {
+        closeMessage(*group.first, first_iov, first_record);
+        first_iov = iovecs.size();
+        first_record = record_frame.size();
+        used = 0;
+      }
+      appendRecord(i, 0, 0, frames[i].size);
+      used += length;
+    }
+    closeMessage(*group.first, first_iov, first_record);
+  }
+  msg_first.push_back(record_frame.size());
+
+  // 一次提交整批报文；失败的报文（例如对端不可达）不影响后面的报文
+  engine_->sendBatch(uc_fd_, msgs);
+  std::vector<bool> failed(frames.size(), false);
+  for (size_t k = 0; k < msgs.size(); k++) {
+    if (msgs[k].msg_len != 0) {
+      datagrams_sent_++;
+      continue;
+    }
+    for (size_t r = msg_first[k]; r < msg_first[k + 1]; r++) {
+      failed[record_frame[r]] = true;
+    }
+  }
+  size_t sent_frames = 0;
+  for (size_t i = 0; i < frames.size(); i++) {
+    if (chunks[i] != 0 && !failed[i]) {
+      sent_frames++;
+    }
+  }
+  return sent_frames;
+}
+
+void UdpCommAdapter::start(ReceiveCallback callback) {
+  if (running_) return;
+  callback_ = std::move(callback);
+  running_ = true;
+  // 接收线程定期检查分片重组超时、发送可靠 topic 的心跳
+  // 以及时钟同步的 Ping
+  uint64_t tick_ms = std::min(config_.reassembly_timeout_ms / 2,
+                              config_.heartbeat_ms);
+  if (config_.clock_sync_ms != 0) {
+    tick_ms = std::min(tick_ms, config_.clock_sync_ms);
+  }
+  engine_->start(std::max<uint64_t>(1, tick_ms), [this]() { tick_(); });
+}
+
+void UdpCommAdapter::stop() {
+  if (!running_) return;
+  running_ = false;
+  engine_->stop();
+}
+
+void UdpCommAdapter::dispatch_(const uint8_t* data, size_t size,
+                               const sockaddr_in& from) {
+  if (config_.receive_drop_rate > 0 &&
+      std::uniform_real_distribution<double>(0, 1)(drop_random_) <
+          config_.receive_drop_rate) {
+    return;
+  }
+  receive_time_ns_ = clockNow_();
+  receive_from_ = from;
+  // 合并的报文依次解析每一帧，遇到格式错误时丢弃报文的剩余部分
+  // I/O 引擎不捕获回调的异常：在这里拦下，一个报文出错不会结束进程
+  try {
+    size_t offset = 0;
+    while (offset < size) {
+      size_t used = dispatchRecord_(data + offset, size - offset);
+      if (used == 0) {
+        return;
+      }
+      offset += used;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "UdpCommAdapter: dropped datagram: " << e.what()
+              << std::endl;
+  }
+}
+
+size_t UdpCommAdapter::dispatchRecord_(const uint8_t* data, size_t size) {
+  if (size < sizeof(UdpFrameHeader)) {
+    return 0;
+  }
+  UdpFrameHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (ntohl(header.magic) != UDP_COMM_MAGIC ||
+      header.version != UDP_COMM_VERSION) {
+    return 0;
+  }
+  uint64_t sender_id = be64toh(header.sender_id);
+  if (sender_id == sender_id_) {
+    return 0;  // 组播回环收到的自己发出的帧，整个报文都是自己的
+  }
+  size_t topic_len = ntohs(header.topic_len);
+  size_t event_len = ntohs(header.event_len);
+  size_t payload_size = ntohl(header.payload_size);
+  size_t offset = ntohl(header.frag_offset);
+  uint32_t index = ntohl(header.frag_index);
+  uint32_t count = ntohl(header.frag_count);
+  size_t prefix = sizeof(UdpFrameHeader) + topic_len + event_len;
+  if (prefix > size || count == 0 || index >= count) {
+    return 0;
+  }
+  // 帧头来自网络：消息长度有上限，避免伪造的帧头让接收端分配任意大的缓冲区
+  if (payload_size > config_.max_message_size) {
+    return 0;
+  }
+  // 不分片的帧之后可能还有其他帧；分片独占报文，占用剩余的全部字节
+  size_t length = count == 1 ? payload_size : size - prefix;
+  if (prefix + length > size || offset + length > payload_size) {
+    return 0;
+  }
+  // 发送端按固定的 chunk 切分：第 k 片从 k * chunk 开始，只有最后一片可以更短，
+  // 分片数为 ceil(payload_size / chunk)
+  if (count > 1) {
+    bool last = index + 1 == count;
+    size_t chunk = last ? offset / index : length;
+    if (chunk == 0 || offset != index * chunk || length > chunk ||
+        (last && offset + length != payload_size) ||
+        (payload_size + chunk - 1) / chunk != count) {
+      return 0;
+    }
+  }
+  const char* names =
+      reinterpret_cast<const char*>(data + sizeof(UdpFrameHeader));
+  CommMessage msg;
+  msg.sender_id = sender_id;
+  msg.seq = be64toh(header.seq);
+  msg.segment_size = ntohl(header.segment_size);
+  msg.source_time = 0;
+  if (header.timestamp != 0) {
+    msg.source_time = toLocalTime_(sender_id, be64toh(header.timestamp));
+  }
+  msg.topic.assign(names, topic_len);
+  msg.event.assign(names + topic_len, event_len);
+
+  if (count == 1) {
+    msg.data = data + prefix;
+    msg.size = payload_size;
+    if (header.flags & UDP_COMM_FLAG_HEARTBEAT) {
+      onHeartbeat_(msg);
+    } else if (header.flags & UDP_COMM_FLAG_NACK) {
+      onNack_(msg);
+    } else if (header.flags & UDP_COMM_FLAG_PING) {
+      onPing_(msg);
+    } else if (header.flags & UDP_COMM_FLAG_PONG) {
+      onPong_(msg);
+    } else {
+      deliver_(msg, header.flags & UDP_COMM_FLAG_RELIABLE);
+    }
+    return prefix + length;
+  }
+
+  std::string key = std::to_string(sender_id) + ":" + msg.topic + "_" +
+                    msg.event;
+  Reassembly& entry = reassembly_[key];
+  entry.last_seen = std::chrono::steady_clock::now();
+  if (entry.active && msg.seq < entry.seq) {
+    return size;  // 已被更新的消息取代
+  }
+  if (!entry.active || msg.seq != entry.seq) {
+    if (entry.active) {
+      incomplete_++;  // 新消息的分片先到，放弃旧消息
+    }
+    entry.active = true;
+    entry.seq = msg.seq;
+    entry.segment_size = msg.segment_size;
+    entry.size = payload_size;
+    entry.fragment_count = count;
+    entry.received = 0;
+    entry.got.assign(count, 0);
+    if (entry.buffer.size() < payload_size) {
+      entry.buffer.resize(payload_size);
+    }
+    entry.started = std::chrono::steady_clock::now();
+    entry.reliable = header.flags & UDP_COMM_FLAG_RELIABLE;
+  }
+  if (count != entry.fragment_count || payload_size != entry.size ||
+      entry.got[index]) {
+    return size;  // 重复的分片或与首个分片不一致
+  }
+  std::memcpy(entry.buffer.data() + offset, data + prefix, length);
+  entry.got[index] = 1;
+  if (++entry.received < entry.fragment_count) {
+    return size;
+  }
+  entry.active = false;
+  msg.data = entry.buffer.data();
+  msg.size = entry.size;
+  deliver_(msg, entry.reliable);
+  return size;
+}
+
+void UdpCommAdapter::deliver_(const CommMessage& msg, bool reliable) {
+  if (!reliable) {
+    if (callback_) {
+      callback_(msg);
+    }
+    return;
+  }
+  ReaderStream& reader = readers_[std::to_string(msg.sender_id) + ":" +
+                                  msg.topic + "_" + msg.event];
+  reader.last_seen = std::chrono::steady_clock::now();
+  reader.last_known = std::max(reader.last_known, msg.seq);
+  // 与 CommGateway 相同，第一条消息作为起点，之前的消息不补发
+  if (reader.expected == 0) {
+    reader.expected = msg.seq;
+  }
+  if (msg.seq < reader.expected || reader.pending.count(msg.seq) != 0) {
+    return;  // 重发或重复到达
+  }
+  if (msg.seq > reader.expected) {
+    // 缺口之后的消息先缓存，立即请求重发缺失的消息
+    if (reader.pending.size() < config_.reliable_window) {
+      reader.pending.emplace(
+          msg.seq, PendingSample{msg.segment_size, msg.source_time,
+                                 std::vector<uint8_t>(msg.data,
+                                                      msg.data + msg.size)});
+    }
+    sendNack_(reader, msg);
+    return;
+  }
+  if (callback_) {
+    callback_(msg);
+  }
+  reader.expected++;
+  flushPending_(reader, msg);
+}
+
+void UdpCommAdapter::flushPending_(ReaderStream& reader, CommMessage msg) {
+  while (!reader.pending.empty() &&
+         reader.pending.begin()->first <= reader.expected) {
+    auto it = reader.pending.begin();
+    if (it->first == reader.expected) {
+      msg.seq = it->first;
+      msg.segment_size = it->second.segment_size;
+      msg.source_time = it->second.source_time;
+      msg.data = it->second.data.data();
+      msg.size = it->second.data.size();
+      if (callback_) {
+        callback_(msg);
+      }
+      reader.expected++;
+    }
+    reader.pending.erase(it);
+  }
+}
+
+CommEndpoint UdpCommAdapter::source_() const {
+  char host[INET_ADDRSTRLEN];
+  inet_ntop(AF_INET, &receive_from_.sin_addr, host, sizeof(host));
+  return CommEndpoint{host, ntohs(receive_from_.sin_port)};
+}
+
+void UdpCommAdapter::onHeartbeat_(const CommMessage& msg) {
+  if (msg.size != sizeof(UdpHeartbeat)) {
+    return;
+  }
+  UdpHeartbeat heartbeat;
+  std::memcpy(&heartbeat, msg.data, sizeof(heartbeat));
+  ReaderStream& reader = readers_[std::to_string(msg.sender_id) + ":" +
+                                  msg.topic + "_" + msg.event];
+  reader.last_seen = std::chrono::steady_clock::now();
+  reader.reply = source_();
+  reader.has_reply = true;
+
+  uint64_t first = be64toh(heartbeat.first_seq);
+  uint64_t last = msg.seq;
+  if (reader.expected == 0) {
+    // 先收到心跳：从之后的消息开始接收，不请求已发出的历史
+    reader.expected = last + 1;
+    reader.last_known = last;
+    return;
+  }
+  reader.last_known = std::max(reader.last_known, last);
+  // 发送端历史窗口已不含 expected：跳过无法重发的消息，缓存中更早的照常交付
+  uint64_t skipped = 0;
+  while (reader.expected < first) {
+    auto it = reader.pending.begin();
+    if (it == reader.pending.end() || it->first >= first) {
+      skipped += first - reader.expected;
+      reader.expected = first;
+      break;
+    }
+    skipped += it->first - reader.expected;
+    reader.expected = it->first;
+    flushPending_(reader, msg);
+  }
+  flushPending_(reader, msg);
+  if (skipped > 0) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    reliable_stats_.unrecoverable += skipped;
+  }
+  if (reader.expected <= reader.last_known) {
+    sendNack_(reader, msg);
+  }
+}
+
+void UdpCommAdapter::sendNack_(ReaderStream& reader, const CommMessage& msg) {
+  auto now = std::chrono::steady_clock::now();
+  if (!reader.has_reply ||
+      now - reader.last_nack <
+          std::chrono::milliseconds(UDP_COMM_NACK_INTERVAL_MS)) {
+    return;
+  }
+  UdpNack nack;
+  std::memset(&nack, 0, sizeof(nack));
+  uint64_t span = std::min<uint64_t>(UDP_COMM_NACK_BITS,
+                                     reader.last_known - reader.expected + 1);
+  bool missing = false;
+  for (uint64_t i = 0; i < span; i++) {
+    if (reader.pending.count(reader.expected + i) == 0) {
+      nack.bitmap[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+      missing = true;
+    }
+  }
+  if (!missing) {
+    return;
+  }
+  CommEndpoint self = localEndpoint();
+  nack.writer_id = htobe64(msg.sender_id);
+  nack.base_seq = htobe64(reader.expected);
+  nack.reply_addr = parseAddress(self.host).s_addr;
+  nack.reply_port = htons(self.port);
+  nack.bit_count = htons(static_cast<uint16_t>(span));
+  CommFrame frame;
+  frame.topic = msg.topic;
+  frame.event = msg.event;
+  frame.data = reinterpret_cast<const uint8_t*>(&nack);
+  frame.size = sizeof(nack);
+  frame.dest = reader.reply;
+  {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    sendFrames_({frame}, UDP_COMM_FLAG_NACK);
+  }
+  reader.last_nack = now;
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  reliable_stats_.nacks_sent++;
+}
+
+void UdpCommAdapter::onNack_(const CommMessage& msg) {
+  if (msg.size != sizeof(UdpNack)) {
+    return;
+  }
+  UdpNack nack;
+  std::memcpy(&nack, msg.data, sizeof(nack));
+  if (be64toh(nack.writer_id) != sender_id_) {
+    return;  // 组播的 NACK，请求的是其他发送端
+  }
+  CommEndpoint reply = source_();
+  uint64_t base = be64toh(nack.base_seq);
+  size_t bits = std::min<size_t>(ntohs(nack.bit_count), UDP_COMM_NACK_BITS);
+
+  size_t resent = 0;
+  {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    auto it = writers_.find(msg.topic + "_" + msg.event);
+    if (it == writers_.end()) {
+      return;
+    }
+    const std::deque<HistorySample>& history = it->second.history;
+    std::vector<CommFrame> frames;
+    for (size_t i = 0; i < bits; i++) {
+      if (!(nack.bitmap[i / 8] & (1u << (i % 8)))) {
+        continue;
+      }
+      uint64_t seq = base + i;
+      auto sample = std::lower_bound(
+          history.begin(), history.end(), seq,
+          [](const HistorySample& entry, uint64_t value) {
+            return entry.seq < value;
+          });
+      if (sample == history.end() || sample->seq != seq) {
+        continue;  // 已移出历史窗口，接收端收到下一次心跳后跳过
+      }
+      CommFrame frame;
+      frame.topic = msg.topic;
+      frame.event = msg.event;
+      frame.seq = seq;
+      frame.segment_size = sample->segment_size;
+      frame.reliable = true;
+      frame.data = sample->data.data();
+      frame.size = sample->data.size();
+      frame.dest = reply;
+      frames.push_back(std::move(frame));
+    }
+    if (!frames.empty()) {
+      resent = sendFrames_(frames, 0);
+    }
+  }
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  reliable_stats_.nacks_received++;
+  reliable_stats_.retransmits += resent;
+}
+
+void UdpCommAdapter::tick_() {
+  expireReassembly_();
+  sendHeartbeats_();
+  sendClockPings_();
+}
+
+void UdpCommAdapter::sendHeartbeats_() {
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  auto now = std::chrono::steady_clock::now();
+  if (writers_.empty() ||
+      now - last_heartbeat_ < std::chrono::milliseconds(config_.heartbeat_ms)) {
+    return;
+  }
+  last_heartbeat_ = now;
+  CommEndpoint self = localEndpoint();
+  std::vector<UdpHeartbeat> bodies;
+  bodies.reserve(writers_.size());
+  std::vector<CommFrame> frames;
+  for (const auto& entry : writers_) {
+    const WriterStream& writer = entry.second;
+    if (writer.history.empty()) {
+      continue;
+    }
+    UdpHeartbeat heartbeat;
+    heartbeat.first_seq = htobe64(writer.history.front().seq);
+    heartbeat.reply_addr = parseAddress(self.host).s_addr;
+    heartbeat.reply_port = htons(self.port);
+    heartbeat.reserved = 0;
+    bodies.push_back(heartbeat);
+    for (const auto& dest : writer.dests) {
+      CommFrame frame;
+      frame.topic = writer.topic;
+      frame.event = writer.event;
+      frame.seq = writer.history.back().seq;
+      frame.data = reinterpret_cast<const uint8_t*>(&bodies.back());
+      frame.size = sizeof(UdpHeartbeat);
+      frame.dest = dest;
+      frames.push_back(std::move(frame));
+    }
+  }
+  if (frames.empty()) {
+    return;
+  }
+  // 所有心跳按目的地址合并成少量报文
+  size_t sent = sendFrames_(frames, UDP_COMM_FLAG_HEARTBEAT);
+  std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+  reliable_stats_.heartbeats_sent += sent;
+}
+
+int64_t UdpCommAdapter::skewed_(int64_t real_ns) const {
+  return real_ns + config_.clock_skew_us * 1000 +
+         static_cast<int64_t>(static_cast<double>(real_ns - clock_base_ns_) *
+                              config_.clock_drift_ppm * 1e-6);
+}
+
+int64_t UdpCommAdapter::clockNow_() const {
+  return skewed_(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count());
+}
+
+void UdpCommAdapter::sendClockPings_() {
+  if (config_.clock_sync_ms == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  auto now = std::chrono::steady_clock::now();
+  if (now - last_ping_ < std::chrono::milliseconds(config_.clock_sync_ms)) {
+    return;
+  }
+  last_ping_ = now;
+  CommEndpoint self = localEndpoint();
+  UdpClockPing ping;
+  ping.reply_addr = parseAddress(self.host).s_addr;
+  ping.reply_port = htons(self.port);
+  ping.reserved = 0;
+  std::vector<CommFrame> frames(1 + clock_peers_.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    frames[i].data = reinterpret_cast<const uint8_t*>(&ping);
+    frames[i].size = sizeof(ping);
+    if (i > 0) {
+      frames[i].dest = clock_peers_[i - 1];
+    }
+  }
+  // 尽量靠近发出的时刻取 t1
+  ping.t1 = static_cast<int64_t>(htobe64(clockNow_()));
+  sendFrames_(frames, UDP_COMM_FLAG_PING);
+}
+
+void UdpCommAdapter::onPing_(const CommMessage& msg) {
+  if (msg.size != sizeof(UdpClockPing)) {
+    return;
+  }
+  UdpClockPing ping;
+  std::memcpy(&ping, msg.data, sizeof(ping));
+  UdpClockPong pong;
+  pong.target_id = htobe64(msg.sender_id);
+  pong.t1 = ping.t1;
+  pong.t2 = static_cast<int64_t>(htobe64(receive_time_ns_));
+  CommFrame frame;
+  frame.data = reinterpret_cast<const uint8_t*>(&pong);
+  frame.size = sizeof(pong);
+  frame.dest = source_();
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  pong.t3 = static_cast<int64_t>(htobe64(clockNow_()));
+  sendFrames_({frame}, UDP_COMM_FLAG_PONG);
+}
+
+void UdpCommAdapter::onPong_(const CommMessage& msg) {
+  if (msg.size != sizeof(UdpClockPong)) {
+    return;
+  }
+  UdpClockPong pong;
+  std::memcpy(&pong, msg.data, sizeof(pong));
+  if (be64toh(pong.target_id) != sender_id_) {
+    return;
+  }
+  int64_t t1 = static_cast<int64_t>(be64toh(pong.t1));
+  int64_t t2 = static_cast<int64_t>(be64toh(pong.t2));
+  int64_t t3 = static_cast<int64_t>(be64toh(pong.t3));
+  int64_t t4 = receive_time_ns_;
+  ClockSample sample;
+  sample.local_ns = t4;
+  sample.offset_ns = ((t2 - t1) + (t3 - t4)) / 2;
+  sample.round_trip_ns = (t4 - t1) - (t3 - t2);
+  if (sample.round_trip_ns < 0) {
+    return;  // 应答方的处理时间比往返时间还长：时间戳不可信
+  }
+  std::lock_guard<std::mutex> lock(clock_mutex_);
+  updateClock_(clocks_[msg.sender_id], sample);
+}
+
+void UdpCommAdapter::updateClock_(ClockPeer& peer,
+                                  const ClockSample& sample) {
+  peer.samples.push_back(sample);
+  if (peer.samples.size() > UDP_CLOCK_SAMPLES) {
+    peer.samples.pop_front();
+  }
+  // 排队、调度造成的延迟只会让样本偏离真实偏移，往返延迟最小的样本最可信
+  size_t recent = std::min<size_t>(peer.samples.size(), UDP_CLOCK_FILTER);
+  peer.best = peer.samples.back();
+  int64_t min_round_trip = peer.best.round_trip_ns;
+  for (size_t i = 0; i < peer.samples.size(); i++) {
+    const ClockSample& entry = peer.samples[i];
+    min_round_trip = std::min(min_round_trip, entry.round_trip_ns);
+    if (i >= peer.samples.size() - recent &&
+        entry.round_trip_ns < peer.best.round_trip_ns) {
+      peer.best = entry;
+    }
+  }
+  // 漂移：对延迟接近最小值的样本做最小二乘，横轴为本端时间（先求均值再累加偏差，
+  // 纳秒时间的平方很大，直接累加会损失精度）
+  int64_t limit = 2 * min_round_trip + UDP_CLOCK_SLACK_NS;
+  const int64_t origin = peer.samples.front().local_ns;
+  double n = 0, mean_x = 0, mean_y = 0;
+  for (const auto& entry : peer.samples) {
+    if (entry.round_trip_ns <= limit) {
+      n += 1;
+      mean_x += static_cast<double>(entry.local_ns - origin);
+      mean_y += static_cast<double>(entry.offset_ns - peer.best.offset_ns);
+    }
+  }
+  peer.drift = 0;
+  if (n < 4) {
+    return;
+  }
+  mean_x /= n;
+  mean_y /= n;
+  double sum_xx = 0, sum_xy = 0;
+  for (const auto& entry : peer.samples) {
+    if (entry.round_trip_ns <= limit) {
+      double dx = static_cast<double>(entry.local_ns - origin) - mean_x;
+      double dy =
+          static_cast<double>(entry.offset_ns - peer.best.offset_ns) - mean_y;
+      sum_xx += dx * dx;
+      sum_xy += dx * dy;
+    }
+  }
+  // 时间跨度太短（方差小于跨度 100 ms 的均匀分布）时不估计漂移
+  if (sum_xx / n > 1e16 / 12) {
+    peer.drift = sum_xy / sum_xx;
+  }
+}
+
+int64_t UdpCommAdapter::offsetAt_(const ClockPeer& peer, int64_t local_ns) {
+  return peer.best.offset_ns +
+         static_cast<int64_t>(peer.drift *
+                              static_cast<double>(local_ns -
+                                                  peer.best.local_ns));
+}
+
+uint64_t UdpCommAdapter::toLocalTime_(uint64_t sender_id, uint64_t remote_us) {
+  int64_t local_ns;
+  {
+    std::lock_guard<std::mutex> lock(clock_mutex_);
+    auto it = clocks_.find(sender_id);
+    if (it == clocks_.end()) {
+      return 0;
+    }
+    local_ns = static_cast<int64_t>(remote_us) * 1000 -
+               offsetAt_(it->second, receive_time_ns_);
+  }
+  // 去掉本端测试用的偏移和漂移，换算到真实的 system_clock
+  int64_t real_ns = local_ns - config_.clock_skew_us * 1000 -
+                    static_cast<int64_t>(
+                        static_cast<double>(local_ns - clock_base_ns_) *
+                        config_.clock_drift_ppm * 1e-6);
+  return real_ns <= 0 ? 0 : static_cast<uint64_t>(real_ns / 1000);
+}
+
+std::vector<PeerClock> UdpCommAdapter::peerClocks() {
+  std::vector<PeerClock> result;
+  int64_t now = clockNow_();
+  std::lock_guard<std::mutex> lock(clock_mutex_);
+  for (const auto& entry : clocks_) {
+    const ClockPeer& peer = entry.second;
+    result.push_back({entry.first, offsetAt_(peer, now),
+                      peer.best.round_trip_ns, peer.drift * 1e6,
+                      peer.samples.size()});
+  }
+  return result;
+}
+
+bool UdpCommAdapter::peerClock(uint64_t peer_id, PeerClock& clock) {
+  for (const auto& entry : peerClocks()) {
+    if (entry.peer_id == peer_id) {
+      clock = entry;
+      return true;
+    }
+  }
+  return false;
+}
+
+UdpReliableStats UdpCommAdapter::reliableStats() {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return reliable_stats_;
+}
+
+void UdpCommAdapter::expireReassembly_() {
+  auto now = std::chrono::steady_clock::now();
+  auto deadline =
+      now - std::chrono::milliseconds(config_.reassembly_timeout_ms);
+  // 发送端（或伪造的 sender_id）长时间没有消息：释放它的重组缓冲区和可靠传输状态
+  auto idle = now - std::chrono::milliseconds(config_.peer_timeout_ms);
+  for (auto it = reassembly_.begin(); it != reassembly_.end();) {
+    Reassembly& reassembly = it->second;
+    if (reassembly.active && reassembly.started < deadline) {
+      reassembly.active = false;
+      incomplete_++;
+    }
+    if (!reassembly.active && reassembly.last_seen < idle) {
+      it = reassembly_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = readers_.begin(); it != readers_.end();) {
+    if (it->second.last_seen < idle) {
+      it = readers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
@@ -0,0 +1,871 @@
+#include "mini_ros2/communication/tcp_comm.h"
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <errno.h>
+#include <limits.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+// epoll_event.data.u64：连接 id 从 1 开始，
+// 0 和最大值留给监听套接字和唤醒 eventfd
+#define LISTEN_TAG 0
+#define WAKE_TAG UINT64_MAX
+
+std::runtime_error socketError(const std::string& what) {
+  return std::runtime_error("TcpCommAdapter: " + what + ": " +
+                            std::string(strerror(errno)));
+}
+
+void setSocketOptions(int fd, const TcpCommConfig& config) {
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &config.receive_buffer,
+             sizeof(config.receive_buffer));
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &config.send_buffer,
+             sizeof(config.send_buffer));
+}
+
+void setCork(int fd, bool cork) {
+  int value = cork ? 1 : 0;
+  setsockopt(fd, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+}
+
+// 对端已关闭（FIN 已到达且没有未读数据）或连接出错；只窥视，不消费接收线程的数据
+bool peerClosed(int fd) {
+  char byte;
+  ssize_t ret = recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (ret == 0) return true;
+  return ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+}
+
+}  // namespace
+
+TcpCommAdapter::Connection::~Connection() {
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+TcpCommAdapter::TcpCommAdapter(const TcpCommConfig& config)
+    : config_(config), sender_id_(randomCommSenderId()) {
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(config_.listen_port);
+  if (inet_pton(AF_INET, config_.listen_address.c_str(), &addr.sin_addr) !=
+      1) {
+    throw std::invalid_argument("TcpCommAdapter: invalid IPv4 address " +
+                                config_.listen_address);
+  }
+  try {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) throw socketError("socket");
+    int on = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) <
+        0) {
+      throw socketError("bind port " + std::to_string(config_.listen_port));
+    }
+    if (listen(listen_fd_, SOMAXCONN) < 0) throw socketError("listen");
+    socklen_t len = sizeof(addr);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    listen_port_ = ntohs(addr.sin_port);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) throw socketError("epoll");
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_TAG;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev);
+    ev.data.u64 = WAKE_TAG;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+  } catch (...) {
+    if (listen_fd_ >= 0) close(listen_fd_);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+    throw;
+  }
+  std::cout << "TcpCommAdapter: listening on " << config_.listen_address
+            << ":" << listen_port_ << ", " << config_.peers.size() << " peers"
+            << std::endl;
+}
+
+TcpCommAdapter::~TcpCommAdapter() {
+  stop();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    peers_.clear();
+    connections_.clear();
+  }
+  close(listen_fd_);
+  close(epoll_fd_);
+  close(wake_fd_);
+}
+
+CommEndpoint TcpCommAdapter::localEndpoint() const {
+  CommEndpoint endpoint;
+  endpoint.host = config_.listen_address == "0.0.0.0"
+                      ? "127.0.0.1"
+                      : config_.listen_address;
+  endpoint.port = listen_port_;
+  return endpoint;
+}
+
+size_t TcpCommAdapter::peerCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return peers_.size();
+}
+
+TcpCommStats TcpCommAdapter::getStats() {
+  TcpCommStats stats;
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats = stats_;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.connections = connections_.size();
+  return stats;
+}
+
+std::string TcpCommAdapter::endpointKey_(const CommEndpoint& endpoint,
+                                         sockaddr_in& addr) {
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+  int ret = getaddrinfo(endpoint.host.c_str(), nullptr, &hints, &result);
+  if (ret != 0 || result == nullptr) {
+    throw std::invalid_argument("TcpCommAdapter: cannot resolve " +
+                                endpoint.host + ": " + gai_strerror(ret));
+  }
+  addr = *reinterpret_cast<sockaddr_in*>(result->ai_addr);
+  freeaddrinfo(result);
+  addr.sin_port = htons(endpoint.port);
+  char ip[INET_ADDRSTRLEN];
+  inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+  return std::string(ip) + ":" + std::to_string(endpoint.port);
+}
+
+void TcpCommAdapter::connect_(const CommEndpoint& endpoint) {
+  sockaddr_in addr;
+  std::string key = endpointKey_(endpoint, addr);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (peers_.count(key) != 0 || connecting_.count(key) != 0) {
+      return;
+    }
+  }
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    connectFailed_(key);
+    return;
+  }
+  auto conn = std::make_shared<Connection>();
+  conn->fd = fd;
+  conn->key = key;
+  setSocketOptions(fd, config_);
+  // 非阻塞连接：可写时由事件循环检查结果并发出握手（finishConnect_），
+  // 调用者（发送线程、事件循环）都不等待
+  if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 &&
+      errno != EINPROGRESS) {
+    connectFailed_(key);
+    return;
+  }
+  conn->connecting = true;
+  conn->connect_started = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  connecting_[key] = conn;
+  addConnectionLocked_(conn, EPOLLOUT);
+}
+
+void TcpCommAdapter::connectFailed_(const std::string& key) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retry_after_[key] = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(config_.reconnect_ms);
+  }
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  stats_.errors++;
+}
+
+void TcpCommAdapter::finishConnect_(const ConnectionPtr& conn) {
+  int error = 0;
+  socklen_t len = sizeof(error);
+  bool connected =
+      getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 &&
+      error == 0;
+  if (connected) {
+    // 先改为关注可读：握手没能一次写完时由 writeAll_ 再关注可写
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.u64 = conn->id;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn->fd, &ev);
+  }
+  if (!connected || !sendHello_(*conn)) {
+    closeConnection_(conn->id);
+    connectFailed_(conn->key);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    conn->connecting = false;
+    connecting_.erase(conn->key);
+    retry_after_.erase(conn->key);
+    // 同时对端连过来、已登记了同一 key 时本连接只用于接收
+    if (peers_.count(conn->key) == 0) {
+      peers_[conn->key] = conn;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.connects++;
+  }
+  std::cout << "TcpCommAdapter: connected to " << conn->key << std::endl;
+}
+
+void TcpCommAdapter::expireConnects_() {
+  auto now = std::chrono::steady_clock::now();
+  std::vector<ConnectionPtr> expired;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : connecting_) {
+      if (now - entry.second->connect_started >=
+          std::chrono::milliseconds(config_.connect_timeout_ms)) {
+        expired.push_back(entry.second);
+      }
+    }
+  }
+  for (const auto& conn : expired) {
+    closeConnection_(conn->id);
+    connectFailed_(conn->key);
+  }
+}
+
+void TcpCommAdapter::addConnectionLocked_(const ConnectionPtr& conn,
+                                          uint32_t events) {
+  conn->id = next_connection_id_++;
+  connections_[conn->id] = conn;
+  if (!conn->key.empty() && !conn->connecting &&
+      peers_.count(conn->key) == 0) {
+    peers_[conn->key] = conn;
+  }
+  epoll_event ev;
+  ev.events = events;
+  ev.data.u64 = conn->id;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, conn->fd, &ev);
+}
+
+void TcpCommAdapter::closeConnection_(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = connections_.find(id);
+  if (it == connections_.end()) {
+    return;
+  }
+  ConnectionPtr conn = it->second;
+  connections_.erase(it);
+  auto peer = peers_.find(conn->key);
+  if (peer != peers_.end() && peer->second == conn) {
+    peers_.erase(peer);
+  }
+  auto pending = connecting_.find(conn->key);
+  if (pending != connecting_.end() && pending->second == conn) {
+    connecting_.erase(pending);
+  }
+  // fd 由最后一个持有者析构时关闭：发送线程可能还拿着这条连接
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->fd, nullptr);
+  shutdown(conn->fd, SHUT_RDWR);
+  conn->broken = true;
+  // 连不上的对端每 reconnect_ms 重试一次，不逐次打印
+  if (!conn->connecting) {
+    std::cout << "TcpCommAdapter: connection "
+              << (conn->key.empty() ? std::to_string(id) : conn->key)
+              << " closed" << std::endl;
+  }
+}
+
+TcpCommAdapter::ConnectionPtr TcpCommAdapter::connectionFor_(
+    const CommEndpoint& dest) {
+  std::string name = dest.host + ":" + std::to_string(dest.port);
+  std::string key;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto resolved = resolved_.find(name);
+    if (resolved != resolved_.end()) {
+      key = resolved->second;
+    }
+  }
+  if (key.empty()) {
+    sockaddr_in addr;
+    key = endpointKey_(dest, addr);
+    std::lock_guard<std::mutex> lock(mutex_);
+    resolved_[name] = key;
+  }
+  auto now = std::chrono::steady_clock::now();
+  ConnectionPtr conn;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(key);
+    if (it != peers_.end() && !it->second->broken) {
+      conn = it->second;
+    }
+  }
+  // 接收线程可能还没处理对端的关闭：发现时先注销，避免把帧写进半关闭的连接
+  if (conn != nullptr) {
+    if (!peerClosed(conn->fd)) {
+      return conn;
+    }
+    closeConnection_(conn->id);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto retry = retry_after_.find(key);
+    if (retry != retry_after_.end() && now < retry->second) {
+      return nullptr;
+    }
+  }
+  // 发起连接后立即返回：调用者可能持有数据段锁（CommGateway 的原地发送），
+  // 连接建立前发往该地址的帧不发出
+  connect_(dest);
+  return nullptr;
+}
+
+size_t TcpCommAdapter::sendBatch(const std::vector<CommFrame>& frames) {
+  // 按连接分组，同一连接上保持帧的原始顺序
+  std::vector<std::pair<ConnectionPtr, std::vector<size_t>>> groups;
+  // 每帧成功写入的连接数：组地址在没有已连接的对端时不算发出
+  std::vector<size_t> written(frames.size(), 0);
+  auto append = [&groups](const ConnectionPtr& conn, size_t index) {
+    for (auto& group : groups) {
+      if (group.first == conn) {
+        group.second.push_back(index);
+        return;
+      }
+    }
+    groups.push_back({conn, {index}});
+  };
+  std::vector<ConnectionPtr> all_peers;
+  bool has_group = std::any_of(
+      frames.begin(), frames.end(),
+      [](const CommFrame& frame) { return frame.dest.isGroup(); });
+  if (has_group) {
+    std::vector<ConnectionPtr> candidates;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& entry : peers_) {
+        candidates.push_back(entry.second);
+      }
+    }
+    for (const auto& conn : candidates) {
+      if (peerClosed(conn->fd)) {
+        closeConnection_(conn->id);
+      } else {
+        all_peers.push_back(conn);
+      }
+    }
+  }
+  for (size_t i = 0; i < frames.size(); i++) {
+    const CommFrame& frame = frames[i];
+    if (frame.topic.size() > UINT16_MAX || frame.event.size() > UINT16_MAX ||
+        frame.topic.size() + frame.event.size() + frame.size >
+            TCP_COMM_MAX_FRAME) {
+      std::cerr << "TcpCommAdapter: frame " << frame.topic << "_"
+                << frame.event << " too large, skipped" << std::endl;
+      continue;
+    }
+    if (frame.dest.isGroup()) {
+      for (const auto& conn : all_peers) {
+        append(conn, i);
+      }
+      continue;
+    }
+    ConnectionPtr conn;
+    try {
+      conn = connectionFor_(frame.dest);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+    }
+    if (conn == nullptr) {
+      continue;
+    }
+    append(conn, i);
+  }
+  for (const auto& group : groups) {
+    if (!writeFrames_(*group.first, frames, group.second)) {
+      closeConnection_(group.first->id);
+      continue;
+    }
+    for (size_t index : group.second) {
+      written[index]++;
+    }
+  }
+  return std::count_if(written.begin(), written.end(),
+                       [](size_t count) { return count > 0; });
+}
+
+bool TcpCommAdapter::writeFrames_(Connection& conn,
+                                  const std::vector<CommFrame>& frames,
+                                  const std::vector<size_t>& indices) {
+  // 帧头先全部填好再取地址，iovec 指向的 vector 不能再扩容
+  std::vector<TcpFrameHeader> headers(indices.size());
+  std::vector<iovec> iov;
+  iov.reserve(indices.size() * 4);
+  size_t total = 0;
+  for (size_t i = 0; i < indices.size(); i++) {
+    const CommFrame& frame = frames[indices[i]];
+    TcpFrameHeader& header = headers[i];
+    std::memset(&header, 0, sizeof(header));
+    header.length =
+        htonl(static_cast<uint32_t>(frame.topic.size() + frame.event.size() +
+                                    frame.size));
+    header.version = TCP_COMM_VERSION;
+    header.topic_len = htons(static_cast<uint16_t>(frame.topic.size()));
+    header.event_len = htons(static_cast<uint16_t>(frame.event.size()));
+    header.segment_size = htonl(frame.segment_size);
+    header.seq = htobe64(frame.seq);
+    header.timestamp = htobe64(frame.timestamp);
+    iov.push_back({&header, sizeof(header)});
+    iov.push_back({const_cast<char*>(frame.topic.data()), frame.topic.size()});
+    iov.push_back({const_cast<char*>(frame.event.data()), frame.event.size()});
+    // 数据直接从调用者的缓冲区（共享内存数据段）写入套接字
+    if (frame.size > 0) {
+      iov.push_back({const_cast<uint8_t*>(frame.data), frame.size});
+    }
+    total += sizeof(header) + frame.topic.size() + frame.event.size() +
+             frame.size;
+  }
+  // 自适应 cork：小批量立即发出；大批量或一次 writev 发不完时先攒满整段再发
+  bool cork = total > config_.cork_bytes || iov.size() > IOV_MAX;
+  bool ok;
+  {
+    std::lock_guard<std::mutex> lock(conn.send_mutex);
+    if (conn.broken) {
+      return false;
+    }
+    if (cork) setCork(conn.fd, true);
+    ok = writeAll_(conn, iov);
+    if (cork) setCork(conn.fd, false);
+  }
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  if (!ok) {
+    stats_.errors++;
+    return false;
+  }
+  stats_.frames_sent += indices.size();
+  stats_.bytes_sent += total;
+  if (cork) stats_.corked_batches++;
+  return true;
+}
+
+bool TcpCommAdapter::sendHello_(Connection& conn) {
+  TcpHello hello;
+  std::memset(&hello, 0, sizeof(hello));
+  hello.magic = htonl(TCP_COMM_MAGIC);
+  hello.sender_id = htobe64(sender_id_);
+  hello.listen_port = htons(listen_port_);
+  TcpFrameHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.length = htonl(sizeof(hello));
+  header.version = TCP_COMM_VERSION;
+  header.flags = TCP_COMM_FLAG_HELLO;
+  std::vector<iovec> iov = {{&header, sizeof(header)},
+                            {&hello, sizeof(hello)}};
+  std::lock_guard<std::mutex> lock(conn.send_mutex);
+  return writeAll_(conn, iov);
+}
+
+bool TcpCommAdapter::writeAll_(Connection& conn, std::vector<iovec>& iov) {
+  size_t next = 0;
+  // 输出队列还有积压时不直接写，整批排在队列后面
+  while (next < iov.size() && conn.output_offset == conn.output.size()) {
+    int count = static_cast<int>(std::min<size_t>(iov.size() - next, IOV_MAX));
+    ssize_t ret = writev(conn.fd, iov.data() + next, count);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      conn.broken = true;
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      stats_.writev_calls++;
+    }
+    // 跳过已写完的 iovec，部分写入的那个调整起点
+    size_t written = static_cast<size_t>(ret);
+    while (next < iov.size() && written >= iov[next].iov_len) {
+      written -= iov[next].iov_len;
+      next++;
+    }
+    if (next < iov.size()) {
+      iov[next].iov_base = static_cast<uint8_t*>(iov[next].iov_base) + written;
+      iov[next].iov_len -= written;
+    }
+  }
+  if (next == iov.size()) {
+    return true;
+  }
+  // 发送缓冲区满：剩余部分拷贝到输出队列，不在调用者的线程里等对端读走
+  size_t pending = conn.output.size() - conn.output_offset;
+  if (pending > config_.max_pending_bytes) {
+    std::cerr << "TcpCommAdapter: " << pending << " bytes pending to "
+              << conn.key << ", closing" << std::endl;
+    conn.broken = true;
+    return false;
+  }
+  if (pending == 0) {
+    conn.output.clear();
+    conn.output_offset = 0;
+    conn.output_progress = std::chrono::steady_clock::now();
+  } else if (conn.output_offset >= pending) {
+    conn.output.erase(conn.output.begin(),
+                      conn.output.begin() + conn.output_offset);
+    conn.output_offset = 0;
+  }
+  for (; next < iov.size(); next++) {
+    const uint8_t* base = static_cast<const uint8_t*>(iov[next].iov_base);
+    conn.output.insert(conn.output.end(), base, base + iov[next].iov_len);
+  }
+  if (pending == 0) {
+    watchWritable_(conn, true);
+  }
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  stats_.queued_batches++;
+  return true;
+}
+
+bool TcpCommAdapter::flush_(Connection& conn) {
+  std::lock_guard<std::mutex> lock(conn.send_mutex);
+  if (conn.broken) {
+    return false;
+  }
+  while (conn.output_offset < conn.output.size()) {
+    ssize_t ret = ::send(conn.fd, conn.output.data() + conn.output_offset,
+                         conn.output.size() - conn.output_offset, MSG_NOSIGNAL);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+      conn.broken = true;
+      return false;
+    }
+    conn.output_offset += ret;
+    conn.output_progress = std::chrono::steady_clock::now();
+  }
+  conn.output.clear();
+  conn.output_offset = 0;
+  watchWritable_(conn, false);
+  return true;
+}
+
+void TcpCommAdapter::watchWritable_(Connection& conn, bool writable) {
+  epoll_event ev;
+  ev.events = EPOLLIN | EPOLLRDHUP;
+  if (writable) {
+    ev.events |= EPOLLOUT;
+  }
+  ev.data.u64 = conn.id;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+void TcpCommAdapter::expireSends_() {
+  std::vector<ConnectionPtr> candidates;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : connections_) {
+      candidates.push_back(entry.second);
+    }
+  }
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& conn : candidates) {
+    bool stalled;
+    {
+      std::lock_guard<std::mutex> lock(conn->send_mutex);
+      stalled = conn->output_offset < conn->output.size() &&
+                now - conn->output_progress >=
+                    std::chrono::milliseconds(config_.send_timeout_ms);
+    }
+    if (!stalled) {
+      continue;
+    }
+    std::cerr << "TcpCommAdapter: send to " << conn->key << " timed out"
+              << std::endl;
+    closeConnection_(conn->id);
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.errors++;
+  }
+}
+
+void TcpCommAdapter::start(ReceiveCallback callback) {
+  if (running_) return;
+  callback_ = std::move(callback);
+  running_ = true;
+  reconnect_();
+  thread_ = std::thread(&TcpCommAdapter::run_, this);
+}
+
+void TcpCommAdapter::stop() {
+  if (!running_) return;
+  running_ = false;
+  uint64_t one = 1;
+  ssize_t ret = write(wake_fd_, &one, sizeof(one));
+  (void)ret;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void TcpCommAdapter::reconnect_() {
+  last_reconnect_ = std::chrono::steady_clock::now();
+  for (const auto& peer : config_.peers) {
+    try {
+      connect_(peer);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+    }
+  }
+}
+
+void TcpCommAdapter::run_() {
+  pthread_setname_np(pthread_self(), "tcp_comm");
+  epoll_event events[64];
+  while (true) {
+    int timeout = static_cast<int>(std::max<uint64_t>(
+        1, std::min(config_.reconnect_ms, config_.connect_timeout_ms)));
+    int ready = epoll_wait(epoll_fd_, events, 64, timeout);
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      std::cerr << "TcpCommAdapter: epoll_wait failed: " << strerror(errno)
+                << std::endl;
+      return;
+    }
+    for (int i = 0; i < ready; i++) {
+      uint64_t tag = events[i].data.u64;
+      if (tag == WAKE_TAG) {
+        uint64_t value;
+        ssize_t ret = read(wake_fd_, &value, sizeof(value));
+        (void)ret;
+        return;
+      }
+      if (tag == LISTEN_TAG) {
+        acceptAll_();
+        continue;
+      }
+      ConnectionPtr conn;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = connections_.find(tag);
+        if (it == connections_.end()) continue;
+        conn = it->second;
+      }
+      if (conn->connecting) {
+        finishConnect_(conn);
+        continue;
+      }
+      bool keep = !(events[i].events & EPOLLERR);
+      if (keep && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) {
+        keep = readConnection_(conn);
+      }
+      if (keep && (events[i].events & EPOLLOUT)) {
+        keep = flush_(*conn);
+      }
+      // 对端关闭：读完已到达的数据后立即注销，发送端不再选中这条连接
+      if (events[i].events & (EPOLLRDHUP | EPOLLHUP)) {
+        keep = false;
+      }
+      if (!keep) {
+        closeConnection_(tag);
+      }
+    }
+    expireConnects_();
+    expireSends_();
+    if (!config_.peers.empty() &&
+        std::chrono::steady_clock::now() - last_reconnect_ >=
+            std::chrono::milliseconds(config_.reconnect_ms)) {
+      reconnect_();
+    }
+  }
+}
+
+void TcpCommAdapter::acceptAll_() {
+  while (true) {
+    int fd =
+        accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        std::cerr << "TcpCommAdapter: accept failed: " << strerror(errno)
+                  << std::endl;
+      }
+      return;
+    }
+    auto conn = std::make_shared<Connection>();
+    conn->fd = fd;
+    setSocketOptions(fd, config_);
+    // 收到对端的握手后才知道它的监听地址，之后才用于发送；
+    // 先加入事件循环，握手没能一次写完时才能关注可写
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      addConnectionLocked_(conn, EPOLLIN | EPOLLRDHUP);
+    }
+    if (!sendHello_(*conn)) {
+      closeConnection_(conn->id);
+      continue;
+    }
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.accepted++;
+  }
+}
+
+bool TcpCommAdapter::readConnection_(const ConnectionPtr& conn) {
+  bool open = true;
+  while (true) {
+    // 至少预留一块；已知当前帧长度时一次留够整帧，大消息不必多次扩容
+    size_t want = TCP_COMM_READ_CHUNK;
+    size_t buffered = conn->input_used - conn->input_offset;
+    if (buffered >= sizeof(TcpFrameHeader)) {
+      TcpFrameHeader header;
+      std::memcpy(&header, conn->input.data() + conn->input_offset,
+                  sizeof(header));
+      size_t frame = sizeof(header) + std::min<size_t>(ntohl(header.length),
+                                                       TCP_COMM_MAX_FRAME);
+      if (frame > buffered) {
+        want = std::max(want, frame - buffered);
+      }
+    }
+    if (conn->input.size() < conn->input_used + want) {
+      conn->input.resize(conn->input_used + want);
+    }
+    size_t space = conn->input.size() - conn->input_used;
+    ssize_t ret =
+        read(conn->fd, conn->input.data() + conn->input_used, space);
+    if (ret > 0) {
+      conn->input_used += ret;
+      {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.bytes_received += ret;
+      }
+      if (!processInput_(*conn)) {
+        return false;
+      }
+      if (static_cast<size_t>(ret) < space) break;
+      continue;
+    }
+    if (ret < 0 && errno == EINTR) continue;
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    open = false;  // 对端关闭或出错
+    break;
+  }
+  return open;
+}
+
+bool TcpCommAdapter::processInput_(Connection& conn) {
+  while (conn.input_used - conn.input_offset >= sizeof(TcpFrameHeader)) {
+    const uint8_t* start = conn.input.data() + conn.input_offset;
+    TcpFrameHeader header;
+    std::memcpy(&header, start, sizeof(header));
+    uint32_t length = ntohl(header.length);
+    uint16_t topic_len = ntohs(header.topic_len);
+    uint16_t event_len = ntohs(header.event_len);
+    if (header.version != TCP_COMM_VERSION || length > TCP_COMM_MAX_FRAME ||
+        static_cast<size_t>(topic_len) + event_len > length) {
+      std::cerr << "TcpCommAdapter: bad frame from "
+                << (conn.key.empty() ? "unknown peer" : conn.key)
+                << ", closing" << std::endl;
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      stats_.errors++;
+      return false;
+    }
+    if (conn.input_used - conn.input_offset < sizeof(header) + length) {
+      break;
+    }
+    const uint8_t* body = start + sizeof(header);
+    conn.input_offset += sizeof(header) + length;
+    if (header.flags & TCP_COMM_FLAG_HELLO) {
+      if (!onHello_(conn, body, length)) {
+        return false;
+      }
+      continue;
+    }
+    // 握手总是连接上的第一帧
+    if (conn.peer_id == 0) {
+      return false;
+    }
+    CommMessage msg;
+    msg.sender_id = conn.peer_id;
+    msg.seq = be64toh(header.seq);
+    msg.segment_size = ntohl(header.segment_size);
+    msg.source_time = 0;
+    msg.topic.assign(reinterpret_cast<const char*>(body), topic_len);
+    msg.event.assign(reinterpret_cast<const char*>(body) + topic_len,
+                     event_len);
+    msg.data = body + topic_len + event_len;
+    msg.size = length - topic_len - event_len;
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      stats_.frames_received++;
+    }
+    if (callback_) {
+      callback_(msg);
+    }
+  }
+  // 未处理完的半帧移到缓冲区开头
+  size_t rest = conn.input_used - conn.input_offset;
+  if (rest == 0) {
+    conn.input_used = 0;
+  } else if (conn.input_offset > 0) {
+    std::memmove(conn.input.data(), conn.input.data() + conn.input_offset,
+                 rest);
+    conn.input_used = rest;
+  }
+  conn.input_offset = 0;
+  return true;
+}
+
+bool TcpCommAdapter::onHello_(Connection& conn, const uint8_t* data,
+                              size_t size) {
+  TcpHello hello;
+  if (size < sizeof(hello)) {
+    return false;
+  }
+  std::memcpy(&hello, data, sizeof(hello));
+  if (ntohl(hello.magic) != TCP_COMM_MAGIC) {
+    return false;
+  }
+  conn.peer_id = be64toh(hello.sender_id);
+  if (conn.peer_id == sender_id_ || conn.peer_id == 0) {
+    return false;  // 连到了自己
+  }
+  if (!conn.key.empty()) {
+    return true;
+  }
+  // 接受的连接：按对端地址和它的监听端口登记，发往该对端的帧复用这条连接
+  sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  if (getpeername(conn.fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+    return false;
+  }
+  char ip[INET_ADDRSTRLEN];
+  inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+  std::string key = std::string(ip) + ":" +
+                    std::to_string(ntohs(hello.listen_port));
+  std::lock_guard<std::mutex> lock(mutex_);
+  conn.key = key;
+  auto it = connections_.find(conn.id);
+  if (it != connections_.end() && peers_.count(key) == 0) {
+    peers_[key] = it->second;
+  }
+  std::cout << "TcpCommAdapter: accepted " << key << std::endl;
+  return true;
+}
@@ -0,0 +1,356 @@
+#include "mini_ros2/message/flat_message.h"
+
+#include <algorithm>
+
+namespace {
+
+size_t alignUp(size_t value, size_t align) {
+  return (value + align - 1) / align * align;
+}
+
+bool isScalarSize(uint8_t size) {
+  return size == 1 || size == 2 || size == 4 || size == 8;
+}
+
+}  // namespace
+
+FlatBuilder::FlatBuilder(size_t initial_capacity)
+    : owned_(std::max<size_t>(initial_capacity, sizeof(FlatHeader))) {
+  buffer_ = owned_.data();
+  capacity_ = owned_.size();
+  size_ = sizeof(FlatHeader);  // 消息头在 finish 时回填
+}
+
+FlatBuilder::FlatBuilder(uint8_t* buffer, size_t capacity)
+    : buffer_(buffer), capacity_(capacity), external_(true) {
+  if (buffer == nullptr || capacity < sizeof(FlatHeader)) {
+    throw std::length_error("FlatBuilder: buffer too small for header");
+  }
+  if (reinterpret_cast<uintptr_t>(buffer) % FLAT_MESSAGE_ALIGN != 0) {
+    throw std::invalid_argument("FlatBuilder: buffer is not 8-byte aligned");
+  }
+  size_ = sizeof(FlatHeader);
+}
+
+void FlatBuilder::reserve_(size_t size) {
+  if (size <= capacity_) {
+    return;
+  }
+  if (external_) {
+    throw std::length_error("FlatBuilder: message needs " +
+                            std::to_string(size) + " bytes, buffer has " +
+                            std::to_string(capacity_));
+  }
+  if (size > UINT32_MAX) {
+    throw std::length_error("FlatBuilder: message exceeds 4GB");
+  }
+  owned_.resize(std::max(size, owned_.size() * 2));
+  buffer_ = owned_.data();
+  capacity_ = owned_.size();
+}
+
+uint32_t FlatBuilder::alloc_(size_t size, size_t align) {
+  size_t pos = alignUp(size_, align);
+  reserve_(pos + size);
+  std::memset(buffer_ + size_, 0, pos - size_);
+  size_ = pos + size;
+  return static_cast<uint32_t>(pos);
+}
+
+uint32_t FlatBuilder::allocVector_(size_t count, size_t elem_size) {
+  checkNotInTable_();
+  // 个数前缀紧挨数据区，数据区按元素大小对齐
+  size_t align = std::max<size_t>(elem_size, sizeof(uint32_t));
+  size_t data_pos = alignUp(size_ + sizeof(uint32_t), align);
+  uint32_t pos = static_cast<uint32_t>(data_pos - sizeof(uint32_t));
+  reserve_(data_pos + elem_size * count);
+  std::memset(buffer_ + size_, 0, pos - size_);
+  size_ = data_pos + elem_size * count;
+  uint32_t n = static_cast<uint32_t>(count);
+  std::memcpy(buffer_ + pos, &n, sizeof(n));
+  return pos;
+}
+
+FlatRef FlatBuilder::createString(std::string_view str) {
+  checkNotInTable_();
+  uint32_t pos = alloc_(sizeof(uint32_t) + str.size() + 1, sizeof(uint32_t));
+  uint32_t len = static_cast<uint32_t>(str.size());
+  std::memcpy(buffer_ + pos, &len, sizeof(len));
+  std::memcpy(buffer_ + pos + sizeof(uint32_t), str.data(), str.size());
+  buffer_[pos + sizeof(uint32_t) + str.size()] = '\0';
+  return FlatRef{pos, FlatFieldKind::String, 1};
+}
+
+FlatRef FlatBuilder::createTableVector(const std::vector<FlatRef>& tables) {
+  for (const auto& table : tables) {
+    if (table.kind != FlatFieldKind::Table) {
+      throw std::invalid_argument("FlatBuilder: table vector needs tables");
+    }
+  }
+  uint32_t pos = allocVector_(tables.size(), sizeof(uint32_t));
+  for (size_t i = 0; i < tables.size(); ++i) {
+    std::memcpy(buffer_ + pos + sizeof(uint32_t) * (i + 1), &tables[i].pos,
+                sizeof(uint32_t));
+  }
+  return FlatRef{pos, FlatFieldKind::TableVector, sizeof(uint32_t)};
+}
+
+void FlatBuilder::startTable() {
+  checkNotInTable_();
+  in_table_ = true;
+  pending_.clear();
+}
+
+void FlatBuilder::addRef(uint16_t id, const FlatRef& ref) {
+  if (ref.kind == FlatFieldKind::Absent || ref.kind == FlatFieldKind::Scalar) {
+    throw std::invalid_argument("FlatBuilder: invalid reference");
+  }
+  PendingField field;
+  field.id = id;
+  field.kind = ref.kind;
+  field.size = sizeof(uint32_t);
+  field.elem_size = ref.elem_size;
+  field.bits = ref.pos;
+  addPending_(field);
+}
+
+void FlatBuilder::addPending_(const PendingField& field) {
+  if (!in_table_) {
+    throw std::logic_error("FlatBuilder: add field outside of a table");
+  }
+  for (const auto& pending : pending_) {
+    if (pending.id == field.id) {
+      throw std::invalid_argument("FlatBuilder: duplicate field id " +
+                                  std::to_string(field.id));
+    }
+  }
+  PendingField copy = field;
+  if (copy.kind == FlatFieldKind::Scalar) {
+    copy.elem_size = copy.size;
+  }
+  pending_.push_back(copy);
+}
+
+FlatRef FlatBuilder::endTable() {
+  if (!in_table_) {
+    throw std::logic_error("FlatBuilder: endTable without startTable");
+  }
+  in_table_ = false;
+
+  uint16_t field_count = 0;
+  for (const auto& field : pending_) {
+    field_count = std::max<uint16_t>(field_count, field.id + 1);
+  }
+  // 字段按大小降序排列，保证每个字段自然对齐且填充最少
+  std::stable_sort(pending_.begin(), pending_.end(),
+                   [](const PendingField& a, const PendingField& b) {
+                     return a.size > b.size;
+                   });
+  std::vector<FlatVTableEntry> entries(field_count, FlatVTableEntry{0, 0, 0});
+  size_t table_size = sizeof(uint32_t);
+  for (const auto& field : pending_) {
+    table_size = alignUp(table_size, field.size);
+    entries[field.id] = FlatVTableEntry{static_cast<uint16_t>(table_size),
+                                        static_cast<uint8_t>(field.kind),
+                                        field.elem_size};
+    table_size += field.size;
+  }
+  if (table_size > UINT16_MAX) {
+    throw std::length_error("FlatBuilder: table too large");
+  }
+
+  uint32_t vtable = alloc_(2 * sizeof(uint16_t) +
+                               sizeof(FlatVTableEntry) * field_count,
+                           sizeof(uint16_t));
+  uint16_t vtable_head[2] = {field_count, static_cast<uint16_t>(table_size)};
+  std::memcpy(buffer_ + vtable, vtable_head, sizeof(vtable_head));
+  if (field_count > 0) {
+    std::memcpy(buffer_ + vtable + sizeof(vtable_head), entries.data(),
+                sizeof(FlatVTableEntry) * field_count);
+  }
+
+  uint32_t table = alloc_(table_size, FLAT_MESSAGE_ALIGN);
+  std::memset(buffer_ + table, 0, table_size);
+  std::memcpy(buffer_ + table, &vtable, sizeof(vtable));
+  for (const auto& field : pending_) {
+    std::memcpy(buffer_ + table + entries[field.id].offset, &field.bits,
+                field.size);
+  }
+  pending_.clear();
+  return FlatRef{table, FlatFieldKind::Table, 0};
+}
+
+size_t FlatBuilder::finish(const FlatRef& root, uint16_t schema_version) {
+  checkNotInTable_();
+  if (root.kind != FlatFieldKind::Table) {
+    throw std::invalid_argument("FlatBuilder: root must be a table");
+  }
+  FlatHeader header;
+  header.magic = FLAT_MESSAGE_MAGIC;
+  header.schema_version = schema_version;
+  header.reserved = 0;
+  header.root = root.pos;
+  header.size = static_cast<uint32_t>(size_);
+  std::memcpy(buffer_, &header, sizeof(header));
+  if (!external_) {
+    owned_.resize(size_);
+    buffer_ = owned_.data();
+    capacity_ = owned_.size();
+  }
+  return size_;
+}
+
+bool FlatVerifier::verify(const uint8_t* data, size_t size,
+                          std::string* error) {
+  FlatVerifier verifier(data, size);
+  bool ok = false;
+  if (data == nullptr || size < sizeof(FlatHeader)) {
+    verifier.fail_("buffer smaller than header");
+  } else {
+    FlatHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != FLAT_MESSAGE_MAGIC) {
+      verifier.fail_("bad magic");
+    } else if (header.size > size || header.size < sizeof(FlatHeader)) {
+      verifier.fail_("bad message size");
+    } else {
+      verifier.size_ = header.size;
+      // 表、vtable 项和表向量元素各至少占 4 字节，访问次数上限与消息大小成正比
+      verifier.budget_ = header.size / sizeof(uint32_t);
+      ok = verifier.verifyTable_(header.root, 0);
+    }
+  }
+  if (!ok && error != nullptr) {
+    *error = verifier.error_;
+  }
+  return ok;
+}
+
+bool FlatVerifier::verifyVector_(uint32_t pos, size_t elem_size) {
+  if (pos % sizeof(uint32_t) != 0 || !inBounds_(pos, sizeof(uint32_t))) {
+    return fail_("vector offset out of bounds");
+  }
+  uint32_t count;
+  std::memcpy(&count, data_ + pos, sizeof(count));
+  size_t data_pos = pos + sizeof(uint32_t);
+  if (elem_size > 1 && data_pos % elem_size != 0) {
+    return fail_("vector data misaligned");
+  }
+  if (!inBounds_(data_pos, static_cast<size_t>(count) * elem_size)) {
+    return fail_("vector data out of bounds");
+  }
+  return true;
+}
+
+bool FlatVerifier::verifyTable_(uint32_t pos, int depth) {
+  if (depth > FLAT_MESSAGE_MAX_DEPTH) {
+    return fail_("nesting too deep");
+  }
+  // 在同样深或更深的位置校验过的子表，现在剩余的嵌套层数不会更少，结果不变
+  auto seen = verified_.find(pos);
+  if (seen != verified_.end() && depth <= seen->second) {
+    return true;
+  }
+  if (!charge_(1)) {
+    return false;
+  }
+  if (pos % FLAT_MESSAGE_ALIGN != 0 || !inBounds_(pos, sizeof(uint32_t))) {
+    return fail_("table offset out of bounds");
+  }
+  uint32_t vtable;
+  std::memcpy(&vtable, data_ + pos, sizeof(vtable));
+  if (vtable % sizeof(uint16_t) != 0 ||
+      !inBounds_(vtable, 2 * sizeof(uint16_t))) {
+    return fail_("vtable offset out of bounds");
+  }
+  uint16_t vtable_head[2];
+  std::memcpy(vtable_head, data_ + vtable, sizeof(vtable_head));
+  uint16_t field_count = vtable_head[0];
+  uint16_t table_size = vtable_head[1];
+  if (!inBounds_(vtable + sizeof(vtable_head),
+                 sizeof(FlatVTableEntry) * field_count)) {
+    return fail_("vtable entries out of bounds");
+  }
+  if (table_size < sizeof(uint32_t) || !inBounds_(pos, table_size)) {
+    return fail_("table body out of bounds");
+  }
+  if (!charge_(field_count)) {
+    return false;
+  }
+
+  for (uint16_t id = 0; id < field_count; ++id) {
+    FlatVTableEntry entry;
+    std::memcpy(&entry,
+                data_ + vtable + sizeof(vtable_head) +
+                    sizeof(FlatVTableEntry) * id,
+                sizeof(entry));
+    if (entry.offset == 0) {
+      continue;
+    }
+    FlatFieldKind kind = static_cast<FlatFieldKind>(entry.kind);
+    size_t field_size =
+        kind == FlatFieldKind::Scalar ? entry.elem_size : sizeof(uint32_t);
+    if (kind == FlatFieldKind::Scalar && !isScalarSize(entry.elem_size)) {
+      return fail_("bad scalar size");
+    }
+    if (entry.offset < sizeof(uint32_t) ||
+        entry.offset + field_size > table_size) {
+      return fail_("field outside of table");
+    }
+    if (kind == FlatFieldKind::Scalar) {
+      continue;
+    }
+    uint32_t ref;
+    std::memcpy(&ref, data_ + pos + entry.offset, sizeof(ref));
+    switch (kind) {
+      case FlatFieldKind::String: {
+        if (!verifyVector_(ref, 1)) {
+          return false;
+        }
+        uint32_t len;
+        std::memcpy(&len, data_ + ref, sizeof(len));
+        if (!inBounds_(ref + sizeof(uint32_t) + len, 1) ||
+            data_[ref + sizeof(uint32_t) + len] != '\0') {
+          return fail_("string not terminated");
+        }
+        break;
+      }
+      case FlatFieldKind::Vector:
+        if (!isScalarSize(entry.elem_size)) {
+          return fail_("bad vector element size");
+        }
+        if (!verifyVector_(ref, entry.elem_size)) {
+          return false;
+        }
+        break;
+      case FlatFieldKind::Table:
+        if (!verifyTable_(ref, depth + 1)) {
+          return false;
+        }
+        break;
+      case FlatFieldKind::TableVector: {
+        if (!verifyVector_(ref, sizeof(uint32_t))) {
+          return false;
+        }
+        uint32_t count;
+        std::memcpy(&count, data_ + ref, sizeof(count));
+        if (!charge_(count)) {
+          return false;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+          uint32_t child;
+          std::memcpy(&child, data_ + ref + sizeof(uint32_t) * (i + 1),
+                      sizeof(child));
+          if (!verifyTable_(child, depth + 1)) {
+            return false;
+          }
+        }
+        break;
+      }
+      default:
+        return fail_("unknown field kind");
+    }
+  }
+  verified_[pos] = depth;
+  return true;
+}
@@ -1,5 +1,10 @@
 #include "mini_ros2/message/json.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
 
 void JsonValue::copyData(const JsonValue& other) {
     switch (other.type_) {
@@ -12,6 +17,9 @@ void JsonValue::copyData(const JsonValue& other) {
         case JsonType::Int:
             data_.int_val = other.data_.int_val;
             break;
+        case JsonType::Int64:
+            data_.int64_val = other.data_.int64_val;
+            break;
         case JsonType::Double:
             data_.double_val = other.data_.double_val;
             break;
@@ -34,60 +42,105 @@ bool JsonValue::isMember(const std::string& key) const {
     return data_.obj_val->find(key) != data_.obj_val->end();
 }
 
+namespace {
+
+// 整数直接写入栈上缓冲区，避免 stringstream 的 locale 和分配开销
+template <typename T>
+void appendInteger(std::string& out, T value) {
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, result.ptr);
+}
+
+// 最短往返表示（libstdc++ 的 to_chars 基于 Ryu）：解析回来与原值逐位相等
+// 无小数点/指数时补 ".0"，保证反序列化后仍为 Double；JSON 不支持 inf/nan，输出 null
+void appendDouble(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out.append("null");
+        return;
+    }
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, result.ptr);
+    if (std::find_if(buf, result.ptr, [](char c) { return c == '.' || c == 'e'; }) ==
+        result.ptr) {
+        out.append(".0");
+    }
+}
+
+void appendEscaped(std::string& out, const std::string& str) {
+    for (char c : str) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b";  break;
+            case '\f': out += "\\f";  break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default:   out += c;
+        }
+    }
+}
+
+}  // namespace
+
 std::string JsonValue::serialize() const {
-    std::stringstream ss;
+    std::string out;
+    serializeTo(out);
+    return out;
+}
+
+void JsonValue::serializeTo(std::string& out) const {
     switch (type_) {
         case JsonType::Null:
-            ss << "null";
+            out.append("null");
             break;
         case JsonType::Bool:
-            ss << (data_.bool_val ? "true" : "false");
+            out.append(data_.bool_val ? "true" : "false");
             break;
         case JsonType::Int:
-            ss << data_.int_val;
+            appendInteger(out, data_.int_val);
+            break;
+        case JsonType::Int64:
+            appendInteger(out, data_.int64_val);
             break;
         case JsonType::Double:
-            ss << data_.double_val;
+            appendDouble(out, data_.double_val);
             break;
         case JsonType::String:
-            ss << "\"" << escapeString(*data_.str_val) << "\"";
+            out.push_back('"');
+            appendEscaped(out, *data_.str_val);
+            out.push_back('"');
             break;
         case JsonType::Array:
-            ss << "[";
+            out.push_back('[');
             for (size_t i = 0; i < data_.arr_val->size(); ++i) {
-                if (i > 0) ss << ",";
-                ss << (*data_.arr_val)[i].serialize();
+                if (i > 0) out.push_back(',');
+                (*data_.arr_val)[i].serializeTo(out);
             }
-            ss << "]";
+            out.push_back(']');
             break;
-        case JsonType::Object:
-            ss << "{";
+        case JsonType::Object: {
+            out.push_back('{');
             size_t i = 0;
             for (const auto& pair : *data_.obj_val) {
-                if (i > 0) ss << ",";
-                ss << "\"" << escapeString(pair.first) << "\":" << pair.second.serialize();
+                if (i > 0) out.push_back(',');
+                out.push_back('"');
+                appendEscaped(out, pair.first);
+                out.append("\":");
+                pair.second.serializeTo(out);
                 ++i;
             }
-            ss << "}";
+            out.push_back('}');
             break;
+        }
     }
-    return ss.str();
 }
 
 std::string JsonValue::escapeString(const std::string& str) const {
     std::string res;
-    for (char c : str) {
-        switch (c) {
-            case '"':  res += "\\\""; break;
-            case '\\': res += "\\\\"; break;
-            case '\b': res += "\\b";  break;
-            case '\f': res += "\\f";  break;
-            case '\n': res += "\\n";  break;
-            case '\r': res += "\\r";  break;
-            case '\t': res += "\\t";  break;
-            default:   res += c;
-        }
-    }
+    appendEscaped(res, str);
     return res;
 }
 
@@ -190,18 +243,27 @@ JsonValue JsonValue::parseNumber(const std::string& json, size_t& index) {
         }
     }
 
-    // 截取数字字符串，转换为int或double
-    std::string num_str = json.substr(start, index - start);
-    if (is_double) {
-        return JsonValue(std::stod(num_str)); // 转为double
-    } else {
-        // 检查是否超出int范围（可选，根据需求调整）
-        long long num = std::stoll(num_str);
-        if (num < INT_MIN || num > INT_MAX) {
-            throw std::invalid_argument("Json deserialize: number " + num_str + " out of int range");
+    // 用 from_chars 直接在原串上转换，不构造临时字符串，也不受 locale 影响
+    const char* first = json.data() + start;
+    const char* last = json.data() + index;
+    if (!is_double) {
+        int64_t num = 0;
+        auto result = std::from_chars(first, last, num);
+        if (result.ec == std::errc() && result.ptr == last) {
+            if (num >= INT_MIN && num <= INT_MAX) {
+                return JsonValue(static_cast<int>(num));
+            }
+            return JsonValue(num);
         }
-        return JsonValue(static_cast<int>(num)); // 转为int
+        // 超出 int64 范围的整数按 double 处理
+    }
+    double value = 0;
+    auto result = std::from_chars(first, last, value);
+    if (result.ec != std::errc() || result.ptr != last) {
+        throw std::invalid_argument("Json deserialize: number " + std::string(first, last) +
+                                    " out of range");
     }
+    return JsonValue(value);
 }
 
 // 解析数组（[]包裹）
@@ -344,6 +406,346 @@ JsonValue JsonValue::deserialize(const std::string& json) {
     }
     return root;
 }
+
+// ------------------------------ 二进制编码（MessagePack 兼容） ------------------------------
+// 帧格式：[JSON_BINARY_MAGIC][JSON_BINARY_VERSION][MessagePack 值]
+// 多字节长度/数值按 MessagePack 规范使用大端序
+namespace {
+
+void putBigEndian(std::string& out, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i) {
+        out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+uint64_t getBigEndian(const uint8_t* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+void encodeInteger(std::string& out, int64_t value) {
+    if (value >= 0 && value <= 0x7F) {
+        out.push_back(static_cast<char>(value));           // positive fixint
+    } else if (value < 0 && value >= -32) {
+        out.push_back(static_cast<char>(value));           // negative fixint
+    } else if (value >= INT8_MIN && value <= INT8_MAX) {
+        out.push_back('\xd0');
+        putBigEndian(out, static_cast<uint8_t>(value), 1);
+    } else if (value >= INT16_MIN && value <= INT16_MAX) {
+        out.push_back('\xd1');
+        putBigEndian(out, static_cast<uint16_t>(value), 2);
+    } else if (value >= INT32_MIN && value <= INT32_MAX) {
+        out.push_back('\xd2');
+        putBigEndian(out, static_cast<uint32_t>(value), 4);
+    } else {
+        out.push_back('\xd3');
+        putBigEndian(out, static_cast<uint64_t>(value), 8);
+    }
+}
+
+void encodeStringHeader(std::string& out, size_t len) {
+    if (len <= 31) {
+        out.push_back(static_cast<char>(0xA0 | len));
+    } else if (len <= 0xFF) {
+        out.push_back('\xd9');
+        putBigEndian(out, len, 1);
+    } else if (len <= 0xFFFF) {
+        out.push_back('\xda');
+        putBigEndian(out, len, 2);
+    } else {
+        out.push_back('\xdb');
+        putBigEndian(out, len, 4);
+    }
+}
+
+void encodeContainerHeader(std::string& out, size_t count, bool is_map) {
+    if (count <= 15) {
+        out.push_back(static_cast<char>((is_map ? 0x80 : 0x90) | count));
+    } else if (count <= 0xFFFF) {
+        out.push_back(is_map ? '\xde' : '\xdc');
+        putBigEndian(out, count, 2);
+    } else {
+        out.push_back(is_map ? '\xdf' : '\xdd');
+        putBigEndian(out, count, 4);
+    }
+}
+
+void requireBytes(size_t size, size_t index, size_t need) {
+    if (need > size || index > size - need) {
+        throw std::invalid_argument("Json binary: unexpected end of input at index " +
+                                    std::to_string(index));
+    }
+}
+
+// 解析类型字节，返回字符串/容器的长度（其他类型返回0），index 指向负载
+// kind: 's' 字符串/二进制, 'a' 数组, 'm' 对象, 其余为标量
+size_t readLength(const uint8_t* data, size_t size, size_t& index, uint8_t tag, char& kind) {
+    auto read = [&](int bytes) {
+        requireBytes(size, index, bytes);
+        size_t len = static_cast<size_t>(getBigEndian(data + index, bytes));
+        index += bytes;
+        return len;
+    };
+    if ((tag & 0xE0) == 0xA0) { kind = 's'; return tag & 0x1F; }
+    if ((tag & 0xF0) == 0x90) { kind = 'a'; return tag & 0x0F; }
+    if ((tag & 0xF0) == 0x80) { kind = 'm'; return tag & 0x0F; }
+    switch (tag) {
+        case 0xd9: case 0xc4: kind = 's'; return read(1);
+        case 0xda: case 0xc5: kind = 's'; return read(2);
+        case 0xdb: case 0xc6: kind = 's'; return read(4);
+        case 0xdc: kind = 'a'; return read(2);
+        case 0xdd: kind = 'a'; return read(4);
+        case 0xde: kind = 'm'; return read(2);
+        case 0xdf: kind = 'm'; return read(4);
+        default: kind = 0; return 0;
+    }
+}
+
+}  // namespace
+
+void JsonValue::encodeBinary(std::string& out) const {
+    switch (type_) {
+        case JsonType::Null:
+            out.push_back('\xc0');
+            break;
+        case JsonType::Bool:
+            out.push_back(data_.bool_val ? '\xc3' : '\xc2');
+            break;
+        case JsonType::Int:
+            encodeInteger(out, data_.int_val);
+            break;
+        case JsonType::Int64:
+            encodeInteger(out, data_.int64_val);
+            break;
+        case JsonType::Double: {
+            uint64_t bits;
+            std::memcpy(&bits, &data_.double_val, sizeof(bits));
+            out.push_back('\xcb');
+            putBigEndian(out, bits, 8);
+            break;
+        }
+        case JsonType::String:
+            encodeStringHeader(out, data_.str_val->size());
+            out.append(*data_.str_val);
+            break;
+        case JsonType::Array:
+            encodeContainerHeader(out, data_.arr_val->size(), false);
+            for (const auto& item : *data_.arr_val) {
+                item.encodeBinary(out);
+            }
+            break;
+        case JsonType::Object:
+            encodeContainerHeader(out, data_.obj_val->size(), true);
+            for (const auto& pair : *data_.obj_val) {
+                encodeStringHeader(out, pair.first.size());
+                out.append(pair.first);
+                pair.second.encodeBinary(out);
+            }
+            break;
+    }
+}
+
+std::string JsonValue::serializeBinary() const {
+    std::string out;
+    out.reserve(64);
+    out.push_back(static_cast<char>(JSON_BINARY_MAGIC));
+    out.push_back(static_cast<char>(JSON_BINARY_VERSION));
+    encodeBinary(out);
+    return out;
+}
+
+JsonValue JsonValue::parseBinary(const uint8_t* data, size_t size, size_t& index, int depth) {
+    if (depth > JSON_BINARY_MAX_DEPTH) {
+        throw std::invalid_argument("Json binary: nesting too deep");
+    }
+    requireBytes(size, index, 1);
+    uint8_t tag = data[index++];
+    if (tag <= 0x7F) {
+        return JsonValue(static_cast<int>(tag));
+    }
+    if (tag >= 0xE0) {
+        return JsonValue(static_cast<int>(static_cast<int8_t>(tag)));
+    }
+    char kind = 0;
+    size_t len = readLength(data, size, index, tag, kind);
+    if (kind == 's') {
+        requireBytes(size, index, len);
+        JsonValue value(std::string(reinterpret_cast<const char*>(data + index), len));
+        index += len;
+        return value;
+    }
+    if (kind == 'a') {
+        JsonValue arr;
+        arr.type_ = JsonType::Array;
+        arr.data_.arr_val = new JsonArray();
+        arr.data_.arr_val->reserve(std::min(len, size - index));  // 每个元素至少 1 字节
+        for (size_t i = 0; i < len; ++i) {
+            arr.data_.arr_val->push_back(parseBinary(data, size, index, depth + 1));
+        }
+        return arr;
+    }
+    if (kind == 'm') {
+        JsonValue obj;
+        obj.type_ = JsonType::Object;
+        obj.data_.obj_val = new JsonObject();
+        for (size_t i = 0; i < len; ++i) {
+            JsonValue key = parseBinary(data, size, index, depth + 1);
+            if (!key.isString()) {
+                throw std::invalid_argument("Json binary: object key must be a string");
+            }
+            (*obj.data_.obj_val)[key.asString()] = parseBinary(data, size, index, depth + 1);
+        }
+        return obj;
+    }
+
+    auto read = [&](int bytes) {
+        requireBytes(size, index, bytes);
+        uint64_t raw = getBigEndian(data + index, bytes);
+        index += bytes;
+        return raw;
+    };
+    // 与文本解析一致：int 范围内为 Int，否则为 Int64
+    auto toInt = [](int64_t value) {
+        if (value < INT_MIN || value > INT_MAX) {
+            return JsonValue(value);
+        }
+        return JsonValue(static_cast<int>(value));
+    };
+    switch (tag) {
+        case 0xc0: return JsonValue();
+        case 0xc2: return JsonValue(false);
+        case 0xc3: return JsonValue(true);
+        case 0xcc: return toInt(static_cast<int64_t>(read(1)));
+        case 0xcd: return toInt(static_cast<int64_t>(read(2)));
+        case 0xce: return toInt(static_cast<int64_t>(read(4)));
+        case 0xcf: {
+            uint64_t value = read(8);
+            if (value > static_cast<uint64_t>(INT64_MAX)) {
+                throw std::invalid_argument("Json binary: uint64 out of range");
+            }
+            return toInt(static_cast<int64_t>(value));
+        }
+        case 0xd0: return toInt(static_cast<int8_t>(read(1)));
+        case 0xd1: return toInt(static_cast<int16_t>(read(2)));
+        case 0xd2: return toInt(static_cast<int32_t>(read(4)));
+        case 0xd3: return toInt(static_cast<int64_t>(read(8)));
+        case 0xca: {
+            uint32_t bits = static_cast<uint32_t>(read(4));
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return JsonValue(static_cast<double>(value));
+        }
+        case 0xcb: {
+            uint64_t bits = read(8);
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return JsonValue(value);
+        }
+        default:
+            throw std::invalid_argument("Json binary: unsupported type byte " +
+                                        std::to_string(tag) + " at index " +
+                                        std::to_string(index - 1));
+    }
+}
+
+void JsonValue::skipBinary(const uint8_t* data, size_t size, size_t& index, int depth) {
+    if (depth > JSON_BINARY_MAX_DEPTH) {
+        throw std::invalid_argument("Json binary: nesting too deep");
+    }
+    requireBytes(size, index, 1);
+    uint8_t tag = data[index++];
+    if (tag <= 0x7F || tag >= 0xE0 || tag == 0xc0 || tag == 0xc2 || tag == 0xc3) {
+        return;
+    }
+    char kind = 0;
+    size_t len = readLength(data, size, index, tag, kind);
+    if (kind == 's') {
+        requireBytes(size, index, len);
+        index += len;  // 字符串直接按长度跳过
+        return;
+    }
+    if (kind == 'a' || kind == 'm') {
+        size_t count = kind == 'm' ? len * 2 : len;
+        for (size_t i = 0; i < count; ++i) {
+            skipBinary(data, size, index, depth + 1);
+        }
+        return;
+    }
+    size_t width = 0;
+    switch (tag) {
+        case 0xcc: case 0xd0: width = 1; break;
+        case 0xcd: case 0xd1: width = 2; break;
+        case 0xce: case 0xd2: case 0xca: width = 4; break;
+        case 0xcf: case 0xd3: case 0xcb: width = 8; break;
+        default:
+            throw std::invalid_argument("Json binary: unsupported type byte " +
+                                        std::to_string(tag));
+    }
+    requireBytes(size, index, width);
+    index += width;
+}
+
+JsonValue JsonValue::deserializeBinary(const uint8_t* data, size_t size) {
+    if (!isBinaryEncoded(data, size)) {
+        throw std::invalid_argument("Json binary: missing frame header");
+    }
+    if (data[1] != JSON_BINARY_VERSION) {
+        throw std::invalid_argument("Json binary: unsupported version " + std::to_string(data[1]));
+    }
+    size_t index = 2;
+    // 只解析一个根值，尾部数据（共享内存中的残留）忽略
+    return parseBinary(data, size, index, 0);
+}
+
+bool JsonValue::findBinaryMember(const uint8_t* data, size_t size,
+                                 const std::string& key, JsonValue& out) {
+    if (!isBinaryEncoded(data, size) || data[1] != JSON_BINARY_VERSION) {
+        return false;
+    }
+    size_t index = 2;
+    requireBytes(size, index, 1);
+    uint8_t tag = data[index++];
+    char kind = 0;
+    size_t count = readLength(data, size, index, tag, kind);
+    if (kind != 'm') {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        requireBytes(size, index, 1);
+        uint8_t key_tag = data[index++];
+        size_t key_len = readLength(data, size, index, key_tag, kind);
+        if (kind != 's') {
+            throw std::invalid_argument("Json binary: object key must be a string");
+        }
+        requireBytes(size, index, key_len);
+        bool match = key_len == key.size() &&
+                     std::memcmp(data + index, key.data(), key_len) == 0;
+        index += key_len;
+        if (match) {
+            out = parseBinary(data, size, index, 1);
+            return true;
+        }
+        skipBinary(data, size, index, 1);
+    }
+    return false;
+}
+
+JsonValue JsonValue::decode(const uint8_t* data, size_t size) {
+    if (data == nullptr) {
+        throw std::invalid_argument("Json decode: null buffer");
+    }
+    if (isBinaryEncoded(data, size)) {
+        return deserializeBinary(data, size);
+    }
+    // 文本编码：共享内存区可能比消息长，遇到 '\0' 即截断
+    const char* text = reinterpret_cast<const char*>(data);
+    const void* end = std::memchr(text, '\0', size);
+    size_t len = end ? static_cast<const char*>(end) - text : size;
+    return deserialize(std::string(text, len));
+}
 /*
 // 类型转换实现
 bool JsonValue::asBool() const {
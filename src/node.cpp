@@ -24,7 +24,9 @@ void Node::signalHandler(int signum) {
     }
     std::cout << "Signal received,exiting normally to allow cleanup signame: "
               << signame << std::endl;
-    signal_handler_node_->stop();
+    // 信号可能打断正持有共享内存锁或在线程池中执行的线程，这里只清除 spinning_，
+    // 不加锁也不等待线程；spinLoop 在一个等待周期（最多 100ms）内退出，其余清理交给析构函数
+    signal_handler_node_->spinning_ = false;
     // signal_handler_node_->unregisterNode();
 
     // 确保资源清理完成后再退出
@@ -36,14 +38,18 @@ Node::Node(const std::string& node_name, const std::string& name_space,
            int domain_id)
     : node_name_(node_name), name_space_(name_space), domain_id_(domain_id) {
   // 初始化共享内存前缀（结合命名空间和域ID，避免冲突）
-  std::string name = name_space.empty() ? name_space_ : name_space + "_";
-  shm_prefix_ = "/" + std::to_string(domain_id_) + "_" + name;
-  shm_manager_ = std::make_shared<ShmManager>();
+  // 注册表和事件通知段按域分区，不同域的节点互不争锁、互不唤醒
+  RegistryConfig config = RegistryConfig::fromEnv();
+  config.domain_id = domain_id_;
+  config.name_space = name_space_;
+  shm_prefix_ = config.topicPrefix();
+  shm_manager_ = std::make_shared<ShmManager>(config);
   signal(SIGINT, Node::signalHandler);
   signal(SIGTERM, Node::signalHandler);
   signal(SIGTSTP, Node::signalHandler);
   signal_handler_node_ = this;
   registerNode();
+  startHeartbeat();
   thread_pool_ = std::make_shared<ThreadPool>(4);
   std::cout << "Node constructor: " << node_name_ << std::endl;
 }
@@ -52,14 +58,18 @@ Node::Node(const std::string&& node_name, const std::string&& name_space,
            int domain_id)
     : node_name_(node_name), name_space_(name_space), domain_id_(domain_id) {
   // 初始化共享内存前缀（结合命名空间和域ID，避免冲突）
-  std::string name = name_space.empty() ? name_space_ : name_space + "_";
-  shm_prefix_ = "/" + std::to_string(domain_id_) + "_" + name;
-  shm_manager_ = std::make_shared<ShmManager>();
+  // 注册表和事件通知段按域分区，不同域的节点互不争锁、互不唤醒
+  RegistryConfig config = RegistryConfig::fromEnv();
+  config.domain_id = domain_id_;
+  config.name_space = name_space_;
+  shm_prefix_ = config.topicPrefix();
+  shm_manager_ = std::make_shared<ShmManager>(config);
   signal(SIGINT, Node::signalHandler);
   signal(SIGTERM, Node::signalHandler);
   signal(SIGTSTP, Node::signalHandler);
   signal_handler_node_ = this;
   registerNode();
+  startHeartbeat();
   std::cout << "after registerNode" << std::endl;
   thread_pool_ = std::make_shared<ThreadPool>(4);
   std::cout << "Node constructor: " << node_name_ << std::endl;
@@ -70,26 +80,22 @@ void Node::registerNode() {
   std::cout << "registerNode: " << node_name_ << std::endl;
   if (!shm_manager_) return;
 
-  // 检查节点数量限制
-  if (shm_manager_->getAliveNodeCount() >= MAX_NODE_COUNT) {
-    std::cerr << "Maximum node count reached" << std::endl;
-    return;
-  }
-
   // 分配节点ID
   node_id_ = shm_manager_->getNextNodeId();
   shm_manager_->setNodeId(node_id_);
   if (node_id_ == -1) {
-    std::cerr << "No free slot for new node" << std::endl;
+    // 节点表已增长到 REGISTRY_MAX_SEGMENTS 段上限
+    std::cerr << "Maximum node count reached" << std::endl;
     return;
   }
   // 找到空闲位置
   NodeInfo new_node;
+  std::memset(&new_node, 0, sizeof(new_node));
   // 填充节点信息
   new_node.node_id = node_id_;
   std::strcpy(new_node.node_name, node_name_.c_str());
   new_node.pid = getpid();
-  new_node.last_heartbeat = time(nullptr);
+  new_node.last_heartbeat = ShmManager::heartbeatNow();
   new_node.is_alive = true;
   // 更新活跃节点计数
   shm_manager_->addNode(new_node);
@@ -109,7 +115,11 @@ void Node::unregisterNode() {
 // 析构函数
 Node::~Node() {
   // 停止心跳
-  heartbeat_running_ = false;
+  {
+    std::lock_guard<std::mutex> lock(heartbeat_mutex_);
+    heartbeat_running_ = false;
+  }
+  heartbeat_cv_.notify_all();
   if (heartbeat_thread_.joinable()) {
     heartbeat_thread_.join();
   }
@@ -130,17 +140,32 @@ Node::~Node() {
   }
 }
 
-// 心跳循环
+// 注册成功后启动心跳线程
+void Node::startHeartbeat() {
+  if (!shm_manager_ || static_cast<int>(node_id_) < 0) return;
+  heartbeat_running_ = true;
+  heartbeat_thread_ = std::thread(&Node::heartbeatLoop, this);
+}
+
+// 心跳循环：无锁写入本节点的心跳时间戳，并定期回收进程已退出的节点
 void Node::heartbeatLoop() {
+  pthread_setname_np(pthread_self(), "heartbeat");
+  auto next_reap = std::chrono::steady_clock::now();
   while (heartbeat_running_) {
-    if (shm_manager_ && node_id_ != 0) {
-      if (shm_manager_->isNodeAlive()) {
-        shm_manager_->updateNodeHeartbeat();
-        break;
+    try {
+      shm_manager_->updateNodeHeartbeat();
+      auto now = std::chrono::steady_clock::now();
+      if (now >= next_reap) {
+        shm_manager_->reapDeadNodes();
+        next_reap = now + std::chrono::seconds(HEARTBEAT_TIMEOUT);
       }
+    } catch (const std::exception& e) {
+      std::cerr << "heartbeat error: " << e.what() << std::endl;
     }
-    // 等待心跳间隔
-    std::this_thread::sleep_for(std::chrono::seconds(HEARTBEAT_INTERVAL));
+    // 等待心跳间隔，析构时被唤醒立即退出
+    std::unique_lock<std::mutex> lock(heartbeat_mutex_);
+    heartbeat_cv_.wait_for(lock, std::chrono::seconds(HEARTBEAT_INTERVAL),
+                           [this]() { return !heartbeat_running_; });
   }
 }
 
@@ -161,8 +186,7 @@ void Node::spinLoop() {
     //    不再需要复杂的锁管理，事件通知和注册表已分离
     uint64_t timeout = std::min(min_timer_period_,
                                 static_cast<uint64_t>(100));  // 最多等待100ms
-    std::bitset<EVENT_MAX_COUNT> trigger_event =
-        shm_manager_->waitForEvent(timeout);
+    EventFlags trigger_event = shm_manager_->waitForEvent(timeout);
 
     // 检查是否应该退出（在等待期间 spinning_ 可能被设置为 false）
     if (!spinning_) {
@@ -195,8 +219,7 @@ void Node::spinLoop() {
           int event_id = subscription_event_ids_[id];
           std::cout << "  subscription[" << id << "] event_id: " << event_id
                     << std::endl;
-          if (event_id >= 0 &&
-              event_id < EVENT_MAX_COUNT) {  // 假设使用 32 位整数
+          if (event_id >= 0) {  // 超出当前事件容量的 id 视为未触发
             // 检查对应的位是否被设置
             bool is_triggered = trigger_event[event_id];
             std::cout << "    bit " << event_id << " is "
@@ -233,9 +256,9 @@ void Node::spinLoop() {
     }
     // 解锁 ShmManager（允许其他线程更新注册表或触发事件）
     shm_manager_->shmManagerUnlockRegistry();
-    if (trigger_event[EVENT_MAX_COUNT - 1]) {
+    if (trigger_event[REGISTRY_CHANGED_EVENT_ID]) {
       shm_manager_->syncRegistryFromShm();
-      shm_manager_->clearTriggerEvent(EVENT_MAX_COUNT - 1);
+      shm_manager_->clearTriggerEvent(REGISTRY_CHANGED_EVENT_ID);
     }
     // std::cout << "timer" << std::endl;
     for (auto& timer : timers_) {
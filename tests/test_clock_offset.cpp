@@ -0,0 +1,194 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "mini_ros2/communication/comm_adapter.h"
+#include "mini_ros2/communication/socket_comm.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "test_utils.h"
+#include "udp_test_utils.h"
+
+// 模拟的主机间时钟差
+#define SKEW_US 250000
+#define DRIFT_PPM 300.0
+#define MESSAGES 50
+
+using Clock = std::chrono::steady_clock;
+
+static bool waitUntil(const std::function<bool()>& done, int timeout_ms) {
+  Clock::time_point deadline =
+      Clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!done()) {
+    if (Clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  return true;
+}
+
+static UdpCommConfig loopbackConfig(uint16_t port) {
+  UdpCommConfig config;
+  config.multicast_port = port;
+  config.interface_address = "127.0.0.1";
+  config.clock_sync_ms = 20;
+  return config;
+}
+
+// 对端时钟快 250 ms、每秒再快 300 us：偏移和漂移都能估计出来，双方的估计互为相反数
+static void offsetAndDrift(uint16_t port) {
+  UdpCommAdapter local(loopbackConfig(port));
+  UdpCommConfig skewed = loopbackConfig(port);
+  skewed.clock_skew_us = SKEW_US;
+  skewed.clock_drift_ppm = DRIFT_PPM;
+  Clock::time_point created = Clock::now();
+  UdpCommAdapter remote(skewed);
+  local.start([](const CommMessage&) {});
+  remote.start([](const CommMessage&) {});
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+  PeerClock clock;
+  CHECK(local.peerClock(remote.senderId(), clock));
+  double elapsed_s =
+      std::chrono::duration<double>(Clock::now() - created).count();
+  double expected_ns = SKEW_US * 1000.0 + DRIFT_PPM * 1000.0 * elapsed_s;
+  std::cout << "offset " << clock.offset_ns / 1000.0 << " us (expected "
+            << expected_ns / 1000.0 << "), drift " << clock.drift_ppm
+            << " ppm, round trip " << clock.round_trip_ns / 1000.0 << " us, "
+            << clock.samples << " samples" << std::endl;
+  CHECK(std::abs(clock.offset_ns - expected_ns) < 300 * 1000);
+  CHECK(std::abs(clock.drift_ppm - DRIFT_PPM) < 60);
+  CHECK(clock.round_trip_ns > 0);
+
+  PeerClock reverse;
+  CHECK(remote.peerClock(local.senderId(), reverse));
+  CHECK(std::abs(reverse.offset_ns + clock.offset_ns) < 300 * 1000);
+  remote.stop();
+  local.stop();
+}
+
+static RegistryConfig domainConfig(int domain_id) {
+  RegistryConfig config;
+  config.domain_id = domain_id;
+  return config;
+}
+
+// 发送端时钟慢 250 ms：不换算时延迟会多算 250 ms，换算后是真实的回环延迟
+static void crossHostLatency(uint16_t port) {
+  UdpCommConfig receiver_config = loopbackConfig(port);
+  auto receiver_adapter = std::make_unique<UdpCommAdapter>(receiver_config);
+  UdpCommAdapter& receiver_udp = *receiver_adapter;
+  CommGateway receiver(domainConfig(81), std::move(receiver_adapter));
+  receiver.addImport("odom", "data");
+  receiver.start();
+
+  UdpCommConfig sender_config = loopbackConfig(port);
+  sender_config.clock_skew_us = -SKEW_US;
+  auto sender_adapter = std::make_unique<UdpCommAdapter>(sender_config);
+  uint64_t sender_id = sender_adapter->senderId();
+  CommGateway sender(domainConfig(80), std::move(sender_adapter));
+  sender.addExport("odom", "data");
+  sender.start();
+  PeerClock clock;
+  CHECK(waitUntil([&]() { return receiver_udp.peerClock(sender_id, clock); },
+                  1000));
+
+  ShmManager local(domainConfig(80));
+  local.setNodeId(local.getNextNodeId());
+  std::string topic = domainConfig(80).topicPrefix() + "odom";
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&local);
+  pub.setTopicNameForEvent(topic);
+  for (int i = 0; i < MESSAGES; i++) {
+    pub.publishLoaned("data", 32, [i](uint8_t* buffer, size_t) {
+      std::memcpy(buffer, &i, sizeof(i));
+      return sizeof(i);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  CHECK(waitUntil(
+      [&]() {
+        return receiver.getStats().received == sender.getStats().sent;
+      },
+      1000));
+  CommStats stats = receiver.getStats();
+  CHECK(stats.latency_count == stats.received);
+  uint64_t mean_us = stats.latency_sum_us / stats.latency_count;
+  std::cout << "latency across skewed clocks: mean " << mean_us
+            << " us, max " << stats.latency_max_us << " us over "
+            << stats.latency_count << " messages" << std::endl;
+  CHECK(mean_us < 20000);
+  CHECK(stats.latency_max_us < SKEW_US / 2);
+  sender.stop();
+  receiver.stop();
+}
+
+// 关闭时钟同步后不做换算，不统计延迟
+static void syncDisabled(uint16_t port) {
+  UdpCommConfig config = loopbackConfig(port);
+  config.clock_sync_ms = 0;
+  UdpCommAdapter local(config);
+  UdpCommAdapter remote(config);
+  uint64_t source_time = 1;
+  local.start([&source_time](const CommMessage& msg) {
+    source_time = msg.source_time;
+  });
+  remote.start([](const CommMessage&) {});
+  uint64_t value = 7;
+  CommFrame frame;
+  frame.topic = "odom";
+  frame.event = "data";
+  frame.seq = 1;
+  frame.timestamp = 123456;
+  frame.data = reinterpret_cast<const uint8_t*>(&value);
+  frame.size = sizeof(value);
+  frame.dest = local.localEndpoint();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  CHECK(remote.send(frame));
+  CHECK(waitUntil([&]() { return source_time != 1; }, 1000));
+  CHECK(source_time == 0);
+  CHECK(local.peerClocks().empty());
+  remote.stop();
+  local.stop();
+}
+
+// Pong 回到 Ping 的源地址，而不是 Ping 中自报的地址
+static void pongToSource(uint16_t port) {
+  UdpCommAdapter responder(loopbackConfig(port));
+  responder.start([](const CommMessage&) {});
+  RawUdpPeer initiator;
+  const uint64_t initiator_id = 4343;
+  UdpClockPing ping;
+  std::memset(&ping, 0, sizeof(ping));
+  ping.t1 = static_cast<int64_t>(htobe64(42));
+  ping.reply_addr = inet_addr("192.0.2.1");
+  ping.reply_port = htons(9);
+  initiator.sendTo(responder.localEndpoint(),
+                   RawUdpPeer::frame("", "", UDP_COMM_FLAG_PING, initiator_id,
+                                     0, &ping, sizeof(ping)));
+  std::vector<uint8_t> packet;
+  CHECK(initiator.receive(UDP_COMM_FLAG_PONG, packet, 1000));
+  UdpClockPong pong;
+  CHECK(packet.size() == sizeof(UdpFrameHeader) + sizeof(pong));
+  std::memcpy(&pong, packet.data() + sizeof(UdpFrameHeader), sizeof(pong));
+  CHECK(be64toh(pong.target_id) == initiator_id);
+  CHECK(static_cast<int64_t>(be64toh(pong.t1)) == 42);
+  responder.stop();
+}
+
+int main() {
+  uint16_t port = static_cast<uint16_t>(20000 + getpid() % 20000);
+  offsetAndDrift(port);
+  crossHostLatency(port + 1);
+  syncDisabled(port + 2);
+  pongToSource(port + 3);
+  std::cout << "test_clock_offset passed" << std::endl;
+  return 0;
+}
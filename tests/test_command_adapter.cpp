@@ -0,0 +1,536 @@
+#include <arpa/inet.h>
+#include <endian.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mini_ros2/communication/comm_adapter.h"
+#include "mini_ros2/communication/shm_manager.h"
+#include "mini_ros2/communication/socket_comm.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "test_utils.h"
+#include "udp_test_utils.h"
+
+// 每个进程代表一台"主机"：各自使用不同的域，只通过 UDP（回环接口）交换消息
+#define MESSAGE_COUNT 20
+
+using Clock = std::chrono::steady_clock;
+
+static RegistryConfig domainConfig(int domain_id) {
+  RegistryConfig config;
+  config.domain_id = domain_id;
+  return config;
+}
+
+static UdpCommConfig loopbackConfig(uint16_t port, size_t mtu = 1500) {
+  UdpCommConfig config;
+  config.interface_address = "127.0.0.1";
+  config.multicast_port = port;
+  config.mtu = mtu;
+  return config;
+}
+
+static std::unique_ptr<CommGateway> makeGateway(int domain_id, uint16_t port,
+                                                size_t mtu = 1500) {
+  return std::make_unique<CommGateway>(
+      domainConfig(domain_id),
+      std::make_unique<UdpCommAdapter>(loopbackConfig(port, mtu)));
+}
+
+static void publishText(Publisher<JsonValue>& pub, const std::string& text) {
+  pub.publishLoaned("data", 64, [&text](uint8_t* buffer, size_t) {
+    std::strcpy(reinterpret_cast<char*>(buffer), text.c_str());
+    return text.size() + 1;
+  });
+}
+
+static bool waitUntil(const std::function<bool()>& done, int timeout_ms) {
+  Clock::time_point deadline =
+      Clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!done()) {
+    if (Clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  return true;
+}
+
+// 子进程：导入 topic，收到 expected 条后检查本地数据段和事件位；返回退出码
+// ready 管道写入本端单播端口，通知父进程可以开始发送
+static int receiverMain(int domain_id, uint16_t port, const char* topic,
+                        int expected, const std::string& last, int ready_fd) {
+  auto gateway = makeGateway(domain_id, port);
+  gateway->addImport(topic, "data");
+  gateway->start();
+  uint16_t unicast_port = gateway->adapter().localEndpoint().port;
+  CHECK(write(ready_fd, &unicast_port, sizeof(unicast_port)) ==
+        sizeof(unicast_port));
+  close(ready_fd);
+
+  if (expected > 0) {
+    waitUntil(
+        [&]() {
+          return gateway->getStats().received >=
+                 static_cast<uint64_t>(expected);
+        },
+        5000);
+  } else {
+    // 不应收到任何消息：等待足够长的时间再检查
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+  CommStats stats = gateway->getStats();
+  std::cout << "receiver domain " << domain_id << " got " << stats.received
+            << " frames, lost " << stats.lost << std::endl;
+  CHECK(stats.received == static_cast<uint64_t>(expected));
+  CHECK(stats.lost == 0);
+  if (expected > 0) {
+    std::string local_topic = domainConfig(domain_id).topicPrefix() + topic;
+    ShmManager local(domainConfig(domain_id));
+    int event_id = local.getTopicEventId(local_topic, "data");
+    CHECK(event_id >= 0);
+    CHECK(local.getTriggerEvent().test(event_id));
+    ShmBase received(local_topic + "_data");
+    received.Open();
+    char buffer[64];
+    received.Read(buffer, sizeof(buffer));
+    CHECK(last == buffer);
+  }
+  return 0;
+}
+
+struct Child {
+  pid_t pid;
+  uint16_t unicast_port;
+};
+
+static Child forkReceiver(int domain_id, uint16_t port, const char* topic,
+                          int expected, const std::string& last) {
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  pid_t pid = fork();
+  CHECK(pid >= 0);
+  if (pid == 0) {
+    close(fds[0]);
+    int code = receiverMain(domain_id, port, topic, expected, last, fds[1]);
+    std::cout.flush();
+    _exit(code);
+  }
+  close(fds[1]);
+  Child child{pid, 0};
+  CHECK(read(fds[0], &child.unicast_port, sizeof(child.unicast_port)) ==
+        sizeof(child.unicast_port));
+  close(fds[0]);
+  return child;
+}
+
+static void expectExitedOk(pid_t pid) {
+  int status = 0;
+  CHECK(waitpid(pid, &status, 0) == pid);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+// 一对多：父进程发布并组播，两个接收进程都写入各自域的本地数据段
+static void multicastToProcesses(uint16_t port) {
+  std::string last = "msg " + std::to_string(MESSAGE_COUNT);
+  Child a = forkReceiver(11, port, "chatter", MESSAGE_COUNT, last);
+  Child b = forkReceiver(12, port, "chatter", MESSAGE_COUNT, last);
+
+  ShmManager local(domainConfig(10));
+  local.setNodeId(local.getNextNodeId());
+  std::string topic = domainConfig(10).topicPrefix() + "chatter";
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&local);
+  pub.setTopicNameForEvent(topic);
+
+  auto gateway = makeGateway(10, port);
+  gateway->addExport("chatter", "data");
+  CHECK(gateway->exportOnce(0) == 0);  // 发布者尚未出现
+  for (int i = 1; i <= MESSAGE_COUNT; i++) {
+    publishText(pub, "msg " + std::to_string(i));
+    CHECK(gateway->exportOnce(0) == 1);
+    CHECK(gateway->exportOnce(0) == 0);  // 没有新消息不重复发送
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  CHECK(gateway->getStats().sent == MESSAGE_COUNT);
+  expectExitedOk(a.pid);
+  expectExitedOk(b.pid);
+  std::cout << "multicast delivered " << MESSAGE_COUNT
+            << " messages to 2 processes" << std::endl;
+}
+
+// 点对点：单播只到达指定对端，同组的其他进程收不到
+static void unicastToPeer(uint16_t port) {
+  Child target = forkReceiver(21, port, "cmd", 1, "go");
+  Child other = forkReceiver(22, port, "cmd", 0, "");
+
+  ShmManager local(domainConfig(20));
+  local.setNodeId(local.getNextNodeId());
+  std::string topic = domainConfig(20).topicPrefix() + "cmd";
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&local);
+  pub.setTopicNameForEvent(topic);
+
+  auto gateway = makeGateway(20, port);
+  CommEndpoint peer;
+  peer.host = "127.0.0.1";
+  peer.port = target.unicast_port;
+  gateway->addExport("cmd", "data", peer);
+  publishText(pub, "go");
+  CHECK(gateway->exportOnce(0) == 1);
+  expectExitedOk(target.pid);
+  expectExitedOk(other.pid);
+  std::cout << "unicast reached port " << peer.port << " only" << std::endl;
+}
+
+// 序号统计：丢失、重复 / 迟到、未登记的 topic；导入写入的消息不会再被导出
+static void sequenceAccounting(uint16_t port) {
+  auto gateway = makeGateway(30, port);
+  gateway->addImport("scan", "data");
+  gateway->addExport("scan", "data");
+  gateway->start();
+
+  UdpCommAdapter sender(loopbackConfig(port));
+  const char payload[] = "scan";
+  std::vector<CommFrame> frames;
+  for (uint64_t seq : {1, 2, 2, 5, 4}) {
+    CommFrame frame;
+    frame.topic = "scan";
+    frame.event = "data";
+    frame.seq = seq;
+    frame.segment_size = 32;
+    frame.data = reinterpret_cast<const uint8_t*>(payload);
+    frame.size = sizeof(payload);
+    frames.push_back(frame);
+  }
+  frames.push_back(frames.front());
+  frames.back().topic = "unknown";
+  CHECK(sender.sendBatch(frames) == frames.size());  // 一次 sendmmsg
+
+  CHECK(waitUntil(
+      [&]() {
+        CommStats stats = gateway->getStats();
+        return stats.received + stats.duplicates + stats.ignored == 6;
+      },
+      2000));
+  CommStats stats = gateway->getStats();
+  CHECK(stats.received == 3);
+  CHECK(stats.duplicates == 2);
+  CHECK(stats.lost == 2);
+  CHECK(stats.ignored == 1);
+  gateway->stop();
+  CHECK(gateway->exportOnce(0) == 0);
+  CHECK(gateway->getStats().sent == 0);
+  std::cout << "received " << stats.received << ", lost " << stats.lost
+            << ", duplicates " << stats.duplicates << std::endl;
+}
+
+// 导入数据段的大小：帧中的 segment_size 来自网络，过大时按 setMaxImportSize
+// 截断，过小时至少放得下消息和结束符
+static void importSegmentSize(uint16_t port) {
+  auto gateway = makeGateway(31, port);
+  gateway->setMaxImportSize(4096);
+  gateway->addImport("huge", "data");
+  gateway->addImport("tiny", "data");
+  gateway->start();
+
+  UdpCommAdapter sender(loopbackConfig(port));
+  std::string text(100, 'x');
+  std::vector<CommFrame> frames(2);
+  for (CommFrame& frame : frames) {
+    frame.event = "data";
+    frame.seq = 1;
+    frame.data = reinterpret_cast<const uint8_t*>(text.data());
+    frame.size = text.size();
+  }
+  frames[0].topic = "huge";
+  frames[0].segment_size = UINT32_MAX;
+  frames[1].topic = "tiny";
+  frames[1].segment_size = 1;
+  CHECK(sender.sendBatch(frames) == frames.size());
+  CHECK(waitUntil([&]() { return gateway->getStats().received == 2; }, 2000));
+
+  std::string prefix = domainConfig(31).topicPrefix();
+  ShmBase huge(prefix + "huge_data");
+  huge.Open();
+  CHECK(huge.getDataSize() == 4096);
+  ShmBase tiny(prefix + "tiny_data");
+  tiny.Open();
+  CHECK(tiny.getDataSize() >= text.size() + 1);
+  std::vector<char> buffer(text.size() + 1);
+  tiny.Read(buffer.data(), buffer.size());
+  CHECK(text == buffer.data());
+  gateway->stop();
+  std::cout << "import segments clamped to " << huge.getDataSize() << " and "
+            << tiny.getDataSize() << " bytes" << std::endl;
+}
+
+static uint8_t patternByte(size_t i, int seed) {
+  return static_cast<uint8_t>((i * 131 + seed) >> 3);
+}
+
+// 点云大小的消息：发送端按 MTU 分片直接从数据段发出，接收端重组后写入本地数据段
+static void largeMessageFragments(uint16_t port) {
+  const size_t size = 4 * 1024 * 1024;
+  auto receiver = makeGateway(41, port);
+  receiver->addImport("points", "data");
+  receiver->start();
+
+  ShmManager local(domainConfig(40));
+  local.setNodeId(local.getNextNodeId());
+  std::string topic = domainConfig(40).topicPrefix() + "points";
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&local);
+  pub.setTopicNameForEvent(topic);
+  auto sender = makeGateway(40, port);
+  sender->addExport("points", "data");
+
+  for (int seed = 1; seed <= 2; seed++) {
+    pub.publishLoaned("data", size, [seed](uint8_t* buffer, size_t capacity) {
+      for (size_t i = 0; i < capacity; i++) {
+        buffer[i] = patternByte(i, seed);
+      }
+      return capacity;
+    });
+    CHECK(sender->exportOnce(0) == 1);
+    CHECK(waitUntil(
+        [&]() {
+          return receiver->getStats().received == static_cast<uint64_t>(seed);
+        },
+        2000));
+    ShmBase received(domainConfig(41).topicPrefix() + "points_data");
+    received.Open();
+    CHECK(received.getDataSize() == size + 1);  // 导入的数据段留出结束符
+    std::vector<uint8_t> data(size);
+    received.Read(data.data(), size);
+    for (size_t i = 0; i < size; i++) {
+      if (data[i] != patternByte(i, seed)) {
+        std::cerr << "mismatch at byte " << i << std::endl;
+        CHECK(false);
+      }
+    }
+  }
+  CHECK(receiver->getStats().lost == 0);
+  std::cout << "4 MB messages reassembled from 1500-byte MTU fragments"
+            << std::endl;
+}
+
+// 缺少分片的消息在超时后丢弃，不影响之后的完整消息
+static void missingFragmentTimeout(uint16_t port) {
+  UdpCommConfig config = loopbackConfig(port);
+  config.reassembly_timeout_ms = 50;
+  auto adapter = std::make_unique<UdpCommAdapter>(config);
+  UdpCommAdapter* receiver_adapter = adapter.get();
+  CommGateway receiver(domainConfig(42), std::move(adapter));
+  receiver.addImport("cloud", "data");
+  receiver.start();
+
+  // 手工构造 3 个分片的消息，只发出第 0、2 片
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  CHECK(fd >= 0);
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(receiver_adapter->localEndpoint().port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const std::string names = "clouddata";
+  const uint32_t chunk = 100;
+  for (uint32_t index : {0u, 2u}) {
+    UdpFrameHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = htonl(UDP_COMM_MAGIC);
+    header.version = UDP_COMM_VERSION;
+    header.topic_len = htons(5);
+    header.event_len = htons(4);
+    header.segment_size = htonl(3 * chunk);
+    header.payload_size = htonl(3 * chunk);
+    header.frag_offset = htonl(index * chunk);
+    header.frag_index = htonl(index);
+    header.frag_count = htonl(3);
+    header.sender_id = htobe64(42);
+    header.seq = htobe64(1);
+    std::vector<uint8_t> packet(sizeof(header) + names.size() + chunk, 'x');
+    std::memcpy(packet.data(), &header, sizeof(header));
+    std::memcpy(packet.data() + sizeof(header), names.data(), names.size());
+    CHECK(sendto(fd, packet.data(), packet.size(), 0,
+                 reinterpret_cast<sockaddr*>(&addr),
+                 sizeof(addr)) == static_cast<ssize_t>(packet.size()));
+  }
+  close(fd);
+  CHECK(waitUntil(
+      [&]() { return receiver_adapter->incompleteMessages() == 1; }, 1000));
+  CHECK(receiver.getStats().received == 0);
+
+  UdpCommAdapter sender(loopbackConfig(port));
+  std::vector<uint8_t> cloud(10000, 7);
+  CommFrame frame;
+  frame.topic = "cloud";
+  frame.event = "data";
+  frame.seq = 1;
+  frame.segment_size = static_cast<uint32_t>(cloud.size());
+  frame.data = cloud.data();
+  frame.size = cloud.size();
+  frame.dest = receiver_adapter->localEndpoint();
+  CHECK(sender.send(frame));
+  CHECK(waitUntil([&]() { return receiver.getStats().received == 1; }, 1000));
+  std::cout << "incomplete message expired after "
+            << config.reassembly_timeout_ms << " ms" << std::endl;
+}
+
+// 伪造的分片帧头：消息长度超过上限、分片数与长度不符、偏移不在分片边界上，
+// 都在分配缓冲区之前丢弃，之后的正常消息照常收到
+static void forgedFragmentHeaders(uint16_t port) {
+  UdpCommConfig config = loopbackConfig(port);
+  config.max_message_size = 1024 * 1024;
+  UdpCommAdapter receiver(config);
+  std::atomic<int> received{0};
+  receiver.start([&received](const CommMessage&) { received++; });
+  CommEndpoint target = receiver.localEndpoint();
+
+  RawUdpPeer peer;
+  auto forge = [&](uint32_t payload_size, uint32_t offset, uint32_t index,
+                   uint32_t count, size_t length) {
+    std::vector<uint8_t> body(length, 1);
+    std::vector<uint8_t> packet =
+        RawUdpPeer::frame("bad", "", 0, 12345, 1, body.data(), body.size());
+    UdpFrameHeader header;
+    std::memcpy(&header, packet.data(), sizeof(header));
+    header.payload_size = htonl(payload_size);
+    header.frag_offset = htonl(offset);
+    header.frag_index = htonl(index);
+    header.frag_count = htonl(count);
+    std::memcpy(packet.data(), &header, sizeof(header));
+    peer.sendTo(target, packet);
+  };
+  forge(0xFFFFFFF0u, 0, 0, 2, 1000);   // 超过 max_message_size
+  forge(4000, 0, 0, 0xFFFFFFu, 1000);  // 分片数与长度不符
+  forge(4000, 500, 1, 4, 1000);        // 偏移不在分片边界上
+  forge(4000, 3000, 3, 4, 500);        // 最后一片没有到达消息末尾
+
+  UdpCommAdapter sender(loopbackConfig(port));
+  std::vector<uint8_t> cloud(5000, 3);
+  CommFrame frame;
+  frame.topic = "cloud";
+  frame.event = "data";
+  frame.seq = 1;
+  frame.segment_size = static_cast<uint32_t>(cloud.size());
+  frame.data = cloud.data();
+  frame.size = cloud.size();
+  frame.dest = target;
+  CHECK(sender.send(frame));
+  CHECK(waitUntil([&]() { return received == 1; }, 1000));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  CHECK(received == 1);
+  receiver.stop();
+  std::cout << "forged fragment headers dropped" << std::endl;
+}
+
+// 回环吞吐：另一个进程连续发出 4 MB 消息，按接收端写入本地数据段的字节数计算
+// 以太网 MTU 下每条消息约 3000 个报文；回环接口的 MTU 为 64K，报文数少得多
+// UDP 没有流控：发送端最多领先接收端 THROUGHPUT_WINDOW 条消息，接收端每写入一条
+// 归还一个额度；接收缓冲区放得下整个窗口，测到的是实际送达的吞吐而不是丢包速度
+#define THROUGHPUT_WINDOW 2
+static void loopbackThroughput(uint16_t port, size_t mtu) {
+  const size_t size = 4 * 1024 * 1024;
+  const int count = 50;
+  int go_fds[2];
+  int credit_fds[2];
+  CHECK(pipe(go_fds) == 0);
+  CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, credit_fds) == 0);
+  pid_t pid = fork();
+  CHECK(pid >= 0);
+  if (pid == 0) {
+    close(go_fds[1]);
+    close(credit_fds[1]);
+    char go;
+    CHECK(read(go_fds[0], &go, 1) == 1);  // 等接收端就绪
+    close(go_fds[0]);
+    {
+      ShmManager local(domainConfig(50));
+      local.setNodeId(local.getNextNodeId());
+      std::string topic = domainConfig(50).topicPrefix() + "bench";
+      Publisher<JsonValue> pub(topic);
+      pub.setShmManager(&local);
+      pub.setTopicNameForEvent(topic);
+      auto sender = makeGateway(50, port, mtu);
+      sender->addExport("bench", "data");
+      for (int i = 0; i < count; i++) {
+        if (i >= THROUGHPUT_WINDOW) {
+          // 等一个额度；丢失的消息不会归还额度，超时后照常发出
+          pollfd pfd{credit_fds[0], POLLIN, 0};
+          char credit;
+          if (poll(&pfd, 1, 200) == 1) {
+            CHECK(recv(credit_fds[0], &credit, 1, 0) == 1);
+          }
+        }
+        pub.publishLoaned("data", size, [i](uint8_t* buffer, size_t capacity) {
+          std::memset(buffer, i, capacity);
+          return capacity;
+        });
+        sender->exportOnce(0);
+      }
+    }
+    close(credit_fds[0]);
+    std::cout.flush();
+    _exit(0);
+  }
+  close(go_fds[0]);
+  close(credit_fds[0]);
+  UdpCommConfig config = loopbackConfig(port, mtu);
+  config.receive_buffer = 64 * 1024 * 1024;
+  CommGateway receiver(domainConfig(51),
+                       std::make_unique<UdpCommAdapter>(config));
+  receiver.addImport("bench", "data");
+  receiver.start();
+  Clock::time_point start = Clock::now();
+  CHECK(write(go_fds[1], "g", 1) == 1);
+  close(go_fds[1]);
+  // 每写入一条归还一个额度（发送端可能已经退出，忽略失败）；
+  // 发送端退出后再等 300 ms 没有新消息为止
+  uint64_t received = 0;
+  Clock::time_point last = Clock::now();
+  while (Clock::now() - last < std::chrono::milliseconds(300)) {
+    uint64_t now_received = receiver.getStats().received;
+    for (; received < now_received; received++) {
+      send(credit_fds[1], "c", 1, MSG_NOSIGNAL);
+      last = Clock::now();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  close(credit_fds[1]);
+  expectExitedOk(pid);
+  double seconds = std::chrono::duration<double>(last - start).count();
+  double bytes = static_cast<double>(received) * size;
+  std::cout << "loopback mtu " << mtu << ": " << received << "/" << count
+            << " x 4 MB delivered (" << count - received << " lost) in "
+            << seconds * 1000 << " ms, " << bytes * 8 / seconds / 1e9
+            << " Gbit/s" << std::endl;
+  CHECK(received * 10 >= static_cast<uint64_t>(count) * 9);
+}
+
+int main() {
+  // 按 pid 选择端口，避免与同时运行的其他测试冲突
+  uint16_t port = static_cast<uint16_t>(20000 + getpid() % 20000);
+  multicastToProcesses(port);
+  unicastToPeer(port);
+  sequenceAccounting(port);
+  importSegmentSize(port);
+  largeMessageFragments(port);
+  missingFragmentTimeout(port);
+  forgedFragmentHeaders(port);
+  loopbackThroughput(port, 1500);
+  loopbackThroughput(port, 65535);
+  std::cout << "test_command_adapter passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,126 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "mini_ros2/communication/domain_bridge.h"
+#include "mini_ros2/communication/shm_manager.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "test_utils.h"
+
+using Clock = std::chrono::steady_clock;
+
+static RegistryConfig domainConfig(int domain_id) {
+  RegistryConfig config;
+  config.domain_id = domain_id;
+  return config;
+}
+
+static void publishText(Publisher<JsonValue>& pub, const char* text) {
+  pub.publishLoaned("data", 64, [text](uint8_t* buffer, size_t) {
+    std::strcpy(reinterpret_cast<char*>(buffer), text);
+    return std::strlen(text) + 1;
+  });
+}
+
+// 分区命名：域 0 沿用原段名，其他域 / 命名空间追加后缀
+static void partitionNames() {
+  RegistryConfig config;
+  CHECK(config.registryName() == SHM_MANAGER_NAME);
+  CHECK(config.eventNotificationName() == EVENT_NOTIFICATION_SHM_NAME);
+  config.domain_id = 7;
+  config.name_space = "sim/robot";
+  CHECK(config.registryName() == std::string(SHM_MANAGER_NAME) + "_d7");
+  CHECK(config.topicPrefix() == "/7_sim/robot_");
+  config.partition_by_namespace = true;
+  CHECK(config.eventNotificationName() ==
+        std::string(EVENT_NOTIFICATION_SHM_NAME) + "_d7_ns_sim_robot");
+}
+
+// 不同域的注册表互不可见，一个域的事件不会唤醒另一个域的等待者
+static void domainsIsolated() {
+  ShmManager real(domainConfig(0));
+  ShmManager sim(domainConfig(7));
+  CHECK(real.getRegistryName() != sim.getRegistryName());
+
+  int sim_id = sim.registerTopicEvent("/7_scan", "data");
+  CHECK(sim_id >= 0);
+  CHECK(real.getTopicEventId("/7_scan", "data") == -1);
+
+  const uint64_t wait_ms = 300;
+  Clock::time_point start = Clock::now();
+  auto waiter = std::async(std::launch::async, [&real, wait_ms]() {
+    return real.waitForEvent(wait_ms);
+  });
+  while (waiter.wait_for(std::chrono::milliseconds(20)) ==
+         std::future_status::timeout) {
+    sim.triggerEvent("/7_scan", "data");
+  }
+  EventFlags flags = waiter.get();
+  double waited_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  CHECK(waited_ms >= wait_ms - 20);  // 没有被 sim 域的广播提前唤醒
+  CHECK(!flags.any());
+  CHECK(sim.getTriggerEvent().test(sim_id));
+  std::cout << "domain 0 waiter slept " << waited_ms
+            << " ms while domain 7 was triggering" << std::endl;
+}
+
+// 显式桥把域 1 的 topic 转发到域 2，只在有新消息时转发
+static void bridgeForwards() {
+  ShmManager src(domainConfig(1));
+  src.setNodeId(src.getNextNodeId());
+  std::string src_topic = domainConfig(1).topicPrefix() + "chatter";
+  Publisher<JsonValue> pub(src_topic);
+  pub.setShmManager(&src);
+  pub.setTopicNameForEvent(src_topic);
+
+  ShmManager dst(domainConfig(2));
+  std::string dst_topic = domainConfig(2).topicPrefix() + "chatter";
+
+  DomainBridge bridge(domainConfig(1), domainConfig(2));
+  bridge.addRoute("chatter", "data");
+  CHECK(bridge.forwardOnce(20) == 0);  // 发布者尚未出现
+
+  publishText(pub, "hello domain 2");
+  CHECK(bridge.forwardOnce(0) == 1);
+  int dst_id = dst.getTopicEventId(dst_topic, "data");
+  CHECK(dst_id >= 0);
+  CHECK(dst.getTriggerEvent().test(dst_id));
+  ShmBase received(dst_topic + "_data");
+  received.Open();
+  char buffer[64];
+  received.Read(buffer, sizeof(buffer));
+  CHECK(std::strcmp(buffer, "hello domain 2") == 0);
+
+  // 源事件位仍然置位（留给源分区的订阅者），但没有新消息时不重复转发
+  CHECK(src.getTriggerEvent().test(src.getTopicEventId(src_topic, "data")));
+  CHECK(bridge.forwardOnce(20) == 0);
+
+  // 后台线程转发
+  dst.clearTriggerEvent(dst_id);
+  bridge.start();
+  publishText(pub, "second message");
+  Clock::time_point deadline = Clock::now() + std::chrono::seconds(2);
+  while (!dst.getTriggerEvent().test(dst_id) && Clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  bridge.stop();
+  CHECK(dst.getTriggerEvent().test(dst_id));
+  received.Read(buffer, sizeof(buffer));
+  CHECK(std::strcmp(buffer, "second message") == 0);
+  std::cout << "bridge forwarded " << src_topic << " -> " << dst_topic
+            << std::endl;
+}
+
+int main() {
+  partitionNames();
+  domainsIsolated();
+  bridgeForwards();
+  std::cout << "test_domain_partition passed" << std::endl;
+  return 0;
+}
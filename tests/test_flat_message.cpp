@@ -0,0 +1,230 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mini_ros2/message/flat_message.h"
+#include "mini_ros2/message/json.h"
+#include "test_utils.h"
+
+// 模拟激光扫描 schema
+//   v1: 0 stamp(uint64) 1 frame_id(string) 2 ranges(float[]) 3 pose(table)
+//       4 echoes(table[])
+//   v2: 新增 5 intensities(float[])
+// pose: 0 x(double) 1 y(double) 2 yaw(float)
+enum ScanField : uint16_t {
+  kStamp = 0,
+  kFrameId = 1,
+  kRanges = 2,
+  kPose = 3,
+  kEchoes = 4,
+  kIntensities = 5,
+};
+
+static FlatRef buildPose(FlatBuilder& builder, double x, double y, float yaw) {
+  builder.startTable();
+  builder.addScalar<double>(0, x);
+  builder.addScalar<double>(1, y);
+  builder.addScalar<float>(2, yaw);
+  return builder.endTable();
+}
+
+static size_t buildScan(FlatBuilder& builder, const std::vector<float>& ranges,
+                        bool with_intensities) {
+  FlatRef frame = builder.createString("laser_link");
+  FlatRef data = builder.createVector(ranges);
+  FlatRef intensities;
+  if (with_intensities) {
+    std::vector<float> values(ranges.size(), 0.5f);
+    intensities = builder.createVector(values);
+  }
+  FlatRef pose = buildPose(builder, 1.5, -2.0, 0.25f);
+  std::vector<FlatRef> echoes;
+  for (int i = 0; i < 3; i++) {
+    echoes.push_back(buildPose(builder, i, i * 2.0, i * 0.1f));
+  }
+  FlatRef echo_vec = builder.createTableVector(echoes);
+
+  builder.startTable();
+  builder.addScalar<uint64_t>(kStamp, 1234567890123ULL);
+  builder.addRef(kFrameId, frame);
+  builder.addRef(kRanges, data);
+  builder.addRef(kPose, pose);
+  builder.addRef(kEchoes, echo_vec);
+  if (with_intensities) {
+    builder.addRef(kIntensities, intensities);
+  }
+  FlatRef root = builder.endTable();
+  return builder.finish(root, with_intensities ? 2 : 1);
+}
+
+int main() {
+  std::cout << "=== MiniROS2 flat message test ===" << std::endl;
+  std::vector<float> ranges(10000);
+  for (size_t i = 0; i < ranges.size(); i++) {
+    ranges[i] = 0.01f * i;
+  }
+
+  // 1. 内部缓冲区构建 + 就地读取
+  FlatBuilder builder;
+  buildScan(builder, ranges, false);
+  FlatMessage msg(builder);
+  std::string error;
+  CHECK(msg.verify(&error));
+  FlatTable scan = msg.root();
+  CHECK(msg.schemaVersion() == 1);
+  CHECK(scan.get<uint64_t>(kStamp) == 1234567890123ULL);
+  CHECK(scan.getString(kFrameId) == "laser_link");
+  FlatVector<float> read_ranges = scan.getVector<float>(kRanges);
+  CHECK(read_ranges.size() == ranges.size());
+  CHECK(read_ranges[9999] == ranges[9999]);
+  CHECK(scan.getTable(kPose).get<double>(0) == 1.5);
+  CHECK(scan.getTable(kPose).get<float>(2) == 0.25f);
+  CHECK(scan.getTableCount(kEchoes) == 3);
+  CHECK(scan.getTableAt(kEchoes, 2).get<double>(1) == 4.0);
+  CHECK(!scan.getTableAt(kEchoes, 3).valid());
+  // 类型不符或不存在的字段返回默认值
+  CHECK(scan.get<uint32_t>(kStamp, 7) == 7);
+  CHECK(scan.getVector<double>(kRanges).empty());
+  std::cout << "in-place read ok, size " << msg.size() << " bytes"
+            << std::endl;
+
+  // 2. 版本兼容：v1 读端读 v2 消息忽略新字段，v2 读端读 v1 消息得到空字段
+  FlatBuilder builder_v2;
+  buildScan(builder_v2, ranges, true);
+  FlatMessage msg_v2(builder_v2);
+  CHECK(msg_v2.verify());
+  CHECK(msg_v2.schemaVersion() == 2);
+  CHECK(msg_v2.root().getString(kFrameId) == "laser_link");
+  CHECK(msg_v2.root().getVector<float>(kIntensities).size() == ranges.size());
+  CHECK(!scan.has(kIntensities));
+  CHECK(scan.getVector<float>(kIntensities).empty());
+  std::cout << "schema evolution ok" << std::endl;
+
+  // 3. 外部缓冲区（模拟借出的共享内存）：容量不足抛异常
+  std::vector<uint64_t> storage(8192);  // 保证 8 字节对齐
+  uint8_t* loaned = reinterpret_cast<uint8_t*>(storage.data());
+  FlatBuilder in_place(loaned, storage.size() * sizeof(uint64_t));
+  size_t size = buildScan(in_place, ranges, false);
+  CHECK(FlatMessage::messageSize(loaned, storage.size() * 8) == size);
+  CHECK(FlatVerifier::verify(loaned, size));
+  CHECK(FlatMessage::rootOf(loaned, size).getVector<float>(kRanges)[10] ==
+        ranges[10]);
+  bool thrown = false;
+  try {
+    FlatBuilder small(loaned, 256);
+    buildScan(small, ranges, false);
+  } catch (const std::length_error&) {
+    thrown = true;
+  }
+  CHECK(thrown);
+
+  // 4. 经 Serializer 传输，损坏的缓冲区被校验器拒绝
+  std::vector<uint8_t> wire(Serializer::getSerializedSize(msg) + 64, 0);
+  Serializer::serialize(msg, wire.data(), wire.size());
+  FlatMessage received;
+  Serializer::deserialize(wire.data(), wire.size(), received);
+  CHECK(received.size() == msg.size());
+  CHECK(received.root().getTableAt(kEchoes, 1).get<float>(2) == 0.1f);
+
+  FlatHeader header;
+  std::memcpy(&header, wire.data(), sizeof(header));
+  std::vector<uint8_t> corrupt = wire;
+  uint32_t bad = 0xFFFFFF00u;
+  std::memcpy(corrupt.data() + header.root, &bad, sizeof(bad));  // vtable 越界
+  CHECK(!FlatVerifier::verify(corrupt.data(), corrupt.size(), &error));
+  std::cout << "corrupt vtable rejected: " << error << std::endl;
+  thrown = false;
+  try {
+    Serializer::deserialize(corrupt.data(), corrupt.size(), received);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  CHECK(thrown);
+  for (size_t cut = 0; cut < msg.size(); cut += 997) {
+    CHECK(!FlatVerifier::verify(msg.data(), cut));
+  }
+
+  // 4b. 多处引用的同一个子表只校验一次：合法的共享不会耗尽预算
+  FlatBuilder shared;
+  FlatRef shared_pose = buildPose(shared, 1.0, 2.0, 3.0f);
+  FlatRef shared_vec =
+      shared.createTableVector(std::vector<FlatRef>(5000, shared_pose));
+  shared.startTable();
+  shared.addRef(kEchoes, shared_vec);
+  FlatRef shared_root = shared.endTable();
+  shared.finish(shared_root, 1);
+  FlatMessage shared_msg(shared);
+  CHECK(shared_msg.verify(&error));
+  CHECK(shared_msg.root().getTableAt(kEchoes, 4999).get<double>(1) == 2.0);
+
+  // 4c. 构造的输入：大量空表共用一个很长的 vtable，按 vtable 项计费后直接拒绝，
+  // 不会做 表数 x vtable 项数 次检查
+  const uint32_t fields = 16000;
+  const uint32_t tables = 16000;
+  uint32_t vtable_pos = sizeof(FlatHeader);
+  uint32_t tables_pos = (vtable_pos + 4 + 4 * fields + 7) / 8 * 8;
+  uint32_t root_vtable = tables_pos + 8 * tables;
+  uint32_t root_pos = root_vtable + 8;
+  uint32_t vector_pos = root_pos + 8;
+  std::vector<uint8_t> crafted(vector_pos + 4 + 4 * tables, 0);
+  auto put16 = [&crafted](uint32_t pos, uint16_t value) {
+    std::memcpy(crafted.data() + pos, &value, sizeof(value));
+  };
+  auto put32 = [&crafted](uint32_t pos, uint32_t value) {
+    std::memcpy(crafted.data() + pos, &value, sizeof(value));
+  };
+  FlatHeader crafted_header{FLAT_MESSAGE_MAGIC, 1, 0, root_pos,
+                            static_cast<uint32_t>(crafted.size())};
+  std::memcpy(crafted.data(), &crafted_header, sizeof(crafted_header));
+  put16(vtable_pos, static_cast<uint16_t>(fields));
+  put16(vtable_pos + 2, 4);
+  put16(root_vtable, 1);
+  put16(root_vtable + 2, 8);
+  FlatVTableEntry vector_entry{
+      4, static_cast<uint8_t>(FlatFieldKind::TableVector), 4};
+  std::memcpy(crafted.data() + root_vtable + 4, &vector_entry,
+              sizeof(vector_entry));
+  put32(root_pos, root_vtable);
+  put32(root_pos + 4, vector_pos);
+  put32(vector_pos, tables);
+  for (uint32_t i = 0; i < tables; i++) {
+    put32(tables_pos + 8 * i, vtable_pos);
+    put32(vector_pos + 4 * (i + 1), tables_pos + 8 * i);
+  }
+  CHECK(!FlatVerifier::verify(crafted.data(), crafted.size(), &error));
+  std::cout << "shared vtable rejected: " << error << std::endl;
+
+  // 5. 与 JsonValue 对比：读取一个字段的耗时
+  JsonValue json;
+  json["frame_id"] = "laser_link";
+  JsonArray json_ranges;
+  for (float r : ranges) {
+    json_ranges.push_back(JsonValue(static_cast<double>(r)));
+  }
+  json["ranges"] = json_ranges;
+  std::string text = json.serialize();
+  const int rounds = 50;
+  float sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    JsonValue parsed = JsonValue::deserialize(text);
+    sink += static_cast<float>(parsed["ranges"][5001].asDouble());
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    CHECK(FlatVerifier::verify(msg.data(), msg.size()));
+    sink += msg.root().getVector<float>(kRanges)[5001];
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::cout << "json parse+read: "
+            << std::chrono::duration<double, std::milli>(mid - start).count()
+            << " ms, flat verify+read: "
+            << std::chrono::duration<double, std::milli>(end - mid).count()
+            << " ms (" << rounds << " rounds, sink " << sink << ")"
+            << std::endl;
+
+  std::cout << "=== all flat message tests passed ===" << std::endl;
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mini_ros2/communication/shm_manager.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "test_utils.h"
+
+static bool hasEvent(const std::vector<GraphEvent>& events,
+                     GraphEventType type, int node_id) {
+  for (const GraphEvent& event : events) {
+    if (event.type == type && event.node_id == node_id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static std::string liveNodeName(ShmManager& manager, int node_id) {
+  for (const NodeInfo& node : manager.getLiveNodes()) {
+    if (node.node_id == node_id) {
+      return node.node_name;
+    }
+  }
+  return "";
+}
+
+int main() {
+  // 两个 ShmManager 模拟两个进程：publisher 侧监听图变化，subscriber 侧修改注册表
+  ShmManager pub_side;
+  ShmManager sub_side;
+  int pub_node = registerNode(pub_side, "lazy_pub");
+
+  std::vector<GraphEvent> events;
+  int callback_id = pub_side.addGraphChangeCallback(
+      [&events](const GraphEvent& event) { events.push_back(event); });
+  // 订阅者出现后才开始发布
+  bool start_publishing = false;
+  pub_side.addGraphChangeCallback([&start_publishing](const GraphEvent& event) {
+    if (event.type == GraphEventType::SubscriberAdded &&
+        std::strcmp(event.name, "/graph_chatter_msg") == 0) {
+      start_publishing = true;
+    }
+  });
+  pub_side.syncRegistryFromShm();
+  events.clear();
+
+  int sub_node = registerNode(sub_side, "listener");
+  pub_side.syncRegistryFromShm();
+  CHECK(hasEvent(events, GraphEventType::NodeAdded, sub_node));
+  CHECK(liveNodeName(pub_side, sub_node) == "listener");  // 快照按日志增量更新
+  CHECK(!start_publishing);
+
+  events.clear();
+  sub_side.addSubTopic("/graph_chatter", "msg");
+  pub_side.syncRegistryFromShm();
+  CHECK(events.size() == 1);
+  CHECK(events[0].type == GraphEventType::SubscriberAdded);
+  CHECK(events[0].node_id == sub_node);
+  CHECK(events[0].event_id ==
+        pub_side.getTopicEventId("/graph_chatter", "msg"));
+  CHECK(start_publishing);
+
+  // 订阅者先登记了 topic：发布者首次发布时照常登记，记录 PublisherAdded
+  events.clear();
+  std::string topic = "/graph_chatter";
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&pub_side);
+  pub.setTopicNameForEvent(topic);
+  JsonValue msg;
+  msg["value"] = 1;
+  pub.publish("msg", msg);
+  pub.publish("msg", msg);
+  pub_side.addPubTopic("/graph_chatter", "msg");  // 重复登记不再记录
+  pub_side.syncRegistryFromShm();
+  int publisher_added = 0;
+  for (const GraphEvent& event : events) {
+    CHECK(event.type != GraphEventType::Resync);
+    if (event.type == GraphEventType::PublisherAdded) {
+      publisher_added++;
+      CHECK(event.node_id == pub_node);
+      CHECK(std::strcmp(event.name, "/graph_chatter_msg") == 0);
+    }
+  }
+  CHECK(publisher_added == 1);
+  NodeInfo pub_info;
+  pub_side.getNodeInfo(pub_info);
+  CHECK(pub_info.pub_topic_count == 1);
+  events.clear();
+
+  // 代数未变化时不重复分发
+  events.clear();
+  pub_side.syncRegistryFromShm();
+  CHECK(events.empty());
+
+  sub_side.removeSubTopic("/graph_chatter", "msg");
+  sub_side.removeNode();
+  pub_side.syncRegistryFromShm();
+  CHECK(events.size() == 2);
+  CHECK(events[0].type == GraphEventType::SubscriberRemoved);
+  CHECK(std::strcmp(events[0].name, "/graph_chatter_msg") == 0);
+  CHECK(events[1].type == GraphEventType::NodeRemoved);
+  CHECK(liveNodeName(pub_side, sub_node).empty());
+
+  // 落后超过日志长度：退回全量同步并分发一条 Resync，快照仍是最新的
+  sub_side.updateNodeAlive();
+  for (int i = 0; i <= REGISTRY_CHANGE_LOG_SIZE; ++i) {
+    sub_side.updateNodeName("renamed_" + std::to_string(i));
+  }
+  events.clear();
+  pub_side.syncRegistryFromShm();
+  CHECK(events.size() == 1);
+  CHECK(events[0].type == GraphEventType::Resync);
+  CHECK(liveNodeName(pub_side, sub_node) ==
+        "renamed_" + std::to_string(REGISTRY_CHANGE_LOG_SIZE));
+
+  // 注销后不再收到回调
+  pub_side.removeGraphChangeCallback(callback_id);
+  events.clear();
+  sub_side.updateNodeName("after_remove");
+  pub_side.syncRegistryFromShm();
+  CHECK(events.empty());
+  CHECK(liveNodeName(pub_side, sub_node) == "after_remove");
+
+  std::cout << "test_graph_events passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,229 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mini_ros2/communication/io_engine.h"
+#include "mini_ros2/communication/io_uring_engine.h"
+#include "mini_ros2/communication/shm_base.h"
+#include "test_utils.h"
+
+// 录制一条消息的块大小和块数：模拟按序追加到录制文件
+#define RECORD_CHUNK 16384
+#define RECORD_CHUNKS 64
+#define DATAGRAM_COUNT 200
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<IoBackend> availableBackends() {
+  std::vector<IoBackend> backends = {IoBackend::Epoll};
+  if (UringIoEngine::isSupported()) {
+    backends.push_back(IoBackend::IoUring);
+  } else {
+    std::cout << "io_uring not supported, only testing epoll" << std::endl;
+  }
+  return backends;
+}
+
+static uint8_t patternByte(size_t i) { return static_cast<uint8_t>(i * 31 + 7); }
+
+static int tempFile(std::string& path) {
+  char name[] = "/tmp/io_engine_XXXXXX";
+  int fd = mkstemp(name);
+  CHECK(fd >= 0);
+  path = name;
+  return fd;
+}
+
+// 共享内存数据段登记为常驻缓冲区后按块写入文件，再追加一段不在登记区域内的数据
+static void recordFromShm(IoEngine& engine) {
+  std::string shm_name = "/io_engine_" + std::to_string(getpid());
+  ShmBase segment(shm_name, RECORD_CHUNK * RECORD_CHUNKS);
+  segment.Create();
+  segment.Open();
+  segment.Loan([](uint8_t* buffer, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      buffer[i] = patternByte(i);
+    }
+    return size;
+  });
+  bool registered = engine.registerBuffers(
+      {{segment.DataUnlocked(), segment.getDataSize()}});
+  CHECK(registered == (std::string(engine.name()) == "io_uring"));
+
+  std::string path;
+  int fd = tempFile(path);
+  std::vector<IoWrite> writes;
+  for (size_t i = 0; i < RECORD_CHUNKS; i++) {
+    writes.push_back({segment.DataUnlocked() + i * RECORD_CHUNK, RECORD_CHUNK,
+                      i * RECORD_CHUNK});
+  }
+  std::string trailer = "end of record";
+  writes.push_back({trailer.data(), trailer.size(),
+                    static_cast<uint64_t>(RECORD_CHUNK) * RECORD_CHUNKS});
+  size_t total = engine.writeBatch(fd, writes);
+  CHECK(total == RECORD_CHUNK * RECORD_CHUNKS + trailer.size());
+
+  std::vector<uint8_t> contents(total);
+  CHECK(pread(fd, contents.data(), contents.size(), 0) ==
+        static_cast<ssize_t>(total));
+  for (size_t i = 0; i < RECORD_CHUNK * RECORD_CHUNKS; i++) {
+    CHECK(contents[i] == patternByte(i));
+  }
+  CHECK(std::memcmp(contents.data() + RECORD_CHUNK * RECORD_CHUNKS,
+                    trailer.data(), trailer.size()) == 0);
+  // 取消登记，数据段释放后不再被内核固定
+  engine.registerBuffers({});
+  close(fd);
+  unlink(path.c_str());
+  std::cout << engine.name() << ": recorded " << total << " bytes from shm"
+            << std::endl;
+}
+
+static int boundSocket(sockaddr_in& addr) {
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  CHECK(fd >= 0);
+  int buffer = 4 * 1024 * 1024;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &buffer, sizeof(buffer));
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  CHECK(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+  socklen_t len = sizeof(addr);
+  CHECK(getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+  return fd;
+}
+
+static void sendNumbered(IoEngine& engine, int fd, sockaddr_in& dest,
+                         uint32_t first, uint32_t count) {
+  std::vector<uint32_t> values(count);
+  std::vector<iovec> iovecs(count);
+  std::vector<mmsghdr> msgs(count);
+  for (uint32_t i = 0; i < count; i++) {
+    values[i] = first + i;
+    iovecs[i] = {&values[i], sizeof(uint32_t)};
+    std::memset(&msgs[i], 0, sizeof(mmsghdr));
+    msgs[i].msg_hdr.msg_name = &dest;
+    msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+    msgs[i].msg_hdr.msg_iov = &iovecs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  CHECK(engine.sendBatch(fd, msgs) == count);
+  for (const auto& msg : msgs) {
+    CHECK(msg.msg_len == sizeof(uint32_t));
+  }
+}
+
+static bool waitFor(const std::atomic<uint32_t>& value, uint32_t expected) {
+  Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+  while (value < expected) {
+    if (Clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+// 一批报文一次提交，接收线程逐个回调并按时执行 tick；stop 之后可以再次 start
+static void datagramRoundTrip(IoBackend backend) {
+  sockaddr_in rx_addr, tx_addr;
+  int rx_fd = boundSocket(rx_addr);
+  int tx_fd = boundSocket(tx_addr);
+  std::unique_ptr<IoEngine> sender = createIoEngine(backend);
+  std::unique_ptr<IoEngine> receiver = createIoEngine(backend);
+  std::atomic<uint32_t> received = 0;
+  std::atomic<uint32_t> ticks = 0;
+  std::atomic<bool> in_order = true;
+  std::atomic<bool> from_sender = true;
+  receiver->addReceiver(rx_fd, 2048, [&](const uint8_t* data, size_t size,
+                                         const sockaddr_in& from) {
+    // 源地址是发送套接字的地址
+    if (from.sin_family != AF_INET || from.sin_port != tx_addr.sin_port ||
+        from.sin_addr.s_addr != tx_addr.sin_addr.s_addr) {
+      from_sender = false;
+    }
+    uint32_t value = 0;
+    if (size != sizeof(value)) {
+      in_order = false;
+      return;
+    }
+    std::memcpy(&value, data, sizeof(value));
+    if (value != received) {
+      in_order = false;
+    }
+    received++;
+  });
+  for (int round = 0; round < 2; round++) {
+    receiver->start(5, [&ticks]() { ticks++; });
+    uint32_t first = received;
+    sendNumbered(*sender, tx_fd, rx_addr, first, DATAGRAM_COUNT);
+    CHECK(waitFor(received, first + DATAGRAM_COUNT));
+    CHECK(in_order);
+    CHECK(from_sender);
+    uint32_t ticks_before = ticks;
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    CHECK(ticks > ticks_before);
+    receiver->stop();
+  }
+  close(rx_fd);
+  close(tx_fd);
+  std::cout << receiver->name() << ": " << received << " datagrams, " << ticks
+            << " ticks" << std::endl;
+}
+
+// 对比逐块 pwrite 和一次 writeBatch 写同样的录制数据
+static void writeThroughput(IoEngine& engine) {
+  const size_t chunk = 4096;
+  const size_t chunks = 8192;
+  std::vector<uint8_t> data(chunk * 64, 0x5a);
+  CHECK(engine.registerBuffers({{data.data(), data.size()}}) ||
+        std::string(engine.name()) == "epoll");
+  std::string path;
+  int fd = tempFile(path);
+  std::vector<IoWrite> writes;
+  for (size_t i = 0; i < chunks; i++) {
+    writes.push_back({data.data() + (i % 64) * chunk, chunk, i * chunk});
+  }
+  // 预热一遍，两种写法都从同样的页缓存状态开始
+  CHECK(engine.writeBatch(fd, writes) == chunk * chunks);
+  CHECK(ftruncate(fd, 0) == 0);
+  Clock::time_point start = Clock::now();
+  for (const auto& write : writes) {
+    CHECK(pwrite(fd, write.data, write.size, write.offset) ==
+          static_cast<ssize_t>(write.size));
+  }
+  double single_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  CHECK(ftruncate(fd, 0) == 0);
+  start = Clock::now();
+  CHECK(engine.writeBatch(fd, writes) == chunk * chunks);
+  double batch_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  engine.registerBuffers({});
+  close(fd);
+  unlink(path.c_str());
+  std::cout << engine.name() << ": " << chunks << " x 4 KB writes, pwrite "
+            << single_ms << " ms, writeBatch " << batch_ms << " ms"
+            << std::endl;
+}
+
+int main() {
+  for (IoBackend backend : availableBackends()) {
+    std::unique_ptr<IoEngine> engine = createIoEngine(backend);
+    recordFromShm(*engine);
+    datagramRoundTrip(backend);
+    writeThroughput(*engine);
+  }
+  std::cout << "test_io_engine passed" << std::endl;
+  return 0;
+}
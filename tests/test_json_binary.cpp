@@ -0,0 +1,91 @@
+#include <iostream>
+#include <string>
+
+#include "mini_ros2/message/json.h"
+#include "mini_ros2/message/message_serializer.h"
+#include "test_utils.h"
+
+// 构造一条类似 IMU 的消息：对象 + 大量浮点数组
+static JsonValue makeImuMessage(int samples) {
+  JsonValue json;
+  json["frame_id"] = "imu_link";
+  json["seq"] = 123456;
+  json["is_calibrated"] = true;
+  JsonArray accel;
+  for (int i = 0; i < samples; i++) {
+    accel.push_back(JsonValue(0.001 * i + 9.80665 / 3.0));
+  }
+  json["accel"] = accel;
+  JsonValue nested;
+  nested["temperature"] = 36.6;
+  nested["status"] = "ok";
+  json["meta"] = nested;
+  return json;
+}
+
+int main() {
+  std::cout << "=== MiniROS2 JSON binary encoding test ===" << std::endl;
+  JsonValue json = makeImuMessage(1000);
+
+  std::string text = json.serialize();
+  std::string binary = json.serializeBinary();
+  const uint8_t* bin_ptr = reinterpret_cast<const uint8_t*>(binary.data());
+  std::cout << "text size: " << text.size() << " bytes, binary size: "
+            << binary.size() << " bytes" << std::endl;
+
+  // 二进制编码往返不丢精度
+  JsonValue decoded = JsonValue::deserializeBinary(bin_ptr, binary.size());
+  CHECK(decoded["frame_id"].asString() == "imu_link");
+  CHECK(decoded["seq"].asInt() == 123456);
+  CHECK(decoded["is_calibrated"].asBool());
+  CHECK(decoded["accel"].size() == 1000);
+  for (size_t i = 0; i < 1000; i++) {
+    CHECK(decoded["accel"][i].asDouble() == json["accel"][i].asDouble());
+  }
+  CHECK(decoded["meta"]["status"].asString() == "ok");
+  CHECK(decoded.encode(JsonEncoding::Binary) == binary);
+
+  // 自动识别编码（含共享内存尾部残留）
+  std::string padded = binary + std::string(16, '\x7f');
+  JsonValue auto_bin = JsonValue::decode(
+      reinterpret_cast<const uint8_t*>(padded.data()), padded.size());
+  CHECK(auto_bin["seq"].asInt() == 123456);
+  std::string text_padded = text + std::string(1, '\0') + "garbage";
+  JsonValue auto_text = JsonValue::decode(
+      reinterpret_cast<const uint8_t*>(text_padded.data()), text_padded.size());
+  CHECK(auto_text["seq"].asInt() == 123456);
+  JsonValue via_serializer;
+  Serializer::deserialize(bin_ptr, binary.size(), via_serializer);
+  CHECK(via_serializer["meta"]["temperature"].asDouble() == 36.6);
+
+  // 只取一个成员，跳过大数组子树
+  JsonValue meta;
+  CHECK(JsonValue::findBinaryMember(bin_ptr, binary.size(), "meta", meta));
+  CHECK(meta["temperature"].asDouble() == 36.6);
+  JsonValue missing;
+  CHECK(!JsonValue::findBinaryMember(bin_ptr, binary.size(), "none", missing));
+
+  // 截断的输入必须报错而不是越界
+  bool truncated = false;
+  try {
+    JsonValue::deserializeBinary(bin_ptr, binary.size() / 2);
+  } catch (const std::invalid_argument& e) {
+    truncated = true;
+  }
+  CHECK(truncated);
+
+  const int rounds = 200;
+  double text_ms = timeMs(rounds, [&]() { JsonValue::deserialize(text); });
+  double bin_ms = timeMs(rounds, [&]() {
+    JsonValue::deserializeBinary(bin_ptr, binary.size());
+  });
+  double skip_ms = timeMs(rounds, [&]() {
+    JsonValue out;
+    JsonValue::findBinaryMember(bin_ptr, binary.size(), "meta", out);
+  });
+  std::cout << "decode x" << rounds << ": text " << text_ms << " ms, binary "
+            << bin_ms << " ms, single member " << skip_ms << " ms"
+            << std::endl;
+  std::cout << "all checks passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,99 @@
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "mini_ros2/message/json.h"
+#include "test_utils.h"
+
+// 数值密集型消息：类似激光雷达 ranges + IMU 采样，外加纳秒时间戳
+static JsonValue makeScan(int count) {
+  JsonValue json;
+  json["stamp_ns"] = static_cast<int64_t>(1718000000123456789LL);
+  JsonArray ranges;
+  for (int i = 0; i < count; i++) {
+    ranges.push_back(JsonValue(0.05 + i * 0.0031415926535 + 1e-9 * (i % 7)));
+  }
+  json["ranges"] = ranges;
+  JsonArray imu;
+  for (int i = 0; i < count; i++) {
+    imu.push_back(JsonValue(9.80665 * std::sin(i * 0.001)));
+  }
+  json["imu"] = imu;
+  return json;
+}
+
+// 旧实现的等价写法：stringstream 输出（默认 6 位有效数字）
+static std::string legacyFormat(const JsonArray& values) {
+  std::stringstream ss;
+  ss << "[";
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (i > 0) ss << ",";
+    ss << values[i].asDouble();
+  }
+  ss << "]";
+  return ss.str();
+}
+
+int main() {
+  std::cout << "=== MiniROS2 JSON number test ===" << std::endl;
+
+  // 1. 64 位整数：文本和二进制都能往返
+  JsonValue ts;
+  ts["stamp_ns"] = static_cast<int64_t>(1718000000123456789LL);
+  ts["min"] = std::numeric_limits<int64_t>::min();
+  ts["small"] = static_cast<int64_t>(42);
+  JsonValue ts_text = JsonValue::deserialize(ts.serialize());
+  CHECK(ts_text["stamp_ns"].isInt64());
+  CHECK(ts_text["stamp_ns"].asInt64() == 1718000000123456789LL);
+  CHECK(ts_text["min"].asInt64() == std::numeric_limits<int64_t>::min());
+  CHECK(ts_text["small"].isInt());  // int 范围内仍解析为 Int
+  CHECK(ts_text["small"].asInt64() == 42);
+  std::string ts_bin = ts.serializeBinary();
+  JsonValue ts_decoded = JsonValue::deserializeBinary(
+      reinterpret_cast<const uint8_t*>(ts_bin.data()), ts_bin.size());
+  CHECK(ts_decoded["stamp_ns"].asInt64() == 1718000000123456789LL);
+  // 超出 int64 的整数退化为 double
+  CHECK(JsonValue::deserialize("18446744073709551616").isDouble());
+
+  // 2. 浮点数最短往返：解析回来与原值逐位相等，整数值的 double 仍是 Double
+  const double samples[] = {0.1, 1.0 / 3.0, 9.80665, 1e-300, 5e-324,
+                            1.7976931348623157e308, -0.0, 50.0, 123456789.0};
+  for (double value : samples) {
+    JsonValue parsed = JsonValue::deserialize(JsonValue(value).serialize());
+    CHECK(parsed.isDouble());
+    CHECK(parsed.asDouble() == value);
+    CHECK(std::signbit(parsed.asDouble()) == std::signbit(value));
+  }
+  CHECK(JsonValue(0.1).serialize() == "0.1");
+  CHECK(JsonValue(50.0).serialize() == "50.0");
+  CHECK(JsonValue(std::nan("")).serialize() == "null");
+
+  // 3. 数值密集型消息基准
+  const int count = 10000;
+  const int rounds = 20;
+  JsonValue scan = makeScan(count);
+  std::string text = scan.serialize();
+  JsonValue decoded = JsonValue::deserialize(text);
+  for (int i = 0; i < count; i++) {
+    CHECK(decoded["ranges"][i].asDouble() == scan["ranges"][i].asDouble());
+  }
+  CHECK(decoded["stamp_ns"].asInt64() == 1718000000123456789LL);
+
+  std::string legacy;
+  double legacy_ms = timeMs(rounds, [&]() {
+    legacy = legacyFormat(scan["ranges"].asArray()) +
+             legacyFormat(scan["imu"].asArray());
+  });
+  double format_ms = timeMs(rounds, [&]() { text = scan.serialize(); });
+  double parse_ms = timeMs(rounds, [&]() { JsonValue::deserialize(text); });
+  std::cout << 2 * count << " doubles x" << rounds
+            << ": legacy stringstream format " << legacy_ms
+            << " ms (lossy, " << legacy.size() << " bytes), serialize "
+            << format_ms << " ms (" << text.size() << " bytes), parse "
+            << parse_ms << " ms" << std::endl;
+
+  std::cout << "all checks passed" << std::endl;
+  return 0;
+}
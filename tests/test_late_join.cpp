@@ -0,0 +1,131 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mini_ros2/communication/shm_manager.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "mini_ros2/pubsub/subscriber.h"
+#include "test_utils.h"
+
+#define LATE_SUBSCRIBERS 8
+
+using Clock = std::chrono::steady_clock;
+
+static JsonValue makeMessage(int value) {
+  JsonValue msg;
+  msg["value"] = value;
+  return msg;
+}
+
+// 订阅先于发布者：subscribe 不抛异常，第一条消息到达时再映射数据段
+static void subscribeBeforePublisher(ShmManager& manager) {
+  std::string topic = "/late_state";
+  Subscriber<JsonValue> sub(topic);
+  int received = -1;
+  sub.subscribe("state", [&received](const JsonValue& msg) {
+    received = msg["value"].asInt();
+  });
+  CHECK(!sub.isAttached());
+  sub.createTaskFromSubEvent()();  // 尚无数据段：空任务
+  CHECK(received == -1);
+
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&manager);
+  pub.setTopicNameForEvent(topic);
+  pub.publish("state", makeMessage(7));
+  sub.createTaskFromSubEvent()();
+  CHECK(sub.isAttached());
+  CHECK(received == 7);
+}
+
+// 发布者按最大消息大小预先创建数据段，订阅者立即映射
+static void advertiseBeforeFirstMessage(ShmManager& manager) {
+  std::string topic = "/late_scan";
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&manager);
+  pub.setTopicNameForEvent(topic);
+  pub.advertise("scan", 4096);
+  CHECK(manager.getTopicEventId(topic, "scan") >= 0);
+
+  Subscriber<JsonValue> sub(topic);
+  sub.subscribe("scan");
+  CHECK(sub.isAttached());
+  ShmBase segment(topic + "_scan");
+  CHECK(segment.getDataSize() == 4096);
+}
+
+// 多个订阅进程先启动，发布者最后出现：全部收到消息，不需要按顺序启动或 sleep
+static void coldStartAnyOrder() {
+  std::string topic = "/late_cold";
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  std::vector<pid_t> children;
+  for (int i = 0; i < LATE_SUBSCRIBERS; ++i) {
+    pid_t pid = fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+      close(fds[0]);
+      ShmManager manager;
+      registerNode(manager, "late_sub");
+      Subscriber<JsonValue> sub(topic);
+      bool received = false;
+      sub.subscribe("cold", [&received](const JsonValue&) { received = true; });
+      manager.addSubTopic(topic, "cold");
+      int event_id = manager.registerTopicEvent(topic, "cold");
+      char ready = 1;
+      if (write(fds[1], &ready, 1) != 1) {
+        _exit(2);
+      }
+      Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+      while (!received && Clock::now() < deadline) {
+        if (manager.waitForEvent(100).test(event_id)) {
+          sub.createTaskFromSubEvent()();
+        }
+      }
+      manager.removeNode();
+      _exit(received ? 0 : 1);
+    }
+    children.push_back(pid);
+  }
+  close(fds[1]);
+  for (int i = 0; i < LATE_SUBSCRIBERS; ++i) {
+    char ready = 0;
+    CHECK(read(fds[0], &ready, 1) == 1);
+  }
+  close(fds[0]);
+
+  Clock::time_point start = Clock::now();
+  ShmManager manager;
+  registerNode(manager, "late_pub");
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&manager);
+  pub.setTopicNameForEvent(topic);
+  CHECK(pub.getSubscriptionCount("cold") == LATE_SUBSCRIBERS);
+  pub.publish("cold", makeMessage(1));
+  for (pid_t pid : children) {
+    int status = 0;
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+  double delivered_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  manager.removeNode();
+  std::cout << LATE_SUBSCRIBERS << " early subscribers received in "
+            << delivered_ms << " ms" << std::endl;
+}
+
+int main() {
+  ShmManager manager;
+  registerNode(manager, "late_join");
+  subscribeBeforePublisher(manager);
+  advertiseBeforeFirstMessage(manager);
+  coldStartAnyOrder();
+  std::cout << "test_late_join passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "geometry_msgs/msg/twist_stamped.h"
+#include "std_msgs/msg/header.h"
+#include "std_msgs/msg/string.h"
+#include "test_utils.h"
+
+int main() {
+  std::cout << "=== MiniROS2 generated message test ===" << std::endl;
+  geometry_msgs::msg::TwistStamped twist;
+  twist.header.stamp_ns = 1700000000123456789ULL;
+  twist.header.seq = 42;
+  twist.header.frame_id = "base_link";
+  twist.linear.x = 1.5;
+  twist.angular.z = -0.25;
+
+  size_t size = Serializer::getSerializedSize(twist);
+  std::vector<uint8_t> buffer(size);
+  Serializer::serialize(twist, buffer.data(), buffer.size());
+
+  geometry_msgs::msg::TwistStamped decoded;
+  Serializer::deserialize(buffer.data(), buffer.size(), decoded);
+  CHECK(decoded.header.stamp_ns == twist.header.stamp_ns);
+  CHECK(decoded.header.seq == 42);
+  CHECK(decoded.header.frame_id.str() == "base_link");
+  CHECK(decoded.linear.x == 1.5 && decoded.angular.z == -0.25);
+  std::cout << "roundtrip ok, " << size << " bytes, type hash 0x" << std::hex
+            << MessageTraits<geometry_msgs::msg::TwistStamped>::type_hash
+            << std::dec << std::endl;
+
+  // 类型不一致时订阅端应拒绝解析
+  std_msgs::msg::String wrong;
+  bool rejected = false;
+  try {
+    std::vector<uint8_t> big(Serializer::getSerializedSize(wrong) + size);
+    std::copy(buffer.begin(), buffer.end(), big.begin());
+    Serializer::deserialize(big.data(), big.size(), wrong);
+  } catch (const std::exception& e) {
+    std::cout << "mismatch rejected: " << e.what() << std::endl;
+    rejected = true;
+  }
+  CHECK(rejected);
+
+  // 对端发来的有界字段长度超过容量时拒绝解析，而不是越界读取
+  uint32_t bad_size = 1000;
+  std::memcpy(buffer.data() + sizeof(MessageWireHeader) +
+                  offsetof(geometry_msgs::msg::TwistStamped, header) +
+                  offsetof(std_msgs::msg::Header, frame_id),
+              &bad_size, sizeof(bad_size));
+  bool invalid = false;
+  try {
+    Serializer::deserialize(buffer.data(), buffer.size(), decoded);
+  } catch (const std::exception& e) {
+    std::cout << "overflow rejected: " << e.what() << std::endl;
+    invalid = true;
+  }
+  CHECK(invalid);
+
+  bool overflow = false;
+  try {
+    twist.header.frame_id = std::string(64, 'x');
+  } catch (const std::length_error&) {
+    overflow = true;
+  }
+  CHECK(overflow);
+  std::cout << "all checks passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,229 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mini_ros2/communication/network_bridge.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "test_utils.h"
+
+#define BATCH_TOPICS 40
+#define FAST_MESSAGES 200
+#define FAST_RATE_HZ 20
+
+using Clock = std::chrono::steady_clock;
+
+static bool waitUntil(const std::function<bool()>& done, int timeout_ms) {
+  Clock::time_point deadline =
+      Clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!done()) {
+    if (Clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  return true;
+}
+
+static RegistryConfig domainConfig(int domain_id) {
+  RegistryConfig config;
+  config.domain_id = domain_id;
+  return config;
+}
+
+static NetworkBridgeConfig bridgeConfig(int domain_id, uint16_t port) {
+  NetworkBridgeConfig config;
+  config.local = domainConfig(domain_id);
+  config.transport.multicast_port = port;
+  config.transport.interface_address = "127.0.0.1";
+  config.scan_interval_ms = 20;
+  return config;
+}
+
+static UdpCommAdapter& udpAdapter(NetworkBridge& bridge) {
+  return static_cast<UdpCommAdapter&>(bridge.gateway().adapter());
+}
+
+static void publishText(Publisher<JsonValue>& pub, const std::string& text) {
+  pub.publishLoaned("data", 64, [&text](uint8_t* buffer, size_t) {
+    std::strcpy(reinterpret_cast<char*>(buffer), text.c_str());
+    return text.size() + 1;
+  });
+}
+
+// 本地分区中的发布者，topic 为不含前缀的名字
+static std::unique_ptr<Publisher<JsonValue>> makePublisher(
+    ShmManager& local, int domain_id, const std::string& topic) {
+  std::string full = domainConfig(domain_id).topicPrefix() + topic;
+  auto pub = std::make_unique<Publisher<JsonValue>>(full);
+  pub->setShmManager(&local);
+  pub->setTopicNameForEvent(full);
+  return pub;
+}
+
+static std::string readText(int domain_id, const std::string& topic) {
+  auto segment = attachTopicSegment(domainConfig(domain_id).topicPrefix() +
+                                    topic + "_data");
+  if (segment == nullptr) {
+    return "";
+  }
+  char buffer[64];
+  segment->Read(buffer, sizeof(buffer));
+  buffer[sizeof(buffer) - 1] = '\0';
+  return buffer;
+}
+
+static bool contains(const std::vector<std::string>& names,
+                     const std::string& name) {
+  return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+// 只有允许列表中的 topic 被导出；远端按导入列表写入本地分区
+static void allowlist(uint16_t port) {
+  ShmManager local(domainConfig(60));
+  local.setNodeId(local.getNextNodeId());
+  auto chatter = makePublisher(local, 60, "chatter");
+  auto secret = makePublisher(local, 60, "secret");
+  // 第一次发布创建数据段并登记 topic，桥扫描到后才开始导出
+  publishText(*chatter, "hello 0");
+  publishText(*secret, "secret 0");
+
+  NetworkBridgeConfig sender_config = bridgeConfig(60, port);
+  sender_config.export_patterns = {"chatter_*"};
+  NetworkBridge sender(sender_config);
+  NetworkBridgeConfig receiver_config = bridgeConfig(61, port);
+  receiver_config.import_patterns = {"chatter_*"};
+  NetworkBridge receiver(receiver_config);
+  receiver.start();
+  sender.start();
+
+  CHECK(waitUntil([&]() { return readText(61, "chatter") == "hello 0"; },
+                  2000));
+  std::vector<std::string> exported = sender.exportedTopics();
+  CHECK(exported.size() == 1 && exported[0] == "chatter_data");
+
+  // 之后新建的 topic 由扫描线程自动导出
+  auto odom = makePublisher(local, 60, "chatter_odom");
+  publishText(*odom, "odom 0");
+  CHECK(waitUntil(
+      [&]() { return contains(sender.exportedTopics(), "chatter_odom_data"); },
+      1000));
+  publishText(*odom, "odom 1");
+  publishText(*chatter, "hello 1");
+  publishText(*secret, "secret 1");
+  CHECK(waitUntil([&]() { return readText(61, "chatter_odom") == "odom 1"; },
+                  2000));
+  CHECK(waitUntil([&]() { return readText(61, "chatter") == "hello 1"; },
+                  2000));
+  CHECK(readText(61, "secret").empty());
+  CHECK(receiver.getStats().lost == 0);
+  sender.stop();
+  receiver.stop();
+}
+
+// 同一轮的小消息合并成少量报文
+static void batching(uint16_t port) {
+  ShmManager local(domainConfig(62));
+  local.setNodeId(local.getNextNodeId());
+  std::vector<std::unique_ptr<Publisher<JsonValue>>> pubs;
+  for (int i = 0; i < BATCH_TOPICS; i++) {
+    pubs.push_back(
+        makePublisher(local, 62, "batch_t" + std::to_string(i)));
+    publishText(*pubs.back(), "first");
+  }
+  NetworkBridgeConfig receiver_config = bridgeConfig(63, port);
+  receiver_config.import_patterns = {"batch_*"};
+  NetworkBridge receiver(receiver_config);
+  receiver.start();
+
+  for (bool coalesce : {true, false}) {
+    NetworkBridgeConfig sender_config = bridgeConfig(62, port);
+    sender_config.export_patterns = {"batch_*"};
+    sender_config.transport.coalesce = coalesce;
+    NetworkBridge sender(sender_config);
+    CHECK(sender.refresh() == BATCH_TOPICS);
+    CHECK(sender.refresh() == 0);
+    uint64_t received = receiver.getStats().received;
+    for (int i = 0; i < BATCH_TOPICS; i++) {
+      publishText(*pubs[i], "batch " + std::to_string(i));
+    }
+    CHECK(sender.gateway().exportOnce(0) == BATCH_TOPICS);
+    uint64_t datagrams = udpAdapter(sender).datagramsSent();
+    std::cout << "batching: " << BATCH_TOPICS << " messages in " << datagrams
+              << " datagrams (coalesce " << coalesce << ")" << std::endl;
+    if (coalesce) {
+      // 每帧约 140 字节，1500 字节的 MTU 一个报文可以装下约 10 帧
+      CHECK(datagrams <= BATCH_TOPICS / 5);
+    } else {
+      CHECK(datagrams == BATCH_TOPICS);
+    }
+    CHECK(waitUntil(
+        [&]() {
+          return receiver.getStats().received == received + BATCH_TOPICS;
+        },
+        2000));
+    for (int i = 0; i < BATCH_TOPICS; i++) {
+      CHECK(readText(63, "batch_t" + std::to_string(i)) ==
+            "batch " + std::to_string(i));
+    }
+  }
+  CHECK(receiver.getStats().lost == 0);
+  receiver.stop();
+}
+
+// 限速：高频 topic 按上限发出，间隔内只保留最新一条，最后一条总会送达
+static void rateLimit(uint16_t port) {
+  ShmManager local(domainConfig(64));
+  local.setNodeId(local.getNextNodeId());
+  auto fast = makePublisher(local, 64, "fast");
+  publishText(*fast, "fast start");
+
+  NetworkBridgeConfig sender_config = bridgeConfig(64, port);
+  sender_config.export_patterns = {"fast_*"};
+  sender_config.rate_limits = {{"fast_*", FAST_RATE_HZ}};
+  NetworkBridge sender(sender_config);
+  NetworkBridgeConfig receiver_config = bridgeConfig(65, port);
+  receiver_config.import_patterns = {"*"};
+  NetworkBridge receiver(receiver_config);
+  receiver.start();
+  sender.start();
+  CHECK(waitUntil([&]() { return readText(65, "fast") == "fast start"; },
+                  2000));
+
+  uint64_t before = receiver.getStats().received;
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < FAST_MESSAGES; i++) {
+    publishText(*fast, "fast " + std::to_string(i));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  std::string last = "fast " + std::to_string(FAST_MESSAGES - 1);
+  CHECK(waitUntil([&]() { return readText(65, "fast") == last; }, 1000));
+  uint64_t received = receiver.getStats().received - before;
+  CommStats stats = sender.getStats();
+  std::cout << "rate limit: " << FAST_MESSAGES << " messages in " << seconds
+            << " s, " << received << " forwarded, " << stats.throttled
+            << " throttled" << std::endl;
+  CHECK(received <= seconds * FAST_RATE_HZ + 3);
+  CHECK(received >= seconds * FAST_RATE_HZ / 2);
+  CHECK(stats.throttled > 0);
+  sender.stop();
+  receiver.stop();
+}
+
+int main() {
+  uint16_t port = static_cast<uint16_t>(20000 + getpid() % 20000);
+  allowlist(port);
+  batching(port + 1);
+  rateLimit(port + 2);
+  std::cout << "test_network_bridge passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,275 @@
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mini_ros2/communication/node_discovery.h"
+#include "test_utils.h"
+
+#define SCALE_PARTICIPANTS 100
+#define SCALE_ENDPOINTS 4
+
+using Clock = std::chrono::steady_clock;
+
+static bool waitUntil(const std::function<bool()>& done, int timeout_ms) {
+  Clock::time_point deadline =
+      Clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!done()) {
+    if (Clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  return true;
+}
+
+static DiscoveryConfig loopbackConfig(const std::string& name, uint16_t port) {
+  DiscoveryConfig config;
+  config.name = name;
+  config.port = port;
+  config.interface_address = "127.0.0.1";
+  config.locator = {"127.0.0.1", port};
+  config.initial_period_ms = 20;
+  config.max_period_ms = 200;
+  config.lease_ms = 600;
+  return config;
+}
+
+// 监听器收到的事件，按 "+name" / "-name" / "+topic" / "-topic" 记录
+struct EventLog {
+  std::mutex mutex;
+  std::vector<std::string> events;
+
+  void attach(NodeDiscovery& discovery) {
+    discovery.setListener([this](const DiscoveryEvent& event) {
+      std::lock_guard<std::mutex> lock(mutex);
+      switch (event.type) {
+        case DiscoveryEventType::ParticipantDiscovered:
+          events.push_back("+" + event.participant_name);
+          break;
+        case DiscoveryEventType::ParticipantLost:
+          events.push_back("-" + event.participant_name);
+          break;
+        case DiscoveryEventType::EndpointAdded:
+          events.push_back("+" + event.endpoint.topic);
+          break;
+        case DiscoveryEventType::EndpointRemoved:
+          events.push_back("-" + event.endpoint.topic);
+          break;
+      }
+    });
+  }
+  bool contains(const std::string& event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& got : events) {
+      if (got == event) return true;
+    }
+    return false;
+  }
+};
+
+static bool knows(NodeDiscovery& discovery, uint64_t id,
+                  size_t endpoints) {
+  for (const auto& participant : discovery.participants()) {
+    if (participant.id == id) {
+      return participant.endpoints.size() == endpoints;
+    }
+  }
+  return false;
+}
+
+// 互相发现全量状态，之后端点变化以增量送达
+static void discoveryAndDeltas(uint16_t port) {
+  NodeDiscovery talker(loopbackConfig("talker", port));
+  NodeDiscovery listener(loopbackConfig("listener", port));
+  talker.addEndpoint(EndpointKind::Publisher, "/chatter", "data");
+  listener.addEndpoint(EndpointKind::Subscriber, "/chatter", "data");
+  EventLog log;
+  log.attach(listener);
+  talker.start();
+  listener.start();
+  CHECK(waitUntil([&]() { return knows(listener, talker.participantId(), 1); },
+                  2000));
+  CHECK(waitUntil([&]() { return knows(talker, listener.participantId(), 1); },
+                  2000));
+  CHECK(log.contains("+talker"));
+  CHECK(log.contains("+/chatter"));
+  DiscoveredParticipant seen = listener.participants().at(0);
+  CHECK(seen.name == "talker");
+  CHECK(seen.locator.host == "127.0.0.1" && seen.locator.port == port);
+  CHECK(seen.endpoints[0].kind == EndpointKind::Publisher);
+
+  // 等宣告稳定下来，再改端点：只应发出增量
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  DiscoveryStats before = talker.getStats();
+  talker.addEndpoint(EndpointKind::Publisher, "/odom", "data");
+  CHECK(waitUntil([&]() { return log.contains("+/odom"); }, 1000));
+  talker.removeEndpoint(EndpointKind::Publisher, "/chatter", "data");
+  CHECK(waitUntil([&]() { return log.contains("-/chatter"); }, 1000));
+  CHECK(knows(listener, talker.participantId(), 1));
+  DiscoveryStats after = talker.getStats();
+  CHECK(after.deltas_sent >= before.deltas_sent + 2);
+  CHECK(after.full_sent == before.full_sent);
+
+  talker.stop();
+  listener.stop();
+}
+
+// 状态稳定后宣告周期退避到 max_period_ms，变化后立即回到初始周期
+static void announceBackoff(uint16_t port) {
+  NodeDiscovery node(loopbackConfig("backoff", port));
+  NodeDiscovery peer(loopbackConfig("peer", port));
+  EventLog log;
+  log.attach(peer);
+  node.start();
+  peer.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  uint64_t before = node.getStats().heartbeats_sent;
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  uint64_t heartbeats = node.getStats().heartbeats_sent - before;
+  std::cout << "backoff: " << heartbeats << " heartbeats/s when stable"
+            << std::endl;
+  // 初始周期下为 50 个/秒，退避后约 5 个/秒
+  CHECK(heartbeats >= 3 && heartbeats <= 7);
+
+  Clock::time_point start = Clock::now();
+  node.addEndpoint(EndpointKind::Subscriber, "/scan", "data");
+  CHECK(waitUntil([&]() { return log.contains("+/scan"); }, 1000));
+  double latency_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  std::cout << "backoff: change seen after " << latency_ms << " ms"
+            << std::endl;
+  CHECK(latency_ms < 100);
+  node.stop();
+  peer.stop();
+}
+
+// 后加入的参与者请求全量状态；租期到期和 Bye 都会被判定离开
+static void lateJoinAndLease(uint16_t port) {
+  NodeDiscovery early(loopbackConfig("early", port));
+  for (int i = 0; i < 3; i++) {
+    early.addEndpoint(EndpointKind::Publisher, "/topic_" + std::to_string(i),
+                      "data");
+  }
+  early.start();
+  // 等 early 退避，确认 late 不是靠周期宣告而是靠请求拿到全量状态
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  NodeDiscovery late(loopbackConfig("late", port));
+  EventLog log;
+  log.attach(late);
+  Clock::time_point start = Clock::now();
+  late.start();
+  CHECK(waitUntil([&]() { return knows(late, early.participantId(), 3); },
+                  1000));
+  double join_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  std::cout << "late join: full state after " << join_ms << " ms" << std::endl;
+  CHECK(join_ms < 150);
+
+  // 崩溃：不发 Bye，租期后离开
+  start = Clock::now();
+  early.stop(false);
+  CHECK(waitUntil([&]() { return log.contains("-early"); }, 2000));
+  double lease_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  std::cout << "lease: crashed participant dropped after " << lease_ms << " ms"
+            << std::endl;
+  CHECK(lease_ms >= 400);
+  CHECK(late.participants().empty());
+
+  // 正常退出：Bye 立即生效
+  EventLog early_log;
+  early.setListener(nullptr);
+  early_log.attach(early);
+  early.start();
+  CHECK(waitUntil([&]() { return early_log.contains("+late"); }, 1000));
+  start = Clock::now();
+  late.stop();
+  CHECK(waitUntil([&]() { return early_log.contains("-late"); }, 1000));
+  double bye_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  CHECK(bye_ms < 100);
+  early.stop();
+}
+
+// 上百个参与者：收敛后的发现流量只有心跳
+static void scale(uint16_t port) {
+  std::vector<std::unique_ptr<NodeDiscovery>> nodes;
+  for (int i = 0; i < SCALE_PARTICIPANTS; i++) {
+    DiscoveryConfig config = loopbackConfig("node_" + std::to_string(i), port);
+    config.initial_period_ms = 50;
+    config.max_period_ms = 500;
+    config.lease_ms = 3000;
+    nodes.push_back(std::make_unique<NodeDiscovery>(config));
+    for (int e = 0; e < SCALE_ENDPOINTS; e++) {
+      nodes.back()->addEndpoint(
+          e % 2 == 0 ? EndpointKind::Publisher : EndpointKind::Subscriber,
+          "/node_" + std::to_string(i) + "/topic_" + std::to_string(e),
+          "data");
+    }
+  }
+  Clock::time_point start = Clock::now();
+  for (auto& node : nodes) {
+    node->start();
+  }
+  auto converged = [&nodes]() {
+    for (auto& node : nodes) {
+      std::vector<DiscoveredParticipant> participants = node->participants();
+      if (participants.size() != SCALE_PARTICIPANTS - 1) return false;
+      for (const auto& participant : participants) {
+        if (participant.endpoints.size() != SCALE_ENDPOINTS) return false;
+      }
+    }
+    return true;
+  };
+  CHECK(waitUntil(converged, 5000));
+  double converge_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  // 等所有参与者退避到最大周期后统计稳态流量
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+  auto totals = [&nodes]() {
+    DiscoveryStats sum;
+    for (auto& node : nodes) {
+      DiscoveryStats stats = node->getStats();
+      sum.full_sent += stats.full_sent;
+      sum.heartbeats_sent += stats.heartbeats_sent;
+      sum.bytes_sent += stats.bytes_sent;
+    }
+    return sum;
+  };
+  DiscoveryStats before = totals();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+  DiscoveryStats after = totals();
+  CHECK(converged());
+  double bytes_per_second = (after.bytes_sent - before.bytes_sent) / 2.0;
+  std::cout << "scale: " << SCALE_PARTICIPANTS << " participants converged in "
+            << converge_ms << " ms, steady state " << bytes_per_second
+            << " bytes/s (" << (after.heartbeats_sent - before.heartbeats_sent)
+            << " heartbeats, " << (after.full_sent - before.full_sent)
+            << " full) in 2 s" << std::endl;
+  // 心跳只有报文头，每个参与者约 2 个/秒
+  CHECK(after.full_sent == before.full_sent);
+  CHECK(bytes_per_second <
+        SCALE_PARTICIPANTS * 3.0 * sizeof(DiscoveryHeader));
+  for (auto& node : nodes) {
+    node->stop();
+  }
+}
+
+int main() {
+  uint16_t port = static_cast<uint16_t>(20000 + getpid() % 20000);
+  discoveryAndDeltas(port);
+  announceBackoff(port + 1);
+  lateJoinAndLease(port + 2);
+  scale(port + 3);
+  std::cout << "test_node_discovery passed" << std::endl;
+  return 0;
+}
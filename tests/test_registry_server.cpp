@@ -0,0 +1,208 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mini_ros2/communication/registry.h"
+#include "test_utils.h"
+
+#define BENCH_THREADS 8
+#define BENCH_PER_THREAD 5000
+#define STORM_THREADS 16
+#define STORM_ROUNDS 50
+
+using Clock = std::chrono::steady_clock;
+
+static bool waitUntil(const std::function<bool()>& done, int timeout_ms) {
+  Clock::time_point deadline =
+      Clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!done()) {
+    if (Clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+static void basicOperations(uint16_t port) {
+  RegistryClient client("127.0.0.1", port);
+  uint64_t version = client.registerNode("talker", "10.0.0.1:7400");
+  CHECK(version > 0);
+  // 重复注册同一地址不改变图
+  CHECK(client.registerNode("talker", "10.0.0.1:7400") == version);
+  std::string address;
+  CHECK(client.lookup("talker", address));
+  CHECK(address == "10.0.0.1:7400");
+  CHECK(client.registerNode("listener", "10.0.0.2:7400") == version + 1);
+  uint64_t list_version = 0;
+  CHECK(client.list(&list_version).size() == 2);
+  CHECK(list_version == version + 1);
+  CHECK(client.unregisterNode("talker"));
+  CHECK(!client.unregisterNode("talker"));
+  CHECK(!client.lookup("talker", address));
+  CHECK(client.unregisterNode("listener"));
+}
+
+// 观察者先拿到快照，之后按顺序收到每次变化；注册方断开时它的节点自动注销
+static void watchNotifications(uint16_t port) {
+  RegistryClient watcher("127.0.0.1", port);
+  uint64_t version = 0;
+  CHECK(watcher.watch(&version).empty());
+  {
+    RegistryClient node("127.0.0.1", port);
+    node.registerNode("camera", "10.0.0.3:7400");
+    node.registerNode("lidar", "10.0.0.4:7400");
+    node.registerNode("imu", "10.0.0.5:7400");
+    CHECK(node.unregisterNode("imu"));
+  }
+  const char* expected[] = {"+camera", "+lidar", "+imu", "-imu"};
+  for (const char* change : expected) {
+    RegistryNotification notification;
+    CHECK(watcher.waitNotification(notification, 2000));
+    std::string got = (notification.added ? "+" : "-") +
+                      notification.entry.name;
+    CHECK(got == change);
+    CHECK(notification.version == ++version);
+  }
+  // 连接关闭后剩下的两个节点被注销，顺序不定
+  int removed = 0;
+  RegistryNotification notification;
+  while (removed < 2 && watcher.waitNotification(notification, 2000)) {
+    CHECK(!notification.added);
+    CHECK(notification.entry.name == "camera" ||
+          notification.entry.name == "lidar");
+    removed++;
+  }
+  CHECK(removed == 2);
+  CHECK(watcher.list().empty());
+}
+
+// 节点重连后重新注册：归属转到新连接，旧连接断开不会注销它
+static void reregisterTransfersOwnership(uint16_t port) {
+  RegistryClient fresh("127.0.0.1", port);
+  {
+    RegistryClient stale("127.0.0.1", port);
+    stale.registerNode("planner", "10.0.0.6:7400");
+    fresh.registerNode("planner", "10.0.0.7:7400");
+  }
+  // 等旧连接关闭被处理：之后的请求在同一个事件循环中排在它后面
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::string address;
+  CHECK(fresh.lookup("planner", address));
+  CHECK(address == "10.0.0.7:7400");
+  CHECK(fresh.unregisterNode("planner"));
+}
+
+// 非法帧只断开发送它的连接
+static void badFrameClosesConnection(RegistryServer& server) {
+  uint64_t errors = server.getStats().errors;
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(server.port());
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  CHECK(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+  const char garbage[] = "REGISTER talker,127.0.0.1:9000";  // 旧的文本协议
+  CHECK(send(fd, garbage, sizeof(garbage), 0) ==
+        static_cast<ssize_t>(sizeof(garbage)));
+  char buffer[16];
+  CHECK(recv(fd, buffer, sizeof(buffer), 0) == 0);
+  close(fd);
+  CHECK(server.getStats().errors == errors + 1);
+  RegistryClient client("127.0.0.1", server.port());
+  CHECK(client.list().empty());
+}
+
+// 多个客户端并发流水线注册
+static void pipelinedThroughput(RegistryServer& server) {
+  uint64_t requests = server.getStats().requests;
+  std::vector<std::thread> threads;
+  std::vector<size_t> registered(BENCH_THREADS, 0);
+  Clock::time_point start = Clock::now();
+  for (int t = 0; t < BENCH_THREADS; t++) {
+    threads.emplace_back([&server, &registered, t]() {
+      RegistryClient client("127.0.0.1", server.port());
+      std::vector<RegistryEntry> entries;
+      for (int i = 0; i < BENCH_PER_THREAD; i++) {
+        entries.push_back({"node_" + std::to_string(t) + "_" +
+                               std::to_string(i),
+                           "10.0." + std::to_string(t) + "." +
+                               std::to_string(i % 256) + ":7400"});
+      }
+      registered[t] = client.registerNodes(entries);
+      CHECK(client.list().size() >= BENCH_PER_THREAD);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  size_t total = 0;
+  for (size_t count : registered) {
+    total += count;
+  }
+  CHECK(total == BENCH_THREADS * BENCH_PER_THREAD);
+  double rate = total / seconds;
+  std::cout << "pipelined: " << total << " registrations from "
+            << BENCH_THREADS << " clients in " << seconds * 1000 << " ms, "
+            << static_cast<uint64_t>(rate) << " registrations/s" << std::endl;
+  CHECK(rate > 10000);
+  CHECK(server.getStats().requests >= requests + total);
+  // 客户端都已断开，注册随连接注销
+  CHECK(waitUntil([&server]() { return server.getStats().entries == 0; },
+                  2000));
+}
+
+// 重连风暴：大量连接反复建立、注册、断开
+static void reconnectStorm(RegistryServer& server) {
+  uint64_t accepted = server.getStats().accepted;
+  std::vector<std::thread> threads;
+  Clock::time_point start = Clock::now();
+  for (int t = 0; t < STORM_THREADS; t++) {
+    threads.emplace_back([&server, t]() {
+      for (int round = 0; round < STORM_ROUNDS; round++) {
+        RegistryClient client("127.0.0.1", server.port());
+        client.registerNode("storm_" + std::to_string(t), "127.0.0.1:9000");
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  CHECK(waitUntil(
+      [&server]() {
+        RegistryServerStats stats = server.getStats();
+        return stats.connections == 0 && stats.entries == 0;
+      },
+      2000));
+  CHECK(server.getStats().accepted == accepted + STORM_THREADS * STORM_ROUNDS);
+  std::cout << "reconnect storm: " << STORM_THREADS * STORM_ROUNDS
+            << " connect/register/close cycles in " << seconds * 1000 << " ms"
+            << std::endl;
+}
+
+int main() {
+  RegistryServer server(0, "127.0.0.1");
+  server.start();
+  basicOperations(server.port());
+  watchNotifications(server.port());
+  reregisterTransfersOwnership(server.port());
+  badFrameClosesConnection(server);
+  pipelinedThroughput(server);
+  reconnectStorm(server);
+  server.stop();
+  std::cout << "test_registry_server passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,272 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mini_ros2/communication/comm_adapter.h"
+#include "mini_ros2/communication/socket_comm.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "test_utils.h"
+#include "udp_test_utils.h"
+
+#define LOSSY_MESSAGES 500
+#define LOSS_RATE 0.2
+#define COMMANDS 100
+
+using Clock = std::chrono::steady_clock;
+
+static bool waitUntil(const std::function<bool()>& done, int timeout_ms) {
+  Clock::time_point deadline =
+      Clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!done()) {
+    if (Clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  return true;
+}
+
+static UdpCommConfig loopbackConfig(uint16_t port, double drop_rate = 0) {
+  UdpCommConfig config;
+  config.multicast_port = port;
+  config.interface_address = "127.0.0.1";
+  config.heartbeat_ms = 20;
+  config.receive_drop_rate = drop_rate;
+  return config;
+}
+
+// 接收端按 topic 记录交付的序号
+struct Delivered {
+  std::mutex mutex;
+  std::vector<uint64_t> commands;
+  std::vector<uint64_t> scans;
+
+  void attach(UdpCommAdapter& adapter) {
+    adapter.start([this](const CommMessage& msg) {
+      std::lock_guard<std::mutex> lock(mutex);
+      (msg.topic == "cmd" ? commands : scans).push_back(msg.seq);
+    });
+  }
+  uint64_t lastCommand() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return commands.empty() ? 0 : commands.back();
+  }
+};
+
+static CommFrame makeFrame(const std::string& topic, uint64_t seq,
+                           bool reliable, const uint64_t& value,
+                           const CommEndpoint& dest = CommEndpoint()) {
+  CommFrame frame;
+  frame.topic = topic;
+  frame.event = "data";
+  frame.seq = seq;
+  frame.segment_size = sizeof(value);
+  frame.reliable = reliable;
+  frame.data = reinterpret_cast<const uint8_t*>(&value);
+  frame.size = sizeof(value);
+  frame.dest = dest;
+  return frame;
+}
+
+// 接收端丢弃 20% 的报文（含心跳和重发）：可靠 topic 按序完整送达，
+// 尽力而为的 topic 丢失约 20%
+static void lossyDelivery(uint16_t port) {
+  UdpCommAdapter sender(loopbackConfig(port));
+  UdpCommAdapter receiver(loopbackConfig(port, LOSS_RATE));
+  sender.start([](const CommMessage&) {});
+  Delivered delivered;
+  delivered.attach(receiver);
+
+  Clock::time_point start = Clock::now();
+  for (uint64_t seq = 1; seq <= LOSSY_MESSAGES; seq++) {
+    uint64_t value = seq;
+    CHECK(sender.sendBatch({makeFrame("cmd", seq, true, value),
+                            makeFrame("scan", seq, false, value)}) == 2);
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+  CHECK(waitUntil([&]() { return delivered.lastCommand() == LOSSY_MESSAGES; },
+                  3000));
+  double recover_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  std::lock_guard<std::mutex> lock(delivered.mutex);
+  // 第一条消息作为起点（它本身也可能丢失），之后连续、不重复
+  CHECK(!delivered.commands.empty() && delivered.commands.front() <= 10);
+  for (size_t i = 1; i < delivered.commands.size(); i++) {
+    CHECK(delivered.commands[i] == delivered.commands[i - 1] + 1);
+  }
+  CHECK(delivered.scans.size() < LOSSY_MESSAGES * 0.9);
+  UdpReliableStats sent = sender.reliableStats();
+  UdpReliableStats received = receiver.reliableStats();
+  std::cout << "lossy: " << delivered.commands.size() << " reliable, "
+            << delivered.scans.size() << "/" << LOSSY_MESSAGES
+            << " best-effort delivered in " << recover_ms << " ms; "
+            << received.nacks_sent << " nacks, " << sent.retransmits
+            << " retransmits, " << sent.heartbeats_sent << " heartbeats"
+            << std::endl;
+  CHECK(received.nacks_sent > 0 && sent.retransmits > 0);
+  CHECK(received.unrecoverable == 0);
+  receiver.stop();
+  sender.stop();
+}
+
+// 后加入的接收端从心跳之后的消息开始，不请求已发出的历史
+static void lateJoin(uint16_t port) {
+  UdpCommAdapter sender(loopbackConfig(port));
+  sender.start([](const CommMessage&) {});
+  uint64_t value = 0;
+  for (uint64_t seq = 1; seq <= 20; seq++) {
+    sender.sendBatch({makeFrame("cmd", seq, true, value)});
+  }
+  UdpCommAdapter receiver(loopbackConfig(port));
+  Delivered delivered;
+  delivered.attach(receiver);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  for (uint64_t seq = 21; seq <= 25; seq++) {
+    sender.sendBatch({makeFrame("cmd", seq, true, value)});
+  }
+  CHECK(waitUntil([&]() { return delivered.lastCommand() == 25; }, 1000));
+  std::lock_guard<std::mutex> lock(delivered.mutex);
+  CHECK(delivered.commands.size() == 5 && delivered.commands.front() == 21);
+  CHECK(sender.reliableStats().retransmits == 0);
+  receiver.stop();
+  sender.stop();
+}
+
+// 缺失的消息已移出发送端的历史窗口：重发窗口中还有的，其余跳过并计数
+static void historyEviction(uint16_t port) {
+  UdpCommConfig config = loopbackConfig(port);
+  config.reliable_history = 5;
+  UdpCommAdapter sender(config);
+  sender.start([](const CommMessage&) {});
+  UdpCommAdapter receiver(loopbackConfig(port));
+  Delivered delivered;
+  delivered.attach(receiver);
+  CommEndpoint to_receiver = receiver.localEndpoint();
+  // 没有人监听的端口：发往这里的消息对接收端来说就是丢失了
+  CommEndpoint black_hole{"127.0.0.1", static_cast<uint16_t>(port + 100)};
+
+  uint64_t value = 0;
+  sender.sendBatch({makeFrame("cmd", 1, true, value, to_receiver)});
+  CHECK(waitUntil([&]() { return delivered.lastCommand() == 1; }, 1000));
+  for (uint64_t seq = 2; seq <= 20; seq++) {
+    sender.sendBatch({makeFrame("cmd", seq, true, value, black_hole)});
+  }
+  sender.sendBatch({makeFrame("cmd", 21, true, value, to_receiver)});
+  CHECK(waitUntil([&]() { return delivered.lastCommand() == 21; }, 1000));
+
+  std::lock_guard<std::mutex> lock(delivered.mutex);
+  std::vector<uint64_t> expected = {1, 17, 18, 19, 20, 21};
+  CHECK(delivered.commands == expected);
+  CHECK(receiver.reliableStats().unrecoverable == 15);
+  CHECK(sender.reliableStats().retransmits >= 4);
+  receiver.stop();
+  sender.stop();
+}
+
+// NACK 发往心跳的源地址：心跳中自报的地址不可达（如绑定在 0.0.0.0 的对端
+// 自报 127.0.0.1）时，接收端仍把 NACK 回给真正的发送端
+static void nackToSource(uint16_t port) {
+  UdpCommAdapter receiver(loopbackConfig(port));
+  receiver.start([](const CommMessage&) {});
+  RawUdpPeer writer;
+  const uint64_t writer_id = 4242;
+  char command = 'c';
+  writer.sendTo(receiver.localEndpoint(),
+                RawUdpPeer::frame("cmd", "data", UDP_COMM_FLAG_RELIABLE,
+                                  writer_id, 1, &command, 1));
+  // 心跳称已发出到 3 号，回复地址为不可达的文档地址
+  UdpHeartbeat heartbeat;
+  std::memset(&heartbeat, 0, sizeof(heartbeat));
+  heartbeat.first_seq = htobe64(1);
+  heartbeat.reply_addr = inet_addr("192.0.2.1");
+  heartbeat.reply_port = htons(9);
+  writer.sendTo(receiver.localEndpoint(),
+                RawUdpPeer::frame("cmd", "data", UDP_COMM_FLAG_HEARTBEAT,
+                                  writer_id, 3, &heartbeat,
+                                  sizeof(heartbeat)));
+  std::vector<uint8_t> packet;
+  CHECK(writer.receive(UDP_COMM_FLAG_NACK, packet, 1000));
+  UdpNack nack;
+  CHECK(packet.size() == sizeof(UdpFrameHeader) + 7 + sizeof(nack));
+  std::memcpy(&nack, packet.data() + packet.size() - sizeof(nack),
+              sizeof(nack));
+  CHECK(be64toh(nack.writer_id) == writer_id);
+  CHECK(be64toh(nack.base_seq) == 2);
+  receiver.stop();
+  std::cout << "NACK returned to the heartbeat source" << std::endl;
+}
+
+static RegistryConfig domainConfig(int domain_id) {
+  RegistryConfig config;
+  config.domain_id = domain_id;
+  return config;
+}
+
+// 经网关的命令 topic：有损链路上发出的每条命令都写入远端分区
+static void gatewayCommands(uint16_t port) {
+  CommGateway receiver(domainConfig(71), std::make_unique<UdpCommAdapter>(
+                                             loopbackConfig(port, LOSS_RATE)));
+  receiver.addImport("cmd_vel", "data");
+  receiver.start();
+
+  ShmManager local(domainConfig(70));
+  local.setNodeId(local.getNextNodeId());
+  std::string topic = domainConfig(70).topicPrefix() + "cmd_vel";
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&local);
+  pub.setTopicNameForEvent(topic);
+  CommGateway sender(domainConfig(70),
+                     std::make_unique<UdpCommAdapter>(loopbackConfig(port)));
+  sender.setReliable("cmd_vel", "data");
+  sender.addExport("cmd_vel", "data");
+  sender.start();
+
+  for (int i = 0; i < COMMANDS; i++) {
+    std::string text = "cmd " + std::to_string(i);
+    pub.publishLoaned("data", 32, [&text](uint8_t* buffer, size_t) {
+      std::strcpy(reinterpret_cast<char*>(buffer), text.c_str());
+      return text.size() + 1;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  std::string last = "cmd " + std::to_string(COMMANDS - 1);
+  auto lastReceived = [&]() {
+    auto segment =
+        attachTopicSegment(domainConfig(71).topicPrefix() + "cmd_vel_data");
+    if (segment == nullptr) return false;
+    char buffer[32];
+    segment->Read(buffer, sizeof(buffer));
+    return last == buffer;
+  };
+  CHECK(waitUntil(lastReceived, 3000));
+  CommStats sent = sender.getStats();
+  CommStats received = receiver.getStats();
+  std::cout << "gateway: " << sent.sent << " commands sent, "
+            << received.received << " written, " << received.lost << " lost"
+            << std::endl;
+  // 第一条命令可能丢失（作为起点之前），之后的全部送达
+  CHECK(received.received + 2 >= sent.sent);
+  CHECK(received.lost == 0);
+  sender.stop();
+  receiver.stop();
+}
+
+int main() {
+  uint16_t port = static_cast<uint16_t>(20000 + getpid() % 20000);
+  lossyDelivery(port);
+  lateJoin(port + 1);
+  historyEviction(port + 2);
+  gatewayCommands(port + 3);
+  nackToSource(port + 4);
+  std::cout << "test_reliable_transport passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,235 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <string>
+
+#include "mini_ros2/communication/shm_manager.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "test_utils.h"
+
+// 混沌测试：持有共享内存锁的进程在写入中途被 SIGKILL，其余进程的等待不超过一个超时周期
+
+#define CHAOS_TIMEOUT_MS 1000
+#define CHAOS_TOPIC_SHM "/miniros2_chaos_topic"
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedMs(Clock::time_point since) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - since)
+      .count();
+}
+
+// 子进程执行 body（持锁写到一半），通知父进程后挂起等待被杀死
+// body 中的共享内存对象需要泄漏：析构会解除映射，内核就无法在进程死亡时释放 robust 锁
+template <typename F>
+static pid_t forkVictim(F&& body) {
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  pid_t pid = fork();
+  CHECK(pid >= 0);
+  if (pid == 0) {
+    close(fds[0]);
+    body();
+    char ready = 1;
+    if (write(fds[1], &ready, 1) != 1) {
+      _exit(2);
+    }
+    while (true) {
+      pause();
+    }
+  }
+  close(fds[1]);
+  char ready = 0;
+  CHECK(read(fds[0], &ready, 1) == 1);
+  close(fds[0]);
+  return pid;
+}
+
+static Clock::time_point killVictim(pid_t pid) {
+  Clock::time_point killed_at = Clock::now();
+  CHECK(kill(pid, SIGKILL) == 0);
+  int status = 0;
+  CHECK(waitpid(pid, &status, 0) == pid);  // 回收僵尸进程，否则 kill(pid, 0) 仍成功
+  CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+  return killed_at;
+}
+
+// 发布者在 Loan 中写到一半被杀死：阻塞的读者在锁恢复后拿到"残缺"异常，下一次写入恢复正常
+static void publisherDiesMidWrite() {
+  ShmBase topic(CHAOS_TOPIC_SHM, 256);
+  topic.Create();
+  topic.Open();
+  const char intact[] = "intact message";
+  topic.Write(intact, sizeof(intact));
+
+  pid_t pid = forkVictim([]() {
+    ShmBase& shm = *new ShmBase(CHAOS_TOPIC_SHM);
+    shm.Open();
+    // 与 Write / Loan 相同的顺序：持锁、标记残缺、写到一半时被杀死
+    shm.shmBaseLock();
+    reinterpret_cast<ShmHead*>(shm.DataUnlocked() - sizeof(ShmHead))->dirty_ =
+        1;
+    std::memcpy(shm.DataUnlocked(), "torn", 4);
+  });
+
+  auto reader = std::async(std::launch::async, [&topic]() {
+    char buffer[sizeof(intact)];
+    try {
+      topic.Read(buffer, sizeof(buffer));
+    } catch (const std::runtime_error& e) {
+      return std::string(e.what());
+    }
+    return std::string();
+  });
+  CHECK(reader.wait_for(std::chrono::milliseconds(50)) ==
+        std::future_status::timeout);  // 读者被持锁的子进程阻塞
+  Clock::time_point killed_at = killVictim(pid);
+  CHECK(reader.wait_for(std::chrono::milliseconds(CHAOS_TIMEOUT_MS)) ==
+        std::future_status::ready);
+  double recover_ms = elapsedMs(killed_at);
+  std::string error = reader.get();
+  CHECK(error.find("torn") != std::string::npos);
+
+  // 新消息覆盖残缺数据后恢复正常读取
+  const char fresh[] = "fresh message";
+  topic.Write(fresh, sizeof(fresh));
+  char buffer[sizeof(fresh)];
+  topic.Read(buffer, sizeof(buffer));
+  CHECK(std::strcmp(buffer, fresh) == 0);
+  std::cout << "publisher killed mid-write: reader recovered in " << recover_ms
+            << " ms" << std::endl;
+}
+
+// 持有事件通知锁的进程被杀死：等待者在一个超时周期内返回，触发事件照常工作
+static void eventLockOwnerDies(ShmManager& registry) {
+  pid_t pid = forkVictim([]() {
+    auto* events = new EventNotificationShm();
+    events->Open();
+    events->lock();
+  });
+
+  Clock::time_point start = Clock::now();
+  auto waiter = std::async(std::launch::async, [&registry]() {
+    return registry.waitForEvent(CHAOS_TIMEOUT_MS / 2);
+  });
+  CHECK(waiter.wait_for(std::chrono::milliseconds(50)) ==
+        std::future_status::timeout);
+  killVictim(pid);
+  CHECK(waiter.wait_for(std::chrono::milliseconds(CHAOS_TIMEOUT_MS)) ==
+        std::future_status::ready);
+  waiter.get();
+  CHECK(elapsedMs(start) < CHAOS_TIMEOUT_MS + 200);
+
+  int event_id = registry.registerTopicEvent("chaos", "tick");
+  CHECK(event_id >= 0);
+  registry.triggerEvent("chaos", "tick");
+  CHECK(registry.getTriggerEvent().test(event_id));
+  registry.clearTriggerEvent(event_id);
+  std::cout << "event lock owner killed: waiter returned in "
+            << elapsedMs(start) << " ms" << std::endl;
+}
+
+// 节点在注册表写区间内被杀死：序号停在奇数、计数错误、新 topic 未进入哈希索引
+// 下一个写者修复注册表，getNextNodeId 回收死亡节点的槽位
+static void registryWriterDies(ShmManager& registry) {
+  pid_t pid = forkVictim([]() {
+    ShmManager& victim = *new ShmManager();
+    registerNode(victim, "victim");
+
+    ShmBase& shm = *new ShmBase(SHM_MANAGER_NAME);
+    shm.Open();
+    shm.shmBaseLock();
+    auto* head = reinterpret_cast<ShmManagerInfo*>(shm.DataUnlocked());
+    head->sequence |= 1;
+    head->nodes_count += 5;
+    head->alive_node_count += 5;
+    // 写入 topic 条目并发布计数，但在插入索引前死亡
+    int count = head->topics_count;
+    auto* topics =
+        new SharedMemory(std::string(SHM_MANAGER_NAME) + ".topics.0",
+                         sizeof(TopicInfo) * head->topics_per_segment);
+    if (!topics->Open() ||
+        count >= static_cast<int>(head->topics_per_segment)) {
+      _exit(3);
+    }
+    TopicInfo& topic = static_cast<TopicInfo*>(topics->Data())[count];
+    std::strcpy(topic.name_, "ghost_e");
+    topic.event_id_ = count;
+    head->topics_count = count + 1;
+  });
+
+  CHECK(registry.getAliveNodeCount() == 6);  // 子进程留下的错误计数
+  Clock::time_point killed_at = killVictim(pid);
+  int event_id = registry.registerTopicEvent("chaos", "after");
+  double recover_ms = elapsedMs(killed_at);
+  CHECK(event_id >= 0);
+  CHECK(recover_ms < CHAOS_TIMEOUT_MS);
+  // 修复后计数按槽位重新统计，只剩尚未回收的死亡节点
+  CHECK(registry.getAliveNodeCount() == 1);
+  // 未进入索引的条目已补入，查找不会重复分配
+  int ghost_id = registry.getTopicEventId("ghost", "e");
+  CHECK(ghost_id >= 0 && ghost_id != event_id);
+  CHECK(registry.registerTopicEvent("ghost", "e") == ghost_id);
+
+  // 新节点启动时回收死亡节点的槽位
+  int id = registry.getNextNodeId();
+  CHECK(id >= 0);
+  registry.setNodeId(id);
+  CHECK(registry.getAliveNodeCount() == 1);
+  CHECK(registry.reapDeadNodes() == 0);
+  NodeInfo self;
+  registry.getNodeInfo(self);
+  CHECK(self.pid == getpid());
+  std::cout << "registry writer killed: repaired in " << recover_ms << " ms"
+            << std::endl;
+}
+
+// 发布者进程被杀死：回收者删除它创建的数据段和残留事件位，重启的发布者可以重新创建
+static void publisherProcessReaped(ShmManager& registry) {
+  const std::string topic = "/chaos_pub";
+  pid_t pid = forkVictim([&topic]() {
+    ShmManager& manager = *new ShmManager();
+    manager.setNodeId(manager.getNextNodeId());
+    std::string name = topic;
+    auto* pub = new Publisher<JsonValue>(name);
+    pub->setShmManager(&manager);
+    pub->setTopicNameForEvent(topic);
+    pub->publishLoaned("data", 64, [](uint8_t* buffer, size_t) {
+      std::memcpy(buffer, "last words", 11);
+      return static_cast<size_t>(11);
+    });
+  });
+  int event_id = registry.getTopicEventId(topic, "data");
+  CHECK(event_id >= 0);
+  CHECK(registry.getTriggerEvent().test(event_id));
+  size_t live_before = registry.getLiveNodes().size();
+
+  killVictim(pid);
+  CHECK(registry.getLiveNodes().size() == live_before - 1);  // 扫描跳过死亡节点
+  CHECK(registry.reapDeadNodes() == 1);
+  CHECK(registry.reapDeadNodes() == 0);
+  CHECK(!SharedMemory(topic + "_data", 64).Exists());
+  CHECK(!registry.getTriggerEvent().test(event_id));
+  // event_id 保持不变，重启的发布者可以重新创建数据段
+  CHECK(registry.getTopicEventId(topic, "data") == event_id);
+  ShmBase restarted(topic + "_data", 64);
+  restarted.Create();
+  restarted.Open();
+  std::cout << "dead publisher reaped, segment " << topic
+            << "_data released" << std::endl;
+}
+
+int main() {
+  publisherDiesMidWrite();
+  ShmManager registry;
+  eventLockOwnerDies(registry);
+  registryWriterDies(registry);
+  publisherProcessReaped(registry);
+  std::cout << "test_robust_shm passed" << std::endl;
+  return 0;
+}
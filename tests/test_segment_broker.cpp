@@ -0,0 +1,231 @@
+#include <stddef.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "mini_ros2/communication/segment_broker.h"
+#include "mini_ros2/communication/shm_manager.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "mini_ros2/pubsub/subscriber.h"
+#include "test_utils.h"
+
+#define FETCH_ROUNDS 500
+
+using Clock = std::chrono::steady_clock;
+
+static bool waitUntil(const std::function<bool()>& done, int timeout_ms) {
+  Clock::time_point deadline =
+      Clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!done()) {
+    if (Clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+static bool shmNameExists(const std::string& shm_name) {
+  return access(("/dev/shm" + shm_name).c_str(), F_OK) == 0;
+}
+
+// 子进程取得描述符后映射同一段：双向可见，/dev/shm 中没有名字
+static void offerAndFetch(SegmentBroker& broker) {
+  SegmentClient client(broker.name());
+  auto segment = ShmBase::createAnonymous("/memfd_chatter", 64);
+  CHECK(segment->IsAnonymous());
+  CHECK(client.offer("/memfd_chatter", segment) == segment);
+  const char hello[] = "hello";
+  segment->Write(hello, sizeof(hello));
+  CHECK(!shmNameExists("/memfd_chatter"));
+
+  pid_t pid = fork();
+  CHECK(pid >= 0);
+  if (pid == 0) {
+    SegmentClient child(broker.name());
+    auto mapped = child.fetch("/memfd_chatter");
+    if (mapped == nullptr || mapped->getDataSize() != 64) _exit(1);
+    char buffer[sizeof(hello)];
+    mapped->Read(buffer, sizeof(buffer));
+    if (std::strcmp(buffer, hello) != 0) _exit(2);
+    const char reply[] = "world";
+    mapped->Write(reply, sizeof(reply), 32);
+    if (child.fetch("/memfd_missing") != nullptr) _exit(3);
+    _exit(0);
+  }
+  int status = 0;
+  CHECK(waitpid(pid, &status, 0) == pid);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  char reply[6];
+  segment->Read(reply, sizeof(reply), 32);
+  CHECK(std::strcmp(reply, "world") == 0);
+  CHECK(client.withdraw("/memfd_chatter"));
+  CHECK(!client.withdraw("/memfd_chatter"));
+  CHECK(broker.getStats().segments == 0);
+}
+
+// 两个发布者同时创建同名段：后登记的一方拿到先登记的段
+static void concurrentOffer(SegmentBroker& broker) {
+  SegmentClient first(broker.name());
+  SegmentClient second(broker.name());
+  auto a = first.offer("/memfd_race", ShmBase::createAnonymous("/memfd_race",
+                                                               16));
+  auto b = second.offer("/memfd_race", ShmBase::createAnonymous("/memfd_race",
+                                                                16));
+  CHECK(a != b);
+  uint32_t value = 42;
+  a->Write(&value, sizeof(value));
+  uint32_t read_back = 0;
+  b->Read(&read_back, sizeof(read_back));
+  CHECK(read_back == 42);
+  // 两个登记者都断开后代理才释放
+  CHECK(first.withdraw("/memfd_race"));
+  CHECK(broker.getStats().segments == 1);
+  CHECK(second.withdraw("/memfd_race"));
+  CHECK(broker.getStats().segments == 0);
+}
+
+// 发布者进程退出（不撤销登记）：代理释放描述符，已映射的订阅者继续可用
+static void publisherExit(SegmentBroker& broker) {
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  pid_t pid = fork();
+  CHECK(pid >= 0);
+  if (pid == 0) {
+    close(fds[0]);
+    SegmentClient client(broker.name());
+    auto segment = ShmBase::createAnonymous("/memfd_exit", 32);
+    client.offer("/memfd_exit", segment);
+    uint64_t value = 7;
+    segment->Write(&value, sizeof(value));
+    char ready = 1;
+    if (write(fds[1], &ready, 1) != 1) _exit(1);
+    while (true) {
+      pause();  // 等父进程映射后被杀死，模拟崩溃
+    }
+  }
+  close(fds[1]);
+  char ready = 0;
+  CHECK(read(fds[0], &ready, 1) == 1);
+  SegmentClient client(broker.name());
+  auto mapped = client.fetch("/memfd_exit");
+  CHECK(mapped != nullptr);
+  close(fds[0]);
+  kill(pid, SIGKILL);
+  int status = 0;
+  CHECK(waitpid(pid, &status, 0) == pid);
+  CHECK(waitUntil([&broker]() { return broker.getStats().segments == 0; },
+                  2000));
+  CHECK(client.fetch("/memfd_exit") == nullptr);
+  uint64_t value = 0;
+  mapped->Read(&value, sizeof(value));
+  CHECK(value == 7);
+}
+
+// 非法报文只断开发送它的连接
+static void badMessage(SegmentBroker& broker) {
+  uint64_t errors = broker.getStats().errors;
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path + 1, broker.name().data(), broker.name().size());
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+  CHECK(connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                offsetof(sockaddr_un, sun_path) + 1 + broker.name().size()) ==
+        0);
+  const char garbage[] = "FETCH /chatter";
+  CHECK(send(fd, garbage, sizeof(garbage), 0) ==
+        static_cast<ssize_t>(sizeof(garbage)));
+  char buffer[64];
+  recv(fd, buffer, sizeof(buffer), 0);  // Error 回复
+  CHECK(recv(fd, buffer, sizeof(buffer), 0) == 0);
+  close(fd);
+  CHECK(broker.getStats().errors == errors + 1);
+  SegmentClient client(broker.name());
+  CHECK(client.fetch("/memfd_chatter") == nullptr);
+}
+
+// 设置 MINIROS2_SEGMENT_BROKER 后发布 / 订阅经代理建立，不再创建命名段
+static void pubsubThroughBroker(SegmentBroker& broker) {
+  setenv(SEGMENT_BROKER_ENV, broker.name().c_str(), 1);
+  ShmManager manager;
+  registerNode(manager, "memfd_node");
+  std::string topic = "/memfd_state";
+  Subscriber<JsonValue> sub(topic);
+  int received = -1;
+  sub.subscribe("state", [&received](const JsonValue& msg) {
+    received = msg["value"].asInt();
+  });
+  CHECK(!sub.isAttached());
+
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&manager);
+  pub.setTopicNameForEvent(topic);
+  JsonValue msg;
+  msg["value"] = 11;
+  pub.publish("state", msg);
+  sub.createTaskFromSubEvent()();
+  CHECK(sub.isAttached());
+  CHECK(received == 11);
+  CHECK(!shmNameExists(topic + "_state"));
+
+  // 桥、网关等使用的发布端接口：已存在时打开代理中的同一段
+  auto shared = manager.openPublisherSegment(topic, "state", 128);
+  CHECK(shared->IsAnonymous());
+  CHECK(shared->lastWriteTime() != 0);
+  manager.removeNode();
+  unsetenv(SEGMENT_BROKER_ENV);
+}
+
+// 订阅建立一次的开销：代理往返取描述符 vs shm_open 查找命名段
+static void attachLatency(SegmentBroker& broker) {
+  SegmentClient client(broker.name());
+  client.offer("/memfd_bench", ShmBase::createAnonymous("/memfd_bench", 4096));
+  auto named = std::make_shared<ShmBase>("/named_bench", 4096);
+  named->Create();
+  named->Open();
+
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < FETCH_ROUNDS; i++) {
+    CHECK(client.fetch("/memfd_bench") != nullptr);
+  }
+  double fetch_us = std::chrono::duration<double, std::micro>(Clock::now() -
+                                                              start)
+                        .count() /
+                    FETCH_ROUNDS;
+  start = Clock::now();
+  for (int i = 0; i < FETCH_ROUNDS; i++) {
+    CHECK(attachTopicSegment("/named_bench") != nullptr);
+  }
+  double named_us = std::chrono::duration<double, std::micro>(Clock::now() -
+                                                              start)
+                        .count() /
+                    FETCH_ROUNDS;
+  std::cout << "attach: memfd via broker " << fetch_us << " us, shm_open "
+            << named_us << " us" << std::endl;
+  CHECK(client.withdraw("/memfd_bench"));
+}
+
+int main() {
+  SegmentBroker broker("miniros2_test_" + std::to_string(getpid()));
+  broker.start();
+  offerAndFetch(broker);
+  concurrentOffer(broker);
+  publisherExit(broker);
+  badMessage(broker);
+  pubsubThroughBroker(broker);
+  attachLatency(broker);
+  broker.stop();
+  std::cout << "test_segment_broker passed" << std::endl;
+  return 0;
+}
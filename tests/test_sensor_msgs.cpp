@@ -0,0 +1,75 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "mini_ros2/communication/shm_base.h"
+#include "mini_ros2/message/message_serializer.h"
+#include "mini_ros2/message/sensor_msgs.h"
+#include "test_utils.h"
+
+using SmallCloud = PointCloudSoA<64>;
+
+int main() {
+  std::cout << "=== MiniROS2 sensor message test ===" << std::endl;
+
+  // 1. 布局：各分量数组按 SENSOR_MSG_ALIGN 对齐
+  CHECK(alignof(SmallCloud) == SENSOR_MSG_ALIGN);
+  CHECK(offsetof(SmallCloud, y) % SENSOR_MSG_ALIGN == 0);
+  CHECK(offsetof(SmallCloud, intensity) % SENSOR_MSG_ALIGN == 0);
+  CHECK(offsetof(ImuBatch64, gyro_z) % SENSOR_MSG_ALIGN == 0);
+  CHECK(ImageVga::kStep % SENSOR_MSG_ALIGN == 0);
+  CHECK(offsetof(ImageVga, data) % SENSOR_MSG_ALIGN == 0);
+
+  // 2. 共享内存数据区满足对齐要求，可直接借出构造消息
+  std::string name = "/test_sensor_msgs_" + std::to_string(getpid());
+  auto shm = std::make_shared<ShmBase>(name, sizeof(SmallCloud));
+  shm->Create();
+  shm->Open();
+  size_t written = shm->Loan([](uint8_t* buffer, size_t capacity) {
+    SmallCloud* cloud = loanMessage<SmallCloud>(buffer, capacity);
+    cloud->header.seq = 7;
+    cloud->header.setFrameId("velodyne");
+    cloud->clear();
+    for (int i = 0; i < 20; i++) {
+      cloud->push(i, 2.0f * i, 3.0f * i, 0.5f);
+    }
+    return sizeof(SmallCloud);
+  });
+  CHECK(written == sizeof(SmallCloud));
+  CHECK(reinterpret_cast<uintptr_t>(shm->DataUnlocked()) % SENSOR_MSG_ALIGN ==
+        0);
+
+  // 3. 订阅端按默认 memcpy 路径读取
+  std::vector<uint8_t> raw(shm->getDataSize());
+  shm->Read(raw.data(), raw.size());
+  auto cloud = std::make_unique<SmallCloud>();
+  Serializer::deserialize(raw.data(), raw.size(), *cloud);
+  CHECK(cloud->header.seq == 7);
+  CHECK(cloud->header.frameId() == "velodyne");
+  CHECK(cloud->size == 20);
+  CHECK(cloud->paddedSize() == 32);
+  CHECK(cloud->y[19] == 38.0f);
+  shm->Close();
+
+  // 4. 越界检查
+  bool thrown = false;
+  try {
+    for (int i = 0; i < 65; i++) {
+      cloud->push(0, 0, 0, 0);
+    }
+  } catch (const std::length_error&) {
+    thrown = true;
+  }
+  CHECK(thrown);
+  thrown = false;
+  try {
+    uint8_t small[64];
+    loanMessage<SmallCloud>(small, sizeof(small));
+  } catch (const std::length_error&) {
+    thrown = true;
+  }
+  CHECK(thrown);
+
+  std::cout << "all checks passed" << std::endl;
+  return 0;
+}
@@ -14,6 +14,8 @@ int main() {
   Node node("test_node2");
   auto pub = node.createPublisher<JsonValue>("test");
   auto pub1 = node.createPublisher<JsonValue>("test");
+  // test1 事件使用二进制编码，订阅端自动识别
+  pub1->setJsonEncoding(JsonEncoding::Binary);
   // node.printRegistry();
   node.createTimer(1000, [&pub, &pub1]() {
     JsonValue json;
@@ -0,0 +1,170 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "mini_ros2/communication/shm_manager.h"
+#include "test_utils.h"
+
+template <typename F>
+static double averageUs(int rounds, F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    f();
+  }
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         rounds;
+}
+
+int main() {
+  // 两个 ShmManager 模拟两个进程：owner 创建注册表，peer 打开已有注册表
+  // 每段容量取小值，便于覆盖链式增长
+  RegistryConfig config;
+  config.nodes_per_segment = 4;
+  config.topics_per_segment = 64;
+  auto start = std::chrono::steady_clock::now();
+  ShmManager owner(config);
+  double create_us = std::chrono::duration<double, std::micro>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+  int node_id = registerNode(owner, "registry_owner");
+  CHECK(owner.getAliveNodeCount() == 1);
+
+  // event_id 从 0 开始连续分配，重复注册返回同一 id
+  CHECK(owner.registerTopicEvent("chatter", "msg") == 0);
+  CHECK(owner.registerTopicEvent("odom", "pose") == 1);
+  CHECK(owner.registerTopicEvent("chatter", "msg") == 0);
+  owner.addPubTopic("odom", "pose");
+  CHECK(owner.getTopicEventId("odom", "pose") == 1);
+  CHECK(owner.getTopicEventId("missing", "msg") == -1);
+
+  start = std::chrono::steady_clock::now();
+  ShmManager peer;
+  double open_us = std::chrono::duration<double, std::micro>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  CHECK(peer.isTopicExist("chatter", "msg"));
+  CHECK(peer.getTopicEventId("odom", "pose") == 1);
+
+  // 新节点必须拿到不同的槽位
+  int peer_id = peer.getNextNodeId();
+  CHECK(peer_id >= 0 && peer_id != node_id);
+  peer.setNodeId(peer_id);
+
+  // peer 注册的新 topic，owner 的快照未命中时自动刷新
+  CHECK(peer.registerTopicEvent("scan", "points") == 2);
+  CHECK(owner.getTopicEventId("scan", "points") == 2);
+
+  owner.updateNodeHeartbeat();
+  CHECK(owner.isNodeAlive());
+
+  // 心跳超时的节点在扫描中跳过（同一进程内的两个节点，进程检查都通过）
+  peer.updateNodeHeartbeat();
+  CHECK(owner.getLiveNodes().size() == 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  owner.updateNodeHeartbeat();
+  std::vector<NodeInfo> live = owner.getLiveNodes(20);
+  CHECK(live.size() == 1 && live[0].node_id == node_id);
+
+  // 查询和重复注册不推进代数，新注册推进代数
+  uint64_t generation = owner.getRegistryGeneration();
+  CHECK(peer.registerTopicEvent("chatter", "msg") == 0);
+  CHECK(peer.isTopicExist("odom", "pose"));
+  CHECK(owner.getRegistryGeneration() == generation);
+  CHECK(peer.registerTopicEvent("imu", "raw") == 3);
+  CHECK(owner.getRegistryGeneration() == generation + 1);
+
+  // 写者持续注册时，读者看到的快照必须一致：event_id 与名字一一对应
+  {
+    ShmManager reader;
+    std::thread writer([&]() {
+      for (int i = 4; i < 404; ++i) {
+        CHECK(owner.registerTopicEvent("seq" + std::to_string(i), "e") == i);
+      }
+    });
+    for (int round = 0; round < 2000; ++round) {
+      int i = 4 + round % 400;
+      int id = reader.getTopicEventId("seq" + std::to_string(i), "e");
+      CHECK(id == -1 || id == i);
+    }
+    writer.join();
+    CHECK(reader.getTopicEventId("seq403", "e") == 403);
+  }
+
+  // 节点表增长：超过一段后追加节点段，已注册节点继续可用
+  {
+    std::vector<std::unique_ptr<ShmManager>> nodes;
+    std::vector<int> ids = {node_id, peer_id};
+    for (int i = 0; i < 10; ++i) {
+      nodes.push_back(std::make_unique<ShmManager>());
+      int id = nodes.back()->getNextNodeId();
+      CHECK(id >= 0);
+      for (int used : ids) {
+        CHECK(id != used);
+      }
+      ids.push_back(id);
+    }
+    CHECK(owner.getNodeCapacity() == 12);
+    owner.updateNodeHeartbeat();
+    CHECK(owner.isNodeAlive());
+  }
+
+  // topic 表和事件位增长：event_id 越过第一个标志块，保留位不分配给 topic
+  // stale 在增长前打开，只映射了第一个标志块
+  EventNotificationShm stale(config.eventNotificationName());
+  stale.Open();
+  int bulk_count = 1200;
+  int last_id = -1;
+  for (int i = 0; i < bulk_count; ++i) {
+    int id = owner.registerTopicEvent("bulk" + std::to_string(i), "e");
+    CHECK(id > last_id);
+    CHECK(id != REGISTRY_CHANGED_EVENT_ID);
+    last_id = id;
+  }
+  CHECK(last_id >= EVENT_MAX_COUNT);
+  CHECK(owner.getTopicCapacity() % config.topics_per_segment == 0);
+  CHECK(peer.getTopicEventId("bulk1199", "e") == last_id);
+  peer.clearAllTriggerEvents();
+  owner.triggerEvent("bulk1199", "e");
+  EventFlags flags = peer.getTriggerEvent();
+  CHECK(flags.capacity() > static_cast<size_t>(last_id));
+  CHECK(flags[last_id]);
+  CHECK(!flags[last_id - 1]);
+  peer.clearTriggerEvent(last_id);
+  CHECK(!peer.getTriggerEvent().any());
+  // 清除全部事件位前先映射其他进程追加的标志块
+  owner.triggerEvent("bulk1199", "e");
+  stale.clearEvents();
+  CHECK(!peer.getTriggerEvent().any());
+
+  // 新打开的进程能看到所有段中的条目
+  ShmManager late_reader;
+  CHECK(late_reader.getTopicEventId("bulk1199", "e") == last_id);
+  CHECK(late_reader.getTopicCapacity() == owner.getTopicCapacity());
+
+  double sync_us = averageUs(10000, [&]() { peer.syncRegistryFromShm(); });
+  double resync_us = averageUs(1000, [&]() {
+    owner.updateNodeAlive();  // 推进代数，迫使 peer 重新读取
+    peer.syncRegistryFromShm();
+  });
+  double lookup_us = averageUs(
+      10000, [&]() { peer.getTopicEventId("bulk500", "e"); });
+  std::cout << "topics: " << bulk_count + 404
+            << ", capacity: " << owner.getTopicCapacity() << std::endl;
+  std::cout << "registry create: " << create_us << " us, open: " << open_us
+            << " us" << std::endl;
+  std::cout << "syncRegistryFromShm unchanged: " << sync_us
+            << " us, changed (incl. write): " << resync_us
+            << " us, lookup: " << lookup_us << " us" << std::endl;
+
+  std::cout << "test_shm_registry passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,119 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "mini_ros2/communication/shm_manager.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "test_utils.h"
+
+#define MATCH_TOPIC "/match_debug"
+
+static JsonValue makeMessage(int value) {
+  JsonValue msg;
+  msg["value"] = value;
+  return msg;
+}
+
+int main() {
+  ShmManager pub_side;
+  registerNode(pub_side, "debug_pub");
+  std::string topic = MATCH_TOPIC;
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&pub_side);
+  pub.setTopicNameForEvent(topic);
+
+  // 首次发布创建数据段并注册 topic，之后无人订阅时跳过
+  CHECK(pub.getSubscriptionCount("state") == 0);
+  pub.publish("state", makeMessage(1));
+  int event_id = pub_side.getTopicEventId(topic, "state");
+  CHECK(event_id >= 0);
+  pub_side.clearTriggerEvent(event_id);
+  ShmBase segment(topic + "_state");
+  segment.Open();
+  uint64_t first_write = segment.lastWriteTime();
+
+  int constructed = 0;
+  auto expensive = [&constructed]() {
+    constructed++;
+    return makeMessage(2);
+  };
+  pub.publish("state", makeMessage(2));
+  pub.publishIfSubscribed("state", expensive);
+  CHECK(constructed == 0);
+  CHECK(segment.lastWriteTime() == first_write);
+  CHECK(!pub_side.getTriggerEvent().test(event_id));
+
+  const int rounds = 100000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    pub.publishIfSubscribed("state", expensive);
+  }
+  double unmatched_ns = std::chrono::duration<double, std::nano>(
+                            std::chrono::steady_clock::now() - start)
+                            .count() /
+                        rounds;
+
+  // 订阅者出现后正常发布
+  ShmManager sub_side;
+  registerNode(sub_side, "debug_sub");
+  sub_side.addSubTopic(topic, "state");
+  CHECK(pub.getSubscriptionCount("state") == 1);
+  CHECK(pub_side.getSubscriptionCount(topic, "state") == 1);
+  pub.publishIfSubscribed("state", expensive);
+  CHECK(constructed == 1);
+  CHECK(segment.lastWriteTime() != first_write);
+  CHECK(pub_side.getTriggerEvent().test(event_id));
+
+  // 同一节点重复订阅不重复计数；取消没有订阅过的 topic 不扣除别人的计数
+  sub_side.addSubTopic(topic, "state");
+  CHECK(pub.getSubscriptionCount("state") == 1);
+  pub_side.removeSubTopic(topic, "state");
+  CHECK(pub.getSubscriptionCount("state") == 1);
+  sub_side.removeSubTopic(topic, "state");
+  CHECK(pub.getSubscriptionCount("state") == 0);
+  sub_side.removeSubTopic(topic, "state");
+  CHECK(pub.getSubscriptionCount("state") == 0);
+  sub_side.addSubTopic(topic, "state");
+  CHECK(pub.getSubscriptionCount("state") == 1);
+
+  // 订阅者注销后计数归零
+  sub_side.removeNode();
+  CHECK(pub.getSubscriptionCount("state") == 0);
+
+  // 订阅者进程崩溃：回收者扣除它的订阅计数
+  pid_t pid = fork();
+  CHECK(pid >= 0);
+  if (pid == 0) {
+    ShmManager& child = *new ShmManager();
+    registerNode(child, "doomed_sub");
+    child.addSubTopic(topic, "state");
+    while (true) {
+      pause();
+    }
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (pub.getSubscriptionCount("state") != 1 &&
+         std::chrono::steady_clock::now() < deadline) {
+    usleep(1000);
+  }
+  CHECK(pub.getSubscriptionCount("state") == 1);
+  CHECK(kill(pid, SIGKILL) == 0);
+  int status = 0;
+  CHECK(waitpid(pid, &status, 0) == pid);
+  CHECK(pub_side.reapDeadNodes() == 1);
+  CHECK(pub.getSubscriptionCount("state") == 0);
+
+  // 未设置 ShmManager 的发布者照常发布
+  std::string raw_topic = "/match_raw";
+  Publisher<JsonValue> raw(raw_topic);
+  CHECK(raw.getSubscriptionCount("state") == -1);
+
+  std::cout << "unmatched publish: " << unmatched_ns << " ns" << std::endl;
+  std::cout << "test_sub_matching passed" << std::endl;
+  return 0;
+}
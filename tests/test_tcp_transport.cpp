@@ -0,0 +1,425 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mini_ros2/communication/comm_adapter.h"
+#include "mini_ros2/communication/socket_comm.h"
+#include "mini_ros2/communication/tcp_comm.h"
+#include "mini_ros2/pubsub/publisher.h"
+#include "test_utils.h"
+
+#define SMALL_FRAMES 200
+#define LARGE_SIZE (3 * 1024 * 1024)
+#define PING_ROUNDS 2000
+
+using Clock = std::chrono::steady_clock;
+
+static bool waitUntil(const std::function<bool()>& done, int timeout_ms) {
+  Clock::time_point deadline =
+      Clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!done()) {
+    if (Clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  return true;
+}
+
+static TcpCommConfig tcpConfig(uint16_t port = 0) {
+  TcpCommConfig config;
+  config.listen_address = "127.0.0.1";
+  config.listen_port = port;
+  config.reconnect_ms = 50;
+  return config;
+}
+
+static CommFrame makeFrame(const std::string& topic, uint64_t seq,
+                           const std::vector<uint8_t>& data,
+                           const CommEndpoint& dest = CommEndpoint()) {
+  CommFrame frame;
+  frame.topic = topic;
+  frame.event = "data";
+  frame.seq = seq;
+  frame.segment_size = static_cast<uint32_t>(data.size());
+  frame.data = data.data();
+  frame.size = data.size();
+  frame.dest = dest;
+  return frame;
+}
+
+// 接收端记录收到的帧
+struct Received {
+  std::mutex mutex;
+  std::vector<std::string> topics;
+  std::vector<uint64_t> seqs;
+  std::vector<size_t> sizes;
+  uint64_t sender_id = 0;
+  bool content_ok = true;
+
+  void attach(CommAdapter& adapter) {
+    adapter.start([this](const CommMessage& msg) {
+      std::lock_guard<std::mutex> lock(mutex);
+      topics.push_back(msg.topic);
+      seqs.push_back(msg.seq);
+      sizes.push_back(msg.size);
+      sender_id = msg.sender_id;
+      for (size_t i = 0; i < msg.size; i += 4096) {
+        content_ok = content_ok && msg.data[i] == static_cast<uint8_t>(msg.seq);
+      }
+    });
+  }
+  size_t count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return seqs.size();
+  }
+};
+
+// 一批小帧按长度前缀分隔、合并成少量 writev；大帧跨多次 read 重组；
+// 各 topic 复用一条连接
+static void framing() {
+  TcpCommAdapter server(tcpConfig());
+  TcpCommConfig client_config = tcpConfig();
+  client_config.peers.push_back(server.localEndpoint());
+  TcpCommAdapter client(client_config);
+  Received received;
+  received.attach(server);
+  client.start([](const CommMessage&) {});
+  CHECK(waitUntil([&]() { return client.peerCount() == 1; }, 1000));
+
+  std::vector<std::vector<uint8_t>> payloads;
+  for (int i = 1; i <= SMALL_FRAMES; i++) {
+    payloads.emplace_back(32 + i, static_cast<uint8_t>(i));
+  }
+  std::vector<CommFrame> frames;
+  for (int i = 1; i <= SMALL_FRAMES; i++) {
+    frames.push_back(makeFrame(i % 2 ? "odom" : "imu", i, payloads[i - 1]));
+  }
+  std::vector<uint8_t> large(LARGE_SIZE,
+                             static_cast<uint8_t>(SMALL_FRAMES + 1));
+  frames.push_back(makeFrame("scan", SMALL_FRAMES + 1, large));
+  CHECK(client.sendBatch(frames) == SMALL_FRAMES + 1);
+  CHECK(waitUntil([&]() { return received.count() == SMALL_FRAMES + 1; },
+                  2000));
+
+  std::lock_guard<std::mutex> lock(received.mutex);
+  for (int i = 0; i < SMALL_FRAMES; i++) {
+    CHECK(received.seqs[i] == static_cast<uint64_t>(i + 1));
+    CHECK(received.sizes[i] == payloads[i].size());
+  }
+  CHECK(received.topics.back() == "scan");
+  CHECK(received.sizes.back() == LARGE_SIZE);
+  CHECK(received.content_ok);
+  CHECK(received.sender_id == client.senderId());
+  TcpCommStats stats = client.getStats();
+  std::cout << "framing: " << stats.frames_sent << " frames in "
+            << stats.writev_calls << " writev calls (incl. hello), "
+            << stats.corked_batches << " corked batches" << std::endl;
+  // 一批 201 帧 804 段 iovec：一次 writev 放得下，缓冲区满时剩余部分进入输出队列
+  CHECK(stats.writev_calls < 20);
+  CHECK(stats.corked_batches == 1);
+  CHECK(stats.connects == 1 && server.getStats().accepted == 1);
+  client.stop();
+  server.stop();
+}
+
+// 接受的连接在握手后登记为到对端的连接：反方向发送复用它，不另建连接
+static void reuseInbound() {
+  TcpCommAdapter server(tcpConfig());
+  TcpCommConfig client_config = tcpConfig();
+  client_config.peers.push_back(server.localEndpoint());
+  TcpCommAdapter client(client_config);
+  Received received;
+  std::vector<uint8_t> data(16, 1);
+  // 还没有对端连上：发往组地址的帧没有写入任何连接，不算发出
+  CHECK(server.sendBatch({makeFrame("cmd", 1, data)}) == 0);
+  CHECK(server.getStats().frames_sent == 0);
+  received.attach(client);
+  server.start([](const CommMessage&) {});
+  CHECK(waitUntil([&]() { return server.peerCount() == 1; }, 1000));
+
+  CHECK(server.send(makeFrame("cmd", 1, data, client.localEndpoint())));
+  CHECK(server.send(makeFrame("cmd", 2, data)));
+  CHECK(waitUntil([&]() { return received.count() == 2; }, 1000));
+  CHECK(server.getStats().connects == 0);
+  CHECK(server.getStats().connections == 1);
+  CHECK(received.sender_id == server.senderId());
+  client.stop();
+  server.stop();
+}
+
+// 对端重启后按 reconnect_ms 自动重连，之后的消息照常送达
+static void reconnect(uint16_t port) {
+  TcpCommConfig client_config = tcpConfig();
+  client_config.peers.push_back({"127.0.0.1", port});
+  TcpCommAdapter client(client_config);
+  client.start([](const CommMessage&) {});
+  std::vector<uint8_t> data(16, 1);
+  for (uint64_t round = 1; round <= 2; round++) {
+    TcpCommAdapter server(tcpConfig(port));
+    Received received;
+    received.attach(server);
+    // 等本轮的新连接，而不是上一轮还没注销的旧连接
+    CHECK(waitUntil(
+        [&]() {
+          return client.getStats().connects == round &&
+                 client.peerCount() == 1;
+        },
+        1000));
+    CHECK(client.send(makeFrame("cmd", round, data)));
+    CHECK(waitUntil([&]() { return received.count() == 1; }, 1000));
+    server.stop();
+    // 析构关闭连接，客户端的接收线程发现后注销这条连接
+  }
+  CHECK(waitUntil([&]() { return client.peerCount() == 0; }, 1000));
+  CHECK(client.getStats().connects == 2);
+  client.stop();
+}
+
+// 对端不读时发送线程不等待：剩余部分进入输出队列，对端开始读后按序送达
+static void slowPeer() {
+  TcpCommConfig server_config = tcpConfig();
+  server_config.receive_buffer = 64 * 1024;
+  TcpCommAdapter server(server_config);
+  TcpCommConfig client_config = tcpConfig();
+  client_config.send_buffer = 64 * 1024;
+  client_config.peers.push_back(server.localEndpoint());
+  TcpCommAdapter client(client_config);
+  client.start([](const CommMessage&) {});
+  // 服务端还没启动：内核完成了连接，但没有人读
+  CHECK(waitUntil([&]() { return client.peerCount() == 1; }, 1000));
+
+  std::vector<std::vector<uint8_t>> payloads;
+  std::vector<CommFrame> frames;
+  for (int i = 1; i <= 33; i++) {
+    payloads.emplace_back(256 * 1024, static_cast<uint8_t>(i));
+  }
+  for (int i = 1; i <= 32; i++) {
+    frames.push_back(makeFrame("map", i, payloads[i - 1]));
+  }
+  Clock::time_point start = Clock::now();
+  CHECK(client.sendBatch(frames) == frames.size());
+  CHECK(client.send(makeFrame("map", 33, payloads[32])));
+  double elapsed_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  TcpCommStats stats = client.getStats();
+  std::cout << "slowPeer: 8 MB to a stalled peer in " << elapsed_ms << " ms, "
+            << stats.queued_batches << " queued batches" << std::endl;
+  CHECK(elapsed_ms < 500);
+  CHECK(stats.queued_batches == 2);
+
+  Received received;
+  received.attach(server);
+  CHECK(waitUntil([&]() { return received.count() == 33; }, 5000));
+  std::lock_guard<std::mutex> lock(received.mutex);
+  for (size_t i = 0; i < received.seqs.size(); i++) {
+    CHECK(received.seqs[i] == i + 1);
+  }
+  CHECK(received.content_ok);
+  CHECK(client.getStats().errors == 0);
+  client.stop();
+  server.stop();
+}
+
+// 对端一直不读：输出队列超过 send_timeout_ms 没有进展，或积压超过上限时断开
+static void stalledPeer() {
+  TcpCommConfig server_config = tcpConfig();
+  server_config.receive_buffer = 64 * 1024;
+  TcpCommAdapter server(server_config);
+  std::vector<uint8_t> data(4 * 1024 * 1024, 1);
+
+  TcpCommConfig timeout_config = tcpConfig();
+  timeout_config.send_buffer = 64 * 1024;
+  timeout_config.send_timeout_ms = 100;
+  timeout_config.peers.push_back(server.localEndpoint());
+  TcpCommAdapter timeout_client(timeout_config);
+  timeout_client.start([](const CommMessage&) {});
+  CHECK(waitUntil([&]() { return timeout_client.peerCount() == 1; }, 1000));
+  CHECK(timeout_client.send(makeFrame("map", 1, data)));
+  // 断开后按 reconnect_ms 重连，以出错计数判断
+  CHECK(waitUntil([&]() { return timeout_client.getStats().errors == 1; },
+                  2000));
+  timeout_client.stop();
+
+  TcpCommConfig limit_config = timeout_config;
+  limit_config.send_timeout_ms = 10000;
+  limit_config.max_pending_bytes = 1024 * 1024;
+  TcpCommAdapter limit_client(limit_config);
+  limit_client.start([](const CommMessage&) {});
+  CHECK(waitUntil([&]() { return limit_client.peerCount() == 1; }, 1000));
+  // 队列为空时整批都能排队；已积压超过上限时下一批断开连接
+  CHECK(limit_client.send(makeFrame("map", 1, data)));
+  CHECK(!limit_client.send(makeFrame("map", 2, data)));
+  CHECK(limit_client.getStats().errors == 1);
+  limit_client.stop();
+}
+
+static RegistryConfig domainConfig(int domain_id) {
+  RegistryConfig config;
+  config.domain_id = domain_id;
+  return config;
+}
+
+// 经网关：大消息从共享内存数据段直接 writev 到连接上，远端写入本地分区
+static void gatewayInPlace() {
+  auto server_adapter = std::make_unique<TcpCommAdapter>(tcpConfig());
+  CommEndpoint server_endpoint = server_adapter->localEndpoint();
+  CommGateway receiver(domainConfig(91), std::move(server_adapter));
+  receiver.addImport("cloud", "data");
+  receiver.start();
+
+  TcpCommConfig client_config = tcpConfig();
+  client_config.peers.push_back(server_endpoint);
+  auto client_adapter = std::make_unique<TcpCommAdapter>(client_config);
+  TcpCommAdapter& client = *client_adapter;
+  CommGateway sender(domainConfig(90), std::move(client_adapter));
+  sender.addExport("cloud", "data");
+  sender.start();
+  CHECK(waitUntil([&]() { return client.peerCount() == 1; }, 1000));
+
+  ShmManager local(domainConfig(90));
+  local.setNodeId(local.getNextNodeId());
+  std::string topic = domainConfig(90).topicPrefix() + "cloud";
+  Publisher<JsonValue> pub(topic);
+  pub.setShmManager(&local);
+  pub.setTopicNameForEvent(topic);
+  const size_t size = 1024 * 1024;
+  pub.publishLoaned("data", size, [](uint8_t* buffer, size_t capacity) {
+    std::memset(buffer, 0x5A, capacity);
+    return capacity;
+  });
+  auto written = [&]() {
+    auto segment =
+        attachTopicSegment(domainConfig(91).topicPrefix() + "cloud_data");
+    if (segment == nullptr) return false;
+    std::vector<uint8_t> buffer(size);
+    segment->Read(buffer.data(), size);
+    return buffer.front() == 0x5A && buffer.back() == 0x5A;
+  };
+  CHECK(waitUntil(written, 2000));
+  CHECK(receiver.getStats().received == 1);
+  sender.stop();
+  receiver.stop();
+}
+
+// 回环上的对比：同一组消息分别经 UDP 和 TCP 发出
+struct BenchResult {
+  double round_trip_us;  // 小消息往返的中位数
+  double throughput_mbps;
+  size_t delivered;
+};
+
+// a 发往 b，b 原样回给 a；a 连续发出 count 条 size 字节的消息测吞吐
+static BenchResult bench(CommAdapter& a, CommAdapter& b,
+                         const CommEndpoint& to_b, const CommEndpoint& to_a,
+                         size_t size, size_t count) {
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint64_t echoed = 0;
+  std::atomic<size_t> delivered = 0;
+  std::atomic<size_t> bytes = 0;
+  a.start([&](const CommMessage& msg) {
+    std::lock_guard<std::mutex> lock(mutex);
+    echoed = msg.seq;
+    cv.notify_one();
+  });
+  b.start([&](const CommMessage& msg) {
+    if (msg.topic == "ping") {
+      std::vector<uint8_t> data(msg.data, msg.data + msg.size);
+      b.send(makeFrame("pong", msg.seq, data, to_a));
+      return;
+    }
+    delivered++;
+    bytes += msg.size;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  BenchResult result;
+  std::vector<uint8_t> small(64, 1);
+  std::vector<double> samples;
+  for (uint64_t seq = 1; seq <= PING_ROUNDS; seq++) {
+    Clock::time_point start = Clock::now();
+    a.send(makeFrame("ping", seq, small, to_b));
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!cv.wait_for(lock, std::chrono::milliseconds(100),
+                     [&]() { return echoed == seq; })) {
+      continue;  // UDP 可能丢包
+    }
+    samples.push_back(
+        std::chrono::duration<double, std::micro>(Clock::now() - start)
+            .count());
+  }
+  std::sort(samples.begin(), samples.end());
+  result.round_trip_us = samples.empty() ? 0 : samples[samples.size() / 2];
+
+  std::vector<uint8_t> payload(size, 2);
+  Clock::time_point start = Clock::now();
+  for (size_t i = 1; i <= count; i++) {
+    a.send(makeFrame("bulk", i, payload, to_b));
+  }
+  waitUntil([&]() { return delivered == count; }, 3000);
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  result.delivered = delivered;
+  result.throughput_mbps = bytes * 8 / seconds / 1e6;
+  a.stop();
+  b.stop();
+  return result;
+}
+
+static void compareWithUdp(uint16_t port) {
+  const size_t sizes[] = {1024, 256 * 1024};
+  const size_t counts[] = {20000, 400};
+  for (int i = 0; i < 2; i++) {
+    UdpCommConfig udp_config;
+    udp_config.multicast_port = port + i;
+    udp_config.interface_address = "127.0.0.1";
+    udp_config.mtu = 65535;
+    udp_config.clock_sync_ms = 0;
+    UdpCommAdapter udp_a(udp_config);
+    UdpCommAdapter udp_b(udp_config);
+    BenchResult udp = bench(udp_a, udp_b, udp_b.localEndpoint(),
+                            udp_a.localEndpoint(), sizes[i], counts[i]);
+
+    TcpCommAdapter tcp_b(tcpConfig());
+    TcpCommConfig a_config = tcpConfig();
+    a_config.peers.push_back(tcp_b.localEndpoint());
+    TcpCommAdapter tcp_a(a_config);
+    BenchResult tcp = bench(tcp_a, tcp_b, tcp_b.localEndpoint(),
+                            tcp_a.localEndpoint(), sizes[i], counts[i]);
+
+    std::cout << sizes[i] << " B x " << counts[i] << ": udp rtt "
+              << udp.round_trip_us << " us, " << udp.throughput_mbps
+              << " Mbit/s, " << udp.delivered << " delivered | tcp rtt "
+              << tcp.round_trip_us << " us, " << tcp.throughput_mbps
+              << " Mbit/s, " << tcp.delivered << " delivered" << std::endl;
+    // TCP 不丢消息；UDP 在接收缓冲区满时可能丢
+    CHECK(tcp.delivered == counts[i]);
+    CHECK(tcp.round_trip_us > 0 && tcp.throughput_mbps > 0);
+    // 反向 pong 复用 a 发起的连接
+    CHECK(tcp_b.getStats().connects == 0);
+  }
+}
+
+int main() {
+  uint16_t port = static_cast<uint16_t>(20000 + getpid() % 20000);
+  framing();
+  reuseInbound();
+  reconnect(port);
+  slowPeer();
+  stalledPeer();
+  gatewayInPlace();
+  compareWithUdp(port + 1);
+  std::cout << "test_tcp_transport passed" << std::endl;
+  return 0;
+}
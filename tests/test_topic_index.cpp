@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mini_ros2/communication/shm_manager.h"
+#include "test_utils.h"
+
+// topic 数增长时查找耗时应保持不变：哈希索引 vs 旧的线性 strcmp 扫描
+
+template <typename F>
+static double averageNs(int rounds, F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) {
+    f(i);
+  }
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         rounds;
+}
+
+static std::string topicName(int i) { return "/robot/sensor_" + std::to_string(i); }
+
+int main() {
+  ShmManager writer;
+  ShmManager reader;  // 模拟另一个进程：只探测索引，不参与写入
+  std::vector<TopicInfo> linear;  // 旧实现的等价数据结构
+
+  const int kRounds = 20000;
+  int registered = 0;
+  volatile int sink = 0;
+  std::cout << std::setw(8) << "topics" << std::setw(14) << "index hit"
+            << std::setw(14) << "index miss" << std::setw(14) << "linear hit"
+            << "  (ns/lookup)" << std::endl;
+  for (int target : {16, 128, 1024, 4096, 8000}) {
+    for (; registered < target; ++registered) {
+      int id = writer.registerTopicEvent(topicName(registered), "data");
+      CHECK(id >= 0);
+      TopicInfo info;
+      std::memset(&info, 0, sizeof(info));
+      std::strcpy(info.name_, (topicName(registered) + "_data").c_str());
+      info.event_id_ = id;
+      linear.push_back(info);
+    }
+    // 查找的名字预先构造好，只测查找本身
+    std::vector<std::string> names;
+    for (int i = 0; i < 64; ++i) {
+      names.push_back(topicName((i * 7919) % registered));
+    }
+    for (const auto& name : names) {
+      CHECK(reader.getTopicEventId(name, "data") >= 0);
+    }
+
+    double hit_ns = averageNs(kRounds, [&](int i) {
+      sink += reader.getTopicEventId(names[i & 63], "data");
+    });
+    double miss_ns = averageNs(kRounds, [&](int i) {
+      sink += reader.getTopicEventId(names[i & 63], "missing");
+    });
+    double linear_ns = averageNs(kRounds / 10, [&](int i) {
+      std::string full = names[i & 63] + "_data";
+      for (const auto& info : linear) {
+        if (std::strcmp(info.name_, full.c_str()) == 0) {
+          sink += info.event_id_;
+          break;
+        }
+      }
+    });
+    std::cout << std::setw(8) << registered << std::setw(14) << std::fixed
+              << std::setprecision(1) << hit_ns << std::setw(14) << miss_ns
+              << std::setw(14) << linear_ns << std::endl;
+  }
+
+  // 另一个进程注册的 topic 立即可查
+  CHECK(reader.registerTopicEvent("/robot/late", "data") >= 0);
+  CHECK(writer.isTopicExist("/robot/late", "data"));
+  CHECK(!writer.isTopicExist("/robot/late", "other"));
+
+  std::cout << "test_topic_index passed" << std::endl;
+  return 0;
+}
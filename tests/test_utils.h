@@ -0,0 +1,45 @@
+#pragma once
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "mini_ros2/communication/shm_manager.h"
+
+// 测试断言：Release 构建下同样生效（assert 会被 NDEBUG 去掉）
+#define CHECK(cond)                                                  \
+  do {                                                               \
+    if (!(cond)) {                                                   \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " \
+                << #cond << std::endl;                               \
+      std::exit(1);                                                  \
+    }                                                                \
+  } while (0)
+
+// 基准计时：调用 f rounds 次，返回总耗时（毫秒）
+template <typename F>
+inline double timeMs(int rounds, F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// 在注册表中登记一个存活节点（本进程），返回节点 id
+inline int registerNode(ShmManager& manager, const char* name) {
+  int node_id = manager.getNextNodeId();
+  CHECK(node_id >= 0);
+  manager.setNodeId(node_id);
+  NodeInfo info;
+  std::memset(&info, 0, sizeof(info));
+  std::strcpy(info.node_name, name);
+  info.node_id = node_id;
+  info.pid = getpid();
+  info.is_alive = true;
+  manager.addNode(info);
+  return node_id;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <arpa/inet.h>
+#include <endian.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "mini_ros2/communication/comm_adapter.h"
+#include "mini_ros2/communication/socket_comm.h"
+#include "test_utils.h"
+
+// 绕过 UdpCommAdapter 直接收发线上格式的报文：注入伪造的帧、检查适配器的回复
+class RawUdpPeer {
+ public:
+  RawUdpPeer() {
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    CHECK(fd_ >= 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+  }
+  ~RawUdpPeer() { close(fd_); }
+  RawUdpPeer(const RawUdpPeer&) = delete;
+  RawUdpPeer& operator=(const RawUdpPeer&) = delete;
+
+  // 不分片的一帧：帧头 + topic + event + body
+  static std::vector<uint8_t> frame(const std::string& topic,
+                                    const std::string& event, uint8_t flags,
+                                    uint64_t sender_id, uint64_t seq,
+                                    const void* body, size_t size) {
+    UdpFrameHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = htonl(UDP_COMM_MAGIC);
+    header.version = UDP_COMM_VERSION;
+    header.flags = flags;
+    header.topic_len = htons(static_cast<uint16_t>(topic.size()));
+    header.event_len = htons(static_cast<uint16_t>(event.size()));
+    header.payload_size = htonl(static_cast<uint32_t>(size));
+    header.frag_count = htonl(1);
+    header.sender_id = htobe64(sender_id);
+    header.seq = htobe64(seq);
+    std::vector<uint8_t> packet(sizeof(header));
+    std::memcpy(packet.data(), &header, sizeof(header));
+    packet.insert(packet.end(), topic.begin(), topic.end());
+    packet.insert(packet.end(), event.begin(), event.end());
+    const uint8_t* bytes = static_cast<const uint8_t*>(body);
+    packet.insert(packet.end(), bytes, bytes + size);
+    return packet;
+  }
+
+  void sendTo(const CommEndpoint& dest, const std::vector<uint8_t>& packet) {
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(dest.port);
+    CHECK(inet_pton(AF_INET, dest.host.c_str(), &addr.sin_addr) == 1);
+    CHECK(sendto(fd_, packet.data(), packet.size(), 0,
+                 reinterpret_cast<sockaddr*>(&addr),
+                 sizeof(addr)) == static_cast<ssize_t>(packet.size()));
+  }
+
+  // 等待一帧 flags 含 flag 的报文，超时返回 false；其他报文跳过
+  bool receive(uint8_t flag, std::vector<uint8_t>& packet, int timeout_ms) {
+    pollfd pfd{fd_, POLLIN, 0};
+    while (poll(&pfd, 1, timeout_ms) == 1) {
+      packet.resize(UDP_COMM_MAX_DATAGRAM);
+      ssize_t n = recv(fd_, packet.data(), packet.size(), 0);
+      if (n < static_cast<ssize_t>(sizeof(UdpFrameHeader))) {
+        continue;
+      }
+      packet.resize(static_cast<size_t>(n));
+      UdpFrameHeader header;
+      std::memcpy(&header, packet.data(), sizeof(header));
+      if (header.flags & flag) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  int fd_ = -1;
+};
@@ -0,0 +1,408 @@
+#!/usr/bin/env python3
+"""miniROS2 消息生成器：把 .msg 描述文件转换为定长布局的 C++ 结构体。
+
+.msg 语法（每行一个字段，'#' 之后为注释）：
+    uint64 stamp_ns              基本类型
+    float64[3] position          定长数组
+    float32[<=1024] ranges       有界序列（BoundedSequence）
+    string<=32 frame_id          有界字符串（BoundedString）
+    geometry_msgs/Vector3 accel  嵌套消息（同包内可省略包名）
+    int32 MAX_COUNT=16           常量
+
+为保证共享内存零拷贝，不支持无界 string / T[]。
+生成的结构体按声明顺序排列，所有对齐填充都显式写出，
+两端编译器/编译选项不同也能得到一致的布局（由 static_assert 校验）。
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# 基本类型：msg 类型 -> (C++ 类型, 大小, 对齐)
+PRIMITIVES = {
+    "bool": ("bool", 1, 1),
+    "byte": ("uint8_t", 1, 1),
+    "char": ("char", 1, 1),
+    "int8": ("int8_t", 1, 1),
+    "uint8": ("uint8_t", 1, 1),
+    "int16": ("int16_t", 2, 2),
+    "uint16": ("uint16_t", 2, 2),
+    "int32": ("int32_t", 4, 4),
+    "uint32": ("uint32_t", 4, 4),
+    "int64": ("int64_t", 8, 8),
+    "uint64": ("uint64_t", 8, 8),
+    "float32": ("float", 4, 4),
+    "float64": ("double", 8, 8),
+}
+
+FIELD_RE = re.compile(
+    r"^(?P<type>[A-Za-z_][A-Za-z0-9_/]*)"
+    r"(?:<=(?P<strbound>\d+))?"
+    r"(?:\[(?P<array>(?:<=)?\d*)\])?"
+    r"\s+(?P<name>[A-Za-z_][A-Za-z0-9_]*)"
+    r"(?:\s*=\s*(?P<value>.+))?$"
+)
+
+
+class MsgError(Exception):
+    pass
+
+
+def align_up(value, align):
+    return (value + align - 1) // align * align
+
+
+def snake_case(name):
+    return re.sub(r"([a-z0-9])([A-Z])", r"\1_\2", name).lower()
+
+
+def fnv1a64(text):
+    h = 0xCBF29CE484222325
+    for b in text.encode("utf-8"):
+        h ^= b
+        h = (h * 0x100000001B3) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+class Field:
+    def __init__(self, base, name, str_bound, array_kind, array_size):
+        self.base = base  # 基本类型名或 "pkg/Name"
+        self.name = name
+        self.str_bound = str_bound  # 有界字符串容量
+        self.array_kind = array_kind  # None / "fixed" / "bounded"
+        self.array_size = array_size
+
+
+class Constant:
+    def __init__(self, base, name, value):
+        self.base = base
+        self.name = name
+        self.value = value
+
+
+class MsgSpec:
+    def __init__(self, package, name, path):
+        self.package = package
+        self.name = name
+        self.path = path
+        self.fields = []
+        self.constants = []
+        # 以下由 Resolver 计算
+        self.size = None
+        self.align = None
+        self.type_hash = None
+        self.layout = []  # [(Field 或 None 表示填充, 偏移, 大小)]
+
+    @property
+    def full_name(self):
+        return self.package + "/" + self.name
+
+    @property
+    def cpp_name(self):
+        return self.package + "::msg::" + self.name
+
+    @property
+    def header(self):
+        return self.package + "/msg/" + snake_case(self.name) + ".h"
+
+
+def parse_msg(path):
+    package = os.path.basename(os.path.dirname(os.path.abspath(path)))
+    name = os.path.splitext(os.path.basename(path))[0]
+    if not re.match(r"^[A-Z][A-Za-z0-9]*$", name):
+        raise MsgError("%s: message name must be CamelCase" % path)
+    spec = MsgSpec(package, name, path)
+    names = set()
+    with open(path) as f:
+        for lineno, raw in enumerate(f, 1):
+            line = raw.split("#", 1)[0].strip()
+            if not line:
+                continue
+            m = FIELD_RE.match(line)
+            if not m:
+                raise MsgError("%s:%d: cannot parse '%s'" % (path, lineno, line))
+            base = m.group("type")
+            fname = m.group("name")
+            if fname in names:
+                raise MsgError("%s:%d: duplicate name '%s'" % (path, lineno, fname))
+            if fname == "validate":
+                raise MsgError("%s:%d: 'validate' is reserved" % (path, lineno))
+            names.add(fname)
+            if base == "string" and m.group("strbound") is None:
+                raise MsgError(
+                    "%s:%d: unbounded string is not shm-safe, use string<=N"
+                    % (path, lineno))
+            if m.group("strbound") is not None and base != "string":
+                raise MsgError("%s:%d: '<=N' only applies to string" % (path, lineno))
+            if base not in PRIMITIVES and base != "string" and "/" not in base:
+                base = package + "/" + base
+            if m.group("value") is not None:
+                if m.group("array") is not None or "/" in base:
+                    raise MsgError(
+                        "%s:%d: constants must be primitive scalars" % (path, lineno))
+                spec.constants.append(Constant(base, fname, m.group("value").strip()))
+                continue
+            array = m.group("array")
+            array_kind, array_size = None, 0
+            if array is not None:
+                if array == "" or array == "<=":
+                    raise MsgError(
+                        "%s:%d: unbounded array is not shm-safe, use T[<=N]"
+                        % (path, lineno))
+                if array.startswith("<="):
+                    array_kind, array_size = "bounded", int(array[2:])
+                else:
+                    array_kind, array_size = "fixed", int(array)
+                if array_size <= 0:
+                    raise MsgError("%s:%d: array size must be positive" % (path, lineno))
+            str_bound = int(m.group("strbound")) if m.group("strbound") else 0
+            if base == "string" and str_bound <= 0:
+                raise MsgError("%s:%d: string bound must be positive" % (path, lineno))
+            spec.fields.append(Field(base, fname, str_bound, array_kind, array_size))
+    return spec
+
+
+class Resolver:
+    """解析嵌套依赖，计算布局和类型哈希"""
+
+    def __init__(self, search_paths):
+        self.search_paths = search_paths
+        self.specs = {}
+        self.resolving = set()
+
+    def add(self, spec):
+        self.specs[spec.full_name] = spec
+
+    def lookup(self, full_name):
+        if full_name in self.specs:
+            return self.specs[full_name]
+        package, name = full_name.split("/", 1)
+        for root in self.search_paths:
+            path = os.path.join(root, package, name + ".msg")
+            if os.path.isfile(path):
+                spec = parse_msg(path)
+                self.add(spec)
+                return spec
+        raise MsgError("cannot find message type '%s'" % full_name)
+
+    def element(self, field):
+        """返回 (C++ 类型, 大小, 对齐, 哈希描述)"""
+        if field.base == "string":
+            size = align_up(4 + field.str_bound, 4)
+            return ("BoundedString<%d>" % field.str_bound, size, 4,
+                    "string<=%d" % field.str_bound)
+        if field.base in PRIMITIVES:
+            cpp, size, align = PRIMITIVES[field.base]
+            return cpp, size, align, field.base
+        nested = self.resolve(self.lookup(field.base))
+        return ("::" + nested.cpp_name, nested.size, nested.align,
+                "%s@%016x" % (nested.full_name, nested.type_hash))
+
+    def resolve(self, spec):
+        if spec.type_hash is not None:
+            return spec
+        if spec.full_name in self.resolving:
+            raise MsgError("recursive message definition '%s'" % spec.full_name)
+        self.resolving.add(spec.full_name)
+
+        canonical = [spec.full_name]
+        for c in spec.constants:
+            canonical.append("const %s %s=%s" % (c.base, c.name, c.value))
+
+        offset, max_align, pad_index = 0, 1, 0
+        for field in spec.fields:
+            cpp, size, align, desc = self.element(field)
+            if field.array_kind == "fixed":
+                field.cpp_type = cpp
+                field.cpp_suffix = "[%d]" % field.array_size
+                size = size * field.array_size
+                desc += "[%d]" % field.array_size
+            elif field.array_kind == "bounded":
+                field.cpp_type = "BoundedSequence<%s, %d>" % (cpp, field.array_size)
+                field.cpp_suffix = ""
+                size = align_up(align_up(4, align) + size * field.array_size,
+                                max(4, align))
+                align = max(4, align)
+                desc += "[<=%d]" % field.array_size
+            else:
+                field.cpp_type = cpp
+                field.cpp_suffix = ""
+            aligned = align_up(offset, align)
+            if aligned != offset:
+                spec.layout.append((None, offset, aligned - offset, pad_index))
+                pad_index += 1
+            spec.layout.append((field, aligned, size, None))
+            offset = aligned + size
+            max_align = max(max_align, align)
+            canonical.append("%s %s" % (desc, field.name))
+
+        total = align_up(max(offset, 1), max_align)
+        if total != offset:
+            spec.layout.append((None, offset, total - offset, pad_index))
+        spec.size = total
+        spec.align = max_align
+        spec.type_hash = fnv1a64("\n".join(canonical))
+        self.resolving.discard(spec.full_name)
+        return spec
+
+
+def constant_literal(const):
+    if const.base == "string":
+        return "const char*", '"%s"' % const.value.strip('"').replace('"', '\\"')
+    if const.base not in PRIMITIVES:
+        raise MsgError("constant '%s' has unsupported type" % const.name)
+    cpp = PRIMITIVES[const.base][0]
+    if const.base == "bool":
+        return cpp, "true" if const.value.lower() in ("true", "1") else "false"
+    return cpp, const.value
+
+
+def element_check(field, item):
+    """单个元素的校验表达式，基本类型不需要校验时返回 None"""
+    if field.base == "string":
+        return "%s.valid()" % item
+    if field.base in PRIMITIVES:
+        return None
+    return "%s.validate()" % item
+
+
+def generate_validate(spec):
+    """validate()：有界容器的 size_ 不超过容量，嵌套消息递归校验"""
+    out = []
+    out.append("  // 反序列化对端数据后校验：有界字段的长度不超过容量")
+    out.append("  bool validate() const {")
+    for field in spec.fields:
+        check = element_check(field, "item")
+        if field.array_kind == "bounded":
+            out.append("    if (!%s.valid()) return false;" % field.name)
+        if field.array_kind is None:
+            check = element_check(field, field.name)
+            if check is not None:
+                out.append("    if (!%s) return false;" % check)
+        elif check is not None:
+            out.append("    for (const auto& item : %s) {" % field.name)
+            out.append("      if (!%s) return false;" % check)
+            out.append("    }")
+    out.append("    return true;")
+    out.append("  }")
+    return out
+
+
+def generate_header(spec, resolver):
+    ns_open = "namespace %s {\nnamespace msg {\n" % spec.package
+    ns_close = "}  // namespace msg\n}  // namespace %s\n" % spec.package
+    includes = set()
+    for field in spec.fields:
+        if "/" in field.base:
+            includes.add(resolver.lookup(field.base).header)
+
+    out = []
+    out.append("// 由 tools/generate_messages.py 根据 %s/%s.msg 生成，请勿手动修改"
+               % (spec.package, spec.name))
+    out.append("#pragma once")
+    out.append("#include <stddef.h>")
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append("#include <type_traits>")
+    out.append("")
+    out.append('#include "mini_ros2/message/bounded.h"')
+    out.append('#include "mini_ros2/message/message_serializer.h"')
+    for inc in sorted(includes):
+        out.append('#include "%s"' % inc)
+    out.append("")
+    out.append(ns_open)
+    out.append("struct %s {" % spec.name)
+    for const in spec.constants:
+        cpp, literal = constant_literal(const)
+        out.append("  static constexpr %s %s = %s;" % (cpp, const.name, literal))
+    if spec.constants:
+        out.append("")
+    for field, offset, size, pad_index in spec.layout:
+        if field is None:
+            out.append("  uint8_t padding%d_[%d] = {};  // offset %d"
+                       % (pad_index, size, offset))
+        else:
+            out.append("  %s %s%s = {};  // offset %d"
+                       % (field.cpp_type, field.name, field.cpp_suffix, offset))
+    out.append("")
+    out.extend(generate_validate(spec))
+    out.append("};")
+    out.append("")
+    out.append(ns_close)
+
+    cpp_name = "::" + spec.cpp_name
+    out.append("static_assert(std::is_trivially_copyable<%s>::value," % cpp_name)
+    out.append('              "%s must be trivially copyable");' % spec.full_name)
+    out.append("static_assert(sizeof(%s) == %d," % (cpp_name, spec.size))
+    out.append('              "%s layout mismatch");' % spec.full_name)
+    for field, offset, size, _ in spec.layout:
+        if field is None:
+            continue
+        out.append("static_assert(offsetof(%s, %s) == %d," % (cpp_name, field.name, offset))
+        out.append('              "%s.%s offset mismatch");' % (spec.full_name, field.name))
+    out.append("")
+    out.append("template <>")
+    out.append("struct MessageTraits<%s> {" % cpp_name)
+    out.append("  static constexpr bool is_generated = true;")
+    out.append('  static constexpr const char* name = "%s";' % spec.full_name)
+    out.append("  static constexpr uint64_t type_hash = 0x%016xULL;" % spec.type_hash)
+    out.append("};")
+    out.append("")
+    out.append("template <>")
+    out.append("inline void Serializer::serialize<%s>(" % cpp_name)
+    out.append("    const %s& data, uint8_t* buffer, size_t buffer_size) {" % cpp_name)
+    out.append("  serializeGenerated(data, buffer, buffer_size);")
+    out.append("}")
+    out.append("")
+    out.append("template <>")
+    out.append("inline void Serializer::deserialize<%s>(" % cpp_name)
+    out.append("    const uint8_t* buffer, size_t buffer_size, %s& data) {" % cpp_name)
+    out.append("  deserializeGenerated(buffer, buffer_size, data);")
+    out.append("}")
+    out.append("")
+    out.append("template <>")
+    out.append("inline size_t Serializer::getSerializedSize<%s>(" % cpp_name)
+    out.append("    const %s& data) {" % cpp_name)
+    out.append("  return sizeof(MessageWireHeader) + sizeof(data);")
+    out.append("}")
+    out.append("")
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="miniROS2 .msg code generator")
+    parser.add_argument("--out", required=True, help="output include directory")
+    parser.add_argument("--search-path", action="append", default=[],
+                        help="root directory containing <package>/<Name>.msg")
+    parser.add_argument("files", nargs="+", help=".msg files to generate")
+    args = parser.parse_args()
+
+    try:
+        resolver = Resolver(args.search_path)
+        targets = []
+        for path in args.files:
+            spec = parse_msg(path)
+            resolver.add(spec)
+            targets.append(spec)
+        for spec in targets:
+            resolver.resolve(spec)
+            out_path = os.path.join(args.out, spec.header)
+            os.makedirs(os.path.dirname(out_path), exist_ok=True)
+            content = generate_header(spec, resolver)
+            # 内容不变时只更新时间戳，让构建系统认为输出已是最新
+            if os.path.isfile(out_path):
+                with open(out_path) as f:
+                    if f.read() == content:
+                        os.utime(out_path, None)
+                        continue
+            with open(out_path, "w") as f:
+                f.write(content)
+    except MsgError as e:
+        sys.stderr.write("generate_messages: error: %s\n" % e)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())